@@ -66,6 +66,25 @@ uint16_t HcSr04ReadDistanceInCentimeters(void);
  */
 uint16_t HcSr04ReadDistanceInInches(void);
 
+/**
+ * @brief Read distance smoothed by a constant velocity Kalman filter
+ * 
+ * Every read gives the filtered distance without the delay of averaging.
+ * When there is no echo or the echo times out (300 cm) the distance is
+ * predicted by the last velocity.
+ * 
+ * @return float filtered distance in cm.
+ */
+float HcSr04ReadDistanceFilteredInCentimeters(void);
+
+/**
+ * @brief Set the Kalman filter of HcSr04ReadDistanceFilteredInCentimeters()
+ * 
+ * @param process_noise variance of the velocity change per read, (cm/read)^2
+ * @param measurement_noise variance of the distance read, cm^2
+ */
+void HcSr04SetFilter(float process_noise, float measurement_noise);
+
 /**
  * @brief HC_SR04 de-initialization.
  * 
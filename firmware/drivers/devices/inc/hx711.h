@@ -86,6 +86,22 @@ float HX711_get_units(uint8_t times);
  */
 void HX711_tare(uint8_t times);
 
+/** @fn HX711_setFilter(float process_noise, float measurement_noise)
+ * @brief Set the Kalman filter of HX711_getUnitsFiltered(). The process noise grows
+ * on a change of the weight, so the filter follows steps and is smooth on a constant weight
+ * @param[in] process_noise Variance of the weight change per sample, counts^2 (default 1)
+ * @param[in] measurement_noise Variance of the raw reading, counts^2 (default 400, 20 counts rms
+ * at gain 128 and 10 SPS, 80 SPS has about 4 times more)
+ */
+void HX711_setFilter(float process_noise, float measurement_noise);
+
+/** @fn HX711_getUnitsFiltered(void)
+ * @brief Read one sample and return the weight smoothed by the Kalman filter,
+ * without the delay of averaging
+ * @return Filtered weight in the units of SCALE
+ */
+float HX711_getUnitsFiltered(void);
+
 /** @fn HX711_setScale(float scale)
  * @brief Set the SCALE value; this value is used to convert the raw data to "human readable" data (measure units)
  * @param[in] scale Scale vlaue
@@ -33,6 +33,32 @@
  * |   Date	    | Description                                    |
  * |:----------:|:-----------------------------------------------|
  * | 18/01/2024 | Document creation		                         |
+ * | 16/10/2026 | Buffered render mode with dirty rectangles	 |
+ * | 16/10/2026 | Buffered mode renders band by band			 |
+ *
+ * @section render Render modes
+ *
+ * In ::ILI9341_DIRECT mode (default) every drawing function writes to the LCD 
+ * immediately. In ::ILI9341_BUFFERED mode only two bands of band_height rows are
+ * kept in RAM, and the frame is rendered band by band: the application draws
+ * the whole frame once per band, and the drawing functions keep only the pixels
+ * of the current band.
+ *
+ * 		ILI9341BeginFrame(ILI9341_WHITE);
+ * 		do {
+ * 			DrawScreen();
+ * 		} while (ILI9341NextBand());
+ *
+ * The band is compared with what the LCD shows through a hash of every 16x4
+ * pixels tile, and only the bounding rectangle of the changed tiles is sent
+ * (one window per band). The two bands work as ping-pong DMA buffers: one is
+ * rendered while the other is sent. Bus time is then proportional to the 
+ * changed area instead of three transactions per pixel, at the cost of drawing
+ * the frame height / band_height times. With band_height = 16 the mode uses
+ * about 20 KB of RAM (two 240x16 bands and 1200 tile hashes) instead of the
+ * 150 KB of a full frame buffer.
+ *
+ * A changed tile with the same hash as before (probability 2^-32) is not sent.
  *
  */
 
@@ -80,6 +106,14 @@ typedef enum ili9341_orientation {
 	ILI9341_Landscape_1, 	/*!< Landscape orientation mode 1 */
 	ILI9341_Landscape_2  	/*!< Landscape orientation mode 2 */
 } ili9341_orientation_t;
+
+/**
+ * @brief  Render modes
+ */
+typedef enum ili9341_render_mode {
+	ILI9341_DIRECT,		/*!< Drawing functions write to the LCD */
+	ILI9341_BUFFERED	/*!< Drawing functions write to a RAM frame buffer, sent band by band by ILI9341NextBand() */
+} ili9341_render_mode_t;
 /*==================[external data declaration]==============================*/
 
 /*==================[external functions declaration]=========================*/
@@ -110,10 +144,12 @@ void ILI9341Fill(uint16_t color);
 
 /**
  * @brief  		Rotates LCD to specific orientation
+ * @note		In buffered mode the bands are reallocated for the new width and the
+ * 				next frame (ILI9341BeginFrame()) is sent whole. Call it between frames.
  * @param[in]	orientation: LCD orientation
- * @retval 		None
+ * @retval 		1 when success, 0 when the bands can't be reallocated (direct mode is used)
  */
-void ILI9341Rotate(ili9341_orientation_t orientation);
+uint8_t ILI9341Rotate(ili9341_orientation_t orientation);
 
 /**
  * @brief  		Draw a single character on the LCD
@@ -267,6 +303,37 @@ void ILI9341DrawFilledTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, i
  */
 void ILI9341DrawPicture(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t* pic);
 
+/**
+ * @brief  		Selects the render mode
+ * @note		Entering buffered mode allocates two bands of width * band_height * 2 bytes
+ * 				and a hash of every 16x4 pixels tile. The first frame is sent whole.
+ * @param[in]  	mode: ::ILI9341_DIRECT or ::ILI9341_BUFFERED
+ * @param[in]  	band_height: Rows of each band (buffered mode, 8 to 320, rounded up to a multiple of 4)
+ * @retval 		1 when success, 0 when the bands can't be allocated
+ */
+uint8_t ILI9341SetRenderMode(ili9341_render_mode_t mode, uint16_t band_height);
+
+/**
+ * @brief  		Starts rendering a frame in the first band (buffered mode)
+ * @note		Drawing functions called outside a frame are ignored in buffered mode.
+ * @param[in]  	background: Color of the pixels not drawn in the frame (RGB565)
+ * @retval 		None
+ */
+void ILI9341BeginFrame(uint16_t background);
+
+/**
+ * @brief  		Sends the changed tiles of the current band and starts the next one (buffered mode)
+ * @note		Returns once the band transfer is queued.
+ * @retval 		1 when the frame must be drawn again for the next band, 0 when the frame is done
+ */
+uint8_t ILI9341NextBand(void);
+
+/**
+ * @brief  		Pixel bytes sent in the last frame (buffered mode)
+ * @retval 		Number of pixel bytes sent
+ */
+uint32_t ILI9341FrameBytes(void);
+
 /**
  * @brief  	De-initializes ILI9341 LCD
  * @param	None
@@ -12,6 +12,7 @@
 /*==================[inclusions]=============================================*/
 #include "hc_sr04.h"
 #include "delay_mcu.h"
+#include "dsps_lkf.h"
 /*==================[macros and definitions]=================================*/
 #define MAX_US		17700	/* maximun distance time in us (300cm or 118inch) */
 #define MAX_CM		300		/* maximun distance time in cm */
@@ -19,8 +20,11 @@
 #define US2CM		59		/* scale factor to conver pulse width to cm */
 #define US2INCH		150		/* scale factor to conver pulse width to inch */
 #define WAIT_MAX	5900	/* maximun time to wait for echo signal */
+#define FILTER_PROCESS_NOISE	0.01	/* default variance of the velocity change per read, (cm/read)^2 */
+#define FILTER_MEASURE_NOISE	4	/* default variance of the distance read, cm^2 */
 /*==================[internal data declaration]==============================*/
 static gpio_t echo_st, trigger_st; /**<  Stores the pin inicilization*/
+static lkf_cv_f32_t distance_filter; /**<  Kalman filter of the distance*/
 /*==================[internal functions declaration]=========================*/
 
 /*==================[internal data definition]===============================*/
@@ -39,6 +43,7 @@ bool HcSr04Init(gpio_t echo, gpio_t trigger){
 	GPIOInit(echo, GPIO_INPUT);
 	GPIOInit(trigger, GPIO_OUTPUT);
 
+	HcSr04SetFilter(FILTER_PROCESS_NOISE, FILTER_MEASURE_NOISE);
 	return true;
 }
 
@@ -86,6 +91,22 @@ uint16_t HcSr04ReadDistanceInInches(void){
 	return (distance/US2INCH);
 }
 
+float HcSr04ReadDistanceFilteredInCentimeters(void){
+	uint16_t distance = HcSr04ReadDistanceInCentimeters();
+	if((distance == 0) || (distance >= MAX_CM)){
+		/* no echo or echo timeout: keep moving with the last velocity */
+		dsps_lkf_cv_predict_f32(&distance_filter, 1);
+		return distance_filter.x[0];
+	}
+	return dsps_lkf_cv_f32(&distance_filter, distance, 1);
+}
+
+void HcSr04SetFilter(float process_noise, float measurement_noise){
+	dsps_lkf_cv_init_f32(&distance_filter, process_noise, measurement_noise);
+	/* a sudden change of the distance: up to 100 times more process noise */
+	dsps_lkf_cv_adaptive_f32(&distance_filter, 0.1, 100);
+}
+
 bool HcSr04Deinit(void){
 	GPIODeinit();
 	return true;
@@ -12,8 +12,11 @@
 #include "hx711.h"
 
 #include <delay_mcu.h>
+#include "dsps_lkf.h"
 
 /*==================[macros and definitions]=================================*/
+#define FILTER_PROCESS_NOISE	1		/*!<  Default variance of the weight change per sample, counts^2 */
+#define FILTER_MEASURE_NOISE	400		/*!<  Default variance of the raw reading, counts^2: 50 nV rms at gain 128 and 10 SPS is 20 counts rms */
 
 /*==================[internal data declaration]==============================*/
 uint8_t GAIN;		             /*!<  Amplification factor */
@@ -23,6 +26,7 @@ float SCALE;	                 /*!<  Used to return weight in grams, kg, ounces,
 
 gpio_t internal_pd_sck;
 gpio_t internal_dout;
+static lkf_const_f32_t weight_filter;	/*!<  Kalman filter of HX711_getUnitsFiltered() */
 
 /*==================[internal functions declaration]=========================*/
 
@@ -50,6 +54,7 @@ void HX711_Init(uint8_t gain, gpio_t pd_sck, gpio_t dout)
 	internal_dout = dout;
 	GPIOInit(pd_sck, GPIO_OUTPUT);//PD_SCK_SET_OUTPUT;
 	GPIOInit(dout, GPIO_INPUT);//DOUT_SET_INPUT;
+    HX711_setFilter(FILTER_PROCESS_NOISE, FILTER_MEASURE_NOISE);
     HX711_setGain(gain);
 
 }
@@ -141,6 +146,19 @@ void HX711_tare(uint8_t times)
 	HX711_setOffset(sum);
 }
 
+void HX711_setFilter(float process_noise, float measurement_noise)
+{
+	dsps_lkf_const_init_f32(&weight_filter, process_noise, measurement_noise);
+	// A step of the weight gives large innovations: up to 10000 times more process noise
+	dsps_lkf_const_adaptive_f32(&weight_filter, 0.1, 10000);
+}
+
+float HX711_getUnitsFiltered(void)
+{
+	float weight = dsps_lkf_const_f32(&weight_filter, HX711_read(), 1);
+	return (weight - OFFSET) / SCALE;
+}
+
 void HX711_setScale(float scale)
 {
 	SCALE = scale;
@@ -10,19 +10,28 @@
  */
 
 /*==================[inclusions]=============================================*/
+#include <stdlib.h>
+#include <string.h>
 #include "ili9341.h"
 #include "fonts.h"
 #include "spi_mcu.h"
 #include "gpio_mcu.h"
 #include "delay_mcu.h"
 /*==================[macros and definitions]=================================*/
-#define NULL 0
+#define NO_CMD 0x00				/*!< No command: only data is sent (0x00 is the NOP command) */
 
 #define SPI_BR 20000000				/*!< Frequency of sck for SPI communication */
 #define MAX_PIXEL 320*240*2			/*!< Maximum number of bytes to write on LCD */
 #define MSK_BIT16 0x8000			/*!< 16th bit mask */
 #define MSK_BIT8 0x80				/*!< 8th bit mask */
 #define MAX_VALUE_SIZE 256			/*!< Maximum length of a data array to prevent excessive use of memory */
+#define FILL_BUFFER_SIZE SPI_MAX_TRANSFER_SIZE	/*!< Solid color buffer, sent in max size DMA transactions */
+#define FB_MIN_BAND_HEIGHT 8		/*!< Minimum rows of a frame buffer band */
+#define FB_TILE_WIDTH 16			/*!< Columns of a change detection tile */
+#define FB_TILE_HEIGHT 4			/*!< Rows of a change detection tile, band heights are multiple of it */
+#define FB_HASH_INIT 2166136261u	/*!< FNV-1a offset basis */
+#define FB_HASH_PRIME 16777619u		/*!< FNV-1a prime */
+#define FbColor(x) (uint16_t)(((x) >> 8) | ((x) << 8))	/*!< RGB565 color in LCD byte order (little endian CPU) */
 #define LEFT -1						/*!< Horizontal grow direction */
 #define RIGHT 1						/*!< Horizontal grow direction */
 #define DOWN 1						/*!< Vertical grow direction */
@@ -82,6 +91,29 @@ typedef struct {
     uint32_t databytes; 	/*!< Number of bytes of data to transmit */
     uint8_t *data;			/*!< Pointer to data or parameters array */
 } lcd_cmd_t;
+
+/**
+ * @brief Band buffers used in buffered render mode
+ */
+typedef struct {
+	bool enabled;						/*!< Buffered render mode active */
+	bool drawing;						/*!< A frame is being rendered (ILI9341BeginFrame() called) */
+	bool flushing;						/*!< Band being sent: WriteLCD goes to the LCD */
+	bool hash_valid;					/*!< Tile hashes describe the LCD content */
+	uint16_t band_height;				/*!< Rows per band */
+	int16_t band_y0, band_y1;			/*!< Rows of the band being rendered */
+	uint16_t background;				/*!< Color of the pixels not drawn, in LCD byte order */
+	uint16_t *band[2];					/*!< Ping-pong band buffers, in LCD byte order */
+	bool queued[2];						/*!< A queued transfer may still read the band buffer */
+	uint8_t index;						/*!< Band buffer being rendered */
+	uint32_t *hash;						/*!< Hash of every tile as it was sent to the LCD */
+	uint16_t tiles_x;					/*!< Tiles in a row of tiles */
+	int16_t win_x0, win_y0;				/*!< Window set by SetCursorPosition (start) */
+	int16_t win_x1, win_y1;				/*!< Window set by SetCursorPosition (end) */
+	int16_t cur_x, cur_y;				/*!< Memory write position inside the window */
+	int16_t pending;					/*!< High byte of an incomplete pixel, -1 if none */
+	uint32_t sent;						/*!< Pixel bytes sent in the current frame */
+} frame_buffer_t;
 /*==================[internal data declaration]==============================*/
 
 /*==================[internal functions declaration]=========================*/
@@ -114,6 +146,16 @@ void SetCursorPosition(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
  */
 void Fill(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color);
 
+static void PanelWrite(lcd_cmd_t * data);
+static bool FbAlloc(uint16_t band_height);
+static void FbFree(void);
+static void FbStartBand(void);
+static uint32_t FbTileHash(const uint16_t *band, int32_t x0, int32_t y0, int32_t rows);
+static void FbSendBand(void);
+static void FbSetPixel(int32_t x, int32_t y, uint16_t color);
+static void FbFillRect(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint16_t color);
+static void FbWrite(lcd_cmd_t * data);
+
 /*==================[internal data definition]===============================*/
 /**
  * @brief Initial LCD configuration parameters
@@ -167,20 +209,21 @@ lcd_cmd_t lcd_init[] = {
 	{NEG_GAMMA, 15, neg_gamma},
 };
 
-lcd_cmd_t lcd_reset = {RESET, NULL, NULL};			/*!< SW reset */
-lcd_cmd_t lcd_sleep_out = {SLEEP_OUT, NULL, NULL};	/*!< Exit sleep mode */
-lcd_cmd_t lcd_on = {DISPLAY_ON, NULL, NULL};		/*!< Exit sleep mode */
+lcd_cmd_t lcd_reset = {RESET, 0, NULL};			/*!< SW reset */
+lcd_cmd_t lcd_sleep_out = {SLEEP_OUT, 0, NULL};	/*!< Exit sleep mode */
+lcd_cmd_t lcd_on = {DISPLAY_ON, 0, NULL};		/*!< Exit sleep mode */
 
 /*
  * @brief: SPI port configuration compatible with LCD interface
  */
 spi_mcu_config_t spi_conf = {
-	.device = NULL, 
+	.device = SPI_1, 
 	.clk_mode = MODE0, 
 	.bitrate = SPI_BR, 
 	.transfer_mode = SPI_POLLING, 
 	.func_p = NULL,
-	.param_p = NULL };
+	.param_p = NULL,
+	.pre_func_p = NULL };
 
 static spi_dev_t ili9341_spi;				/*!< uC SPI port */
 static gpio_t ili9341_dc, ili9341_rst;		/*!< uC GPIO ports to use as CS, DC and RST */
@@ -191,18 +234,33 @@ static orientation_properties_t lcd_orientation = {
 		ILI9341_Portrait_1
 };	/*!< Default orientation configuration */
 
+static frame_buffer_t fb;					/*!< Frame buffer (buffered render mode) */
+
 /*==================[internal functions definition]==========================*/
 
 void WriteLCD(lcd_cmd_t * data){
-	SpiInit(&spi_conf);
-	/* If command is NULL don't send command */
-	if (data->cmd != NULL){
+	if (fb.enabled && !fb.flushing){
+		FbWrite(data);
+	}
+	else{
+		PanelWrite(data);
+	}
+}
+
+static void PanelWrite(lcd_cmd_t * data){
+	/* DC can't change while queued data is still being sent */
+	SpiWaitAll(ili9341_spi);
+	/* Nothing reads the band buffers anymore */
+	fb.queued[0] = false;
+	fb.queued[1] = false;
+	/* If there is no command don't send command */
+	if (data->cmd != NO_CMD){
 		/* Send command */
 		GPIOOff(ili9341_dc);
 		SpiWrite(ili9341_spi, &data->cmd, 1);
 	}
 	/* If there are parameters or data to send */
-	if (data->databytes != NULL){
+	if (data->databytes > 0){
 		/* Send parameters or data */
 		GPIOOn(ili9341_dc);
 		SpiWrite(ili9341_spi, data->data, data->databytes);
@@ -235,8 +293,12 @@ void Fill(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color){
 	static uint16_t i;
 	static int32_t bytes_count;
 	static int16_t x_dist, y_dist;
-	static uint8_t pixel[MAX_VALUE_SIZE];
+	static uint8_t pixel[FILL_BUFFER_SIZE];
 
+	if (fb.enabled){
+		FbFillRect(x0, y0, x1, y1, color);
+		return;
+	}
 	x_dist = x1 - x0;
 	y_dist = y1 - y0;
 	if (x0 > x1){
@@ -250,21 +312,253 @@ void Fill(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color){
 	/* Define area to fill */
 	SetCursorPosition(x0, y0, x1, y1);
 
-	for (i = 0; i < MAX_VALUE_SIZE; i += 2){
+	/* Previous queued transfers finished in SetCursorPosition(), the buffer can be rewritten */
+	for (i = 0; i < FILL_BUFFER_SIZE; i += 2){
 		pixel[i] = HighByte(color);
 		pixel[i + 1] = LowByte(color);
 	}
 	/* Start writing LCD memory */
-	lcd_cmd_t lcd_write = {MEM_WRITE, NULL, NULL};
+	lcd_cmd_t lcd_write = {MEM_WRITE, 0, NULL};
 	WriteLCD(&lcd_write);
 
-	while(bytes_count - MAX_VALUE_SIZE > 0){
-		lcd_cmd_t lcd_pixel = {NULL, MAX_VALUE_SIZE, pixel};
-		WriteLCD(&lcd_pixel);
-		bytes_count -= MAX_VALUE_SIZE;
+	/* Queue the pixels and return, the next command waits for them */
+	GPIOOn(ili9341_dc);
+	while(bytes_count - FILL_BUFFER_SIZE > 0){
+		SpiWriteAsync(ili9341_spi, pixel, FILL_BUFFER_SIZE, NULL);
+		bytes_count -= FILL_BUFFER_SIZE;
+	}
+	SpiWriteAsync(ili9341_spi, pixel, bytes_count, NULL);
+}
+
+static bool FbAlloc(uint16_t band_height){
+	uint16_t rows;
+	uint32_t tiles;
+
+	if (band_height < FB_MIN_BAND_HEIGHT){
+		band_height = FB_MIN_BAND_HEIGHT;
+	}
+	if (band_height > lcd_orientation.height){
+		band_height = lcd_orientation.height;
+	}
+	/* Bands hold whole tiles */
+	band_height = (band_height + FB_TILE_HEIGHT - 1) / FB_TILE_HEIGHT * FB_TILE_HEIGHT;
+	rows = band_height;
+	fb.band_height = band_height;
+	fb.tiles_x = (lcd_orientation.width + FB_TILE_WIDTH - 1) / FB_TILE_WIDTH;
+	tiles = fb.tiles_x * ((lcd_orientation.height + FB_TILE_HEIGHT - 1) / FB_TILE_HEIGHT);
+	fb.band[0] = malloc(lcd_orientation.width * rows * 2);
+	fb.band[1] = malloc(lcd_orientation.width * rows * 2);
+	fb.hash = malloc(tiles * sizeof(uint32_t));
+	if (fb.band[0] == NULL || fb.band[1] == NULL || fb.hash == NULL){
+		FbFree();
+		return false;
+	}
+	fb.queued[0] = false;
+	fb.queued[1] = false;
+	fb.index = 0;
+	fb.pending = -1;
+	fb.drawing = false;
+	fb.flushing = false;
+	/* The LCD content is unknown: the first frame is sent whole */
+	fb.hash_valid = false;
+	fb.enabled = true;
+	return true;
+}
+
+static void FbFree(void){
+	free(fb.band[0]);
+	free(fb.band[1]);
+	free(fb.hash);
+	fb.band[0] = NULL;
+	fb.band[1] = NULL;
+	fb.hash = NULL;
+	fb.drawing = false;
+	fb.enabled = false;
+}
+
+static void FbStartBand(void){
+	uint32_t i, n;
+	uint16_t *band;
+
+	fb.band_y1 = fb.band_y0 + fb.band_height - 1;
+	if (fb.band_y1 >= lcd_orientation.height){
+		fb.band_y1 = lcd_orientation.height - 1;
+	}
+	/* Transfers end in order: wait only if the last one sent this buffer */
+	if (fb.queued[fb.index]){
+		SpiWaitAll(ili9341_spi);
+		fb.queued[0] = false;
+		fb.queued[1] = false;
+	}
+	band = fb.band[fb.index];
+	n = lcd_orientation.width * (fb.band_y1 - fb.band_y0 + 1);
+	for (i = 0; i < n; i++){
+		band[i] = fb.background;
+	}
+}
+
+static uint32_t FbTileHash(const uint16_t *band, int32_t x0, int32_t y0, int32_t rows){
+	uint32_t hash = FB_HASH_INIT;
+	int32_t x, y, x1, y1;
+	const uint16_t *row;
+
+	x1 = (x0 + FB_TILE_WIDTH < lcd_orientation.width) ? x0 + FB_TILE_WIDTH : lcd_orientation.width;
+	y1 = (y0 + FB_TILE_HEIGHT < rows) ? y0 + FB_TILE_HEIGHT : rows;
+	for (y = y0; y < y1; y++){
+		row = band + y * lcd_orientation.width;
+		for (x = x0; x < x1; x++){
+			hash = (hash ^ row[x]) * FB_HASH_PRIME;
+		}
+	}
+	return hash;
+}
+
+static void FbSendBand(void){
+	int32_t tx, ty, x0, x1, y0, y1, y, width, rows;
+	int32_t ch_tx0 = INT16_MAX, ch_ty0 = INT16_MAX, ch_tx1 = -1, ch_ty1 = -1;
+	uint32_t h, bytes;
+	uint32_t *hash;
+	uint16_t *band = fb.band[fb.index];
+
+	width = lcd_orientation.width;
+	rows = fb.band_y1 - fb.band_y0 + 1;
+	hash = &fb.hash[(fb.band_y0 / FB_TILE_HEIGHT) * fb.tiles_x];
+	/* Bounding box of the tiles that differ from the LCD content */
+	for (ty = 0; ty * FB_TILE_HEIGHT < rows; ty++){
+		for (tx = 0; tx < fb.tiles_x; tx++){
+			h = FbTileHash(band, tx * FB_TILE_WIDTH, ty * FB_TILE_HEIGHT, rows);
+			if (fb.hash_valid && hash[ty * fb.tiles_x + tx] == h){
+				continue;
+			}
+			hash[ty * fb.tiles_x + tx] = h;
+			if (tx < ch_tx0){
+				ch_tx0 = tx;
+			}
+			if (tx > ch_tx1){
+				ch_tx1 = tx;
+			}
+			if (ty < ch_ty0){
+				ch_ty0 = ty;
+			}
+			ch_ty1 = ty;
+		}
+	}
+	if (ch_tx1 < 0){
+		return;
+	}
+	x0 = ch_tx0 * FB_TILE_WIDTH;
+	x1 = ((ch_tx1 + 1) * FB_TILE_WIDTH < width) ? (ch_tx1 + 1) * FB_TILE_WIDTH - 1 : width - 1;
+	y0 = ch_ty0 * FB_TILE_HEIGHT;
+	y1 = ((ch_ty1 + 1) * FB_TILE_HEIGHT < rows) ? (ch_ty1 + 1) * FB_TILE_HEIGHT - 1 : rows - 1;
+	/* Pack the rectangle rows at the start of the buffer, so it goes out in one transfer */
+	for (y = y0; y <= y1; y++){
+		memmove(band + (y - y0) * (x1 - x0 + 1), band + y * width + x0, (x1 - x0 + 1) * 2);
+	}
+	bytes = (x1 - x0 + 1) * (y1 - y0 + 1) * 2;
+	/* One window per band */
+	fb.flushing = true;
+	SetCursorPosition(x0, fb.band_y0 + y0, x1, fb.band_y0 + y1);
+	lcd_cmd_t lcd_write = {MEM_WRITE, 0, NULL};
+	WriteLCD(&lcd_write);
+	fb.flushing = false;
+	/* Queue the band and return: the next band is rendered in the other buffer meanwhile */
+	GPIOOn(ili9341_dc);
+	SpiWriteAsync(ili9341_spi, (uint8_t *)band, bytes, NULL);
+	fb.queued[fb.index] = true;
+	fb.sent += bytes;
+}
+
+static void FbSetPixel(int32_t x, int32_t y, uint16_t color){
+	if (!fb.drawing || x < 0 || x >= lcd_orientation.width || y < fb.band_y0 || y > fb.band_y1){
+		return;
+	}
+	fb.band[fb.index][(y - fb.band_y0) * lcd_orientation.width + x] = FbColor(color);
+}
+
+static void FbFillRect(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint16_t color){
+	int32_t x, y, aux;
+	uint16_t *row;
+
+	if (!fb.drawing){
+		return;
+	}
+	if (x0 > x1){
+		aux = x0;
+		x0 = x1;
+		x1 = aux;
+	}
+	if (y0 > y1){
+		aux = y0;
+		y0 = y1;
+		y1 = aux;
+	}
+	/* Clip to the band */
+	if (x0 < 0){
+		x0 = 0;
+	}
+	if (y0 < fb.band_y0){
+		y0 = fb.band_y0;
+	}
+	if (x1 >= lcd_orientation.width){
+		x1 = lcd_orientation.width - 1;
+	}
+	if (y1 > fb.band_y1){
+		y1 = fb.band_y1;
+	}
+	color = FbColor(color);
+	for (y = y0; y <= y1; y++){
+		row = fb.band[fb.index] + (y - fb.band_y0) * lcd_orientation.width;
+		for (x = x0; x <= x1; x++){
+			row[x] = color;
+		}
+	}
+}
+
+static void FbWrite(lcd_cmd_t * data){
+	uint32_t i;
+
+	/* Emulate the LCD memory window: column/page set, then memory write */
+	switch (data->cmd){
+	case COLUMN_ADDR_SET:
+		fb.win_x0 = (data->data[0] << 8) | data->data[1];
+		fb.win_x1 = (data->data[2] << 8) | data->data[3];
+		return;
+	case PAGE_ADDR_SET:
+		fb.win_y0 = (data->data[0] << 8) | data->data[1];
+		fb.win_y1 = (data->data[2] << 8) | data->data[3];
+		return;
+	case MEM_WRITE:
+		fb.cur_x = fb.win_x0;
+		fb.cur_y = fb.win_y0;
+		fb.pending = -1;
+		break;
+	case NO_CMD:
+		break;
+	default:
+		PanelWrite(data);
+		return;
+	}
+	if (!fb.drawing){
+		return;
+	}
+	for (i = 0; i < data->databytes; i++){
+		if (fb.pending < 0){
+			fb.pending = data->data[i];
+			continue;
+		}
+		/* Only the pixels of the band being rendered are kept */
+		if (fb.cur_y >= fb.band_y0 && fb.cur_y <= fb.band_y1 && fb.cur_x < lcd_orientation.width){
+			fb.band[fb.index][(fb.cur_y - fb.band_y0) * lcd_orientation.width + fb.cur_x] = fb.pending | (data->data[i] << 8);
+		}
+		fb.pending = -1;
+		/* Advance inside the window, wrapping as the LCD does */
+		if (++fb.cur_x > fb.win_x1){
+			fb.cur_x = fb.win_x0;
+			if (++fb.cur_y > fb.win_y1){
+				fb.cur_y = fb.win_y0;
+			}
+		}
 	}
-	lcd_cmd_t lcd_pixel = {NULL, bytes_count, pixel};
-	WriteLCD(&lcd_pixel);
 }
 
 /*==================[external functions definition]==========================*/
@@ -273,6 +567,7 @@ uint8_t ILI9341Init(spi_dev_t spi_dev, uint8_t gpio_dc, uint8_t gpio_rst){
 	/* SPI configuration */
 	spi_conf.device = spi_dev;
 	ili9341_spi = spi_dev;
+	SpiInit(&spi_conf);
 	/* GPIOs configuration and initialization */
 	ili9341_dc = gpio_dc;
 	ili9341_rst = gpio_rst;
@@ -303,6 +598,10 @@ uint8_t ILI9341Init(spi_dev_t spi_dev, uint8_t gpio_dc, uint8_t gpio_rst){
 }
 
 void ILI9341DrawPixel(uint16_t x, uint16_t y, uint16_t color){
+	if (fb.enabled){
+		FbSetPixel((int16_t)x, (int16_t)y, color);
+		return;
+	}
 	/* Define area (pixel) to fill */
 	SetCursorPosition(x, y, x, y);
 	uint8_t pixels[] = {HighByte(color), LowByte(color)};
@@ -314,8 +613,16 @@ void ILI9341Fill(uint16_t color){
 	Fill(0, 0, lcd_orientation.width, lcd_orientation.height, color);
 }
 
-void ILI9341Rotate(ili9341_orientation_t orientation){
+uint8_t ILI9341Rotate(ili9341_orientation_t orientation){
 	uint8_t mem_acc[1];
+	uint16_t band_height = fb.band_height;
+	bool buffered = fb.enabled;
+
+	/* Bands depend on the orientation width */
+	if (buffered){
+		SpiWaitAll(ili9341_spi);
+		FbFree();
+	}
 	switch(orientation)	{
 	case ILI9341_Portrait_1:
 		mem_acc[0] = 0x48;		/*!< Row Address Order (MY) = 0, Column Address Order (MX) = 1, Row/Column Exchange (MV) = 0 */
@@ -347,6 +654,11 @@ void ILI9341Rotate(ili9341_orientation_t orientation){
 	}
 	lcd_cmd_t lcd_mem_acc = {MEM_ACC_CTRL, 1, mem_acc};
 	WriteLCD(&lcd_mem_acc);
+	if (buffered){
+		/* On failure the bands stay freed: drawing falls back to direct mode */
+		return FbAlloc(band_height);
+	}
+	return true;
 }
 
 void ILI9341DrawChar(uint16_t x, uint16_t y, char data, Font_t* font, uint16_t foreground, uint16_t background){
@@ -372,7 +684,7 @@ void ILI9341DrawChar(uint16_t x, uint16_t y, char data, Font_t* font, uint16_t f
 	bytes_count = font->font_height * font->info[data - ' '].width * 2;
 
 	/* Start writing LCD memory */
-	lcd_cmd_t lcd_write = {MEM_WRITE, NULL, NULL};
+	lcd_cmd_t lcd_write = {MEM_WRITE, 0, NULL};
 	WriteLCD(&lcd_write);
 
 	/* Draw font data */
@@ -389,7 +701,7 @@ void ILI9341DrawChar(uint16_t x, uint16_t y, char data, Font_t* font, uint16_t f
 			}
 			/* If exceed buffer size, send buffer */
 			if ((2 * j + i * font->info[data - ' '].width * 2 - k * MAX_VALUE_SIZE + 1) > MAX_VALUE_SIZE){
-				lcd_cmd_t lcd_pixels = {NULL, MAX_VALUE_SIZE, pixel};
+				lcd_cmd_t lcd_pixels = {NO_CMD, MAX_VALUE_SIZE, pixel};
 				WriteLCD(&lcd_pixels);
 				bytes_count -= MAX_VALUE_SIZE;
 				k++;
@@ -407,7 +719,7 @@ void ILI9341DrawChar(uint16_t x, uint16_t y, char data, Font_t* font, uint16_t f
 		}
 	}
 	/* Send the rest of the buffer */
-	lcd_cmd_t lcd_pixels = {NULL, bytes_count, pixel};
+	lcd_cmd_t lcd_pixels = {NO_CMD, bytes_count, pixel};
 	WriteLCD(&lcd_pixels);
 }
 
@@ -434,7 +746,7 @@ void ILI9341DrawIcon(uint16_t x, uint16_t y, icon_t icon, icon_font_t* icon_font
 	bytes_count = icon_font->height * icon_font->width * 2;
 
 	/* Start writing LCD memory */
-	lcd_cmd_t lcd_write = {MEM_WRITE, NULL, NULL};
+	lcd_cmd_t lcd_write = {MEM_WRITE, 0, NULL};
 	WriteLCD(&lcd_write);
 
 	/* Draw font data */
@@ -451,7 +763,7 @@ void ILI9341DrawIcon(uint16_t x, uint16_t y, icon_t icon, icon_font_t* icon_font
 			}
 			/* If exceed buffer size, send buffer */
 			if ((2 * j + i * icon_font->width * 2 - k * MAX_VALUE_SIZE + 1) > MAX_VALUE_SIZE){
-				lcd_cmd_t lcd_pixels = {NULL, MAX_VALUE_SIZE, pixel};
+				lcd_cmd_t lcd_pixels = {NO_CMD, MAX_VALUE_SIZE, pixel};
 				WriteLCD(&lcd_pixels);
 				bytes_count -= MAX_VALUE_SIZE;
 				k++;
@@ -469,7 +781,7 @@ void ILI9341DrawIcon(uint16_t x, uint16_t y, icon_t icon, icon_font_t* icon_font
 		}
 	}
 	/* Send the rest of the buffer */
-	lcd_cmd_t lcd_pixels = {NULL, bytes_count, pixel};
+	lcd_cmd_t lcd_pixels = {NO_CMD, bytes_count, pixel};
 	WriteLCD(&lcd_pixels);
 }
 
@@ -810,7 +1122,7 @@ void ILI9341DrawPicture(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
 	bytes_count = width * height * 2;
 
 	/* Start writing LCD memory */
-	lcd_cmd_t lcd_write = {MEM_WRITE, NULL, NULL};
+	lcd_cmd_t lcd_write = {MEM_WRITE, 0, NULL};
 	WriteLCD(&lcd_write);
 
 	j = 0;
@@ -818,7 +1130,7 @@ void ILI9341DrawPicture(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
 		for (i = 0; i < MAX_VALUE_SIZE; i++){
 			pixel[i] = pic[j * MAX_VALUE_SIZE + i];
 		}
-		lcd_cmd_t lcd_pixel = {NULL, MAX_VALUE_SIZE, pixel};
+		lcd_cmd_t lcd_pixel = {NO_CMD, MAX_VALUE_SIZE, pixel};
 		WriteLCD(&lcd_pixel);
 		bytes_count -= MAX_VALUE_SIZE;
 		j++;
@@ -826,11 +1138,59 @@ void ILI9341DrawPicture(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
 	for (i = 0; i < bytes_count; i++){
 		pixel[i] = pic[j * MAX_VALUE_SIZE + i];
 	}
-	lcd_cmd_t lcd_pixel = {NULL, bytes_count, pixel};
+	lcd_cmd_t lcd_pixel = {NO_CMD, bytes_count, pixel};
 	WriteLCD(&lcd_pixel);
 }
 
+uint8_t ILI9341SetRenderMode(ili9341_render_mode_t mode, uint16_t band_height){
+	if (fb.enabled){
+		SpiWaitAll(ili9341_spi);
+		FbFree();
+	}
+	if (mode == ILI9341_BUFFERED){
+		return FbAlloc(band_height);
+	}
+	return true;
+}
+
+void ILI9341BeginFrame(uint16_t background){
+	if (!fb.enabled){
+		return;
+	}
+	fb.background = FbColor(background);
+	fb.sent = 0;
+	fb.band_y0 = 0;
+	fb.drawing = true;
+	FbStartBand();
+}
+
+uint8_t ILI9341NextBand(void){
+	if (!fb.drawing){
+		return false;
+	}
+	FbSendBand();
+	fb.index ^= 1;
+	fb.band_y0 += fb.band_height;
+	if (fb.band_y0 >= lcd_orientation.height){
+		/* Frame done: the LCD has the content hashed */
+		fb.drawing = false;
+		fb.hash_valid = true;
+		return false;
+	}
+	FbStartBand();
+	return true;
+}
+
+uint32_t ILI9341FrameBytes(void){
+	return fb.sent;
+}
+
 uint8_t ILI9341DeInit(void){
+	if (fb.enabled){
+		SpiWaitAll(ili9341_spi);
+		FbFree();
+	}
+	SpiDeInit(ili9341_spi);
 	return 0;
 }
 
@@ -21,7 +21,26 @@
  * |   Date	    | Description                                    						|
  * |:----------:|:----------------------------------------------------------------------|
  * | 24/02/2024 | Document creation		                         						|
+ * | 16/10/2026 | Continuous (DMA) mode: multi-channel scan, block ring buffer			|
+ * | 17/10/2026 | Continuous mode: software decimation below the unit minimum rate		|
  * 
+ * @section continuous Continuous mode
+ * 
+ * In continuous mode the ADC unit scans every started channel (CH0 to CH3) 
+ * and delivers the conversions by DMA. The driver splits each DMA frame per 
+ * channel into blocks of ::ADC_CONT_BLOCK_SIZE samples, stored in a ring of 
+ * ::ADC_CONT_RING_BLOCKS blocks per channel. Each time a block is completed 
+ * the channel callback (if any) is called from ISR context; the block can 
+ * then be read with AnalogInputReadContinuous() from a task.
+ * 
+ * The ADC unit converts between SOC_ADC_SAMPLE_FREQ_THRES_LOW (611 Hz on the 
+ * ESP32-C6) and SOC_ADC_SAMPLE_FREQ_THRES_HIGH (83333 Hz) conversions per second, 
+ * shared by the started channels. Lower per channel rates have no minimum: the 
+ * unit runs an integer number of times faster and only one conversion of each 
+ * group is kept. Above the maximum the rate is limited; the rate applied is 
+ * reported by AnalogInputGetStats().
+ * 
+ * @note Continuous and single modes share the ADC unit, they cannot be used at the same time.
  **/
 
 /*==================[inclusions]=============================================*/
@@ -40,6 +59,9 @@ typedef enum adc_mode {
 } adc_mode_t;
 
 #define DAC	0    			/*!< DAC pin. Override CH0 declaration*/
+
+#define ADC_CONT_BLOCK_SIZE		128		/*!< Samples per channel block in continuous mode */
+#define ADC_CONT_RING_BLOCKS	4		/*!< Blocks in each channel ring buffer (one is always being filled) */
 /*==================[typedef]================================================*/
 /**
  * @brief Analog inputs config structure
@@ -50,9 +72,20 @@ typedef struct {
 	adc_mode_t mode;		/*!< Mode: single read or continuous read */
 	void *func_p;			/*!< Pointer to callback function for convertion end (only for continuous mode) */
 	void *param_p;			/*!< Pointer to callback function parameters (only for continuous mode) */
-	uint16_t sample_frec;	/*!< Sample frequency min: 20kHz - max: 2MHz (only for continuous mode)  */
+	uint32_t sample_frec;	/*!< Sample frequency per channel in Hz (only for continuous mode). Shared by all continuous channels, at most 83333 / started channels */
 } analog_input_config_t;	
 
+/**
+ * @brief Continuous mode statistics of one channel
+ * 
+ */
+typedef struct {
+	uint32_t blocks;		/*!< Blocks completed since AnalogInputInit */
+	uint32_t overruns;		/*!< Blocks dropped because the ring buffer was full */
+	uint32_t invalid;		/*!< Conversions discarded for belonging to another unit or channel */
+	uint32_t sample_frec;	/*!< Sample frequency applied to the channel in Hz, 0 if stopped */
+} analog_cont_stats_t;
+
 /*==================[external data declaration]==============================*/
 
 /*==================[external functions declaration]=========================*/
@@ -83,6 +116,9 @@ void AnalogInputReadSingle(adc_ch_t channel, uint16_t *value);
 /**
  * @brief Start convertion for ADC module in continuous mode
  * 
+ * The channel is added to the scan pattern. If other channels are already 
+ * running the conversion is briefly stopped to reconfigure the pattern.
+ * 
  * @param channel Channel selected
  */
 void AnalogStartContinuous(adc_ch_t channel);
@@ -90,17 +126,37 @@ void AnalogStartContinuous(adc_ch_t channel);
 /**
  * @brief Stop convertion for ADC module
  * 
+ * The channel is removed from the scan pattern, the ADC unit stops when 
+ * no channel is left.
+ * 
  * @param channel Channel selected
  */
 void AnalogStopContinuous(adc_ch_t channel);
 
 /**
- * @brief 
+ * @brief Read the oldest complete block of a channel in continuous mode.
+ * 
+ * @param channel Channel selected.
+ * @param values Read variable array (at least ::ADC_CONT_BLOCK_SIZE elements, raw 12 bit values)
+ * @return Number of samples copied: ::ADC_CONT_BLOCK_SIZE, or 0 if no block was ready
+ */
+uint16_t AnalogInputReadContinuous(adc_ch_t channel, uint16_t *values);
+
+/**
+ * @brief Number of complete blocks waiting to be read on a channel.
+ * 
+ * @param channel Channel selected.
+ * @return Blocks ready
+ */
+uint8_t AnalogInputContinuousAvailable(adc_ch_t channel);
+
+/**
+ * @brief Get continuous mode statistics of a channel.
  * 
  * @param channel Channel selected.
- * @param values Read variable array
+ * @param stats Pointer to statistics structure
  */
-void AnalogInputReadContinuous(adc_ch_t channel, uint16_t *values);
+void AnalogInputGetStats(adc_ch_t channel, analog_cont_stats_t *stats);
 
 /**
  * @brief Digital-to-Analog convert.
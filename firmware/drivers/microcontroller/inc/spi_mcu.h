@@ -21,12 +21,24 @@
  * |   Date	    | Description                                    						|
  * |:----------:|:----------------------------------------------------------------------|
  * | 09/02/2024 | Document creation		                         						|
+ * | 16/10/2026 | Persistent device handles, queued (asynchronous) write API			|
  * 
+ * @section async Asynchronous transfers
+ * 
+ * SpiWriteAsync() queues the transfer on the DMA engine and returns immediately, 
+ * so the CPU can prepare the next buffer while the previous one is being sent. 
+ * Each device owns a pool of ::SPI_QUEUE_SIZE preallocated transactions; when 
+ * the pool is exhausted SpiWriteAsync() waits for the oldest one to finish. 
+ * Buffers must remain valid (and unmodified) until SpiWaitAll() returns. 
+ * Blocking functions (SpiRead(), SpiWrite(), SpiReadWrite()) wait for the 
+ * queued transfers of the device before starting.
  **/
 /*==================[inclusions]=============================================*/
 #include <stdbool.h>
 #include <stdint.h>
 /*==================[macros]=================================================*/
+#define SPI_MAX_TRANSFER_SIZE	4092	/*!< Maximum bytes per DMA transaction */
+#define SPI_QUEUE_SIZE			8		/*!< Queued transactions per device */
 
 /*==================[typedef]================================================*/
 
@@ -68,6 +80,7 @@ typedef struct{
 	transfer_mode_t transfer_mode;	/*!< Transfer mode */
 	void *func_p;					/*!< Pointer to callback function for transaction end */
 	void *param_p;					/*!< Pointer to callback parameter */
+	void *pre_func_p;				/*!< Pointer to callback function called before each queued transaction (ISR context), receives the SpiWriteAsync() trans_param. NULL if not used */
 } spi_mcu_config_t;
 /*==================[external data declaration]==============================*/
 
@@ -75,8 +88,11 @@ typedef struct{
 /**
  * @brief Initialize SPI module with the corresponding configuration
  * 
+ * The device is added to the bus only once, calling SpiInit() again with the 
+ * same configuration does nothing. A different configuration re-adds the device.
+ * 
  * @param spi Structure with the module configuration
- * @return uint8_t 
+ * @return uint8_t 0 on success
  */
 uint8_t SpiInit(spi_mcu_config_t* spi);
 
@@ -108,6 +124,36 @@ void SpiWrite(spi_dev_t device, uint8_t * tx_buffer, uint32_t tx_buffer_size);
  */
 void SpiReadWrite(spi_dev_t device, uint8_t * tx_buffer, uint8_t * rx_buffer, uint32_t buffer_size);
 
+/**
+ * @brief Queue data to write on SPI port without waiting for the transfer.
+ * 
+ * Buffers larger than ::SPI_MAX_TRANSFER_SIZE are split in several transactions.
+ * 
+ * @param device SPI device to write to
+ * @param tx_buffer pointer to data, must remain valid until SpiWaitAll()
+ * @param tx_buffer_size numbers of bytes to write
+ * @param trans_param parameter passed to the pre transaction callback (pre_func_p)
+ */
+void SpiWriteAsync(spi_dev_t device, const uint8_t * tx_buffer, uint32_t tx_buffer_size, void * trans_param);
+
+/**
+ * @brief Wait until every queued transaction of the device is finished.
+ * 
+ * @param device SPI device
+ */
+void SpiWaitAll(spi_dev_t device);
+
+/**
+ * @brief Wait until at most max_pending queued transactions of the device remain.
+ * 
+ * Transactions finish in order, so this allows reusing a buffer queued before 
+ * the last max_pending ones (e.g. ping-pong buffers with max_pending = 1).
+ * 
+ * @param device SPI device
+ * @param max_pending Number of transactions that may still be pending
+ */
+void SpiWaitQueued(spi_dev_t device, uint8_t max_pending);
+
 /**
  * @brief De-Initialize SPI module with the corresponding configuration
  * 
@@ -16,16 +16,48 @@
 #include "esp_adc/adc_cali_scheme.h"
 #include "esp_adc/adc_oneshot.h"
 #include "esp_adc/adc_continuous.h"
+#include "esp_attr.h"
+#include <string.h>
 /*==================[macros and definitions]=================================*/
 #define ADC_BITWIDTH 		SOC_ADC_DIGI_MAX_BITWIDTH	// 12 bit resolution
 #define ADC_ATTENUATION		ADC_ATTEN_DB_12				// 12dB attenuation (for 0-3,3V ADC range)
+#define ADC_CHANNELS		4							// CH0 to CH3
+#define ADC_CONT_FRAME_CONV	256							// Conversions per DMA frame (all channels)
+#define ADC_CONT_FRAME_SIZE	(ADC_CONT_FRAME_CONV * SOC_ADC_DIGI_RESULT_BYTES)	// DMA frame size in bytes
+#define ADC_CONT_POOL_SIZE	(ADC_CONT_FRAME_SIZE * 2)	// Driver internal pool, flushed since frames are parsed in the ISR
 /*==================[internal data declaration]==============================*/
+/**
+ * @brief Continuous mode state of one channel
+ * 
+ * The ring is single producer (DMA ISR) / single consumer (task): the ISR only 
+ * advances head and the reader only advances tail, both as free running counters.
+ */
+typedef struct {
+	uint16_t blocks[ADC_CONT_RING_BLOCKS][ADC_CONT_BLOCK_SIZE];	/*!< Ring of sample blocks */
+	uint16_t fill;						/*!< Samples written in the block being filled */
+	uint16_t skip;						/*!< Conversions to discard before the next kept one */
+	volatile uint32_t head;				/*!< Completed blocks counter (written by ISR) */
+	volatile uint32_t tail;				/*!< Read blocks counter (written by reader) */
+	volatile uint32_t overruns;			/*!< Blocks dropped because the ring was full */
+	volatile uint32_t invalid;			/*!< Discarded conversions */
+	void (*func_p)(void*);				/*!< Block completed callback */
+	void *param_p;						/*!< Block completed callback parameter */
+	bool running;						/*!< Channel included in the scan pattern */
+} adc_cont_channel_t;
+
 adc_cali_handle_t adc_calibration_single_0, adc_calibration_single_1, adc_calibration_single_2, adc_calibration_single_3;
 adc_oneshot_unit_handle_t adc1_single; 
-adc_continuous_handle_t adc2_cont;
+adc_continuous_handle_t adc2_cont = NULL;
 sdm_channel_handle_t dac = NULL;
 bool adc1_single_used = false;
+static adc_cont_channel_t adc_cont_ch[ADC_CHANNELS];
+static uint32_t adc_cont_frec = SOC_ADC_SAMPLE_FREQ_THRES_LOW;
+static uint32_t adc_cont_decim = 1;
+static uint32_t adc_cont_frec_applied = 0;
+static bool adc_cont_started = false;
 /*==================[internal functions declaration]=========================*/
+static bool IRAM_ATTR AdcContConvDone(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data);
+static void AdcContUpdatePattern(void);
 
 /*==================[internal data definition]===============================*/
 adc_oneshot_unit_init_cfg_t init_config_single = {
@@ -39,6 +71,95 @@ adc_oneshot_chan_cfg_t adc_config_single = {
 /*==================[external data definition]===============================*/
 
 /*==================[internal functions definition]==========================*/
+/**
+ * @brief DMA frame completed ISR. Splits the frame conversions by channel into the rings.
+ */
+static bool IRAM_ATTR AdcContConvDone(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data){
+	const adc_digi_output_data_t *conv = (const adc_digi_output_data_t *)edata->conv_frame_buffer;
+	uint32_t n_conv = edata->size / SOC_ADC_DIGI_RESULT_BYTES;
+	for(uint32_t i = 0; i < n_conv; i++){
+		uint32_t chan = conv[i].type2.channel;
+		if(chan >= ADC_CHANNELS){
+			continue;
+		}
+		adc_cont_channel_t *ch = &adc_cont_ch[chan];
+		if(conv[i].type2.unit != ADC_UNIT_1 || !ch->running){
+			ch->invalid++;
+			continue;
+		}
+		// software decimation for rates below the unit minimum
+		if(ch->skip > 0){
+			ch->skip--;
+			continue;
+		}
+		ch->skip = adc_cont_decim - 1;
+		ch->blocks[ch->head % ADC_CONT_RING_BLOCKS][ch->fill++] = conv[i].type2.data;
+		if(ch->fill == ADC_CONT_BLOCK_SIZE){
+			ch->fill = 0;
+			// keep one free block for filling, otherwise the block is overwritten
+			if((ch->head - ch->tail) < (ADC_CONT_RING_BLOCKS - 1)){
+				ch->head++;
+				if(ch->func_p != NULL){
+					ch->func_p(ch->param_p);
+				}
+			}
+			else{
+				ch->overruns++;
+			}
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Rebuild the scan pattern with the running channels and restart the conversion.
+ * 
+ * When the scan rate is below SOC_ADC_SAMPLE_FREQ_THRES_LOW the unit runs an integer 
+ * number of times faster and the ISR keeps one conversion of every adc_cont_decim.
+ */
+static void AdcContUpdatePattern(void){
+	adc_digi_pattern_config_t pattern[ADC_CHANNELS];
+	uint32_t n_chan = 0;
+
+	if(adc_cont_started){
+		adc_continuous_stop(adc2_cont);
+		adc_cont_started = false;
+	}
+	for(uint8_t i = 0; i < ADC_CHANNELS; i++){
+		if(adc_cont_ch[i].running){
+			pattern[n_chan].atten = ADC_ATTENUATION;
+			pattern[n_chan].channel = i;			// ADC_CHANNEL_x matches CHx
+			pattern[n_chan].unit = ADC_UNIT_1;
+			pattern[n_chan].bit_width = ADC_BITWIDTH;
+			adc_cont_ch[i].skip = 0;
+			n_chan++;
+		}
+	}
+	if(n_chan == 0){
+		adc_cont_frec_applied = 0;
+		return;
+	}
+	uint32_t frec = adc_cont_frec * n_chan;
+	adc_cont_decim = 1;
+	if(frec < SOC_ADC_SAMPLE_FREQ_THRES_LOW){
+		adc_cont_decim = (SOC_ADC_SAMPLE_FREQ_THRES_LOW + frec - 1) / frec;
+		frec *= adc_cont_decim;
+	}
+	if(frec > SOC_ADC_SAMPLE_FREQ_THRES_HIGH){
+		frec = SOC_ADC_SAMPLE_FREQ_THRES_HIGH;
+	}
+	adc_cont_frec_applied = frec / (n_chan * adc_cont_decim);
+	adc_continuous_config_t dig_cfg = {
+		.pattern_num = n_chan,
+		.adc_pattern = pattern,
+		.sample_freq_hz = frec,
+		.conv_mode = ADC_CONV_SINGLE_UNIT_1,
+		.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
+	};
+	ESP_ERROR_CHECK(adc_continuous_config(adc2_cont, &dig_cfg));
+	ESP_ERROR_CHECK(adc_continuous_start(adc2_cont));
+	adc_cont_started = true;
+}
 
 /*==================[external functions definition]==========================*/
 
@@ -99,19 +220,30 @@ void AnalogInputInit(analog_input_config_t *config){
 			}
 		break;
 		case ADC_CONTINUOUS:
-			switch(config->input){
-				case CH0:
-
-				break;
-				case CH1:
-
-				break;
-				case CH2:
-
-				break;
-				case CH3:
-
-				break;
+			if(adc2_cont == NULL){
+				adc_continuous_handle_cfg_t handle_cfg = {
+					.max_store_buf_size = ADC_CONT_POOL_SIZE,
+					.conv_frame_size = ADC_CONT_FRAME_SIZE,
+					.flags.flush_pool = true,
+				};
+				ESP_ERROR_CHECK(adc_continuous_new_handle(&handle_cfg, &adc2_cont));
+				adc_continuous_evt_cbs_t cbs = {
+					.on_conv_done = AdcContConvDone,
+				};
+				ESP_ERROR_CHECK(adc_continuous_register_event_callbacks(adc2_cont, &cbs, NULL));
+			}
+			if(config->input < ADC_CHANNELS){
+				adc_cont_channel_t *ch = &adc_cont_ch[config->input];
+				ch->func_p = config->func_p;
+				ch->param_p = config->param_p;
+				ch->fill = 0;
+				ch->head = 0;
+				ch->tail = 0;
+				ch->overruns = 0;
+				ch->invalid = 0;
+				if(config->sample_frec != 0){
+					adc_cont_frec = config->sample_frec;
+				}
 			}
 		break;
 	}
@@ -145,15 +277,51 @@ void AnalogInputReadSingle(adc_ch_t channel, uint16_t *value){
 }
 
 void AnalogStartContinuous(adc_ch_t channel){
-
+	if(channel >= ADC_CHANNELS || adc2_cont == NULL || adc_cont_ch[channel].running){
+		return;
+	}
+	adc_cont_ch[channel].fill = 0;
+	adc_cont_ch[channel].skip = 0;
+	adc_cont_ch[channel].running = true;
+	AdcContUpdatePattern();
 }
 
 void AnalogStopContinuous(adc_ch_t channel){
+	if(channel >= ADC_CHANNELS || !adc_cont_ch[channel].running){
+		return;
+	}
+	adc_cont_ch[channel].running = false;
+	AdcContUpdatePattern();
+}
 
+uint16_t AnalogInputReadContinuous(adc_ch_t channel, uint16_t *values){
+	if(channel >= ADC_CHANNELS){
+		return 0;
+	}
+	adc_cont_channel_t *ch = &adc_cont_ch[channel];
+	if(ch->head == ch->tail){
+		return 0;
+	}
+	memcpy(values, ch->blocks[ch->tail % ADC_CONT_RING_BLOCKS], sizeof(ch->blocks[0]));
+	ch->tail++;
+	return ADC_CONT_BLOCK_SIZE;
 }
 
-void AnalogInputReadContinuous(adc_ch_t channel, uint16_t *values){
+uint8_t AnalogInputContinuousAvailable(adc_ch_t channel){
+	if(channel >= ADC_CHANNELS){
+		return 0;
+	}
+	return adc_cont_ch[channel].head - adc_cont_ch[channel].tail;
+}
 
+void AnalogInputGetStats(adc_ch_t channel, analog_cont_stats_t *stats){
+	if(channel >= ADC_CHANNELS){
+		return;
+	}
+	stats->blocks = adc_cont_ch[channel].head;
+	stats->overruns = adc_cont_ch[channel].overruns;
+	stats->invalid = adc_cont_ch[channel].invalid;
+	stats->sample_frec = adc_cont_ch[channel].running ? adc_cont_frec_applied : 0;
 }
 
 void AnalogOutputWrite(uint8_t value){
@@ -22,7 +22,16 @@
 #define PIN_NUM_CS1		GPIO_19	/*!<  */
 #define PIN_NUM_CS2		GPIO_18	/*!<  */
 #define PIN_NUM_CS3		GPIO_9	/*!<  */
+#define SPI_DEVICES		3		/*!< SPI_1, SPI_2 and SPI_3 */
 /*==================[internal data declaration]==============================*/
+/**
+ * @brief Preallocated transaction used by the asynchronous API
+ */
+typedef struct {
+	spi_transaction_t t;		/*!< esp-idf transaction, t.user points to this structure */
+	void *param;				/*!< Parameter for the pre transaction callback */
+} spi_async_trans_t;
+
 spi_device_handle_t spi_1, spi_2, spi_3;
 const spi_bus_config_t bus_cfg = {
     .miso_io_num = PIN_NUM_MISO,
@@ -30,7 +39,7 @@ const spi_bus_config_t bus_cfg = {
     .sclk_io_num = PIN_NUM_CLK,
     .quadwp_io_num = -1,
     .quadhd_io_num = -1,
-    .max_transfer_sz = 4092
+    .max_transfer_sz = SPI_MAX_TRANSFER_SIZE
 };
 transfer_mode_t transfer_mode_1, transfer_mode_2, transfer_mode_3;
 void (*spi_1_isr_p)(void*);	/*!<  */
@@ -39,6 +48,11 @@ void (*spi_3_isr_p)(void*);	/*!<  */
 void *spi_1_user_data;	    /*!<  */
 void *spi_2_user_data;	    /*!<  */
 void *spi_3_user_data;	    /*!<  */
+static void (*spi_pre_isr_p[SPI_DEVICES])(void*);					/*!< Pre transaction callbacks */
+static spi_mcu_config_t spi_cfg[SPI_DEVICES];						/*!< Configuration of each added device */
+static spi_async_trans_t spi_pool[SPI_DEVICES][SPI_QUEUE_SIZE];		/*!< Transactions pool of each device */
+static uint8_t spi_pool_next[SPI_DEVICES];							/*!< Next free transaction of the pool */
+static uint8_t spi_pool_pending[SPI_DEVICES];						/*!< Queued transactions not yet finished */
 /*==================[internal functions declaration]=========================*/
 static void IRAM_ATTR spi_1_isr(spi_transaction_t *t){
 	spi_1_isr_p(spi_1_user_data);
@@ -49,24 +63,100 @@ static void IRAM_ATTR spi_2_isr(spi_transaction_t *t){
 static void IRAM_ATTR spi_3_isr(spi_transaction_t *t){
 	spi_3_isr_p(spi_3_user_data);
 }
+static void IRAM_ATTR spi_1_pre_isr(spi_transaction_t *t){
+	if(t->user != NULL){
+		spi_pre_isr_p[SPI_1](((spi_async_trans_t *)t->user)->param);
+	}
+}
+static void IRAM_ATTR spi_2_pre_isr(spi_transaction_t *t){
+	if(t->user != NULL){
+		spi_pre_isr_p[SPI_2](((spi_async_trans_t *)t->user)->param);
+	}
+}
+static void IRAM_ATTR spi_3_pre_isr(spi_transaction_t *t){
+	if(t->user != NULL){
+		spi_pre_isr_p[SPI_3](((spi_async_trans_t *)t->user)->param);
+	}
+}
+static spi_device_handle_t SpiHandle(spi_dev_t device);
+static bool SpiSameConfig(const spi_mcu_config_t *a, const spi_mcu_config_t *b);
+static transfer_mode_t SpiTransferMode(spi_dev_t device);
+static void SpiTransmit(spi_dev_t device, spi_transaction_t *t);
 /*==================[internal data definition]===============================*/
 
 /*==================[external data definition]===============================*/
 
 /*==================[internal functions definition]==========================*/
+static spi_device_handle_t SpiHandle(spi_dev_t device){
+    switch(device){
+        case SPI_1:
+            return spi_1;
+        case SPI_2:
+            return spi_2;
+        case SPI_3:
+            return spi_3;
+    }
+    return NULL;
+}
+
+static bool SpiSameConfig(const spi_mcu_config_t *a, const spi_mcu_config_t *b){
+    return (a->clk_mode == b->clk_mode) && (a->bitrate == b->bitrate) &&
+        (a->transfer_mode == b->transfer_mode) && (a->func_p == b->func_p) &&
+        (a->param_p == b->param_p) && (a->pre_func_p == b->pre_func_p);
+}
+
+static transfer_mode_t SpiTransferMode(spi_dev_t device){
+    switch(device){
+        case SPI_1:
+            return transfer_mode_1;
+        case SPI_2:
+            return transfer_mode_2;
+        case SPI_3:
+            return transfer_mode_3;
+    }
+    return SPI_POLLING;
+}
+
+static void SpiTransmit(spi_dev_t device, spi_transaction_t *t){
+    spi_device_handle_t handle = SpiHandle(device);
+    if(handle == NULL){
+        return;
+    }
+    /* Polling transactions can't be mixed with queued ones */
+    SpiWaitAll(device);
+    switch(SpiTransferMode(device)){
+        case SPI_POLLING:
+            spi_device_polling_transmit(handle, t); 
+            break;
+        case SPI_INTERRUPT:
+            spi_device_transmit(handle, t); 
+            break;
+    }
+}
 
 /*==================[external functions definition]==========================*/
 uint8_t SpiInit(spi_mcu_config_t* spi){
     static bool spi_initialized = false;
+    if(spi->device >= SPI_DEVICES){
+        return 1;
+    }
     if(!spi_initialized){
 	    spi_bus_initialize(SPI2_HOST, &bus_cfg, SPI_DMA_CH_AUTO);
         spi_initialized = true;
+    }
+    /* Device already on the bus with the same configuration */
+    if(SpiHandle(spi->device) != NULL){
+        if(SpiSameConfig(&spi_cfg[spi->device], spi)){
+            return 0;
+        }
+        SpiDeInit(spi->device);
     }
 	spi_device_interface_config_t dev_cfg = {
         .clock_speed_hz = spi->bitrate,     	
         .mode = spi->clk_mode,                  
-        .queue_size = 8,                        
+        .queue_size = SPI_QUEUE_SIZE,                        
     };
+    spi_pre_isr_p[spi->device] = spi->pre_func_p;
     switch(spi->device){
         case SPI_1:
             dev_cfg.spics_io_num = PIN_NUM_CS1;
@@ -74,31 +164,43 @@ uint8_t SpiInit(spi_mcu_config_t* spi){
             if(transfer_mode_1 == SPI_INTERRUPT){
                 dev_cfg.post_cb = spi_1_isr;
             } 
+            if(spi->pre_func_p != NULL){
+                dev_cfg.pre_cb = spi_1_pre_isr;
+            }
             spi_bus_add_device(SPI2_HOST, &dev_cfg, &spi_1);
             spi_1_isr_p = spi->func_p;
             spi_1_user_data = spi->param_p;
             break;
         case SPI_2:
             dev_cfg.spics_io_num = PIN_NUM_CS2;
+            transfer_mode_2 = spi->transfer_mode;
             if(transfer_mode_2 == SPI_INTERRUPT){
                 dev_cfg.post_cb = spi_2_isr;
             } 
-            transfer_mode_1 = spi->transfer_mode;
+            if(spi->pre_func_p != NULL){
+                dev_cfg.pre_cb = spi_2_pre_isr;
+            }
             spi_bus_add_device(SPI2_HOST, &dev_cfg, &spi_2);
             spi_2_isr_p = spi->func_p;
             spi_2_user_data = spi->param_p;
             break;
         case SPI_3:
             dev_cfg.spics_io_num = PIN_NUM_CS3;
+            transfer_mode_3 = spi->transfer_mode;
             if(transfer_mode_3 == SPI_INTERRUPT){
                 dev_cfg.post_cb = spi_3_isr;
             } 
-            transfer_mode_1 = spi->transfer_mode;
+            if(spi->pre_func_p != NULL){
+                dev_cfg.pre_cb = spi_3_pre_isr;
+            }
             spi_bus_add_device(SPI2_HOST, &dev_cfg, &spi_3);
             spi_3_isr_p = spi->func_p;
             spi_3_user_data = spi->param_p;
             break;
     }
+    spi_cfg[spi->device] = *spi;
+    spi_pool_next[spi->device] = 0;
+    spi_pool_pending[spi->device] = 0;
     return 0;
 }
 
@@ -108,38 +210,7 @@ void SpiRead(spi_dev_t device, uint8_t * rx_buffer, uint32_t rx_buffer_size){
     t.length = rx_buffer_size * 8;  // tx_buffer_size is in bytes, transaction length is in bits.
     t.rxlength = rx_buffer_size * 8;
     t.rx_buffer = rx_buffer;        // Data
-    switch(device){
-        case SPI_1:
-            switch(transfer_mode_1){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_1, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_1, &t); 
-                    break;
-            }
-            break;
-        case SPI_2:
-            switch(transfer_mode_2){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_2, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_2, &t); 
-                    break;
-            }
-            break;
-        case SPI_3:
-            switch(transfer_mode_3){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_3, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_3, &t); 
-                    break;
-            }
-            break;
-    }
+    SpiTransmit(device, &t);
 }
 
 void SpiWrite(spi_dev_t device, uint8_t * tx_buffer, uint32_t tx_buffer_size){
@@ -147,38 +218,7 @@ void SpiWrite(spi_dev_t device, uint8_t * tx_buffer, uint32_t tx_buffer_size){
     memset(&t, 0, sizeof(t));       // Zero out the transaction
     t.length = tx_buffer_size * 8;  // tx_buffer_size is in bytes, transaction length is in bits.
     t.tx_buffer = tx_buffer;        // Data
-    switch(device){
-        case SPI_1:
-            switch(transfer_mode_1){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_1, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_1, &t); 
-                    break;
-            }
-            break;
-        case SPI_2:
-            switch(transfer_mode_2){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_2, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_2, &t); 
-                    break;
-            }
-            break;
-        case SPI_3:
-            switch(transfer_mode_3){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_3, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_3, &t); 
-                    break;
-            }
-            break;
-    }
+    SpiTransmit(device, &t);
 }
 
 void SpiReadWrite(spi_dev_t device, uint8_t * tx_buffer, uint8_t * rx_buffer, uint32_t buffer_size){
@@ -188,41 +228,72 @@ void SpiReadWrite(spi_dev_t device, uint8_t * tx_buffer, uint8_t * rx_buffer, ui
     t.rxlength = buffer_size * 8;
     t.tx_buffer = tx_buffer;        // Data
     t.rx_buffer = rx_buffer;        
+    SpiTransmit(device, &t);
+}
+
+void SpiWriteAsync(spi_dev_t device, const uint8_t * tx_buffer, uint32_t tx_buffer_size, void * trans_param){
+    spi_device_handle_t handle = SpiHandle(device);
+    spi_transaction_t *done;
+    uint32_t chunk;
+    if(handle == NULL){
+        return;
+    }
+    while(tx_buffer_size > 0){
+        /* Pool exhausted: recycle the oldest transaction (they finish in order) */
+        if(spi_pool_pending[device] == SPI_QUEUE_SIZE){
+            spi_device_get_trans_result(handle, &done, portMAX_DELAY);
+            spi_pool_pending[device]--;
+        }
+        chunk = (tx_buffer_size > SPI_MAX_TRANSFER_SIZE) ? SPI_MAX_TRANSFER_SIZE : tx_buffer_size;
+        spi_async_trans_t *trans = &spi_pool[device][spi_pool_next[device]];
+        memset(&trans->t, 0, sizeof(trans->t));
+        trans->t.length = chunk * 8;
+        trans->t.tx_buffer = tx_buffer;
+        trans->t.user = trans;
+        trans->param = trans_param;
+        spi_device_queue_trans(handle, &trans->t, portMAX_DELAY);
+        spi_pool_next[device] = (spi_pool_next[device] + 1) % SPI_QUEUE_SIZE;
+        spi_pool_pending[device]++;
+        tx_buffer += chunk;
+        tx_buffer_size -= chunk;
+    }
+}
+
+void SpiWaitAll(spi_dev_t device){
+    SpiWaitQueued(device, 0);
+}
+
+void SpiWaitQueued(spi_dev_t device, uint8_t max_pending){
+    spi_device_handle_t handle = SpiHandle(device);
+    spi_transaction_t *done;
+    if(handle == NULL){
+        return;
+    }
+    while(spi_pool_pending[device] > max_pending){
+        spi_device_get_trans_result(handle, &done, portMAX_DELAY);
+        spi_pool_pending[device]--;
+    }
+}
+
+uint8_t SpiDeInit(spi_dev_t device){
+    spi_device_handle_t handle = SpiHandle(device);
+    if(handle == NULL){
+        return 0;
+    }
+    SpiWaitAll(device);
+    spi_bus_remove_device(handle);
     switch(device){
         case SPI_1:
-            switch(transfer_mode_1){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_1, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_1, &t); 
-                    break;
-            }
+            spi_1 = NULL;
             break;
         case SPI_2:
-            switch(transfer_mode_2){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_2, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_2, &t); 
-                    break;
-            }
+            spi_2 = NULL;
             break;
         case SPI_3:
-            switch(transfer_mode_3){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_3, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_3, &t); 
-                    break;
-            }
+            spi_3 = NULL;
             break;
     }
-}
-
-uint8_t SpiDeInit(spi_dev_t device){
+    memset(&spi_cfg[device], 0, sizeof(spi_mcu_config_t));
     return 0;
 }
 
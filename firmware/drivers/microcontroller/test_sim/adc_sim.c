@@ -0,0 +1,125 @@
+// Host emulation of the esp-idf ADC and SDM drivers used by analog_io_mcu.c.
+// The continuous driver keeps the last configuration and forwards the frames
+// pushed by the test to the registered conversion done callback.
+
+#include <string.h>
+#include "driver/sdm.h"
+#include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "esp_adc/adc_continuous.h"
+
+static int sim_handle;
+static adc_continuous_handle_cfg_t sim_hdl_cfg;
+static adc_continuous_config_t sim_cfg;
+static adc_digi_pattern_config_t sim_pattern[8];
+static adc_continuous_evt_cbs_t sim_cbs;
+static void *sim_user_data;
+static bool sim_running;
+
+esp_err_t sdm_new_channel(const sdm_config_t *config, sdm_channel_handle_t *ret_chan)
+{
+    *ret_chan = (sdm_channel_handle_t)&sim_handle;
+    return ESP_OK;
+}
+
+esp_err_t sdm_channel_enable(sdm_channel_handle_t chan)
+{
+    return ESP_OK;
+}
+
+esp_err_t sdm_channel_set_pulse_density(sdm_channel_handle_t chan, int8_t density)
+{
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_new_unit(const adc_oneshot_unit_init_cfg_t *init_config, adc_oneshot_unit_handle_t *ret_unit)
+{
+    *ret_unit = (adc_oneshot_unit_handle_t)&sim_handle;
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_config_channel(adc_oneshot_unit_handle_t handle, adc_channel_t channel, const adc_oneshot_chan_cfg_t *config)
+{
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_read(adc_oneshot_unit_handle_t handle, adc_channel_t chan, int *out_raw)
+{
+    *out_raw = 0;
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_create_scheme_curve_fitting(const adc_cali_curve_fitting_config_t *config, adc_cali_handle_t *ret_handle)
+{
+    *ret_handle = (adc_cali_handle_t)&sim_handle;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_new_handle(const adc_continuous_handle_cfg_t *hdl_config, adc_continuous_handle_t *ret_handle)
+{
+    if (hdl_config->conv_frame_size % SOC_ADC_DIGI_RESULT_BYTES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sim_hdl_cfg = *hdl_config;
+    *ret_handle = (adc_continuous_handle_t)&sim_handle;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_config(adc_continuous_handle_t handle, const adc_continuous_config_t *config)
+{
+    if (sim_running || config->pattern_num > 8 ||
+            config->sample_freq_hz < SOC_ADC_SAMPLE_FREQ_THRES_LOW ||
+            config->sample_freq_hz > SOC_ADC_SAMPLE_FREQ_THRES_HIGH) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    sim_cfg = *config;
+    memcpy(sim_pattern, config->adc_pattern, config->pattern_num * sizeof(adc_digi_pattern_config_t));
+    sim_cfg.adc_pattern = sim_pattern;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_register_event_callbacks(adc_continuous_handle_t handle, const adc_continuous_evt_cbs_t *cbs, void *user_data)
+{
+    sim_cbs = *cbs;
+    sim_user_data = user_data;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_start(adc_continuous_handle_t handle)
+{
+    if (sim_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    sim_running = true;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_stop(adc_continuous_handle_t handle)
+{
+    if (!sim_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    sim_running = false;
+    return ESP_OK;
+}
+
+const adc_continuous_config_t *adc_continuous_sim_config(void)
+{
+    return &sim_cfg;
+}
+
+bool adc_continuous_sim_running(void)
+{
+    return sim_running;
+}
+
+void adc_continuous_sim_push_frame(const uint8_t *frame, uint32_t size)
+{
+    adc_continuous_evt_data_t edata = {
+        .conv_frame_buffer = (uint8_t *)frame,
+        .size = size,
+    };
+    if (sim_running && sim_cbs.on_conv_done) {
+        sim_cbs.on_conv_done((adc_continuous_handle_t)&sim_handle, &edata, sim_user_data);
+    }
+}
@@ -0,0 +1,15 @@
+// Host emulation of delay_mcu: delays return immediately.
+
+#include "delay_mcu.h"
+
+void DelaySec(uint16_t sec)
+{
+}
+
+void DelayMs(uint16_t msec)
+{
+}
+
+void DelayUs(uint16_t usec)
+{
+}
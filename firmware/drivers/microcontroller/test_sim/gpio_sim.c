@@ -0,0 +1,25 @@
+// Host emulation of gpio_mcu: keeps the pin levels in memory.
+
+#include "gpio_mcu.h"
+
+bool gpio_sim_level[GPIO_23 + 1];
+
+void GPIOInit(gpio_t pin, io_t io)
+{
+    gpio_sim_level[pin] = false;
+}
+
+void GPIOOn(gpio_t pin)
+{
+    gpio_sim_level[pin] = true;
+}
+
+void GPIOOff(gpio_t pin)
+{
+    gpio_sim_level[pin] = false;
+}
+
+void GPIOState(gpio_t pin, bool state)
+{
+    gpio_sim_level[pin] = state;
+}
@@ -0,0 +1,8 @@
+// Host build placeholder for the esp-idf general purpose timer driver
+
+#ifndef _driver_gptimer_h_
+#define _driver_gptimer_h_
+
+#include "esp_err.h"
+
+#endif // _driver_gptimer_h_
@@ -0,0 +1,25 @@
+// Host build emulation of the esp-idf sigma-delta modulator driver
+
+#ifndef _driver_sdm_h_
+#define _driver_sdm_h_
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef struct sdm_channel_t *sdm_channel_handle_t;
+
+typedef enum {
+    SDM_CLK_SRC_DEFAULT,
+} sdm_clock_source_t;
+
+typedef struct {
+    int gpio_num;
+    sdm_clock_source_t clk_src;
+    uint32_t sample_rate_hz;
+} sdm_config_t;
+
+esp_err_t sdm_new_channel(const sdm_config_t *config, sdm_channel_handle_t *ret_chan);
+esp_err_t sdm_channel_enable(sdm_channel_handle_t chan);
+esp_err_t sdm_channel_set_pulse_density(sdm_channel_handle_t chan, int8_t density);
+
+#endif // _driver_sdm_h_
@@ -0,0 +1,81 @@
+// Host build emulation of the esp-idf SPI master driver.
+// Transactions are executed (recorded) when queued and their results are
+// returned in order by spi_device_get_trans_result().
+
+#ifndef _driver_spi_master_h_
+#define _driver_spi_master_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_attr.h"
+
+#define portMAX_DELAY 0xFFFFFFFF
+
+typedef enum {
+    SPI1_HOST,
+    SPI2_HOST,
+} spi_host_device_t;
+
+typedef enum {
+    SPI_DMA_DISABLED,
+    SPI_DMA_CH_AUTO = 3,
+} spi_dma_chan_t;
+
+typedef struct {
+    int mosi_io_num;
+    int miso_io_num;
+    int sclk_io_num;
+    int quadwp_io_num;
+    int quadhd_io_num;
+    int max_transfer_sz;
+} spi_bus_config_t;
+
+typedef struct spi_transaction_t spi_transaction_t;
+typedef void (*transaction_cb_t)(spi_transaction_t *trans);
+
+typedef struct {
+    uint8_t mode;
+    int clock_speed_hz;
+    int spics_io_num;
+    int queue_size;
+    transaction_cb_t pre_cb;
+    transaction_cb_t post_cb;
+} spi_device_interface_config_t;
+
+struct spi_transaction_t {
+    uint32_t flags;
+    size_t length;
+    size_t rxlength;
+    void *user;
+    const void *tx_buffer;
+    void *rx_buffer;
+};
+
+typedef struct spi_device_t *spi_device_handle_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host_id, const spi_bus_config_t *bus_config, spi_dma_chan_t dma_chan);
+esp_err_t spi_bus_add_device(spi_host_device_t host_id, const spi_device_interface_config_t *dev_config, spi_device_handle_t *handle);
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle);
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc);
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc);
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans_desc, uint32_t ticks_to_wait);
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans_desc, uint32_t ticks_to_wait);
+
+/* Simulation only */
+typedef struct {
+    uint32_t devices_added;         /*!< spi_bus_add_device calls */
+    uint32_t transactions;          /*!< Transactions executed */
+    uint32_t queued;                /*!< Transactions executed through the queue */
+    uint32_t bytes;                 /*!< Bytes sent */
+    uint32_t max_transaction;       /*!< Largest transaction in bytes */
+    uint32_t max_in_flight;         /*!< Maximum queued transactions without result */
+    uint32_t in_flight;             /*!< Queued transactions without result */
+} spi_sim_stats_t;
+
+extern spi_sim_stats_t spi_sim_stats;
+/* Called for every byte sent, in bus order */
+extern void (*spi_sim_byte_hook)(uint8_t byte);
+
+#endif // _driver_spi_master_h_
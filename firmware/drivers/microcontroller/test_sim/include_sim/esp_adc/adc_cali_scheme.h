@@ -0,0 +1,19 @@
+// Host build emulation of the esp-idf ADC calibration schemes
+
+#ifndef _esp_adc_adc_cali_scheme_h_
+#define _esp_adc_adc_cali_scheme_h_
+
+#include "esp_adc/adc_oneshot.h"
+
+typedef struct adc_cali_scheme_t *adc_cali_handle_t;
+
+typedef struct {
+    adc_unit_t unit_id;
+    adc_channel_t chan;
+    adc_atten_t atten;
+    adc_bitwidth_t bitwidth;
+} adc_cali_curve_fitting_config_t;
+
+esp_err_t adc_cali_create_scheme_curve_fitting(const adc_cali_curve_fitting_config_t *config, adc_cali_handle_t *ret_handle);
+
+#endif // _esp_adc_adc_cali_scheme_h_
@@ -0,0 +1,8 @@
+// This file include defenitions that are emulate esp-idf attributes for host builds
+
+#ifndef _esp_attr_h_
+#define _esp_attr_h_
+
+#define IRAM_ATTR
+
+#endif // _esp_attr_h_
@@ -0,0 +1,25 @@
+// This file include defenitions that are emulate esp-idf error codes for host builds
+
+#ifndef _esp_err_h_
+#define _esp_err_h_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK                  0
+#define ESP_FAIL                -1
+#define ESP_ERR_INVALID_ARG     0x102
+#define ESP_ERR_INVALID_STATE   0x103
+#define ESP_ERR_TIMEOUT         0x107
+
+#define ESP_ERROR_CHECK(x) do {                                         \
+        esp_err_t err_rc_ = (x);                                        \
+        if (err_rc_ != ESP_OK) {                                        \
+            printf("ESP_ERROR_CHECK failed: %s:%d 0x%x\n", __FILE__, __LINE__, err_rc_); \
+            abort();                                                    \
+        }                                                               \
+    } while(0)
+
+#endif // _esp_err_h_
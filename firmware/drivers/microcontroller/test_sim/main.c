@@ -0,0 +1,18 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+int test_analog_io_continuous();
+int test_spi_async();
+int test_ili9341_buffered();
+
+int main(void)
+{
+    int errors = 0;
+    printf("main starts!\n");
+    errors += test_analog_io_continuous();
+    errors += test_spi_async();
+    errors += test_ili9341_buffered();
+
+    printf("Test done, %i error(s)\n", errors);
+    return errors != 0;
+}
@@ -0,0 +1,112 @@
+// Host emulation of the esp-idf SPI master driver used by spi_mcu.c.
+
+#include <string.h>
+#include "driver/spi_master.h"
+
+#define SIM_MAX_DEVICES 6
+#define SIM_QUEUE_SIZE  16
+
+typedef struct spi_device_t {
+    bool used;
+    spi_device_interface_config_t cfg;
+    spi_transaction_t *queue[SIM_QUEUE_SIZE];
+    int head;
+    int count;
+} sim_device_t;
+
+static sim_device_t sim_devices[SIM_MAX_DEVICES];
+spi_sim_stats_t spi_sim_stats;
+void (*spi_sim_byte_hook)(uint8_t byte);
+
+static void SimExecute(spi_device_handle_t handle, spi_transaction_t *t)
+{
+    uint32_t bytes = t->length / 8;
+    if (handle->cfg.pre_cb) {
+        handle->cfg.pre_cb(t);
+    }
+    spi_sim_stats.transactions++;
+    spi_sim_stats.bytes += bytes;
+    if (bytes > spi_sim_stats.max_transaction) {
+        spi_sim_stats.max_transaction = bytes;
+    }
+    if (spi_sim_byte_hook && t->tx_buffer) {
+        for (uint32_t i = 0; i < bytes; i++) {
+            spi_sim_byte_hook(((const uint8_t *)t->tx_buffer)[i]);
+        }
+    }
+    if (handle->cfg.post_cb) {
+        handle->cfg.post_cb(t);
+    }
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host_id, const spi_bus_config_t *bus_config, spi_dma_chan_t dma_chan)
+{
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host_id, const spi_device_interface_config_t *dev_config, spi_device_handle_t *handle)
+{
+    for (int i = 0; i < SIM_MAX_DEVICES; i++) {
+        if (!sim_devices[i].used) {
+            memset(&sim_devices[i], 0, sizeof(sim_device_t));
+            sim_devices[i].used = true;
+            sim_devices[i].cfg = *dev_config;
+            *handle = &sim_devices[i];
+            spi_sim_stats.devices_added++;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle)
+{
+    if (handle->count) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->used = false;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc)
+{
+    return spi_device_polling_transmit(handle, trans_desc);
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc)
+{
+    if (handle->count) {
+        // esp-idf refuses polling transactions while queued ones are pending
+        return ESP_ERR_INVALID_STATE;
+    }
+    SimExecute(handle, trans_desc);
+    return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans_desc, uint32_t ticks_to_wait)
+{
+    if (handle->count >= handle->cfg.queue_size || (int)(trans_desc->length / 8) > 4092) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    SimExecute(handle, trans_desc);
+    handle->queue[(handle->head + handle->count) % SIM_QUEUE_SIZE] = trans_desc;
+    handle->count++;
+    spi_sim_stats.queued++;
+    spi_sim_stats.in_flight++;
+    if (handle->count > spi_sim_stats.max_in_flight) {
+        spi_sim_stats.max_in_flight = handle->count;
+    }
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans_desc, uint32_t ticks_to_wait)
+{
+    if (handle->count == 0) {
+        return ESP_ERR_TIMEOUT;
+    }
+    *trans_desc = handle->queue[handle->head];
+    handle->head = (handle->head + 1) % SIM_QUEUE_SIZE;
+    handle->count--;
+    spi_sim_stats.in_flight--;
+    return ESP_OK;
+}
@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "analog_io_mcu.h"
+#include "esp_adc/adc_continuous.h"
+
+#define FRAME_CONV 256
+
+static adc_digi_output_data_t frame[FRAME_CONV];
+static uint16_t block[ADC_CONT_BLOCK_SIZE];
+static uint32_t sample_count[4];
+static int block_events[4];
+
+static void BlockDone(void *param)
+{
+    block_events[*(int *)param]++;
+}
+
+// Fake frame source: scans the configured pattern, each channel carries a
+// ramp starting at channel * 1000 so the samples can be checked after demux.
+static void PushFrame(int n_conv)
+{
+    const adc_continuous_config_t *cfg = adc_continuous_sim_config();
+    for (int i = 0; i < n_conv; i++) {
+        uint8_t ch = cfg->adc_pattern[i % cfg->pattern_num].channel;
+        frame[i].val = 0;
+        frame[i].type2.channel = ch;
+        frame[i].type2.unit = 0;
+        frame[i].type2.data = (ch * 1000 + sample_count[ch]++) & 0xFFF;
+    }
+    adc_continuous_sim_push_frame((uint8_t *)frame, n_conv * sizeof(adc_digi_output_data_t));
+}
+
+static int CheckBlock(int ch, uint32_t first)
+{
+    for (int i = 0; i < ADC_CONT_BLOCK_SIZE; i++) {
+        if (block[i] != ((ch * 1000 + first + i) & 0xFFF)) {
+            printf("ERROR CH%i sample[%i]: %i, expect = %i\n", ch, i, block[i], (int)((ch * 1000 + first + i) & 0xFFF));
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int test_analog_io_continuous()
+{
+    static int ids[4] = {0, 1, 2, 3};
+    int errors = 0;
+    analog_cont_stats_t stats;
+
+    for (int ch = CH0; ch <= CH3; ch++) {
+        analog_input_config_t cfg = {
+            .input = ch,
+            .mode = ADC_CONTINUOUS,
+            .func_p = BlockDone,
+            .param_p = &ids[ch],
+            .sample_frec = 1000,
+        };
+        AnalogInputInit(&cfg);
+    }
+    AnalogStartContinuous(CH0);
+    AnalogStartContinuous(CH2);
+    const adc_continuous_config_t *cfg = adc_continuous_sim_config();
+    if (!adc_continuous_sim_running() || cfg->pattern_num != 2 || cfg->sample_freq_hz != 2000) {
+        printf("ERROR pattern: %i channels at %i Hz\n", (int)cfg->pattern_num, (int)cfg->sample_freq_hz);
+        errors++;
+    }
+
+    // 256 conversions over 2 channels complete exactly one block per channel
+    PushFrame(FRAME_CONV);
+    if (block_events[0] != 1 || block_events[2] != 1 || block_events[1] != 0) {
+        printf("ERROR callbacks: %i %i %i\n", block_events[0], block_events[1], block_events[2]);
+        errors++;
+    }
+    if (AnalogInputReadContinuous(CH0, block) != ADC_CONT_BLOCK_SIZE) {
+        printf("ERROR CH0 block not ready\n");
+        errors++;
+    }
+    errors += CheckBlock(CH0, 0);
+    if (AnalogInputReadContinuous(CH0, block) != 0) {
+        printf("ERROR CH0 ring should be empty\n");
+        errors++;
+    }
+    errors += (AnalogInputReadContinuous(CH2, block) != ADC_CONT_BLOCK_SIZE);
+    errors += CheckBlock(CH2, 0);
+
+    // Odd frame sizes must keep the per channel sequence continuous
+    PushFrame(100);
+    PushFrame(156);
+    errors += (AnalogInputReadContinuous(CH0, block) != ADC_CONT_BLOCK_SIZE);
+    errors += CheckBlock(CH0, ADC_CONT_BLOCK_SIZE);
+
+    // Fill CH2 ring without reading: one block is kept for filling, the rest overrun
+    for (int i = 0; i < ADC_CONT_RING_BLOCKS + 2; i++) {
+        PushFrame(FRAME_CONV);
+    }
+    AnalogInputGetStats(CH2, &stats);
+    if (AnalogInputContinuousAvailable(CH2) != ADC_CONT_RING_BLOCKS - 1 || stats.overruns != 4) {
+        printf("ERROR CH2 available = %i, overruns = %i\n", AnalogInputContinuousAvailable(CH2), (int)stats.overruns);
+        errors++;
+    }
+    // Oldest kept block is the second one pushed, right after the one already read
+    errors += (AnalogInputReadContinuous(CH2, block) != ADC_CONT_BLOCK_SIZE);
+    errors += CheckBlock(CH2, ADC_CONT_BLOCK_SIZE);
+
+    // Removing a channel reconfigures the pattern, stopping all stops the unit
+    AnalogStopContinuous(CH0);
+    if (!adc_continuous_sim_running() || cfg->pattern_num != 1 || cfg->adc_pattern[0].channel != CH2) {
+        printf("ERROR pattern after stop CH0\n");
+        errors++;
+    }
+    AnalogStopContinuous(CH2);
+    if (adc_continuous_sim_running()) {
+        printf("ERROR unit still running\n");
+        errors++;
+    }
+
+    // 500 Hz on one channel is below the unit minimum: 1000 Hz, one conversion of every two kept
+    analog_input_config_t slow = {
+        .input = CH1,
+        .mode = ADC_CONTINUOUS,
+        .func_p = BlockDone,
+        .param_p = &ids[CH1],
+        .sample_frec = 500,
+    };
+    AnalogInputInit(&slow);
+    AnalogStartContinuous(CH1);
+    AnalogInputGetStats(CH1, &stats);
+    if (cfg->sample_freq_hz != 1000 || stats.sample_frec != 500) {
+        printf("ERROR slow rate: unit at %i Hz, channel at %i Hz\n", (int)cfg->sample_freq_hz, (int)stats.sample_frec);
+        errors++;
+    }
+    PushFrame(FRAME_CONV);
+    if (AnalogInputReadContinuous(CH1, block) != ADC_CONT_BLOCK_SIZE) {
+        printf("ERROR CH1 block not ready\n");
+        errors++;
+    }
+    for (int i = 0; i < ADC_CONT_BLOCK_SIZE; i++) {
+        if (block[i] != 1000 + 2 * i) {
+            printf("ERROR CH1 decimated sample[%i]: %i, expect = %i\n", i, block[i], 1000 + 2 * i);
+            errors++;
+            break;
+        }
+    }
+
+    // Above the unit maximum the rate is limited and reported
+    slow.sample_frec = 50000;
+    AnalogInputInit(&slow);
+    AnalogStartContinuous(CH3);
+    AnalogInputGetStats(CH1, &stats);
+    if (cfg->sample_freq_hz != SOC_ADC_SAMPLE_FREQ_THRES_HIGH || stats.sample_frec != SOC_ADC_SAMPLE_FREQ_THRES_HIGH / 2) {
+        printf("ERROR fast rate: unit at %i Hz, channel at %i Hz\n", (int)cfg->sample_freq_hz, (int)stats.sample_frec);
+        errors++;
+    }
+    AnalogStopContinuous(CH1);
+    AnalogStopContinuous(CH3);
+    AnalogInputGetStats(CH1, &stats);
+    errors += (stats.sample_frec != 0);
+    if (errors == 0) {
+        printf("Test Correct!\n");
+    }
+    return errors;
+}
@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ili9341.h"
+#include "gpio_mcu.h"
+#include "driver/spi_master.h"
+
+#define DC_PIN  GPIO_3
+#define RST_PIN GPIO_5
+
+extern bool gpio_sim_level[];
+
+// Panel emulator: decodes the SPI byte stream (DC low = command) into LCD memory
+static uint16_t panel[ILI9341_HEIGHT][ILI9341_WIDTH];
+static uint8_t cmd, params[4];
+static int n_params;
+static uint16_t col0, col1, page0, page1, cur_x, cur_y;
+static int pixel_byte = -1;
+
+static void PanelByte(uint8_t byte)
+{
+    if (!gpio_sim_level[DC_PIN]) {
+        cmd = byte;
+        n_params = 0;
+        if (cmd == 0x2C) {
+            cur_x = col0;
+            cur_y = page0;
+            pixel_byte = -1;
+        }
+        return;
+    }
+    switch (cmd) {
+    case 0x2A:
+    case 0x2B:
+        if (n_params < 4) {
+            params[n_params++] = byte;
+        }
+        if (n_params == 4) {
+            if (cmd == 0x2A) {
+                col0 = (params[0] << 8) | params[1];
+                col1 = (params[2] << 8) | params[3];
+            } else {
+                page0 = (params[0] << 8) | params[1];
+                page1 = (params[2] << 8) | params[3];
+            }
+        }
+        break;
+    case 0x2C:
+        if (pixel_byte < 0) {
+            pixel_byte = byte;
+            break;
+        }
+        if (cur_x < ILI9341_WIDTH && cur_y < ILI9341_HEIGHT) {
+            panel[cur_y][cur_x] = (pixel_byte << 8) | byte;
+        }
+        pixel_byte = -1;
+        if (++cur_x > col1) {
+            cur_x = col0;
+            if (++cur_y > page1) {
+                cur_y = page0;
+            }
+        }
+        break;
+    }
+}
+
+static void DrawDashboard(uint32_t value)
+{
+    ILI9341DrawFilledRectangle(10, 10, 229, 60, ILI9341_NAVY);
+    ILI9341DrawString(20, 25, "ECG monitor", &font_11, ILI9341_WHITE, ILI9341_NAVY);
+    ILI9341DrawRectangle(5, 70, 234, 200, ILI9341_BLACK);
+    for (int i = 0; i < 10; i++) {
+        ILI9341DrawLine(10 + i * 22, 190 - (i % 3) * 40, 32 + i * 22, 190 - ((i + 1) % 3) * 40, ILI9341_RED);
+    }
+    ILI9341DrawCircle(120, 260, 40, ILI9341_DARKGREEN);
+    ILI9341DrawFilledCircle(120, 260, 10, ILI9341_ORANGE);
+    ILI9341DrawInt(150, 300, value, 3, &font_11, ILI9341_BLACK, ILI9341_WHITE);
+    ILI9341DrawPixel(0, 319, ILI9341_MAGENTA);
+}
+
+static uint32_t BusBytes(void)
+{
+    return spi_sim_stats.bytes;
+}
+
+static int frame_bands, overlapped_bands;
+
+// Buffered frame: the dashboard is drawn once per band
+static uint32_t DrawBuffered(uint32_t value)
+{
+    frame_bands = 0;
+    overlapped_bands = 0;
+    ILI9341BeginFrame(ILI9341_WHITE);
+    do {
+        // The previous band must still be on the bus while this one is rendered
+        frame_bands++;
+        if (spi_sim_stats.in_flight > 0) {
+            overlapped_bands++;
+        }
+        DrawDashboard(value);
+    } while (ILI9341NextBand());
+    return ILI9341FrameBytes();
+}
+
+int test_ili9341_buffered()
+{
+    static uint16_t ref_first[ILI9341_HEIGHT][ILI9341_WIDTH];
+    static uint16_t ref_update[ILI9341_HEIGHT][ILI9341_WIDTH];
+    // 10 rows are rounded to 12: the last band is shorter
+    const uint16_t band_heights[] = {16, 10};
+    int errors = 0;
+    uint32_t start, direct_bytes, frame_bytes, update_bytes, flushed;
+
+    spi_sim_byte_hook = PanelByte;
+    ILI9341Init(SPI_2, DC_PIN, RST_PIN);
+
+    // Direct mode references: first frame, then a frame where only the number changes
+    start = BusBytes();
+    DrawDashboard(123);
+    direct_bytes = BusBytes() - start;
+    memcpy(ref_first, panel, sizeof(panel));
+    DrawDashboard(124);
+    memcpy(ref_update, panel, sizeof(panel));
+
+    for (int h = 0; h < sizeof(band_heights) / sizeof(band_heights[0]); h++) {
+        // Same frames band by band, from a screen that doesn't match
+        ILI9341Fill(ILI9341_BLACK);
+        if (!ILI9341SetRenderMode(ILI9341_BUFFERED, band_heights[h])) {
+            printf("ERROR band buffers allocation\n");
+            return 1;
+        }
+        start = BusBytes();
+        flushed = DrawBuffered(123);
+        frame_bytes = BusBytes() - start;
+        if (flushed != ILI9341_WIDTH * ILI9341_HEIGHT * 2) {
+            printf("ERROR first frame must send the whole screen: %i\n", (int)flushed);
+            errors++;
+        }
+        if (memcmp(ref_first, panel, sizeof(panel)) != 0) {
+            printf("ERROR buffered frame differs from direct frame\n");
+            errors++;
+        }
+        // Every band of the first frame is sent: all but the first render during a transfer
+        if (overlapped_bands < frame_bands - 1) {
+            printf("ERROR %i of %i bands rendered while the previous one was sent\n", overlapped_bands, frame_bands);
+            errors++;
+        }
+
+        // Full redraw where only the number changes: only the digits reach the bus
+        start = BusBytes();
+        flushed = DrawBuffered(124);
+        update_bytes = BusBytes() - start;
+        if (memcmp(ref_update, panel, sizeof(panel)) != 0) {
+            printf("ERROR buffered update differs from direct update\n");
+            errors++;
+        }
+
+        // Same frame again: nothing is sent
+        start = BusBytes();
+        if ((DrawBuffered(124) != 0) || (BusBytes() != start)) {
+            printf("ERROR frame without changes sent data\n");
+            errors++;
+        }
+
+        printf("Bus bytes, bands of %i rows: direct frame %i, buffered first frame %i, buffered redraw with one changed number %i (%i pixel bytes)\n",
+               (int)band_heights[h], (int)direct_bytes, (int)frame_bytes, (int)update_bytes, (int)flushed);
+        if (update_bytes * 20 > direct_bytes) {
+            printf("ERROR redraw should cost a small fraction of direct drawing\n");
+            errors++;
+        }
+        ILI9341SetRenderMode(ILI9341_DIRECT, 0);
+    }
+    ILI9341DeInit();
+    spi_sim_byte_hook = NULL;
+    if (errors == 0) {
+        printf("Test Correct!\n");
+    }
+    return errors;
+}
@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "spi_mcu.h"
+#include "driver/spi_master.h"
+
+static uint8_t tx[10000];
+static int pre_calls;
+
+static void PreTrans(void *param)
+{
+    pre_calls += (param == tx);
+}
+
+int test_spi_async()
+{
+    int errors = 0;
+    spi_mcu_config_t cfg = {
+        .device = SPI_1,
+        .clk_mode = MODE0,
+        .bitrate = 20000000,
+        .transfer_mode = SPI_POLLING,
+        .func_p = NULL,
+        .param_p = NULL,
+        .pre_func_p = PreTrans,
+    };
+
+    memset(&spi_sim_stats, 0, sizeof(spi_sim_stats));
+    // Repeated init with the same configuration keeps the device handle
+    for (int i = 0; i < 100; i++) {
+        SpiInit(&cfg);
+    }
+    if (spi_sim_stats.devices_added != 1) {
+        printf("ERROR devices added: %i\n", (int)spi_sim_stats.devices_added);
+        errors++;
+    }
+
+    // Large buffers are split in max size transactions
+    SpiWriteAsync(SPI_1, tx, sizeof(tx), tx);
+    if (spi_sim_stats.queued != 3 || spi_sim_stats.max_transaction != SPI_MAX_TRANSFER_SIZE ||
+            spi_sim_stats.bytes != sizeof(tx) || pre_calls != 3) {
+        printf("ERROR async split: %i transactions, max %i bytes, %i total, %i pre callbacks\n",
+               (int)spi_sim_stats.queued, (int)spi_sim_stats.max_transaction, (int)spi_sim_stats.bytes, pre_calls);
+        errors++;
+    }
+
+    // The pool is recycled when more transactions than its size are queued
+    for (int i = 0; i < 3 * SPI_QUEUE_SIZE; i++) {
+        SpiWriteAsync(SPI_1, tx, 16, NULL);
+    }
+    if (spi_sim_stats.max_in_flight != SPI_QUEUE_SIZE) {
+        printf("ERROR in flight: %i\n", (int)spi_sim_stats.max_in_flight);
+        errors++;
+    }
+
+    // Blocking transfers wait for the queue, otherwise esp-idf rejects them
+    uint32_t before = spi_sim_stats.transactions;
+    SpiWrite(SPI_1, tx, 4);
+    if (spi_sim_stats.transactions != before + 1) {
+        printf("ERROR blocking write after async was not executed\n");
+        errors++;
+    }
+    SpiWaitAll(SPI_1);
+
+    // A new configuration re-adds the device
+    cfg.bitrate = 10000000;
+    SpiInit(&cfg);
+    if (spi_sim_stats.devices_added != 2) {
+        printf("ERROR reconfigure devices added: %i\n", (int)spi_sim_stats.devices_added);
+        errors++;
+    }
+    SpiDeInit(SPI_1);
+    if (errors == 0) {
+        printf("Test Correct!\n");
+    }
+    return errors;
+}
@@ -28,6 +28,7 @@ extern "C"
 #include "dsps_dotprod.h"
 #include "dsps_math.h"
 #include "dsps_fir.h"
+#include "dsps_fir_gen.h"
 #include "dsps_biquad.h"
 #include "dsps_biquad_gen.h"
 #include "dsps_wind.h"
@@ -60,6 +61,7 @@ extern "C"
 
 #ifdef __cplusplus
 #include "mat.h"
+#include "mat_n.h"
 #endif
 
 #endif // _esp_dsp_H_
@@ -21,6 +21,7 @@
 typedef int esp_err_t;
 
 #define ESP_OK 0
+#define ESP_ERR_NO_MEM 0x101
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
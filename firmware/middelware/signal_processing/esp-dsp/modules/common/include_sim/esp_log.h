@@ -19,6 +19,12 @@
 
 #include <stdlib.h>
 
+#include <stdio.h>
+
 #define ESP_LOGD
+#define ESP_LOGV(tag, format, ...)
+#define ESP_LOGI(tag, format, ...) printf("I %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) printf("W %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGE(tag, format, ...) printf("E %s: " format "\n", tag, ##__VA_ARGS__)
 
 #endif // _esp_log_h_
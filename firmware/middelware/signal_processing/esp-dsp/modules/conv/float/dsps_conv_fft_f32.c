@@ -0,0 +1,154 @@
+// Copyright 2018-2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "dsps_conv.h"
+#include "dsps_corr.h"
+#include "dsps_fft2r.h"
+
+// Spectrum of the kernel, optionally time reversed (correlation)
+static esp_err_t dsps_conv_fft_kernel(const float *kern, int kernlen, bool reverse, float *spectrum, int N)
+{
+    memset(spectrum, 0, 2 * N * sizeof(float));
+    for (int i = 0; i < kernlen; i++) {
+        spectrum[2 * i] = reverse ? kern[kernlen - 1 - i] : kern[i];
+    }
+    esp_err_t ret = dsps_fft2r_fc32(spectrum, N);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return dsps_bit_rev2r_fc32(spectrum, N);
+}
+
+// FFT size for overlap-add: about 4 kernel lengths, bounded by the output
+// length and by the size of the fft2r coefficients table
+static int dsps_conv_fft_size(int siglen, int kernlen)
+{
+    int N = 1;
+    while (N < 4 * kernlen && N < siglen + kernlen - 1) {
+        N <<= 1;
+    }
+    while (N > dsps_fft_w_table_size && N / 2 > kernlen) {
+        N >>= 1;
+    }
+    return N;
+}
+
+/*
+ * Overlap-add engine. Computes out[n] = (sig * kern)[n + out_start] for
+ * 0 <= n < out_len. Two signal blocks are transformed at once: block a in the
+ * real part and block b in the imaginary part, since the kernel is real the
+ * real part of the result is a * kern and the imaginary part is b * kern.
+ */
+static esp_err_t dsps_conv_fft_ola(const float *sig, int siglen, const float *kern, int kernlen, bool reverse,
+                                   float *out, int out_start, int out_len)
+{
+    int N = dsps_conv_fft_size(siglen, kernlen);
+    if (N < kernlen + 1 || N > dsps_fft_w_table_size) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    int L = N - kernlen + 1;
+    float *spectrum = (float *)malloc(4 * N * sizeof(float));
+    if (spectrum == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    float *work = spectrum + 2 * N;
+    esp_err_t ret = dsps_conv_fft_kernel(kern, kernlen, reverse, spectrum, N);
+    memset(out, 0, out_len * sizeof(float));
+    float scale = 1.0f / N;
+
+    for (int pos = 0; pos < siglen && ret == ESP_OK; pos += 2 * L) {
+        memset(work, 0, 2 * N * sizeof(float));
+        for (int i = 0; i < L && pos + i < siglen; i++) {
+            work[2 * i] = sig[pos + i];
+        }
+        for (int i = 0; i < L && pos + L + i < siglen; i++) {
+            work[2 * i + 1] = sig[pos + L + i];
+        }
+        ret = dsps_fft2r_fc32(work, N);
+        if (ret != ESP_OK) {
+            break;
+        }
+        dsps_bit_rev2r_fc32(work, N);
+        // Multiply by the kernel spectrum and conjugate: the inverse FFT is conj(FFT(conj(Y))) / N
+        for (int k = 0; k < N; k++) {
+            float re = work[2 * k] * spectrum[2 * k] - work[2 * k + 1] * spectrum[2 * k + 1];
+            float im = work[2 * k] * spectrum[2 * k + 1] + work[2 * k + 1] * spectrum[2 * k];
+            work[2 * k] = re;
+            work[2 * k + 1] = -im;
+        }
+        dsps_fft2r_fc32(work, N);
+        dsps_bit_rev2r_fc32(work, N);
+        // Add both blocks (real part and -imaginary part) to the output
+        for (int b = 0; b < 2; b++) {
+            int first = pos + b * L - out_start;
+            float sign = b ? -scale : scale;
+            for (int i = 0; i < N; i++) {
+                int n = first + i;
+                if (n >= 0 && n < out_len) {
+                    out[n] += sign * work[2 * i + b];
+                }
+            }
+        }
+    }
+    free(spectrum);
+    return ret;
+}
+
+esp_err_t dsps_conv_fft_f32(const float *Signal, const int siglen, const float *Kernel, const int kernlen, float *convout)
+{
+    if (NULL == Signal || NULL == Kernel || NULL == convout) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    if (siglen < kernlen) {
+        return dsps_conv_fft_ola(Kernel, kernlen, Signal, siglen, false, convout, 0, siglen + kernlen - 1);
+    }
+    return dsps_conv_fft_ola(Signal, siglen, Kernel, kernlen, false, convout, 0, siglen + kernlen - 1);
+}
+
+esp_err_t dsps_corr_fft_f32(const float *Signal, const int siglen, const float *Pattern, const int patlen, float *dest)
+{
+    if (NULL == Signal || NULL == Pattern || NULL == dest) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    if (siglen < patlen) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    return dsps_conv_fft_ola(Signal, siglen, Pattern, patlen, true, dest, patlen - 1, siglen - patlen + 1);
+}
+
+esp_err_t dsps_conv_auto_f32(const float *Signal, const int siglen, const float *Kernel, const int kernlen, float *convout)
+{
+    int shortest = (siglen < kernlen) ? siglen : kernlen;
+    if (shortest >= DSPS_CONV_FFT_MIN_LEN && dsps_fft2r_initialized) {
+        esp_err_t ret = dsps_conv_fft_f32(Signal, siglen, Kernel, kernlen, convout);
+        if (ret != ESP_ERR_DSP_PARAM_OUTOFRANGE && ret != ESP_ERR_NO_MEM) {
+            return ret;
+        }
+    }
+    return dsps_conv_f32(Signal, siglen, Kernel, kernlen, convout);
+}
+
+esp_err_t dsps_corr_auto_f32(const float *Signal, const int siglen, const float *Pattern, const int patlen, float *dest)
+{
+    if (patlen >= DSPS_CONV_FFT_MIN_LEN && siglen >= patlen && dsps_fft2r_initialized) {
+        esp_err_t ret = dsps_corr_fft_f32(Signal, siglen, Pattern, patlen, dest);
+        if (ret != ESP_ERR_DSP_PARAM_OUTOFRANGE && ret != ESP_ERR_NO_MEM) {
+            return ret;
+        }
+    }
+    return dsps_corr_f32(Signal, siglen, Pattern, patlen, dest);
+}
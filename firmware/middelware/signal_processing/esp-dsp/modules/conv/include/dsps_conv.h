@@ -18,6 +18,15 @@
 
 #include "dsps_conv_platform.h"
 
+// Shortest input length from which dsps_conv_auto_f32/dsps_corr_auto_f32 use the FFT.
+// The benchmark in signal_processing/test_sim measures the crossover at 14-16
+// taps. The host vectorizes the direct loop, so on scalar targets the FFT wins
+// from shorter kernels still. Override it with a compile definition to
+// re-calibrate on the target.
+#ifndef DSPS_CONV_FFT_MIN_LEN
+#define DSPS_CONV_FFT_MIN_LEN 16
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -45,6 +54,47 @@ esp_err_t dsps_conv_f32_ae32(const float *Signal, const int siglen, const float
 esp_err_t dsps_conv_f32_ansi(const float *Signal, const int siglen, const float *Kernel, const int kernlen, float *convout);
 /**@}*/
 
+/**@{*/
+/**
+ * @brief   Convolution through FFT
+ * Same result as dsps_conv_f32, computed by overlap-add: the signal is split
+ * in blocks that are convolved with the kernel in the frequency domain, so
+ * signals of any length can be processed with a small FFT.
+ * The fft2r tables must be initialized (dsps_fft2r_init_fc32) with a size of
+ * at least two times the kernel length. Work buffers (4 * FFT size floats)
+ * are allocated during the call.
+ * The implementation use ANSI C and could be compiled and run on any platform
+ * @param[in] Signal:  input array with signal
+ * @param[in] siglen:  length of the input signal
+ * @param[in] Kernel:  input array with convolution kernel
+ * @param[in] kernlen: length of the Kernel array
+ * @param convout: output array with convolution result length of (siglen + Kernel -1)
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_DSP_UNINITIALIZED if the fft2r tables are not initialized
+ *      - ESP_ERR_DSP_PARAM_OUTOFRANGE if the fft2r tables are too small
+ *      - ESP_ERR_NO_MEM if the work buffers can't be allocated
+ */
+esp_err_t dsps_conv_fft_f32(const float *Signal, const int siglen, const float *Kernel, const int kernlen, float *convout);
+/**@}*/
+
+/**@{*/
+/**
+ * @brief   Convolution, direct or through FFT
+ * Uses dsps_conv_fft_f32 when both lengths are at least DSPS_CONV_FFT_MIN_LEN
+ * and the fft2r tables allow it, dsps_conv_f32 otherwise.
+ * @param[in] Signal:  input array with signal
+ * @param[in] siglen:  length of the input signal
+ * @param[in] Kernel:  input array with convolution kernel
+ * @param[in] kernlen: length of the Kernel array
+ * @param convout: output array with convolution result length of (siglen + Kernel -1)
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_conv_auto_f32(const float *Signal, const int siglen, const float *Kernel, const int kernlen, float *convout);
+/**@}*/
+
 #ifdef __cplusplus
 }
 #endif
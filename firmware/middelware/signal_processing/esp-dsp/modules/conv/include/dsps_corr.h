@@ -45,6 +45,30 @@ esp_err_t dsps_corr_f32_ansi(const float *Signal, const int siglen, const float
 esp_err_t dsps_corr_f32_ae32(const float *Signal, const int siglen, const float *Pattern, const int patlen, float *dest);
 /**@}*/
 
+/**@{*/
+/**
+ * @brief   Correlation with pattern through FFT
+ * Same result as dsps_corr_f32, computed by overlap-add as a convolution with
+ * the reversed pattern (see dsps_conv_fft_f32 for the requirements).
+ * @param[in] Signal: input array with signal values
+ * @param[in] siglen: length of the signal array
+ * @param[in] Pattern: input array with pattern values
+ * @param[in] patlen: length of the pattern array. The siglen must be bigger then patlen!
+ * @param dest: output array with result of correlation (siglen - patlen + 1)
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_corr_fft_f32(const float *Signal, const int siglen, const float *Pattern, const int patlen, float *dest);
+
+/**
+ * @brief   Correlation with pattern, direct or through FFT
+ * Uses dsps_corr_fft_f32 when the pattern has at least DSPS_CONV_FFT_MIN_LEN
+ * values and the fft2r tables allow it, dsps_corr_f32 otherwise.
+ */
+esp_err_t dsps_corr_auto_f32(const float *Signal, const int siglen, const float *Pattern, const int patlen, float *dest);
+/**@}*/
+
 #ifdef __cplusplus
 }
 #endif
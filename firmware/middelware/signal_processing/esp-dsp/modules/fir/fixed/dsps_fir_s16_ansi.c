@@ -0,0 +1,99 @@
+// Copyright 2018-2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dsps_fir.h"
+
+esp_err_t dsps_fir_s16_ansi(fir_s16_t *fir, const int16_t *input, int16_t *output, int32_t len)
+{
+    long long rounding = 0;
+    const int32_t final_shift = fir->shift - 15;
+    // Circular line of N + 3 samples, each one stored at pos and pos + line:
+    // the window of the last N samples starts at delay[start] without wrapping
+    const int N = fir->coeffs_len;
+    const int line = N + 3;
+    const int16_t *coeffs = &fir->coeffs[N - 1];                        // coeffs[N - 1] is applied to the oldest sample
+
+    rounding = (long long)(fir->rounding_val);
+
+    if (fir->shift >= 0) {
+        rounding = (rounding >> fir->shift) & 0xFFFFFFFFFF;         // 40-bit mask
+    } else {
+        rounding = (rounding << (-fir->shift)) & 0xFFFFFFFFFF;      // 40-bit mask
+    }
+
+    int i = 0;
+    for (; i + 4 <= len; i += 4) {
+        for (int k = 0; k < 4; k++) {
+            fir->delay[fir->pos] = input[i + k];
+            fir->delay[fir->pos + line] = input[i + k];
+            fir->pos++;
+            if (fir->pos >= line) {
+                fir->pos = 0;
+            }
+        }
+        // Window of the first output, the next ones are shifted by one sample
+        int start = fir->pos - 4 - N + 1;
+        if (start < 0) {
+            start += line;
+        }
+        const int16_t *d = &fir->delay[start];
+        long long acc0 = rounding, acc1 = rounding, acc2 = rounding, acc3 = rounding;
+        int32_t x0 = d[0], x1 = d[1], x2 = d[2];
+        for (int n = 0; n < N; n++) {
+            int32_t c = coeffs[-n];
+            int32_t x3 = d[n + 3];
+            acc0 += c * x0;
+            acc1 += c * x1;
+            acc2 += c * x2;
+            acc3 += c * x3;
+            x0 = x1;
+            x1 = x2;
+            x2 = x3;
+        }
+        if (final_shift > 0) {
+            output[i] = (int16_t)(acc0 << final_shift);
+            output[i + 1] = (int16_t)(acc1 << final_shift);
+            output[i + 2] = (int16_t)(acc2 << final_shift);
+            output[i + 3] = (int16_t)(acc3 << final_shift);
+        } else {
+            output[i] = (int16_t)(acc0 >> (-final_shift));
+            output[i + 1] = (int16_t)(acc1 >> (-final_shift));
+            output[i + 2] = (int16_t)(acc2 >> (-final_shift));
+            output[i + 3] = (int16_t)(acc3 >> (-final_shift));
+        }
+    }
+    for (; i < len; i++) {
+        fir->delay[fir->pos] = input[i];
+        fir->delay[fir->pos + line] = input[i];
+        fir->pos++;
+        if (fir->pos >= line) {
+            fir->pos = 0;
+        }
+        int start = fir->pos - N;
+        if (start < 0) {
+            start += line;
+        }
+        const int16_t *d = &fir->delay[start];
+        long long acc = rounding;
+        for (int n = 0; n < N; n++) {
+            acc += (int32_t)coeffs[-n] * (int32_t)d[n];
+        }
+        if (final_shift > 0) {
+            output[i] = (int16_t)(acc << final_shift);
+        } else {
+            output[i] = (int16_t)(acc >> (-final_shift));
+        }
+    }
+    return ESP_OK;
+}
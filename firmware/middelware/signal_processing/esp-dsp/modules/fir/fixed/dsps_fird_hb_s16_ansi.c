@@ -0,0 +1,64 @@
+// Copyright 2018-2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dsps_fir.h"
+
+int32_t dsps_fird_hb_s16_ansi(fir_s16_t *fir, const int16_t *input, int16_t *output, int32_t len)
+{
+    long long rounding = 0;
+    const int32_t final_shift = fir->shift - 15;
+    const int N = fir->coeffs_len;
+    const int center = (N - 1) / 2;
+
+    rounding = (long long)(fir->rounding_val);
+
+    if (fir->shift >= 0) {
+        rounding = (rounding >> fir->shift) & 0xFFFFFFFFFF;         // 40-bit mask
+    } else {
+        rounding = (rounding << (-fir->shift)) & 0xFFFFFFFFFF;      // 40-bit mask
+    }
+
+    for (int i = 0; i < len; i++) {
+        for (int k = 0; k < 2; k++) {
+            if (fir->pos >= N) {
+                fir->pos = 0;
+            }
+            fir->delay[fir->pos++] = *input++;
+        }
+
+        // Oldest sample at pos, newest at pos - 1: symmetric pairs at even distances
+        int old_pos = (fir->pos < N) ? fir->pos : 0;
+        int new_pos = fir->pos - 1;
+        int center_pos = (old_pos + center < N) ? old_pos + center : old_pos + center - N;
+        long long acc = rounding + (int32_t)fir->coeffs[center] * (int32_t)fir->delay[center_pos];
+        for (int coeff_pos = 0; coeff_pos < center; coeff_pos += 2) {
+            acc += (int32_t)fir->coeffs[coeff_pos] * ((int32_t)fir->delay[old_pos] + (int32_t)fir->delay[new_pos]);
+            old_pos += 2;
+            if (old_pos >= N) {
+                old_pos -= N;
+            }
+            new_pos -= 2;
+            if (new_pos < 0) {
+                new_pos += N;
+            }
+        }
+
+        if (final_shift > 0) {
+            output[i] = (int16_t)(acc << final_shift);
+        } else {
+            output[i] = (int16_t)(acc >> (-final_shift));
+        }
+    }
+    return len;
+}
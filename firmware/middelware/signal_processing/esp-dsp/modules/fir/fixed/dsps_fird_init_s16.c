@@ -99,7 +99,12 @@ esp_err_t dsps_fird_init_s16(fir_s16_t *fir, int16_t *coeffs, int16_t *delay, in
 #endif      // dsps_fird_s16_aes3_enabled
 #endif      // CONFIG_DSP_OPTIMIZED
 
-    for (int i = 0; i < fir->coeffs_len; i++) {                                  // Initialize the dealy line to zero
+#if CONFIG_DSP_OPTIMIZED && dsps_fird_s16_aes3_enabled
+    int16_t delay_len = fir->coeffs_len;                                        // esp32s3 uses a single delay line
+#else
+    int16_t delay_len = 2 * fir->coeffs_len;                                    // Mirrored delay line of the ANSI version
+#endif
+    for (int i = 0; i < delay_len; i++) {                                        // Initialize the dealy line to zero
         fir->delay[i] = 0;
     }
 
@@ -144,3 +149,28 @@ esp_err_t dsps_16_array_rev(int16_t *arr, int16_t len)
     }
     return ESP_OK;
 }
+
+esp_err_t dsps_fir_init_s16(fir_s16_t *fir, int16_t *coeffs, int16_t *delay, int16_t coeffs_len, int16_t shift)
+{
+    if (coeffs_len < 1) {
+        return ESP_ERR_DSP_INVALID_LENGTH;
+    }
+    if ((shift > 40) || (shift < -40)) {                                // shift amount must be within a range from -40 to 40
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    fir->coeffs = coeffs;
+    fir->delay = delay;
+    fir->coeffs_len = coeffs_len;
+    fir->pos = 0;
+    fir->decim = 1;
+    fir->d_pos = 0;
+    fir->shift = shift;
+    fir->rounding_buff = NULL;
+    fir->rounding_val = (int16_t)(ROUNDING_VALUE);
+    fir->free_status = 0;
+
+    for (int i = 0; i < DSPS_FIR_DELAY_LEN(coeffs_len); i++) {
+        fir->delay[i] = 0;
+    }
+    return ESP_OK;
+}
@@ -29,18 +29,18 @@ int32_t dsps_fird_s16_ansi(fir_s16_t *fir, const int16_t *input, int16_t *output
             if (fir->pos >= fir->coeffs_len) {
                 fir->pos = 0;
             }
+            // Mirrored delay line: the last coeffs_len samples start at pos without wrapping
+            fir->delay[fir->pos + fir->coeffs_len] = input[input_pos];
             fir->delay[fir->pos++] = input[input_pos++];
         }
         fir->d_pos = 0;
 
         long long acc = rounding;
-        int16_t coeff_pos = fir->coeffs_len - 1;
+        const int16_t *delay = &fir->delay[fir->pos];
+        const int16_t *coeffs = &fir->coeffs[fir->coeffs_len - 1];
 
-        for (int n = fir->pos; n < fir->coeffs_len ; n++) {
-            acc += (int32_t)fir->coeffs[coeff_pos--] * (int32_t)fir->delay[n];
-        }
-        for (int n = 0; n < fir->pos ; n++) {
-            acc += (int32_t)fir->coeffs[coeff_pos--] * (int32_t)fir->delay[n];
+        for (int n = 0; n < fir->coeffs_len; n++) {
+            acc += (int32_t)coeffs[-n] * (int32_t)delay[n];
         }
 
         if (final_shift > 0) {
@@ -0,0 +1,93 @@
+// Copyright 2018-2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dsps_fir.h"
+
+#define ROUNDING_VALUE  0x7fff
+
+esp_err_t dsps_resample_init_s16(fir_resample_s16_t *fir, int16_t *coeffs, int16_t *delay, int16_t N, int16_t interp, int16_t decim, int16_t shift)
+{
+    if (N < 1) {
+        return ESP_ERR_DSP_INVALID_LENGTH;
+    }
+    if ((interp < 1) || (decim < 1)) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    if ((shift > 40) || (shift < -40)) {                                // shift amount must be within a range from -40 to 40
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    fir->coeffs = coeffs;
+    fir->delay = delay;
+    fir->N = N;
+    fir->taps = (N + interp - 1) / interp;
+    fir->pos = 0;
+    fir->interp = interp;
+    fir->decim = decim;
+    fir->phase = 0;
+    fir->shift = shift;
+    fir->rounding_val = (int16_t)(ROUNDING_VALUE);
+
+    for (int i = 0; i < fir->taps; i++) {
+        fir->delay[i] = 0;
+    }
+    return ESP_OK;
+}
+
+esp_err_t dsps_fird_hb_init_s16(fir_s16_t *fir, int16_t *coeffs, int16_t *delay, int16_t N, int16_t shift)
+{
+    // Non zero coefficients at even positions and an odd center: N = 4 * k + 3
+    if ((N < 3) || (N % 4 != 3)) {
+        return ESP_ERR_DSP_INVALID_LENGTH;
+    }
+    if ((shift > 40) || (shift < -40)) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    // Same fields as dsps_fird_init_s16, without the buffers of the optimized versions
+    fir->coeffs = coeffs;
+    fir->delay = delay;
+    fir->coeffs_len = N;
+    fir->pos = 0;
+    fir->decim = 2;
+    fir->d_pos = 0;
+    fir->shift = shift;
+    fir->rounding_buff = NULL;
+    fir->rounding_val = (int16_t)(ROUNDING_VALUE);
+    fir->free_status = 0;
+
+    for (int i = 0; i < N; i++) {
+        fir->delay[i] = 0;
+    }
+    return ESP_OK;
+}
+
+esp_err_t dsps_src_init_s16(fir_src_s16_t *src, fir_s16_t *hb, int hb_stages, fir_resample_s16_t *resample, int16_t *work, int work_len)
+{
+    if ((hb_stages < 0) || ((hb_stages > 0) && ((hb == NULL) || (work == NULL) || (work_len < 1)))) {
+        return ESP_ERR_DSP_INVALID_PARAM;
+    }
+    if ((hb_stages == 0) && (resample == NULL)) {
+        return ESP_ERR_DSP_INVALID_PARAM;
+    }
+    for (int i = 0; i < hb_stages; i++) {
+        if (hb[i].decim != 2) {
+            return ESP_ERR_DSP_UNINITIALIZED;
+        }
+    }
+    src->hb = hb;
+    src->hb_stages = hb_stages;
+    src->resample = resample;
+    src->work = work;
+    src->work_len = work_len;
+    return ESP_OK;
+}
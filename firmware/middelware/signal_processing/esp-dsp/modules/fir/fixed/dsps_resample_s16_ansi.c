@@ -0,0 +1,59 @@
+// Copyright 2018-2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dsps_fir.h"
+
+int32_t dsps_resample_s16_ansi(fir_resample_s16_t *fir, const int16_t *input, int16_t *output, int32_t len)
+{
+    int32_t result = 0;
+    long long rounding = 0;
+    const int32_t final_shift = fir->shift - 15;
+
+    rounding = (long long)(fir->rounding_val);
+
+    if (fir->shift >= 0) {
+        rounding = (rounding >> fir->shift) & 0xFFFFFFFFFF;         // 40-bit mask
+    } else {
+        rounding = (rounding << (-fir->shift)) & 0xFFFFFFFFFF;      // 40-bit mask
+    }
+
+    for (int i = 0; i < len; i++) {
+        fir->delay[fir->pos++] = input[i];
+        if (fir->pos >= fir->taps) {
+            fir->pos = 0;
+        }
+        // Outputs between this input and the next one on the interpolated grid.
+        // Output at phase p: sum of coeffs[p + k * interp] * x[n - k]
+        while (fir->phase < fir->interp) {
+            long long acc = rounding;
+            int coeff_pos = fir->phase;
+            for (int n = fir->pos - 1; (n >= 0) && (coeff_pos < fir->N); n--) {
+                acc += (int32_t)fir->coeffs[coeff_pos] * (int32_t)fir->delay[n];
+                coeff_pos += fir->interp;
+            }
+            for (int n = fir->taps - 1; coeff_pos < fir->N; n--) {
+                acc += (int32_t)fir->coeffs[coeff_pos] * (int32_t)fir->delay[n];
+                coeff_pos += fir->interp;
+            }
+            if (final_shift > 0) {
+                output[result++] = (int16_t)(acc << final_shift);
+            } else {
+                output[result++] = (int16_t)(acc >> (-final_shift));
+            }
+            fir->phase += fir->decim;
+        }
+        fir->phase -= fir->interp;
+    }
+    return result;
+}
@@ -0,0 +1,39 @@
+// Copyright 2018-2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dsps_fir.h"
+
+int32_t dsps_src_s16_ansi(fir_src_s16_t *src, const int16_t *input, int16_t *output, int32_t len)
+{
+    // Every half-band stage halves the block, the first one writes len / 2
+    // samples to the work buffer
+    if ((len < 0) || (len & ((1 << src->hb_stages) - 1))) {
+        return -ESP_ERR_DSP_INVALID_LENGTH;
+    }
+    if ((src->hb_stages > 0) && (len / 2 > src->work_len)) {
+        return -ESP_ERR_DSP_INVALID_LENGTH;
+    }
+    // The half-band stages work in place on the work buffer: every output
+    // is written after its two input samples were copied to the delay line
+    const int16_t *stage_in = input;
+    for (int s = 0; s < src->hb_stages; s++) {
+        int16_t *stage_out = ((s == src->hb_stages - 1) && (src->resample == NULL)) ? output : src->work;
+        len = dsps_fird_hb_s16(&src->hb[s], stage_in, stage_out, len / 2);
+        stage_in = stage_out;
+    }
+    if (src->resample != NULL) {
+        len = dsps_resample_s16(src->resample, stage_in, output, len);
+    }
+    return len;
+}
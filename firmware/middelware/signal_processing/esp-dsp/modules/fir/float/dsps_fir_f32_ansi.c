@@ -16,19 +16,59 @@
 
 esp_err_t dsps_fir_f32_ansi(fir_f32_t *fir, const float *input, float *output, int len)
 {
-    for (int i = 0 ; i < len ; i++) {
-        float acc = 0;
-        int coeff_pos = 0;
+    // Circular line of N + 3 samples, each one stored at pos and pos + line:
+    // the window of the last N samples starts at delay[start] without wrapping
+    const int N = fir->N;
+    const int line = N + 3;
+    int i = 0;
+    for (; i + 4 <= len ; i += 4) {
+        for (int k = 0; k < 4; k++) {
+            fir->delay[fir->pos] = input[i + k];
+            fir->delay[fir->pos + line] = input[i + k];
+            fir->pos++;
+            if (fir->pos >= line) {
+                fir->pos = 0;
+            }
+        }
+        // Window of the first output, the next ones are shifted by one sample
+        int start = fir->pos - 4 - N + 1;
+        if (start < 0) {
+            start += line;
+        }
+        const float *d = &fir->delay[start];
+        float acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+        float x0 = d[0], x1 = d[1], x2 = d[2];
+        for (int n = 0; n < N ; n++) {
+            float c = fir->coeffs[n];
+            float x3 = d[n + 3];
+            acc0 += c * x0;
+            acc1 += c * x1;
+            acc2 += c * x2;
+            acc3 += c * x3;
+            x0 = x1;
+            x1 = x2;
+            x2 = x3;
+        }
+        output[i] = acc0;
+        output[i + 1] = acc1;
+        output[i + 2] = acc2;
+        output[i + 3] = acc3;
+    }
+    for (; i < len ; i++) {
         fir->delay[fir->pos] = input[i];
+        fir->delay[fir->pos + line] = input[i];
         fir->pos++;
-        if (fir->pos >= fir->N) {
+        if (fir->pos >= line) {
             fir->pos = 0;
         }
-        for (int n = fir->pos; n < fir->N ; n++) {
-            acc += fir->coeffs[coeff_pos++] * fir->delay[n];
+        int start = fir->pos - N;
+        if (start < 0) {
+            start += line;
         }
-        for (int n = 0; n < fir->pos ; n++) {
-            acc += fir->coeffs[coeff_pos++] * fir->delay[n];
+        const float *d = &fir->delay[start];
+        float acc = 0;
+        for (int n = 0; n < N ; n++) {
+            acc += fir->coeffs[n] * d[n];
         }
         output[i] = acc;
     }
@@ -0,0 +1,92 @@
+// Copyright 2018-2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dsps_fir_gen.h"
+#include <math.h>
+
+esp_err_t dsps_fir_gen_lpf_f32(float *coeffs, int N, float f, float gain)
+{
+    if (N < 1) {
+        return ESP_ERR_DSP_INVALID_LENGTH;
+    }
+    if ((f <= 0) || (f >= 0.5f)) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    // Sinc centered at (N - 1) / 2 and Blackman window over N + 2 points,
+    // so the first and last coefficients are not zero
+    float sum = 0;
+    for (int i = 0; i < N; i++) {
+        float t = i - (N - 1) / 2.0f;
+        float h = (t == 0) ? 2 * f : sinf(2 * M_PI * f * t) / (M_PI * t);
+        float x = (float)(i + 1) / (N + 1);
+        float w = 0.42f - 0.5f * cosf(2 * M_PI * x) + 0.08f * cosf(4 * M_PI * x);
+        coeffs[i] = h * w;
+    }
+    // Exact symmetry (linear phase, also after the conversion to 16 bit)
+    for (int i = 0; i < N / 2; i++) {
+        coeffs[N - 1 - i] = coeffs[i];
+    }
+    for (int i = 0; i < N; i++) {
+        sum += coeffs[i];
+    }
+    for (int i = 0; i < N; i++) {
+        coeffs[i] *= gain / sum;
+    }
+    return ESP_OK;
+}
+
+esp_err_t dsps_fir_gen_halfband_f32(float *coeffs, int N)
+{
+    if ((N < 3) || (N % 4 != 3)) {
+        return ESP_ERR_DSP_INVALID_LENGTH;
+    }
+    dsps_fir_gen_lpf_f32(coeffs, N, 0.25f, 1);
+    // The sinc is zero at even distances from the center: make them exact and
+    // scale the rest to 0.5, so H(w) + H(pi - w) = 1
+    int center = (N - 1) / 2;
+    float sum = 0;
+    for (int i = 0; i < N; i++) {
+        if ((i - center) % 2 == 0) {
+            coeffs[i] = 0;
+        } else {
+            sum += coeffs[i];
+        }
+    }
+    for (int i = 0; i < N; i++) {
+        coeffs[i] *= 0.5f / sum;
+    }
+    coeffs[center] = 0.5f;
+    return ESP_OK;
+}
+
+esp_err_t dsps_fir_coef_s16(const float *coeffs, int16_t *coeffs_s16, int N, int shift)
+{
+    if ((shift < 0) || (shift > 15)) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    esp_err_t ret = ESP_OK;
+    float scale = (float)(1 << (15 - shift));
+    for (int i = 0; i < N; i++) {
+        long q = lroundf(coeffs[i] * scale);
+        if (q > INT16_MAX) {
+            q = INT16_MAX;
+            ret = ESP_ERR_DSP_PARAM_OUTOFRANGE;
+        } else if (q < INT16_MIN) {
+            q = INT16_MIN;
+            ret = ESP_ERR_DSP_PARAM_OUTOFRANGE;
+        }
+        coeffs_s16[i] = (int16_t)q;
+    }
+    return ret;
+}
@@ -21,15 +21,15 @@ esp_err_t dsps_fir_init_f32(fir_f32_t *fir, float *coeffs, float *delay, int coe
     // Allocate delay line in case if it's NULL
     if (delay == NULL) {
 #ifdef CONFIG_IDF_TARGET_ESP32S3
-        delay = (float *)memalign(16, (coeffs_len + 4) * sizeof(float));
+        delay = (float *)memalign(16, DSPS_FIR_DELAY_LEN(coeffs_len) * sizeof(float));
 #else
-        delay = (float *)malloc((coeffs_len + 4) * sizeof(float));
+        delay = (float *)malloc(DSPS_FIR_DELAY_LEN(coeffs_len) * sizeof(float));
 #endif // CONFIG_IDF_TARGET_ESP32S3
         fir->use_delay = 1;
     } else {
         fir->use_delay = 0;
     }
-    for (int i = 0; i < (coeffs_len + 4); i++) {
+    for (int i = 0; i < DSPS_FIR_DELAY_LEN(coeffs_len); i++) {
         delay[i] = 0;
     }
     fir->coeffs = coeffs;
@@ -0,0 +1,47 @@
+// Copyright 2018-2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dsps_fir.h"
+
+int dsps_fird_hb_f32_ansi(fir_f32_t *fir, const float *input, float *output, int len)
+{
+    const int N = fir->N;
+    const int center = (N - 1) / 2;
+    for (int i = 0; i < len ; i++) {
+        for (int k = 0 ; k < 2 ; k++) {
+            fir->delay[fir->pos++] = *input++;
+            if (fir->pos >= N) {
+                fir->pos = 0;
+            }
+        }
+        // Oldest sample at pos, newest at pos - 1: symmetric pairs at even distances
+        int old_pos = fir->pos;
+        int new_pos = (fir->pos > 0) ? fir->pos - 1 : N - 1;
+        int center_pos = (fir->pos + center < N) ? fir->pos + center : fir->pos + center - N;
+        float acc = fir->coeffs[center] * fir->delay[center_pos];
+        for (int coeff_pos = 0; coeff_pos < center; coeff_pos += 2) {
+            acc += fir->coeffs[coeff_pos] * (fir->delay[old_pos] + fir->delay[new_pos]);
+            old_pos += 2;
+            if (old_pos >= N) {
+                old_pos -= N;
+            }
+            new_pos -= 2;
+            if (new_pos < 0) {
+                new_pos += N;
+            }
+        }
+        output[i] = acc;
+    }
+    return len;
+}
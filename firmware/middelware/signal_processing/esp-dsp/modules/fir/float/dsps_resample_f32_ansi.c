@@ -0,0 +1,44 @@
+// Copyright 2018-2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dsps_fir.h"
+
+int dsps_resample_f32_ansi(fir_resample_f32_t *fir, const float *input, float *output, int len)
+{
+    int result = 0;
+    for (int i = 0; i < len ; i++) {
+        fir->delay[fir->pos++] = input[i];
+        if (fir->pos >= fir->taps) {
+            fir->pos = 0;
+        }
+        // Outputs between this input and the next one on the interpolated grid.
+        // Output at phase p: sum of coeffs[p + k * interp] * x[n - k]
+        while (fir->phase < fir->interp) {
+            float acc = 0;
+            int coeff_pos = fir->phase;
+            for (int n = fir->pos - 1; (n >= 0) && (coeff_pos < fir->N); n--) {
+                acc += fir->coeffs[coeff_pos] * fir->delay[n];
+                coeff_pos += fir->interp;
+            }
+            for (int n = fir->taps - 1; coeff_pos < fir->N; n--) {
+                acc += fir->coeffs[coeff_pos] * fir->delay[n];
+                coeff_pos += fir->interp;
+            }
+            output[result++] = acc;
+            fir->phase += fir->decim;
+        }
+        fir->phase -= fir->interp;
+    }
+    return result;
+}
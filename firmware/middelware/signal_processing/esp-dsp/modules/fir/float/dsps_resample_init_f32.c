@@ -0,0 +1,79 @@
+// Copyright 2018-2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dsps_fir.h"
+
+
+esp_err_t dsps_resample_init_f32(fir_resample_f32_t *fir, float *coeffs, float *delay, int N, int interp, int decim)
+{
+    if (N < 1) {
+        return ESP_ERR_DSP_INVALID_LENGTH;
+    }
+    if ((interp < 1) || (decim < 1)) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    fir->coeffs = coeffs;
+    fir->delay = delay;
+    fir->N = N;
+    fir->taps = (N + interp - 1) / interp;
+    fir->pos = 0;
+    fir->interp = interp;
+    fir->decim = decim;
+    fir->phase = 0;
+
+    for (int i = 0 ; i < fir->taps; i++) {
+        fir->delay[i] = 0;
+    }
+    return ESP_OK;
+}
+
+esp_err_t dsps_fird_hb_init_f32(fir_f32_t *fir, float *coeffs, float *delay, int N)
+{
+    // Non zero coefficients at even positions and an odd center: N = 4 * k + 3
+    if ((N < 3) || (N % 4 != 3)) {
+        return ESP_ERR_DSP_INVALID_LENGTH;
+    }
+    fir->coeffs = coeffs;
+    fir->delay = delay;
+    fir->N = N;
+    fir->pos = 0;
+    fir->decim = 2;
+    fir->use_delay = 0;
+
+    for (int i = 0 ; i < N; i++) {
+        fir->delay[i] = 0;
+    }
+    return ESP_OK;
+}
+
+esp_err_t dsps_src_init_f32(fir_src_f32_t *src, fir_f32_t *hb, int hb_stages, fir_resample_f32_t *resample, float *work, int work_len)
+{
+    if ((hb_stages < 0) || ((hb_stages > 0) && ((hb == NULL) || (work == NULL) || (work_len < 1)))) {
+        return ESP_ERR_DSP_INVALID_PARAM;
+    }
+    if ((hb_stages == 0) && (resample == NULL)) {
+        return ESP_ERR_DSP_INVALID_PARAM;
+    }
+    for (int i = 0; i < hb_stages; i++) {
+        if (hb[i].decim != 2) {
+            return ESP_ERR_DSP_UNINITIALIZED;
+        }
+    }
+    src->hb = hb;
+    src->hb_stages = hb_stages;
+    src->resample = resample;
+    src->work = work;
+    src->work_len = work_len;
+    return ESP_OK;
+}
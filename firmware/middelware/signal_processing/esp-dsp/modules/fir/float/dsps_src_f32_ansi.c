@@ -0,0 +1,39 @@
+// Copyright 2018-2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dsps_fir.h"
+
+int dsps_src_f32_ansi(fir_src_f32_t *src, const float *input, float *output, int len)
+{
+    // Every half-band stage halves the block, the first one writes len / 2
+    // samples to the work buffer
+    if ((len < 0) || (len & ((1 << src->hb_stages) - 1))) {
+        return -ESP_ERR_DSP_INVALID_LENGTH;
+    }
+    if ((src->hb_stages > 0) && (len / 2 > src->work_len)) {
+        return -ESP_ERR_DSP_INVALID_LENGTH;
+    }
+    // The half-band stages work in place on the work buffer: every output
+    // is written after its two input samples were copied to the delay line
+    const float *stage_in = input;
+    for (int s = 0; s < src->hb_stages; s++) {
+        float *stage_out = ((s == src->hb_stages - 1) && (src->resample == NULL)) ? output : src->work;
+        len = dsps_fird_hb_f32(&src->hb[s], stage_in, stage_out, len / 2);
+        stage_in = stage_out;
+    }
+    if (src->resample != NULL) {
+        len = dsps_resample_f32(src->resample, stage_in, output, len);
+    }
+    return len;
+}
@@ -21,6 +21,15 @@
 #include "dsps_fir_platform.h"
 #include "dsp_common.h"
 
+/**
+ * @brief Delay line length of dsps_fir_f32 and dsps_fir_s16
+ *
+ * The ANSI versions keep a mirrored (double length) delay line of coeffs_len + 3
+ * samples, so the last coeffs_len samples of up to 4 consecutive outputs are always
+ * contiguous: the inner loops run without wrapping and compute 4 outputs per pass.
+ */
+#define DSPS_FIR_DELAY_LEN(coeffs_len) (2 * (coeffs_len) + 6)
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -62,6 +71,74 @@ typedef struct fir_s16_s {
     int16_t     free_status;    /*!< Indicator for dsps_fird_s16_aes3_free() function*/
 } fir_s16_t;
 
+/**
+ * @brief Data struct of f32 polyphase resampler (interpolation by interp, decimation by decim)
+ *
+ * This structure is used by a filter internally. A user should access this structure only in case of
+ * extensions for the DSP Library.
+ * All fields of this structure are initialized by the dsps_resample_init_f32(...) function.
+ */
+typedef struct fir_resample_f32_s {
+    float  *coeffs;     /*!< Pointer to the prototype filter coefficients, designed at interp times the input rate.*/
+    float  *delay;      /*!< Pointer to the delay line buffer.*/
+    int     N;          /*!< Prototype filter coefficients amount.*/
+    int     taps;       /*!< Delay line length, coefficients per phase: (N + interp - 1) / interp.*/
+    int     pos;        /*!< Position in delay line.*/
+    int     interp;     /*!< Interpolation factor.*/
+    int     decim;      /*!< Decimation factor.*/
+    int     phase;      /*!< Position of the next output on the interpolated grid, relative to the last input.*/
+} fir_resample_f32_t;
+
+/**
+ * @brief Data struct of s16 polyphase resampler (interpolation by interp, decimation by decim)
+ *
+ * This structure is used by a filter internally. A user should access this structure only in case of
+ * extensions for the DSP Library.
+ * All fields of this structure are initialized by the dsps_resample_init_s16(...) function.
+ */
+typedef struct fir_resample_s16_s {
+    int16_t    *coeffs;         /*!< Pointer to the prototype filter coefficients, designed at interp times the input rate.*/
+    int16_t    *delay;          /*!< Pointer to the delay line buffer.*/
+    int16_t     N;              /*!< Prototype filter coefficients amount.*/
+    int16_t     taps;           /*!< Delay line length, coefficients per phase: (N + interp - 1) / interp.*/
+    int16_t     pos;            /*!< Position in delay line.*/
+    int16_t     interp;         /*!< Interpolation factor.*/
+    int16_t     decim;          /*!< Decimation factor.*/
+    int16_t     phase;          /*!< Position of the next output on the interpolated grid, relative to the last input.*/
+    int16_t     shift;          /*!< Shift value of the result.*/
+    int32_t     rounding_val;   /*!< Rounding value*/
+} fir_resample_s16_t;
+
+/**
+ * @brief Data struct of f32 multistage sample rate converter
+ *
+ * Half-band decimation stages (each one halves the rate) followed by an optional
+ * polyphase L/M stage. The stages are initialized by the user, the converter only chains them.
+ * All fields of this structure are initialized by the dsps_src_init_f32(...) function.
+ */
+typedef struct fir_src_f32_s {
+    fir_f32_t          *hb;         /*!< Half-band stages, initialized by dsps_fird_hb_init_f32(...).*/
+    int                 hb_stages;  /*!< Number of half-band stages.*/
+    fir_resample_f32_t *resample;   /*!< Last L/M stage, NULL if not used.*/
+    float              *work;       /*!< Work buffer between the stages.*/
+    int                 work_len;   /*!< Length of the work buffer.*/
+} fir_src_f32_t;
+
+/**
+ * @brief Data struct of s16 multistage sample rate converter
+ *
+ * Half-band decimation stages (each one halves the rate) followed by an optional
+ * polyphase L/M stage. The stages are initialized by the user, the converter only chains them.
+ * All fields of this structure are initialized by the dsps_src_init_s16(...) function.
+ */
+typedef struct fir_src_s16_s {
+    fir_s16_t          *hb;         /*!< Half-band stages, initialized by dsps_fird_hb_init_s16(...).*/
+    int                 hb_stages;  /*!< Number of half-band stages.*/
+    fir_resample_s16_t *resample;   /*!< Last L/M stage, NULL if not used.*/
+    int16_t            *work;       /*!< Work buffer between the stages.*/
+    int                 work_len;   /*!< Length of the work buffer.*/
+} fir_src_s16_t;
+
 /**
  * @brief   initialize structure for 32 bit FIR filter
  *
@@ -70,7 +147,7 @@ typedef struct fir_s16_s {
  *
  * @param fir: pointer to fir filter structure, that must be preallocated
  * @param coeffs: array with FIR filter coefficients. Must be length N
- * @param delay: array for FIR filter delay line. Must have a length = coeffs_len + 4
+ * @param delay: array for FIR filter delay line. Must have a length = DSPS_FIR_DELAY_LEN(coeffs_len)
  * @param coeffs_len: FIR filter length. Length of coeffs array. For esp32s3 length should be divided by 4 and aligned to 16.
  *
  * @return
@@ -103,8 +180,9 @@ esp_err_t dsps_fird_init_f32(fir_f32_t *fir, float *coeffs, float *delay, int N,
  *
  * @param fir: pointer to fir filter structure, that must be preallocated
  * @param coeffs: array with FIR filter coefficients. Must be length N
- * @param delay: array for FIR filter delay line. Must be length N
- * @param coeffs_len: FIR filter length. Length of coeffs and delay arrays.
+ * @param delay: array for FIR filter delay line. Must be length 2 * N, the ANSI version
+ *               keeps a mirrored copy of the samples (length N for esp32s3)
+ * @param coeffs_len: FIR filter length. Length of coeffs array.
  * @param decim: decimation factor.
  * @param start_pos: initial value of decimation counter. Must be [0..d)
  * @param shift: shift position of the result
@@ -115,6 +193,147 @@ esp_err_t dsps_fird_init_f32(fir_f32_t *fir, float *coeffs, float *delay, int N,
  */
 esp_err_t dsps_fird_init_s16(fir_s16_t *fir, int16_t *coeffs, int16_t *delay, int16_t coeffs_len, int16_t decim, int16_t start_pos, int16_t shift);
 
+/**
+ * @brief   initialize structure for 16 bit FIR filter
+ * Function initialize structure for 16 bit signed fixed point FIR filter without decimation.
+ * Coefficients and shift as dsps_fird_init_s16. No memory is allocated.
+ * The implementation use ANSI C and could be compiled and run on any platform
+ *
+ * @param fir: pointer to fir filter structure, that must be preallocated
+ * @param coeffs: array with FIR filter coefficients. Must be length N
+ * @param delay: array for FIR filter delay line. Must have a length = DSPS_FIR_DELAY_LEN(coeffs_len)
+ * @param coeffs_len: FIR filter length. Length of coeffs array.
+ * @param shift: shift position of the result
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_fir_init_s16(fir_s16_t *fir, int16_t *coeffs, int16_t *delay, int16_t coeffs_len, int16_t shift);
+
+/**
+ * @brief   initialize structure for 32 bit polyphase resampler
+ *
+ * Function initialize structure for 32 bit floating point resampler by interp/decim.
+ * The prototype low pass filter works at interp times the input rate: cut off below
+ * 0.5 / max(interp, decim) and DC gain interp (see dsps_fir_gen_lpf_f32).
+ * Only the non zero products of the zero stuffed signal are computed, so each output
+ * costs (N / interp) multiplications. No memory is allocated.
+ * The implementation use ANSI C and could be compiled and run on any platform
+ *
+ * @param fir: pointer to resampler structure, that must be preallocated
+ * @param coeffs: array with prototype filter coefficients. Must be length N
+ * @param delay: array for the delay line. Must be length (N + interp - 1) / interp
+ * @param N: prototype filter length. Length of coeffs array.
+ * @param interp: interpolation factor (1 for decimation only)
+ * @param decim: decimation factor (1 for interpolation only)
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_resample_init_f32(fir_resample_f32_t *fir, float *coeffs, float *delay, int N, int interp, int decim);
+
+/**
+ * @brief   initialize structure for 16 bit polyphase resampler
+ *
+ * Function initialize structure for 16 bit signed fixed point resampler by interp/decim.
+ * Same prototype filter as dsps_resample_init_f32, converted with dsps_fir_coef_s16 and
+ * the same shift (a DC gain of interp needs shift >= log2(interp)). No memory is allocated.
+ * The implementation use ANSI C and could be compiled and run on any platform
+ *
+ * @param fir: pointer to resampler structure, that must be preallocated
+ * @param coeffs: array with prototype filter coefficients. Must be length N
+ * @param delay: array for the delay line. Must be length (N + interp - 1) / interp
+ * @param N: prototype filter length. Length of coeffs array.
+ * @param interp: interpolation factor (1 for decimation only)
+ * @param decim: decimation factor (1 for interpolation only)
+ * @param shift: shift position of the result, as dsps_fird_init_s16
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_resample_init_s16(fir_resample_s16_t *fir, int16_t *coeffs, int16_t *delay, int16_t N, int16_t interp, int16_t decim, int16_t shift);
+
+/**
+ * @brief   initialize structure for 32 bit half-band decimation by 2
+ *
+ * Function initialize a fir_f32_t structure for dsps_fird_hb_f32.
+ * Half-band filters (dsps_fir_gen_halfband_f32) have every second coefficient equal to zero
+ * and are symmetric, so each output costs (N + 5) / 4 multiplications instead of N.
+ * No memory is allocated.
+ * The implementation use ANSI C and could be compiled and run on any platform
+ *
+ * @param fir: pointer to fir filter structure, that must be preallocated
+ * @param coeffs: array with half-band filter coefficients. Must be length N
+ * @param delay: array for FIR filter delay line. Must be length N
+ * @param N: FIR filter length, N = 4 * k + 3
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_fird_hb_init_f32(fir_f32_t *fir, float *coeffs, float *delay, int N);
+
+/**
+ * @brief   initialize structure for 16 bit half-band decimation by 2
+ *
+ * Function initialize a fir_s16_t structure for dsps_fird_hb_s16. The results are the same
+ * as dsps_fird_s16 with decimation 2 and start position 0. No memory is allocated.
+ * The implementation use ANSI C and could be compiled and run on any platform
+ *
+ * @param fir: pointer to fir filter structure, that must be preallocated
+ * @param coeffs: array with half-band filter coefficients. Must be length N
+ * @param delay: array for FIR filter delay line. Must be length N
+ * @param N: FIR filter length, N = 4 * k + 3
+ * @param shift: shift position of the result
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_fird_hb_init_s16(fir_s16_t *fir, int16_t *coeffs, int16_t *delay, int16_t N, int16_t shift);
+
+/**
+ * @brief   initialize structure for 32 bit multistage sample rate converter
+ *
+ * Function chains hb_stages half-band decimators and an optional L/M resampler, all of
+ * them initialized before. Large decimation factors are cheaper as a cascade: each
+ * half-band stage runs at a lower rate and needs a shorter filter than a single stage.
+ * No memory is allocated.
+ *
+ * @param src: pointer to converter structure, that must be preallocated
+ * @param hb: array of hb_stages half-band stages (dsps_fird_hb_init_f32), NULL if hb_stages is 0
+ * @param hb_stages: number of half-band stages
+ * @param resample: last resampler stage (dsps_resample_init_f32), NULL if not used
+ * @param work: work buffer between the stages
+ * @param work_len: length of the work buffer, at least half of the longest input block
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_src_init_f32(fir_src_f32_t *src, fir_f32_t *hb, int hb_stages, fir_resample_f32_t *resample, float *work, int work_len);
+
+/**
+ * @brief   initialize structure for 16 bit multistage sample rate converter
+ *
+ * Same as dsps_src_init_f32 with the 16 bit stages.
+ *
+ * @param src: pointer to converter structure, that must be preallocated
+ * @param hb: array of hb_stages half-band stages (dsps_fird_hb_init_s16), NULL if hb_stages is 0
+ * @param hb_stages: number of half-band stages
+ * @param resample: last resampler stage (dsps_resample_init_s16), NULL if not used
+ * @param work: work buffer between the stages
+ * @param work_len: length of the work buffer, at least half of the longest input block
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_src_init_s16(fir_src_s16_t *src, fir_s16_t *hb, int hb_stages, fir_resample_s16_t *resample, int16_t *work, int work_len);
+
 
 /**@{*/
 /**
@@ -138,6 +357,26 @@ esp_err_t dsps_fir_f32_ae32(fir_f32_t *fir, const float *input, float *output, i
 esp_err_t dsps_fir_f32_aes3(fir_f32_t *fir, const float *input, float *output, int len);
 /**@}*/
 
+/**@{*/
+/**
+ * @brief   16 bit signed fixed point FIR filter
+ *
+ * Function implements FIR filter without decimation, same results as dsps_fird_s16
+ * with decimation 1.
+ * The extension (_ansi) uses ANSI C and could be compiled and run on any platform.
+ *
+ * @param fir: pointer to fir filter structure, that must be initialized before
+ * @param[in] input: input array
+ * @param[out] output: array with the result of FIR filter
+ * @param[in] len: length of input and result arrays
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_fir_s16_ansi(fir_s16_t *fir, const int16_t *input, int16_t *output, int32_t len);
+/**@}*/
+
 /**@{*/
 /**
  *  @brief   32 bit floating point Decimation FIR filter
@@ -180,6 +419,114 @@ int32_t dsps_fird_s16_ae32(fir_s16_t *fir, const int16_t *input, int16_t *output
 int32_t dsps_fird_s16_aes3(fir_s16_t *fir, const int16_t *input, int16_t *output, int32_t len);
 /**@}*/
 
+/**@{*/
+/**
+ *  @brief   32 bit floating point polyphase resampler
+ *
+ * Function resamples the input by interp/decim. Blocks of any length can be streamed,
+ * the phase is kept between calls.
+ * The extension (_ansi) uses ANSI C and could be compiled and run on any platform.
+ *
+ * @param fir: pointer to resampler structure, that must be initialized before
+ * @param input: input array
+ * @param output: array with the result, at least (len * interp + decim - 1) / decim samples
+ * @param len: length of input array
+ *
+ * @return: function returns the number of samples stored in the output array
+ */
+int dsps_resample_f32_ansi(fir_resample_f32_t *fir, const float *input, float *output, int len);
+/**@}*/
+
+/**@{*/
+/**
+ *  @brief   16 bit signed fixed point polyphase resampler
+ *
+ * Function resamples the input by interp/decim. Blocks of any length can be streamed,
+ * the phase is kept between calls.
+ * The extension (_ansi) uses ANSI C and could be compiled and run on any platform.
+ *
+ * @param fir: pointer to resampler structure, that must be initialized before
+ * @param input: input array
+ * @param output: array with the result, at least (len * interp + decim - 1) / decim samples
+ * @param len: length of input array
+ *
+ * @return: function returns the number of samples stored in the output array
+ */
+int32_t dsps_resample_s16_ansi(fir_resample_s16_t *fir, const int16_t *input, int16_t *output, int32_t len);
+/**@}*/
+
+/**@{*/
+/**
+ *  @brief   32 bit floating point half-band decimation by 2
+ *
+ * Function implements dsps_fird_f32 with decimation 2 for half-band filters,
+ * skipping the zero coefficients and adding the symmetric samples before the multiplication.
+ * The extension (_ansi) uses ANSI C and could be compiled and run on any platform.
+ *
+ * @param fir: pointer to fir filter structure, initialized by dsps_fird_hb_init_f32
+ * @param input: input array, 2 * len samples. Can be the same array as output
+ * @param output: array with the result of FIR filter
+ * @param len: length of result array
+ *
+ * @return: function returns the number of samples stored in the output array
+ */
+int dsps_fird_hb_f32_ansi(fir_f32_t *fir, const float *input, float *output, int len);
+/**@}*/
+
+/**@{*/
+/**
+ *  @brief   16 bit signed fixed point half-band decimation by 2
+ *
+ * Function implements dsps_fird_s16 with decimation 2 for half-band filters,
+ * skipping the zero coefficients and adding the symmetric samples before the multiplication.
+ * The extension (_ansi) uses ANSI C and could be compiled and run on any platform.
+ *
+ * @param fir: pointer to fir filter structure, initialized by dsps_fird_hb_init_s16
+ * @param input: input array, 2 * len samples. Can be the same array as output
+ * @param output: array with the result of FIR filter
+ * @param len: length of result array
+ *
+ * @return: function returns the number of samples stored in the output array
+ */
+int32_t dsps_fird_hb_s16_ansi(fir_s16_t *fir, const int16_t *input, int16_t *output, int32_t len);
+/**@}*/
+
+/**@{*/
+/**
+ *  @brief   32 bit floating point multistage sample rate converter
+ *
+ * Function runs the half-band stages and the resampler of the converter.
+ * The extension (_ansi) uses ANSI C and could be compiled and run on any platform.
+ *
+ * @param src: pointer to converter structure, that must be initialized before
+ * @param input: input array
+ * @param output: array with the result
+ * @param len: length of input array, multiple of 2^hb_stages and at most 2 * work_len
+ *
+ * @return: function returns the number of samples stored in the output array,
+ *          -ESP_ERR_DSP_INVALID_LENGTH (negative) if len is not a multiple of 2^hb_stages or exceeds 2 * work_len
+ */
+int dsps_src_f32_ansi(fir_src_f32_t *src, const float *input, float *output, int len);
+/**@}*/
+
+/**@{*/
+/**
+ *  @brief   16 bit signed fixed point multistage sample rate converter
+ *
+ * Function runs the half-band stages and the resampler of the converter.
+ * The extension (_ansi) uses ANSI C and could be compiled and run on any platform.
+ *
+ * @param src: pointer to converter structure, that must be initialized before
+ * @param input: input array
+ * @param output: array with the result
+ * @param len: length of input array, multiple of 2^hb_stages and at most 2 * work_len
+ *
+ * @return: function returns the number of samples stored in the output array,
+ *          -ESP_ERR_DSP_INVALID_LENGTH (negative) if len is not a multiple of 2^hb_stages or exceeds 2 * work_len
+ */
+int32_t dsps_src_s16_ansi(fir_src_s16_t *src, const int16_t *input, int16_t *output, int32_t len);
+/**@}*/
+
 
 /**@{*/
 /**
@@ -264,11 +611,26 @@ esp_err_t dsps_16_array_rev(int16_t *arr, int16_t len);
 #define dsps_fird_s16 dsps_fird_s16_ansi
 #endif
 
+#define dsps_fir_s16 dsps_fir_s16_ansi
+#define dsps_resample_f32 dsps_resample_f32_ansi
+#define dsps_resample_s16 dsps_resample_s16_ansi
+#define dsps_fird_hb_f32 dsps_fird_hb_f32_ansi
+#define dsps_fird_hb_s16 dsps_fird_hb_s16_ansi
+#define dsps_src_f32 dsps_src_f32_ansi
+#define dsps_src_s16 dsps_src_s16_ansi
+
 #else // CONFIG_DSP_OPTIMIZED
 
 #define dsps_fir_f32 dsps_fir_f32_ansi
 #define dsps_fird_f32 dsps_fird_f32_ansi
 #define dsps_fird_s16 dsps_fird_s16_ansi
+#define dsps_fir_s16 dsps_fir_s16_ansi
+#define dsps_resample_f32 dsps_resample_f32_ansi
+#define dsps_resample_s16 dsps_resample_s16_ansi
+#define dsps_fird_hb_f32 dsps_fird_hb_f32_ansi
+#define dsps_fird_hb_s16 dsps_fird_hb_s16_ansi
+#define dsps_src_f32 dsps_src_f32_ansi
+#define dsps_src_s16 dsps_src_s16_ansi
 
 #endif // CONFIG_DSP_OPTIMIZED
 
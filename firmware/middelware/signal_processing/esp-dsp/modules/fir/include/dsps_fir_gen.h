@@ -0,0 +1,86 @@
+// Copyright 2018-2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _dsps_fir_gen_H_
+#define _dsps_fir_gen_H_
+
+#include <stdint.h>
+#include "dsp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Common rules for all generated coefficients.
+// The filters are linear phase (symmetric coefficients), windowed with a
+// Blackman window: about -74 dB stop band and a transition band of 5.5 / N.
+
+/**
+ * @brief   LPF FIR filter coefficients
+ * Coefficients for a low pass FIR filter (windowed sinc)
+ * The implementation use ANSI C and could be compiled and run on any platform
+ *
+ * For the polyphase resampler the filter runs at interp times the input rate:
+ * f = 0.5 / max(interp, decim) minus half the transition band, gain = interp.
+ *
+ * @param coeffs: result coefficients. Must be length N
+ * @param N: number of coefficients
+ * @param f: filter cut off frequency (-6 dB) in range of 0..0.5 (normalized to sample frequency)
+ * @param gain: gain at DC
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_fir_gen_lpf_f32(float *coeffs, int N, float f, float gain);
+
+/**
+ * @brief   Half-band FIR filter coefficients
+ * Coefficients for a half-band low pass FIR filter (cut off 0.25, DC gain 1) for
+ * dsps_fird_hb_f32. Every second coefficient is exactly zero and the center one is 0.5.
+ * The implementation use ANSI C and could be compiled and run on any platform
+ *
+ * @param coeffs: result coefficients. Must be length N
+ * @param N: number of coefficients, N = 4 * k + 3
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_fir_gen_halfband_f32(float *coeffs, int N);
+
+/**
+ * @brief   Convert FIR coefficients to 16 bit
+ * Coefficients for the 16 bit FIR functions (dsps_fird_s16, dsps_resample_s16, ...)
+ * with the same shift: coeffs_s16 = coeffs * 2^(15 - shift).
+ * The implementation use ANSI C and could be compiled and run on any platform
+ *
+ * @param coeffs: float coefficients
+ * @param coeffs_s16: result coefficients
+ * @param N: number of coefficients
+ * @param shift: shift position of the result, 0..15. Coefficients up to 2^shift are allowed
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_DSP_PARAM_OUTOFRANGE if a coefficient was saturated
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_fir_coef_s16(const float *coeffs, int16_t *coeffs_s16, int N, int shift);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _dsps_fir_gen_H_
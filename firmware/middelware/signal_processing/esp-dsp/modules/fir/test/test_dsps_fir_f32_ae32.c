@@ -35,9 +35,9 @@ static float y_compare[1024];
 __attribute__((aligned(16)))
 static float coeffs[32];
 __attribute__((aligned(16)))
-static float delay[32 + 4];
+static float delay[DSPS_FIR_DELAY_LEN(32)];
 __attribute__((aligned(16)))
-static float delay_compare[32];
+static float delay_compare[DSPS_FIR_DELAY_LEN(32)];
 
 TEST_CASE("dsps_fir_f32_aexx functionality", "[dsps]")
 {
@@ -29,7 +29,7 @@ static float x[1024];
 static float y[1024];
 
 static float coeffs[32];
-static float delay[32 + 4];
+static float delay[DSPS_FIR_DELAY_LEN(32)];
 
 TEST_CASE("dsps_fir_f32_ansi functionality", "[dsps]")
 {
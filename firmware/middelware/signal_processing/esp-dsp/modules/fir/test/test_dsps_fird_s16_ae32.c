@@ -82,8 +82,8 @@ TEST_CASE("dsps_fird_s16_aexx functionality", "[dsps]")
     int16_t *coeffs_aexx = (int16_t *)memalign(16, MAX_FIR_LEN * sizeof(int16_t));
     int16_t *coeffs_ansi = (int16_t *)memalign(16, MAX_FIR_LEN * sizeof(int16_t));
 
-    int16_t *delay = (int16_t *)memalign(16, MAX_FIR_LEN * sizeof(int16_t));
-    int16_t *delay_compare = (int16_t *)memalign(16, MAX_FIR_LEN * sizeof(int16_t));
+    int16_t *delay = (int16_t *)memalign(16, 2 * MAX_FIR_LEN * sizeof(int16_t));
+    int16_t *delay_compare = (int16_t *)memalign(16, 2 * MAX_FIR_LEN * sizeof(int16_t));
 
     int32_t combinations = 0;
     esp_err_t status1 = ESP_OK, status2 = ESP_OK;
@@ -134,6 +134,9 @@ TEST_CASE("dsps_fird_s16_aexx functionality", "[dsps]")
 
                         for (int j = 0; j < fir1.coeffs_len; j++) {
                             fir1.delay[j] = 0;
+                        }
+                        // The ANSI version has a mirrored delay line of 2 * coeffs_len
+                        for (int j = 0; j < 2 * fir2.coeffs_len; j++) {
                             fir2.delay[j] = 0;
                         }
 
@@ -181,7 +184,7 @@ TEST_CASE("dsps_fird_s16_aexx benchmark", "[dsps]")
     int16_t *y = (int16_t *)memalign(16, local_len * sizeof(int16_t));
 
     int16_t *coeffs = (int16_t *)memalign(16, MAX_FIR_LEN * sizeof(int16_t));
-    int16_t *delay = (int16_t *)memalign(16, MAX_FIR_LEN * sizeof(int16_t));
+    int16_t *delay = (int16_t *)memalign(16, 2 * MAX_FIR_LEN * sizeof(int16_t));
 
     const int repeat_count = 100;
     const int16_t start_pos = 0;
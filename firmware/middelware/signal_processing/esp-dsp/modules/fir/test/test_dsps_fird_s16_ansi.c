@@ -68,7 +68,7 @@ TEST_CASE("dsps_fird_s16_ansi functionality", "[dsps]")
     int16_t *y = (int16_t *)memalign(16, len * sizeof(int16_t));
 
     int16_t *coeffs = (int16_t *)memalign(16, fir_len * sizeof(int16_t));
-    int16_t *delay = (int16_t *)memalign(16, fir_len * sizeof(int16_t));
+    int16_t *delay = (int16_t *)memalign(16, 2 * fir_len * sizeof(int16_t));
 
     const int16_t start_pos = 0;
     const int16_t shift = 0;
@@ -115,7 +115,7 @@ TEST_CASE("dsps_fird_s16_ansi benchmark", "[dsps]")
     int16_t *y = (int16_t *)memalign(16, len * sizeof(int16_t));
 
     int16_t *coeffs = (int16_t *)memalign(16, fir_len * sizeof(int16_t));
-    int16_t *delay = (int16_t *)memalign(16, fir_len * sizeof(int16_t));
+    int16_t *delay = (int16_t *)memalign(16, 2 * fir_len * sizeof(int16_t));
 
     const int repeat_count = 4;
     const int16_t dec = 1;
@@ -173,7 +173,7 @@ TEST_CASE("dsps_fird_s16_ansi noise_snr", "[dsps]")
 
     // FIR Coeffs
     int16_t *s_coeffs = (int16_t *)memalign(16, fir_len * sizeof(int16_t));         // fixed point coefficients
-    int16_t *delay_line = (int16_t *)memalign(16, fir_len * sizeof(int16_t));       // fixed point delay line
+    int16_t *delay_line = (int16_t *)memalign(16, 2 * fir_len * sizeof(int16_t));       // fixed point delay line
     float *f_coeffs = (float *)memalign(16, fir_len * sizeof(float));               // floating point coefficients
 
     // Coefficients windowing
@@ -12,8 +12,8 @@ float y[1024];
 float y_compare[1024];
 
 float coeffs[256];
-float delay[256];
-float delay_compare[256];
+float delay[DSPS_FIR_DELAY_LEN(256)];
+float delay_compare[DSPS_FIR_DELAY_LEN(256)];
 
 
 void test_fir()
@@ -0,0 +1,64 @@
+// Copyright 2018-2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dsps_biquad.h"
+
+
+// Transposed direct form II. The state of each section stays in locals for the
+// whole block, two sections per pass. s0 = (b1*x + s1) - a1*y keeps the
+// recursion on y to a multiply and two additions.
+
+esp_err_t dsps_biquad_cascade_f32_ansi(const float *input, float *output, int len, const float *coef, float *w, int n_sections)
+{
+    const float *c = coef;
+    for (int k = 0 ; k + 1 < n_sections ; k += 2) {
+        float b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+        float d0 = c[5], d1 = c[6], d2 = c[7], e1 = c[8], e2 = c[9];
+        float s0 = w[0], s1 = w[1];
+        float t0 = w[2], t1 = w[3];
+        for (int i = 0 ; i < len ; i++) {
+            float x = input[i];
+            float y = b0 * x + s0;
+            s0 = (b1 * x + s1) - a1 * y;
+            s1 = b2 * x - a2 * y;
+            x = y;
+            y = d0 * x + t0;
+            t0 = (d1 * x + t1) - e1 * y;
+            t1 = d2 * x - e2 * y;
+            output[i] = y;
+        }
+        w[0] = s0;
+        w[1] = s1;
+        w[2] = t0;
+        w[3] = t1;
+        // The next pass filters the output
+        input = output;
+        c += 10;
+        w += 4;
+    }
+    if (n_sections & 1) {
+        float b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+        float s0 = w[0], s1 = w[1];
+        for (int i = 0 ; i < len ; i++) {
+            float x = input[i];
+            float y = b0 * x + s0;
+            s0 = (b1 * x + s1) - a1 * y;
+            s1 = b2 * x - a2 * y;
+            output[i] = y;
+        }
+        w[0] = s0;
+        w[1] = s1;
+    }
+    return ESP_OK;
+}
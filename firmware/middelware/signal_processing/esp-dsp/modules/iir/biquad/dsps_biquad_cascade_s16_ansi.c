@@ -0,0 +1,54 @@
+// Copyright 2018-2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dsps_biquad.h"
+
+
+// Saturation of a state to 32 bits
+static inline int32_t dsps_biquad_sat32(int64_t x)
+{
+    if (x > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (x < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (int32_t)x;
+}
+
+esp_err_t dsps_biquad_cascade_s16_ansi(const int16_t *input, int16_t *output, int len, const int16_t *coef, int32_t *w, int n_sections)
+{
+    const int32_t rounding = 1 << (DSPS_BIQUAD_S16_Q - 1);
+    for (int i = 0 ; i < len ; i++) {
+        int32_t x = input[i];
+        const int16_t *c = coef;
+        int32_t *s = w;
+        for (int k = 0 ; k < n_sections ; k++) {
+            // Products fit 31 bits, the sums are done in 64 bits and the states saturate
+            int32_t y = (int32_t)(((int64_t)(c[0] * x) + s[0] + rounding) >> DSPS_BIQUAD_S16_Q);
+            if (y > INT16_MAX) {
+                y = INT16_MAX;
+            } else if (y < INT16_MIN) {
+                y = INT16_MIN;
+            }
+            s[0] = dsps_biquad_sat32((int64_t)(c[1] * x) - (c[3] * y) + s[1]);
+            s[1] = dsps_biquad_sat32((int64_t)(c[2] * x) - (c[4] * y));
+            x = y;
+            c += 5;
+            s += 2;
+        }
+        output[i] = x;
+    }
+    return ESP_OK;
+}
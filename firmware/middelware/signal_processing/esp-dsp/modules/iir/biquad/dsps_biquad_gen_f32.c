@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "dsps_biquad_gen.h"
+#include "dsps_biquad.h"
 #include <math.h>
 #include "esp_log.h"
 
@@ -288,3 +289,64 @@ esp_err_t dsps_biquad_gen_highShelf_f32(float *coeffs, float f, float gain, floa
     coeffs[4] = a2 / a0;
     return ESP_OK;
 }
+
+// Quantizes one section to q fractional bits. b1 takes the rounding error of
+// the other coefficients so the DC gain of the quantized section is exact.
+static esp_err_t dsps_biquad_coef_quantize(const float *coeffs, int64_t *result, int q, int64_t max)
+{
+    double one = (double)((int64_t)1 << q);
+    double den = 1.0 + coeffs[3] + coeffs[4];
+    for (int i = 0; i < 5; i++) {
+        result[i] = llround(coeffs[i] * one);
+    }
+    // Poles close to z = 1 or z = -1 (1 + a1 + a2, 1 - a1 + a2 = squared distance)
+    // or to the unit circle (1 - a2) need more fractional bits than q
+    double a1 = coeffs[3], a2 = coeffs[4];
+    double qa1 = result[3] / one, qa2 = result[4] / one;
+    if ((fabs((qa1 + qa2) - (a1 + a2)) > DSPS_BIQUAD_MAX_POLE_ERROR * fabs(1.0 + a1 + a2)) ||
+            (fabs((qa2 - qa1) - (a2 - a1)) > DSPS_BIQUAD_MAX_POLE_ERROR * fabs(1.0 - a1 + a2)) ||
+            (fabs(qa2 - a2) > DSPS_BIQUAD_MAX_POLE_ERROR * fabs(1.0 - a2))) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    if (fabs(den) > 1e-9) {
+        double gain = (coeffs[0] + coeffs[1] + coeffs[2]) / den;
+        int64_t target = llround(gain * (double)(((int64_t)1 << q) + result[3] + result[4]));
+        result[1] += target - (result[0] + result[1] + result[2]);
+    }
+    for (int i = 0; i < 5; i++) {
+        if (result[i] > max || result[i] < -max - 1) {
+            return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t dsps_biquad_coef_s16(const float *coeffs, int16_t *result, int n_sections)
+{
+    int64_t q[5];
+    for (int k = 0; k < n_sections; k++) {
+        esp_err_t ret = dsps_biquad_coef_quantize(&coeffs[k * 5], q, DSPS_BIQUAD_S16_Q, INT16_MAX);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        for (int i = 0; i < 5; i++) {
+            result[k * 5 + i] = (int16_t)q[i];
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t dsps_biquad_coef_s32(const float *coeffs, int32_t *result, int n_sections)
+{
+    int64_t q[5];
+    for (int k = 0; k < n_sections; k++) {
+        esp_err_t ret = dsps_biquad_coef_quantize(&coeffs[k * 5], q, DSPS_BIQUAD_S32_Q, INT32_MAX);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        for (int i = 0; i < 5; i++) {
+            result[k * 5 + i] = (int32_t)q[i];
+        }
+    }
+    return ESP_OK;
+}
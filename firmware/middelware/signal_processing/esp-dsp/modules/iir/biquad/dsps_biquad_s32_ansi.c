@@ -0,0 +1,49 @@
+// Copyright 2018-2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dsps_biquad.h"
+
+
+esp_err_t dsps_biquad_s32_ansi(const int32_t *input, int32_t *output, int len, const int32_t *coef, int32_t *w)
+{
+    const int64_t frac_mask = ((int64_t)1 << DSPS_BIQUAD_S32_Q) - 1;
+    int32_t x1 = w[0], x2 = w[1], y1 = w[2], y2 = w[3];
+    int64_t err = w[4];
+    for (int i = 0 ; i < len ; i++) {
+        int32_t x0 = input[i];
+        // Direct form I, the fraction dropped by the last output is fed back
+        int64_t acc = (int64_t)coef[0] * x0 + (int64_t)coef[1] * x1 + (int64_t)coef[2] * x2
+                      - (int64_t)coef[3] * y1 - (int64_t)coef[4] * y2 + err;
+        int64_t y0 = acc >> DSPS_BIQUAD_S32_Q;
+        err = acc & frac_mask;
+        if (y0 > INT32_MAX) {
+            y0 = INT32_MAX;
+            err = 0;
+        } else if (y0 < INT32_MIN) {
+            y0 = INT32_MIN;
+            err = 0;
+        }
+        x2 = x1;
+        x1 = x0;
+        y2 = y1;
+        y1 = (int32_t)y0;
+        output[i] = (int32_t)y0;
+    }
+    w[0] = x1;
+    w[1] = x2;
+    w[2] = y1;
+    w[3] = y2;
+    w[4] = (int32_t)err;
+    return ESP_OK;
+}
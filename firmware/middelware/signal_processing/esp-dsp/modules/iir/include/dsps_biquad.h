@@ -20,6 +20,13 @@
 
 #include "dsps_biquad_platform.h"
 
+// Fractional bits of the s16 biquad coefficients (Q14, range -2..2)
+#define DSPS_BIQUAD_S16_Q 14
+// Fractional bits of the s32 biquad coefficients (Q30, range -2..2)
+#define DSPS_BIQUAD_S32_Q 30
+// Delay line of the fixed point biquad: x1, x2, y1, y2 and error feedback
+#define DSPS_BIQUAD_FX_STATE_SIZE 5
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -48,6 +55,57 @@ esp_err_t dsps_biquad_f32_ae32(const float *input, float *output, int len, float
 esp_err_t dsps_biquad_f32_aes3(const float *input, float *output, int len, float *coef, float *w);
 /**@}*/
 
+/**@{*/
+/**
+ * @brief   IIR filter in fixed point
+ *
+ * IIR filter 2nd order direct form I (bi quad) with error feedback: the
+ * fraction dropped when the accumulator is scaled back is added to the next
+ * sample, which keeps low cut-off filters stable and free of limit cycles.
+ * s16 uses Q14 coefficients and s32 uses Q30 coefficients, both with a 64 bit
+ * accumulator. Outputs saturate.
+ * The extension (_ansi) use ANSI C and could be compiled and run on any platform.
+ *
+ * @param[in] input: input array
+ * @param output: output array
+ * @param len: length of input and output vectors
+ * @param coef: array of coefficients. b0,b1,b2,a1,a2 (see dsps_biquad_coef_s16/s32)
+ * @param w: delay line x1,x2,y1,y2,error. Length of DSPS_BIQUAD_FX_STATE_SIZE.
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_biquad_s16_ansi(const int16_t *input, int16_t *output, int len, const int16_t *coef, int32_t *w);
+esp_err_t dsps_biquad_s32_ansi(const int32_t *input, int32_t *output, int len, const int32_t *coef, int32_t *w);
+/**@}*/
+
+/**@{*/
+/**
+ * @brief   IIR filter cascade
+ *
+ * Cascade of 2nd order sections in transposed direct form II. The f32 kernel
+ * runs two sections per pass over the block, with their coefficients and state in
+ * locals, so the signal is swept (n_sections + 1) / 2 times. The s16 kernel runs
+ * each sample through all sections before the next one is read.
+ * The extension (_ansi) use ANSI C and could be compiled and run on any platform.
+ *
+ * @param[in] input: input array
+ * @param output: output array (may be the same as input)
+ * @param len: length of input and output vectors
+ * @param coef: array of coefficients, b0,b1,b2,a1,a2 for each section (5 * n_sections).
+ *              expected that a0 = 1. For s16 the coefficients are Q14 (DSPS_BIQUAD_S16_Q).
+ * @param w: delay line, 2 values per section (2 * n_sections).
+ *           The state of the transposed form differs from the one used by dsps_biquad_f32.
+ *           s16 keeps it in 32 bits, saturated, and sums it in 64 bits.
+ * @param n_sections: number of 2nd order sections
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_biquad_cascade_f32_ansi(const float *input, float *output, int len, const float *coef, float *w, int n_sections);
+esp_err_t dsps_biquad_cascade_s16_ansi(const int16_t *input, int16_t *output, int len, const int16_t *coef, int32_t *w, int n_sections);
+/**@}*/
+
 
 #ifdef __cplusplus
 }
@@ -62,10 +120,18 @@ esp_err_t dsps_biquad_f32_aes3(const float *input, float *output, int len, float
 #else
 #define dsps_biquad_f32 dsps_biquad_f32_ansi
 #endif
+#define dsps_biquad_cascade_f32 dsps_biquad_cascade_f32_ansi
+#define dsps_biquad_cascade_s16 dsps_biquad_cascade_s16_ansi
+#define dsps_biquad_s16 dsps_biquad_s16_ansi
+#define dsps_biquad_s32 dsps_biquad_s32_ansi
 
 #else // CONFIG_DSP_OPTIMIZED
 
 #define dsps_biquad_f32 dsps_biquad_f32_ansi
+#define dsps_biquad_cascade_f32 dsps_biquad_cascade_f32_ansi
+#define dsps_biquad_cascade_s16 dsps_biquad_cascade_s16_ansi
+#define dsps_biquad_s16 dsps_biquad_s16_ansi
+#define dsps_biquad_s32 dsps_biquad_s32_ansi
 
 #endif // CONFIG_DSP_OPTIMIZED
 
@@ -17,6 +17,9 @@
 
 #include "dsp_err.h"
 
+// Largest pole shift accepted by dsps_biquad_coef_s16/s32, relative to the distance of the poles to z = 1, z = -1 or the unit circle
+#define DSPS_BIQUAD_MAX_POLE_ERROR 0.05
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -193,6 +196,31 @@ esp_err_t dsps_biquad_gen_lowShelf_f32(float *coeffs, float f, float gain, float
  */
 esp_err_t dsps_biquad_gen_highShelf_f32(float *coeffs, float f, float gain, float qFactor);
 
+/**@{*/
+/**
+ * @brief   fixed point IIR filter coefficients
+ *
+ * Converts coefficients made by the dsps_biquad_gen_*_f32 functions to the
+ * Q14 (s16) or Q30 (s32) format used by dsps_biquad_s16 and dsps_biquad_s32.
+ * b1 absorbs the rounding error of the other coefficients, so the DC gain of
+ * each quantized section stays exact. A section is rejected when rounding moves
+ * its poles by more than DSPS_BIQUAD_MAX_POLE_ERROR of their distance to z = 1,
+ * z = -1 or the unit circle (low cut-off frequencies in Q14).
+ * The implementation use ANSI C and could be compiled and run on any platform
+ *
+ * @param coeffs: b0,b1,b2,a1,a2 coefficients of each section (5 * n_sections)
+ * @param result: fixed point coefficients (5 * n_sections)
+ * @param n_sections: number of 2nd order sections
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_DSP_PARAM_OUTOFRANGE if a coefficient is outside -2..2 or the
+ *        poles can't be represented with enough precision
+ */
+esp_err_t dsps_biquad_coef_s16(const float *coeffs, int16_t *result, int n_sections);
+esp_err_t dsps_biquad_coef_s32(const float *coeffs, int32_t *result, int n_sections);
+/**@}*/
+
 #ifdef __cplusplus
 }
 #endif
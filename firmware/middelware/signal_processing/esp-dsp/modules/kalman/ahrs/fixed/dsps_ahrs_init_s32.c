@@ -0,0 +1,79 @@
+/*
+ * SPDX-FileCopyrightText: 2018-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "dsps_ahrs.h"
+
+#define Q30_ONE (1 << 30)
+
+static void dsps_ahrs_identity_s32(int32_t *q)
+{
+    q[0] = Q30_ONE;
+    q[1] = 0;
+    q[2] = 0;
+    q[3] = 0;
+}
+
+// Value in [0..2) to Q1.30
+static esp_err_t dsps_ahrs_q30(float value, int32_t *result)
+{
+    if ((value < 0) || (value >= 2)) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    *result = (int32_t)(value * Q30_ONE + 0.5f);
+    return ESP_OK;
+}
+
+// Gyroscope scale with the best precision: gyro_k in [2^29..2^30], gyro_shift >= 30
+static esp_err_t dsps_ahrs_gyro_k(float gyro_scale, float dt, int32_t *gyro_k, int16_t *gyro_shift)
+{
+    float k = gyro_scale * dt * 0.5f;
+    if ((k <= 0) || (k > 1)) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    int shift = 30;
+    while ((k < 0.5f) && (shift < 62)) {
+        k *= 2;
+        shift++;
+    }
+    *gyro_k = (int32_t)(k * Q30_ONE + 0.5f);
+    *gyro_shift = shift;
+    return ESP_OK;
+}
+
+esp_err_t dsps_madgwick_init_s32(ahrs_madgwick_s32_t *ahrs, float beta, float gyro_scale, float dt)
+{
+    if (dt <= 0) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    esp_err_t ret = dsps_ahrs_gyro_k(gyro_scale, dt, &ahrs->gyro_k, &ahrs->gyro_shift);
+    if (ret == ESP_OK) {
+        ret = dsps_ahrs_q30(beta * dt, &ahrs->beta_dt);
+    }
+    dsps_ahrs_identity_s32(ahrs->q);
+    return ret;
+}
+
+esp_err_t dsps_mahony_init_s32(ahrs_mahony_s32_t *ahrs, float kp, float ki, float gyro_scale, float dt)
+{
+    if (dt <= 0) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    esp_err_t ret = dsps_ahrs_gyro_k(gyro_scale, dt, &ahrs->gyro_k, &ahrs->gyro_shift);
+    if (ret == ESP_OK) {
+        ret = dsps_ahrs_q30(kp * dt * 0.5f, &ahrs->kp_k);
+    }
+    if (ret == ESP_OK) {
+        ret = dsps_ahrs_q30(ki * dt, &ahrs->ki_dt);
+    }
+    if (ret == ESP_OK) {
+        ret = dsps_ahrs_q30(dt * 0.5f, &ahrs->half_dt);
+    }
+    dsps_ahrs_identity_s32(ahrs->q);
+    for (int i = 0; i < 3; i++) {
+        ahrs->integral[i] = 0;
+    }
+    return ret;
+}
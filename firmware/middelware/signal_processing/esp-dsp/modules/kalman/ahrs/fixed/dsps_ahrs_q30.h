@@ -0,0 +1,76 @@
+/*
+ * SPDX-FileCopyrightText: 2018-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _dsps_ahrs_q30_H_
+#define _dsps_ahrs_q30_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Q1.30 helpers of the s32 attitude filters
+
+static inline int32_t dsps_ahrs_mul_q30(int32_t a, int32_t b)
+{
+    return (int32_t)(((int64_t)a * b + (1 << 29)) >> 30);
+}
+
+static inline int32_t dsps_ahrs_sat_q30(int64_t x)
+{
+    if (x > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (x < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (int32_t)x;
+}
+
+/**
+ * Scale the vector to unit length in Q1.30, the elements have to be less than 2^30
+ * by absolute value. 1/sqrt(sum) is found by table and Newton iterations, without division.
+ *
+ * @return false if the vector is zero
+ */
+static inline bool dsps_ahrs_normalize_q30(int32_t *v, int len)
+{
+    // 1/sqrt(x) for x in [1..4) by steps of 0.25, Q1.30
+    static const int32_t rsqrt_table[12] = {
+        1012333500, 915690104, 842312387, 784150157, 736580814, 696735698,
+        662727842, 633258380, 607400100, 584471019, 563956835, 545461392
+    };
+    uint64_t sum = 0;
+    for (int i = 0; i < len; i++) {
+        sum += (uint64_t)((int64_t)v[i] * v[i]);
+    }
+    if (sum == 0) {
+        return false;
+    }
+    // sum * 2^k in [2^60..2^62), k is even
+    int k = 60 - (63 - __builtin_clzll(sum));
+    k += k & 1;
+    uint64_t m = (k >= 0) ? (sum << k) : (sum >> -k);
+    int64_t x = (int64_t)(m >> 32); // Q2.28, [1..4)
+    int64_t y = rsqrt_table[(x >> 26) - 4];
+    for (int i = 0; i < 3; i++) {
+        int64_t y2 = (y * y) >> 30;
+        int64_t xy2 = (x * y2) >> 28;
+        y = (y * ((3LL << 30) - xy2)) >> 31;
+    }
+    // v / sqrt(sum) = v * y * 2^(k/2) in Q1.30
+    int shift = 30 - k / 2;
+    for (int i = 0; i < len; i++) {
+        int64_t r = (int64_t)v[i] * y;
+        if (shift > 0) {
+            r = (r + (1LL << (shift - 1))) >> shift;
+        } else {
+            r <<= -shift;
+        }
+        v[i] = (int32_t)r;
+    }
+    return true;
+}
+
+#endif // _dsps_ahrs_q30_H_
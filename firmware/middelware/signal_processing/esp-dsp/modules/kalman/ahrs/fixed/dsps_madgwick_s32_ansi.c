@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: 2018-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "dsps_ahrs.h"
+#include "dsps_ahrs_q30.h"
+
+esp_err_t dsps_madgwick_s32_ansi(ahrs_madgwick_s32_t *ahrs, const int16_t *motion)
+{
+    if (NULL == ahrs) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    int64_t q0 = ahrs->q[0];
+    int64_t q1 = ahrs->q[1];
+    int64_t q2 = ahrs->q[2];
+    int64_t q3 = ahrs->q[3];
+
+    // Half of the rotation angle of the step, Q1.30
+    int shift = ahrs->gyro_shift - 30;
+    int64_t round = (shift > 0) ? (1LL << (shift - 1)) : 0;
+    int64_t wx = ((int64_t)motion[3] * ahrs->gyro_k + round) >> shift;
+    int64_t wy = ((int64_t)motion[4] * ahrs->gyro_k + round) >> shift;
+    int64_t wz = ((int64_t)motion[5] * ahrs->gyro_k + round) >> shift;
+
+    // q += q x (0, w), Q2.60 products
+    int64_t dq0 = -q1 * wx - q2 * wy - q3 * wz;
+    int64_t dq1 = q0 * wx + q2 * wz - q3 * wy;
+    int64_t dq2 = q0 * wy - q1 * wz + q3 * wx;
+    int64_t dq3 = q0 * wz + q1 * wy - q2 * wx;
+
+    int32_t a[3] = {motion[0], motion[1], motion[2]};
+    if (dsps_ahrs_normalize_q30(a, 3)) {
+        // Error between the estimated and the measured gravity direction, Q3.28
+        int64_t f1 = ((2 * (q1 * q3 - q0 * q2)) >> 32) - (a[0] >> 2);
+        int64_t f2 = ((2 * (q0 * q1 + q2 * q3)) >> 32) - (a[1] >> 2);
+        int64_t f3 = (1 << 28) - ((2 * (q1 * q1 + q2 * q2)) >> 32) - (a[2] >> 2);
+
+        // Gradient J'*f, Q7.24
+        int32_t s[4];
+        s[0] = (int32_t)((-2 * q2 * f1 + 2 * q1 * f2) >> 34);
+        s[1] = (int32_t)((2 * q3 * f1 + 2 * q0 * f2 - 4 * q1 * f3) >> 34);
+        s[2] = (int32_t)((-2 * q0 * f1 + 2 * q3 * f2 - 4 * q2 * f3) >> 34);
+        s[3] = (int32_t)((2 * q1 * f1 + 2 * q2 * f2) >> 34);
+        if (dsps_ahrs_normalize_q30(s, 4)) {
+            int64_t k = ahrs->beta_dt;
+            dq0 -= k * s[0];
+            dq1 -= k * s[1];
+            dq2 -= k * s[2];
+            dq3 -= k * s[3];
+        }
+    }
+
+    int32_t q[4];
+    q[0] = (int32_t)(q0 + ((dq0 + (1 << 29)) >> 30));
+    q[1] = (int32_t)(q1 + ((dq1 + (1 << 29)) >> 30));
+    q[2] = (int32_t)(q2 + ((dq2 + (1 << 29)) >> 30));
+    q[3] = (int32_t)(q3 + ((dq3 + (1 << 29)) >> 30));
+    dsps_ahrs_normalize_q30(q, 4);
+    for (int i = 0; i < 4; i++) {
+        ahrs->q[i] = q[i];
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,61 @@
+/*
+ * SPDX-FileCopyrightText: 2018-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "dsps_ahrs.h"
+#include "dsps_ahrs_q30.h"
+
+esp_err_t dsps_mahony_s32_ansi(ahrs_mahony_s32_t *ahrs, const int16_t *motion)
+{
+    if (NULL == ahrs) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    int64_t q0 = ahrs->q[0];
+    int64_t q1 = ahrs->q[1];
+    int64_t q2 = ahrs->q[2];
+    int64_t q3 = ahrs->q[3];
+
+    // Half of the rotation angle of the step, Q1.30
+    int shift = ahrs->gyro_shift - 30;
+    int64_t round = (shift > 0) ? (1LL << (shift - 1)) : 0;
+    int32_t w[3];
+    for (int i = 0; i < 3; i++) {
+        w[i] = (int32_t)(((int64_t)motion[3 + i] * ahrs->gyro_k + round) >> shift);
+    }
+
+    int32_t a[3] = {motion[0], motion[1], motion[2]};
+    if (dsps_ahrs_normalize_q30(a, 3)) {
+        // Estimated gravity direction, Q1.30
+        int64_t vx = (2 * (q1 * q3 - q0 * q2)) >> 30;
+        int64_t vy = (2 * (q0 * q1 + q2 * q3)) >> 30;
+        int64_t vz = (q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3) >> 30;
+
+        // Error is the cross product of the measured and the estimated directions
+        int32_t e[3];
+        e[0] = (int32_t)((a[1] * vz - a[2] * vy) >> 30);
+        e[1] = (int32_t)((a[2] * vx - a[0] * vz) >> 30);
+        e[2] = (int32_t)((a[0] * vy - a[1] * vx) >> 30);
+
+        for (int i = 0; i < 3; i++) {
+            ahrs->integral[i] = dsps_ahrs_sat_q30((int64_t)ahrs->integral[i] + dsps_ahrs_mul_q30(ahrs->ki_dt, e[i]));
+            w[i] += dsps_ahrs_mul_q30(ahrs->kp_k, e[i]) + dsps_ahrs_mul_q30(ahrs->half_dt, ahrs->integral[i]);
+        }
+    }
+
+    // q += q x (0, w)
+    int64_t wx = w[0];
+    int64_t wy = w[1];
+    int64_t wz = w[2];
+    int32_t q[4];
+    q[0] = (int32_t)(q0 + ((-q1 * wx - q2 * wy - q3 * wz + (1 << 29)) >> 30));
+    q[1] = (int32_t)(q1 + ((q0 * wx + q2 * wz - q3 * wy + (1 << 29)) >> 30));
+    q[2] = (int32_t)(q2 + ((q0 * wy - q1 * wz + q3 * wx + (1 << 29)) >> 30));
+    q[3] = (int32_t)(q3 + ((q0 * wz + q1 * wy - q2 * wx + (1 << 29)) >> 30));
+    dsps_ahrs_normalize_q30(q, 4);
+    for (int i = 0; i < 4; i++) {
+        ahrs->q[i] = q[i];
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,42 @@
+/*
+ * SPDX-FileCopyrightText: 2018-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "dsps_ahrs.h"
+
+static void dsps_ahrs_identity_f32(float *q)
+{
+    q[0] = 1;
+    q[1] = 0;
+    q[2] = 0;
+    q[3] = 0;
+}
+
+esp_err_t dsps_madgwick_init_f32(ahrs_madgwick_f32_t *ahrs, float beta, float gyro_scale, float dt)
+{
+    if ((dt <= 0) || (beta < 0)) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    dsps_ahrs_identity_f32(ahrs->q);
+    ahrs->gyro_k = gyro_scale * dt * 0.5f;
+    ahrs->beta_dt = beta * dt;
+    return ESP_OK;
+}
+
+esp_err_t dsps_mahony_init_f32(ahrs_mahony_f32_t *ahrs, float kp, float ki, float gyro_scale, float dt)
+{
+    if ((dt <= 0) || (kp < 0) || (ki < 0)) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    dsps_ahrs_identity_f32(ahrs->q);
+    for (int i = 0; i < 3; i++) {
+        ahrs->integral[i] = 0;
+    }
+    ahrs->gyro_k = gyro_scale * dt * 0.5f;
+    ahrs->kp_k = kp * dt * 0.5f;
+    ahrs->ki_dt = ki * dt;
+    ahrs->half_dt = dt * 0.5f;
+    return ESP_OK;
+}
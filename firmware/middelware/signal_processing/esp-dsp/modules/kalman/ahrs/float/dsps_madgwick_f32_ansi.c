@@ -0,0 +1,71 @@
+/*
+ * SPDX-FileCopyrightText: 2018-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "dsps_ahrs.h"
+#include "dsps_sqrt.h"
+
+esp_err_t dsps_madgwick_f32_ansi(ahrs_madgwick_f32_t *ahrs, const int16_t *motion)
+{
+    if (NULL == ahrs) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    float q0 = ahrs->q[0];
+    float q1 = ahrs->q[1];
+    float q2 = ahrs->q[2];
+    float q3 = ahrs->q[3];
+
+    // Half of the rotation angle of the step
+    float wx = motion[3] * ahrs->gyro_k;
+    float wy = motion[4] * ahrs->gyro_k;
+    float wz = motion[5] * ahrs->gyro_k;
+
+    // q += q x (0, w)
+    float dq0 = -q1 * wx - q2 * wy - q3 * wz;
+    float dq1 = q0 * wx + q2 * wz - q3 * wy;
+    float dq2 = q0 * wy - q1 * wz + q3 * wx;
+    float dq3 = q0 * wz + q1 * wy - q2 * wx;
+
+    float a2 = (float)motion[0] * motion[0] + (float)motion[1] * motion[1] + (float)motion[2] * motion[2];
+    if (a2 > 0) {
+        float inv_a = dsps_inverted_sqrtf_f32_ansi(a2);
+        float ax = motion[0] * inv_a;
+        float ay = motion[1] * inv_a;
+        float az = motion[2] * inv_a;
+
+        // Error between the estimated and the measured gravity direction
+        float f1 = 2 * (q1 * q3 - q0 * q2) - ax;
+        float f2 = 2 * (q0 * q1 + q2 * q3) - ay;
+        float f3 = 1 - 2 * (q1 * q1 + q2 * q2) - az;
+
+        // Gradient J'*f
+        float s0 = -2 * q2 * f1 + 2 * q1 * f2;
+        float s1 = 2 * q3 * f1 + 2 * q0 * f2 - 4 * q1 * f3;
+        float s2 = -2 * q0 * f1 + 2 * q3 * f2 - 4 * q2 * f3;
+        float s3 = 2 * q1 * f1 + 2 * q2 * f2;
+        float s2_sum = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+        if (s2_sum > 0) {
+            float k = ahrs->beta_dt * dsps_inverted_sqrtf_f32_ansi(s2_sum);
+            dq0 -= k * s0;
+            dq1 -= k * s1;
+            dq2 -= k * s2;
+            dq3 -= k * s3;
+        }
+    }
+
+    q0 += dq0;
+    q1 += dq1;
+    q2 += dq2;
+    q3 += dq3;
+    // One more Newton step: the norm error of the quaternion is 1e-6 instead of 2e-3
+    float q2_sum = q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3;
+    float inv_q = dsps_inverted_sqrtf_f32_ansi(q2_sum);
+    inv_q *= 1.5f - 0.5f * q2_sum * inv_q * inv_q;
+    ahrs->q[0] = q0 * inv_q;
+    ahrs->q[1] = q1 * inv_q;
+    ahrs->q[2] = q2 * inv_q;
+    ahrs->q[3] = q3 * inv_q;
+    return ESP_OK;
+}
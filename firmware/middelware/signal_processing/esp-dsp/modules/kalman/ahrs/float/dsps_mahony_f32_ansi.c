@@ -0,0 +1,64 @@
+/*
+ * SPDX-FileCopyrightText: 2018-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "dsps_ahrs.h"
+#include "dsps_sqrt.h"
+
+esp_err_t dsps_mahony_f32_ansi(ahrs_mahony_f32_t *ahrs, const int16_t *motion)
+{
+    if (NULL == ahrs) {
+        return ESP_ERR_DSP_PARAM_OUTOFRANGE;
+    }
+    float q0 = ahrs->q[0];
+    float q1 = ahrs->q[1];
+    float q2 = ahrs->q[2];
+    float q3 = ahrs->q[3];
+
+    // Half of the rotation angle of the step
+    float wx = motion[3] * ahrs->gyro_k;
+    float wy = motion[4] * ahrs->gyro_k;
+    float wz = motion[5] * ahrs->gyro_k;
+
+    float a2 = (float)motion[0] * motion[0] + (float)motion[1] * motion[1] + (float)motion[2] * motion[2];
+    if (a2 > 0) {
+        float inv_a = dsps_inverted_sqrtf_f32_ansi(a2);
+        float ax = motion[0] * inv_a;
+        float ay = motion[1] * inv_a;
+        float az = motion[2] * inv_a;
+
+        // Estimated gravity direction
+        float vx = 2 * (q1 * q3 - q0 * q2);
+        float vy = 2 * (q0 * q1 + q2 * q3);
+        float vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+
+        // Error is the cross product of the measured and the estimated directions
+        float ex = ay * vz - az * vy;
+        float ey = az * vx - ax * vz;
+        float ez = ax * vy - ay * vx;
+
+        ahrs->integral[0] += ahrs->ki_dt * ex;
+        ahrs->integral[1] += ahrs->ki_dt * ey;
+        ahrs->integral[2] += ahrs->ki_dt * ez;
+        wx += ahrs->kp_k * ex + ahrs->half_dt * ahrs->integral[0];
+        wy += ahrs->kp_k * ey + ahrs->half_dt * ahrs->integral[1];
+        wz += ahrs->kp_k * ez + ahrs->half_dt * ahrs->integral[2];
+    }
+
+    // q += q x (0, w)
+    float n0 = q0 - q1 * wx - q2 * wy - q3 * wz;
+    float n1 = q1 + q0 * wx + q2 * wz - q3 * wy;
+    float n2 = q2 + q0 * wy - q1 * wz + q3 * wx;
+    float n3 = q3 + q0 * wz + q1 * wy - q2 * wx;
+    // One more Newton step: the norm error of the quaternion is 1e-6 instead of 2e-3
+    float n2_sum = n0 * n0 + n1 * n1 + n2 * n2 + n3 * n3;
+    float inv_q = dsps_inverted_sqrtf_f32_ansi(n2_sum);
+    inv_q *= 1.5f - 0.5f * n2_sum * inv_q * inv_q;
+    ahrs->q[0] = n0 * inv_q;
+    ahrs->q[1] = n1 * inv_q;
+    ahrs->q[2] = n2 * inv_q;
+    ahrs->q[3] = n3 * inv_q;
+    return ESP_OK;
+}
@@ -0,0 +1,180 @@
+/*
+ * SPDX-FileCopyrightText: 2018-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _dsps_ahrs_H_
+#define _dsps_ahrs_H_
+
+#include <stdint.h>
+#include "dsp_err.h"
+
+/**
+ * @brief Attitude of the quaternion filters
+ *
+ * The filters keep the attitude quaternion q = {w, x, y, z} of the sensor frame
+ * relative to the earth frame, the same as X[0..3] of ekf_imu13states.
+ * The input of a filter step is the raw sample of 6-axis IMU in the order of
+ * MPU6050_getMotion6(): {ax, ay, az, gx, gy, gz}.
+ * The accelerometer is used only as direction, any scale could be used.
+ * The gyroscope is converted by gyro_scale, rad/sec per LSB:
+ * for the +-250 deg/sec range of MPU6050 it is (M_PI / 180) / 131.
+ * The filters have no magnetometer, so only the tilt is corrected and the
+ * heading follows the gyroscope.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief Data struct of f32 Madgwick filter
+ *
+ * All fields of this structure are initialized by the dsps_madgwick_init_f32(...) function.
+ */
+typedef struct ahrs_madgwick_f32_s {
+    float q[4];         /*!< Attitude quaternion {w, x, y, z}.*/
+    float gyro_k;       /*!< Gyroscope LSB to half of the rotation angle of one step: gyro_scale * dt / 2.*/
+    float beta_dt;      /*!< Gradient descent step: beta * dt.*/
+} ahrs_madgwick_f32_t;
+
+/**
+ * @brief Data struct of f32 Mahony filter
+ *
+ * All fields of this structure are initialized by the dsps_mahony_init_f32(...) function.
+ */
+typedef struct ahrs_mahony_f32_s {
+    float q[4];         /*!< Attitude quaternion {w, x, y, z}.*/
+    float integral[3];  /*!< Integral feedback, estimated gyroscope bias in rad/sec with opposite sign.*/
+    float gyro_k;       /*!< Gyroscope LSB to half of the rotation angle of one step: gyro_scale * dt / 2.*/
+    float kp_k;         /*!< Proportional feedback: kp * dt / 2.*/
+    float ki_dt;        /*!< Integral feedback: ki * dt.*/
+    float half_dt;      /*!< Half of the sample period: dt / 2.*/
+} ahrs_mahony_f32_t;
+
+/**
+ * @brief Data struct of s32 Madgwick filter
+ *
+ * The quaternion and the coefficients are in Q1.30 format.
+ * All fields of this structure are initialized by the dsps_madgwick_init_s32(...) function.
+ */
+typedef struct ahrs_madgwick_s32_s {
+    int32_t q[4];       /*!< Attitude quaternion {w, x, y, z}, Q1.30.*/
+    int32_t gyro_k;     /*!< Gyroscope LSB to half of the rotation angle of one step, gyro_scale * dt / 2 * 2^(gyro_shift).*/
+    int16_t gyro_shift; /*!< Shift of gyro_k.*/
+    int32_t beta_dt;    /*!< Gradient descent step: beta * dt, Q1.30.*/
+} ahrs_madgwick_s32_t;
+
+/**
+ * @brief Data struct of s32 Mahony filter
+ *
+ * The quaternion and the coefficients are in Q1.30 format.
+ * All fields of this structure are initialized by the dsps_mahony_init_s32(...) function.
+ */
+typedef struct ahrs_mahony_s32_s {
+    int32_t q[4];           /*!< Attitude quaternion {w, x, y, z}, Q1.30.*/
+    int32_t integral[3];    /*!< Integral feedback in rad/sec, Q1.30.*/
+    int32_t gyro_k;         /*!< Gyroscope LSB to half of the rotation angle of one step, gyro_scale * dt / 2 * 2^(gyro_shift).*/
+    int16_t gyro_shift;     /*!< Shift of gyro_k.*/
+    int32_t kp_k;           /*!< Proportional feedback: kp * dt / 2, Q1.30.*/
+    int32_t ki_dt;          /*!< Integral feedback: ki * dt, Q1.30.*/
+    int32_t half_dt;        /*!< Half of the sample period: dt / 2, Q1.30.*/
+} ahrs_mahony_s32_t;
+
+/**@{*/
+/**
+ * @brief   Initialization of Madgwick filter
+ *
+ * The function initializes the filter structure, the attitude is set to the identity quaternion.
+ *
+ * @param ahrs: pointer to filter structure
+ * @param beta: gain of the accelerometer correction, rad/sec. 0.033..0.1 is a typical value
+ * @param gyro_scale: gyroscope scale, rad/sec per LSB
+ * @param dt: sample period, sec
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_madgwick_init_f32(ahrs_madgwick_f32_t *ahrs, float beta, float gyro_scale, float dt);
+esp_err_t dsps_madgwick_init_s32(ahrs_madgwick_s32_t *ahrs, float beta, float gyro_scale, float dt);
+/**@}*/
+
+/**@{*/
+/**
+ * @brief   Initialization of Mahony filter
+ *
+ * The function initializes the filter structure, the attitude is set to the identity quaternion.
+ *
+ * @param ahrs: pointer to filter structure
+ * @param kp: proportional gain of the accelerometer correction, 1/sec. 0.5..2 is a typical value
+ * @param ki: integral gain of the accelerometer correction, 1/sec^2. 0 disables the gyroscope bias estimation
+ * @param gyro_scale: gyroscope scale, rad/sec per LSB
+ * @param dt: sample period, sec
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_mahony_init_f32(ahrs_mahony_f32_t *ahrs, float kp, float ki, float gyro_scale, float dt);
+esp_err_t dsps_mahony_init_s32(ahrs_mahony_s32_t *ahrs, float kp, float ki, float gyro_scale, float dt);
+/**@}*/
+
+/**@{*/
+/**
+ * @brief   Madgwick filter step
+ *
+ * The attitude is integrated from the gyroscope and corrected by one step of
+ * gradient descent to the accelerometer direction. Fixed-size state, no allocation.
+ * The implementation use ANSI C and could be compiled and run on any platform
+ *
+ * @param ahrs: pointer to filter structure
+ * @param[in] motion: raw sample {ax, ay, az, gx, gy, gz}, the output of MPU6050_getMotion6()
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_madgwick_f32_ansi(ahrs_madgwick_f32_t *ahrs, const int16_t *motion);
+esp_err_t dsps_madgwick_s32_ansi(ahrs_madgwick_s32_t *ahrs, const int16_t *motion);
+/**@}*/
+
+/**@{*/
+/**
+ * @brief   Mahony filter step
+ *
+ * The attitude is integrated from the gyroscope, corrected by proportional and
+ * integral feedback of the error between the measured and the estimated gravity
+ * direction. Fixed-size state, no allocation.
+ * The implementation use ANSI C and could be compiled and run on any platform
+ *
+ * @param ahrs: pointer to filter structure
+ * @param[in] motion: raw sample {ax, ay, az, gx, gy, gz}, the output of MPU6050_getMotion6()
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_mahony_f32_ansi(ahrs_mahony_f32_t *ahrs, const int16_t *motion);
+esp_err_t dsps_mahony_s32_ansi(ahrs_mahony_s32_t *ahrs, const int16_t *motion);
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#if CONFIG_DSP_OPTIMIZED
+#define dsps_madgwick_f32 dsps_madgwick_f32_ansi
+#define dsps_madgwick_s32 dsps_madgwick_s32_ansi
+#define dsps_mahony_f32 dsps_mahony_f32_ansi
+#define dsps_mahony_s32 dsps_mahony_s32_ansi
+#else // CONFIG_DSP_OPTIMIZED
+#define dsps_madgwick_f32 dsps_madgwick_f32_ansi
+#define dsps_madgwick_s32 dsps_madgwick_s32_ansi
+#define dsps_mahony_f32 dsps_mahony_f32_ansi
+#define dsps_mahony_s32 dsps_mahony_s32_ansi
+#endif // CONFIG_DSP_OPTIMIZED
+
+#endif // _dsps_ahrs_H_
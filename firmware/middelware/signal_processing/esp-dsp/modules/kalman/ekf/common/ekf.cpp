@@ -15,22 +15,29 @@
 #include "ekf.h"
 #include <float.h>
 
-ekf::ekf(int x, int w) : NUMX(x),
+ekf::ekf(int x, int w, int scratch) : NUMX(x),
     NUMW(w),
     X(*new dspm::Mat(x, 1)),
 
     F(*new dspm::Mat(x, x)),
     G(*new dspm::Mat(x, w)),
     P(*new dspm::Mat(x, x)),
-    Q(*new dspm::Mat(w, w))
+    Q(*new dspm::Mat(w, w)),
+    scratch(scratch > 0 ? scratch : ScratchSize(x, w))
 {
 
     this->P *= 0;
     this->Q *= 0;
     this->X *= 0;
     this->X.data[0] = 1; // direction to 0
+    this->innovation_gate = 0;
+    this->rejected = 0;
     this->HP = new float[this->NUMX];
     this->Km = new float[this->NUMX];
+    this->f_nonzero.start = new int[this->NUMX + 1];
+    this->f_nonzero.cols = new uint16_t[this->NUMX * this->NUMX];
+    this->g_nonzero.start = new int[this->NUMX + 1];
+    this->g_nonzero.cols = new uint16_t[this->NUMX * this->NUMW];
     for (size_t i = 0; i < this->NUMX; i++) {
         this->HP[i] = 0;
         this->Km[i] = 0;
@@ -47,10 +54,23 @@ ekf::~ekf()
 
     delete this->HP;
     delete this->Km;
+    delete[] this->f_nonzero.start;
+    delete[] this->f_nonzero.cols;
+    delete[] this->g_nonzero.start;
+    delete[] this->g_nonzero.cols;
+}
+
+int ekf::ScratchSize(int x, int w)
+{
+    // The covariance prediction keeps two x*x and one x*w temporaries;
+    // the largest step is UpdateRef() with up to x measurements, it keeps
+    // about twelve x*x temporaries alive at the same time
+    return 12 * x * x + x * w;
 }
 
 void ekf::Process(float *u, float dt)
 {
+    dspm::MatArena::Scope scope(this->scratch);
     this->LinearizeFG(this->X, (float *)u);
     this->RungeKutta(this->X, u, dt);
     this->CovariancePrediction(dt);
@@ -77,14 +97,13 @@ void ekf::RungeKutta(dspm::Mat &x, float *U, float dt)
     x = Xlast + (K1 + 2.0f * K2 + 2.0f * K3 + K4) * (dt / 6.0f);
 }
 
-dspm::Mat ekf::SkewSym4x4(float w[3])
+void ekf::SkewSym4x4(const float *w, dspm::MatN<4, 4> &result)
 {
     //={    0,  -w[0],  -w[1],  -w[2],
     //   w[0],      0,   w[2],  -w[1],
     //   w[1],  -w[2],      0,   w[0],
     //   w[2],   w[1],  -w[0],     0 };
 
-    dspm::Mat result(4, 4);
     result.data[0] = 0;
     result.data[1] = -w[0];
     result.data[2] = -w[1];
@@ -104,14 +123,17 @@ dspm::Mat ekf::SkewSym4x4(float w[3])
     result.data[13] = w[1];
     result.data[14] = -w[0];
     result.data[15] = 0;
-
-    return result;
 }
 
-dspm::Mat ekf::qProduct(float *q)
+dspm::Mat ekf::SkewSym4x4(float w[3])
 {
-    dspm::Mat result(4, 4);
+    dspm::MatN<4, 4> result;
+    SkewSym4x4(w, result);
+    return result.toMat();
+}
 
+void ekf::qProduct(const float *q, dspm::MatN<4, 4> &result)
+{
     result.data[0] = q[0];
     result.data[1] = -q[1];
     result.data[2] = -q[2];
@@ -131,18 +153,84 @@ dspm::Mat ekf::qProduct(float *q)
     result.data[13] = -q[2];
     result.data[14] = q[1];
     result.data[15] = q[0];
+}
 
-    return result;
+dspm::Mat ekf::qProduct(float *q)
+{
+    dspm::MatN<4, 4> result;
+    qProduct(q, result);
+    return result.toMat();
 }
 
 void ekf::CovariancePrediction(float dt)
 {
-    dspm::Mat f = this->F * dt;
-
-    f = f + dspm::Mat::eye(this->NUMX);
+    int n = this->NUMX;
+    int w = this->NUMW;
+    // Nonzero values of f = I + F*dt, in the order of f_nonzero
+    dspm::Mat f_values(n, n);
+    int pos = 0;
+    for (int i = 0; i < n; i++) {
+        this->f_nonzero.start[i] = pos;
+        for (int j = 0; j < n; j++) {
+            float value = this->F(i, j) * dt + ((i == j) ? 1.0f : 0.0f);
+            if (value != 0) {
+                this->f_nonzero.cols[pos] = j;
+                f_values.data[pos++] = value;
+            }
+        }
+    }
+    this->f_nonzero.start[n] = pos;
+    pos = 0;
+    for (int i = 0; i < n; i++) {
+        this->g_nonzero.start[i] = pos;
+        for (int j = 0; j < w; j++) {
+            if (this->G(i, j) != 0) {
+                this->g_nonzero.cols[pos++] = j;
+            }
+        }
+    }
+    this->g_nonzero.start[n] = pos;
+
+    // fP = f*P
+    dspm::Mat fP(n, n);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            float acc = 0;
+            for (int k = this->f_nonzero.start[i]; k < this->f_nonzero.start[i + 1]; k++) {
+                acc += f_values.data[k] * this->P(this->f_nonzero.cols[k], j);
+            }
+            fP(i, j) = acc;
+        }
+    }
+    // GQ = G*Q
+    dspm::Mat GQ(n, w);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < w; j++) {
+            float acc = 0;
+            for (int k = this->g_nonzero.start[i]; k < this->g_nonzero.start[i + 1]; k++) {
+                int col = this->g_nonzero.cols[k];
+                acc += this->G(i, col) * this->Q(col, j);
+            }
+            GQ(i, j) = acc;
+        }
+    }
 
-    dspm::Mat f_t = f.t();
-    this->P = ((f * this->P) * f_t) + (dt * dt) * ((G * Q) * G.t());
+    // P = fP*f' + dt^2*GQ*G', upper triangle
+    float dt2 = dt * dt;
+    for (int i = 0; i < n; i++) {
+        for (int j = i; j < n; j++) {
+            float fpf = 0;
+            for (int k = this->f_nonzero.start[j]; k < this->f_nonzero.start[j + 1]; k++) {
+                fpf += fP(i, this->f_nonzero.cols[k]) * f_values.data[k];
+            }
+            float gqg = 0;
+            for (int k = this->g_nonzero.start[j]; k < this->g_nonzero.start[j + 1]; k++) {
+                int col = this->g_nonzero.cols[k];
+                gqg += GQ(i, col) * this->G(j, col);
+            }
+            this->P(i, j) = this->P(j, i) = fpf + dt2 * gqg;
+        }
+    }
 }
 
 void ekf::Update(dspm::Mat &H, float *measured, float *expected, float *R)
@@ -185,17 +273,73 @@ void ekf::Update(dspm::Mat &H, float *measured, float *expected, float *R)
     }
 }
 
+int ekf::UpdateSequential(dspm::Mat &H, float *measured, float *expected, float *R, float gate)
+{
+    int result = 0;
+    for (int m = 0; m < H.rows; m++) {
+        // Find hp = h*P, only nonzero elements of h
+        for (int j = 0; j < this->NUMX; j++) {
+            HP[j] = 0;
+        }
+        for (int k = 0; k < this->NUMX; k++) {
+            float h = H(m, k);
+            if (h == 0) {
+                continue;
+            }
+            for (int j = 0; j < this->NUMX; j++) {
+                HP[j] += h * P(k, j);
+            }
+        }
+        // Find innovation variance s = h*P*h' + r
+        float s = R[m];
+        for (int k = 0; k < this->NUMX; k++) {
+            s += HP[k] * H(m, k);
+        }
+        float error = measured[m] - expected[m];
+        if ((gate > 0) && (error * error > gate * gate * s)) {
+            result++;
+            continue;
+        }
+        float inv_s = 1.0f / s;
+        for (int k = 0; k < this->NUMX; k++) {
+            Km[k] = HP[k] * inv_s; // find K = hp'/s
+        }
+        // Joseph form for a scalar measurement, s = h*P*h' + r:
+        // (I - K*h)*P*(I - K*h)' + K*r*K' = P - K*hp - hp'*K' + s*K*K'
+        for (int i = 0; i < this->NUMX; i++) {
+            float sk = s * Km[i];
+            for (int j = i; j < this->NUMX; j++) {
+                P(i, j) = P(j, i) = P(i, j) - Km[i] * HP[j] - HP[i] * Km[j] + sk * Km[j];
+            }
+        }
+        for (int i = 0; i < this->NUMX; i++) {
+            X(i, 0) += Km[i] * error;
+        }
+    }
+    this->rejected += result;
+    return result;
+}
+
 void ekf::UpdateRef(dspm::Mat &H, float *measured, float *expected, float *R)
 {
+    dspm::MatArena::Scope scope(this->scratch);
     dspm::Mat h_t = H.t();
     dspm::Mat S = H * P * h_t; // +diag(R);
     for (size_t i = 0; i < H.rows; i++) {
         S(i, i) += R[i];
     }
 
-    dspm::Mat S_ = S.pinv(); // 1 / S
-
-    dspm::Mat K = (P * h_t) * S_;
+    // K = P*H'/S, P and S are symmetric: K' = S \ (H*P)
+    dspm::Mat K_t = H * P;
+    dspm::Mat LDL = S;
+    dspm::Mat K;
+    if (LDL.choleskyDecompose()) {
+        LDL.choleskySolve(K_t);
+        K = K_t.t();
+    } else {
+        // S lost positive definiteness
+        K = (P * h_t) * S.pinv();
+    }
     this->P = (dspm::Mat::eye(this->NUMX) - K * H) * P;
 
     dspm::Mat Y(measured, H.rows, 1);
@@ -205,13 +349,12 @@ void ekf::UpdateRef(dspm::Mat &H, float *measured, float *expected, float *R)
     this->X += (K * Err);
 }
 
-dspm::Mat ekf::quat2rotm(float q[4])
+void ekf::quat2rotm(const float q[4], dspm::MatN<3, 3> &Rm)
 {
     float q0 = q[0];
     float q1 = q[1];
     float q2 = q[2];
     float q3 = q[3];
-    dspm::Mat Rm(3, 3);
 
     Rm(0, 0) = q0 * q0 + q1 * q1 - q2 * q2 - q3 * q3;
     Rm(1, 0) = 2.0f * (q1 * q2 + q0 * q3);
@@ -222,8 +365,13 @@ dspm::Mat ekf::quat2rotm(float q[4])
     Rm(0, 2) = 2.0f * (q1 * q3 + q0 * q2);
     Rm(1, 2) = 2.0f * (q2 * q3 - q0 * q1);
     Rm(2, 2) = (q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3);
+}
 
-    return Rm;
+dspm::Mat ekf::quat2rotm(float q[4])
+{
+    dspm::MatN<3, 3> Rm;
+    quat2rotm(q, Rm);
+    return Rm.toMat();
 }
 
 dspm::Mat ekf::quat2eul(const float q[4])
@@ -363,48 +511,58 @@ dspm::Mat ekf::rotm2quat(dspm::Mat &m)
     return res;
 }
 
-dspm::Mat ekf::dFdq(dspm::Mat &vector, dspm::Mat &q)
+void ekf::dFdq(const float *vector, const float *q, dspm::MatN<3, 4> &result)
 {
-    dspm::Mat result(3, 4);
-    result(0, 0) = q.data[0] * vector.data[0] - q.data[3] * vector.data[1] + q.data[2] * vector.data[2];
-    result(0, 1) = q.data[1] * vector.data[0] + q.data[2] * vector.data[1] + q.data[3] * vector.data[2];
-    result(0, 2) = -q.data[2] * vector.data[0] + q.data[1] * vector.data[1] + q.data[0] * vector.data[2];
-    result(0, 3) = -q.data[3] * vector.data[0] - q.data[0] * vector.data[1] + q.data[1] * vector.data[2];
-
-    result(1, 0) = q.data[3] * vector.data[0] + q.data[0] * vector.data[1] - q.data[1] * vector.data[2];
-    result(1, 1) = q.data[2] * vector.data[0] - q.data[1] * vector.data[1] - q.data[0] * vector.data[2];
-    result(1, 2) = q.data[1] * vector.data[0] + q.data[2] * vector.data[1] + q.data[3] * vector.data[2];
-    result(1, 3) = q.data[0] * vector.data[0] - q.data[3] * vector.data[1] + q.data[2] * vector.data[2];
-
-    result(2, 0) = -q.data[2] * vector.data[0] + q.data[1] * vector.data[1] + q.data[0] * vector.data[2];
-    result(2, 1) = q.data[3] * vector.data[0] + q.data[0] * vector.data[1] - q.data[1] * vector.data[2];
-    result(2, 2) = -q.data[0] * vector.data[0] + q.data[3] * vector.data[1] - q.data[2] * vector.data[2];
-    result(2, 3) = q.data[1] * vector.data[0] + q.data[2] * vector.data[1] + q.data[3] * vector.data[2];
+    result(0, 0) = q[0] * vector[0] - q[3] * vector[1] + q[2] * vector[2];
+    result(0, 1) = q[1] * vector[0] + q[2] * vector[1] + q[3] * vector[2];
+    result(0, 2) = -q[2] * vector[0] + q[1] * vector[1] + q[0] * vector[2];
+    result(0, 3) = -q[3] * vector[0] - q[0] * vector[1] + q[1] * vector[2];
+
+    result(1, 0) = q[3] * vector[0] + q[0] * vector[1] - q[1] * vector[2];
+    result(1, 1) = q[2] * vector[0] - q[1] * vector[1] - q[0] * vector[2];
+    result(1, 2) = q[1] * vector[0] + q[2] * vector[1] + q[3] * vector[2];
+    result(1, 3) = q[0] * vector[0] - q[3] * vector[1] + q[2] * vector[2];
+
+    result(2, 0) = -q[2] * vector[0] + q[1] * vector[1] + q[0] * vector[2];
+    result(2, 1) = q[3] * vector[0] + q[0] * vector[1] - q[1] * vector[2];
+    result(2, 2) = -q[0] * vector[0] + q[3] * vector[1] - q[2] * vector[2];
+    result(2, 3) = q[1] * vector[0] + q[2] * vector[1] + q[3] * vector[2];
 
     result *= 2;
-    return result;
 }
 
-dspm::Mat ekf::dFdq_inv(dspm::Mat &vector, dspm::Mat &q)
+dspm::Mat ekf::dFdq(dspm::Mat &vector, dspm::Mat &q)
 {
-    dspm::Mat result(3, 4);
-    result(0, 0) = q.data[0] * vector.data[0] + q.data[3] * vector.data[1] - q.data[2] * vector.data[2];
-    result(0, 1) = q.data[1] * vector.data[0] + q.data[2] * vector.data[1] + q.data[3] * vector.data[2];
-    result(0, 2) = -q.data[2] * vector.data[0] + q.data[1] * vector.data[1] - q.data[0] * vector.data[2];
-    result(0, 3) = -q.data[3] * vector.data[0] + q.data[0] * vector.data[1] + q.data[1] * vector.data[2];
-
-    result(1, 0) = -q.data[3] * vector.data[0] + q.data[0] * vector.data[1] + q.data[1] * vector.data[2];
-    result(1, 1) = q.data[2] * vector.data[0] - q.data[1] * vector.data[1] + q.data[0] * vector.data[2];
-    result(1, 2) = q.data[1] * vector.data[0] + q.data[2] * vector.data[1] + q.data[3] * vector.data[2];
-    result(1, 3) = -q.data[0] * vector.data[0] - q.data[3] * vector.data[1] + q.data[2] * vector.data[2];
-
-    result(2, 0) = q.data[2] * vector.data[0] - q.data[1] * vector.data[1] + q.data[0] * vector.data[2];
-    result(2, 1) = q.data[3] * vector.data[0] - q.data[0] * vector.data[1] - q.data[1] * vector.data[2];
-    result(2, 2) = q.data[0] * vector.data[0] + q.data[3] * vector.data[1] - q.data[2] * vector.data[2];
-    result(2, 3) = q.data[1] * vector.data[0] + q.data[2] * vector.data[1] + q.data[3] * vector.data[2];
+    dspm::MatN<3, 4> result;
+    dFdq(vector.data, q.data, result);
+    return result.toMat();
+}
+
+void ekf::dFdq_inv(const float *vector, const float *q, dspm::MatN<3, 4> &result)
+{
+    result(0, 0) = q[0] * vector[0] + q[3] * vector[1] - q[2] * vector[2];
+    result(0, 1) = q[1] * vector[0] + q[2] * vector[1] + q[3] * vector[2];
+    result(0, 2) = -q[2] * vector[0] + q[1] * vector[1] - q[0] * vector[2];
+    result(0, 3) = -q[3] * vector[0] + q[0] * vector[1] + q[1] * vector[2];
+
+    result(1, 0) = -q[3] * vector[0] + q[0] * vector[1] + q[1] * vector[2];
+    result(1, 1) = q[2] * vector[0] - q[1] * vector[1] + q[0] * vector[2];
+    result(1, 2) = q[1] * vector[0] + q[2] * vector[1] + q[3] * vector[2];
+    result(1, 3) = -q[0] * vector[0] - q[3] * vector[1] + q[2] * vector[2];
+
+    result(2, 0) = q[2] * vector[0] - q[1] * vector[1] + q[0] * vector[2];
+    result(2, 1) = q[3] * vector[0] - q[0] * vector[1] - q[1] * vector[2];
+    result(2, 2) = q[0] * vector[0] + q[3] * vector[1] - q[2] * vector[2];
+    result(2, 3) = q[1] * vector[0] + q[2] * vector[1] + q[3] * vector[2];
 
     result *= 2;
-    return result;
+}
+
+dspm::Mat ekf::dFdq_inv(dspm::Mat &vector, dspm::Mat &q)
+{
+    dspm::MatN<3, 4> result;
+    dFdq_inv(vector.data, q.data, result);
+    return result.toMat();
 }
 
 dspm::Mat ekf::StateXdot(dspm::Mat &x, float *u)
@@ -21,6 +21,7 @@
 #include <math.h>
 #include <stdint.h>
 #include <mat.h>
+#include <mat_n.h>
 
 /**
  * The ekf is a base class for Extended Kalman Filter.
@@ -34,8 +35,10 @@ public:
      * THe constructor allocate main memory for the matrixes.
      * @param[in] x: - amount of states in EKF. x[n] = F*x[n-1] + G*u + W. Size of matrix F
      * @param[in] w: - amount of control measurements and noise inputs. Size of matrix G
+     * @param[in] scratch: - size of the scratch memory for temporary matrices in floats,
+     *                       0 to use the default size for x and w
     */
-    ekf(int x, int w);
+    ekf(int x, int w, int scratch = 0);
 
 
     /**
@@ -125,6 +128,9 @@ public:
     /**
      * Calculates covariance prediction matrux P.
      * Update matrix P
+     * P = f*P*f' + dt^2*G*Q*G', where f = I + F*dt.
+     * Only the nonzero elements of f and G are used, and only the upper
+     * triangle of the symmetric result is calculated and copied to the lower one.
      * @param[in] dt: time interval from last update
      */
     virtual void CovariancePrediction(float dt);
@@ -139,10 +145,29 @@ public:
      * @param[in] R: measurement noise covariance values
      */
     virtual void Update(dspm::Mat &H, float *measured, float *expected, float *R);
+    /**
+     * Sequential update of current state by measured values with diagonal R.
+     * The measurements are processed one at a time as scalars, and P is updated
+     * by the rank-1 Joseph form P = (I - K*h)*P*(I - K*h)' + K*r*K', that keeps P
+     * symmetric and positive. No matrix inversion and no temporary matrices,
+     * O(NUMX^2) operations per measurement.
+     * A measurement with the innovation e outside of the gate, e^2 > gate^2*(h*P*h' + r),
+     * is rejected as an outlier and does not change X and P.
+     * @param[in] H: derivative matrix
+     * @param[in] measured: array of measured values
+     * @param[in] expected: array of expected values
+     * @param[in] R: measurement noise covariance values
+     * @param[in] gate: innovation gate in standard deviations, 0 - no gate
+     *
+     * @return
+     *      - amount of rejected measurements
+     */
+    virtual int UpdateSequential(dspm::Mat &H, float *measured, float *expected, float *R, float gate = 0);
     /**
      * Update of current state by measured values.
      * This method just as a reference for research purpose.
      * Not used in real calculations.
+     * The Kalman gain is found by Cholesky (LDL') solve of the innovation covariance.
      * @param[in] H: derivative matrix
      * @param[in] measured: array of measured values
      * @param[in] expected: array of expected values
@@ -150,6 +175,15 @@ public:
      */
     virtual void UpdateRef(dspm::Mat &H, float *measured, float *expected, float *R);
 
+    /**
+     * Innovation gate of the measurement updates in standard deviations, 0 - no gate
+    */
+    float innovation_gate;
+    /**
+     * Amount of measurements rejected by the innovation gate
+    */
+    int rejected;
+
     /**
      * Matrix for intermidieve calculations
     */
@@ -159,6 +193,40 @@ public:
     */
     float *Km;
 
+    /**
+     * Nonzero elements of a matrix by rows
+    */
+    struct SparseRows {
+        int *start;         /*!< Position of the first element of each row in cols, [rows + 1]*/
+        uint16_t *cols;     /*!< Column indexes of the nonzero elements*/
+    };
+    /**
+     * Nonzero elements of f = I + F*dt, found at every covariance prediction
+    */
+    SparseRows f_nonzero;
+    /**
+     * Nonzero elements of G, found at every covariance prediction
+    */
+    SparseRows g_nonzero;
+
+    /**
+     * Scratch memory for the temporary matrices of one filter step.
+     * Process() and the update methods take all temporary matrices from it,
+     * so the processing loop does no heap allocations. The high_water and
+     * overflows fields show if the size has to be changed by scratch.resize().
+    */
+    dspm::MatArena scratch;
+
+    /**
+     * Default size of the scratch memory.
+     * @param[in] x: amount of states
+     * @param[in] w: amount of control measurements and noise inputs
+     *
+     * @return
+     *      - size in floats
+    */
+    static int ScratchSize(int x, int w);
+
 public:
     // Additional universal helper methods
     /**
@@ -169,6 +237,12 @@ public:
      *      - rotation matrix 3x3
      */
     static dspm::Mat quat2rotm(float q[4]);
+    /**
+     * Convert quaternion to rotation matrix, without allocation.
+     * @param[in] q: quaternion
+     * @param[out] Rm: rotation matrix 3x3
+     */
+    static void quat2rotm(const float q[4], dspm::MatN<3, 3> &Rm);
 
     /**
      * Convert rotation matrix to quaternion.
@@ -214,6 +288,13 @@ public:
      *      - Derivative matrix 3x4
      */
     static dspm::Mat dFdq(dspm::Mat &vector, dspm::Mat &quat);
+    /**
+     * Df/dq:  Derivative of vector by quaternion, without allocation.
+     * @param[in] vector: input vector 3x1
+     * @param[in] quat: quaternion 4x1
+     * @param[out] result: derivative matrix 3x4
+     */
+    static void dFdq(const float *vector, const float *quat, dspm::MatN<3, 4> &result);
 
     /**
      * Df/dq: Derivative of vector by inverted quaternion.
@@ -224,6 +305,13 @@ public:
      *      - Derivative matrix 3x4
      */
     static dspm::Mat dFdq_inv(dspm::Mat &vector, dspm::Mat &quat);
+    /**
+     * Df/dq: Derivative of vector by inverted quaternion, without allocation.
+     * @param[in] vector: input vector 3x1
+     * @param[in] quat: quaternion 4x1
+     * @param[out] result: derivative matrix 3x4
+     */
+    static void dFdq_inv(const float *vector, const float *quat, dspm::MatN<3, 4> &result);
 
     /**
      * Make skew-symmetric matrix of vector.
@@ -233,6 +321,12 @@ public:
      *      - skew-symmetric matrix 4x4
      */
     static dspm::Mat SkewSym4x4(float *w);
+    /**
+     * Make skew-symmetric matrix of vector, without allocation.
+     * @param[in] w: source vector
+     * @param[out] result: skew-symmetric matrix 4x4
+     */
+    static void SkewSym4x4(const float *w, dspm::MatN<4, 4> &result);
 
     // q product
     // Rl = [q(1) - q(2) - q(3) - q(4); ...
@@ -248,6 +342,12 @@ public:
      *      - right quaternion-product matrix 4x4
      */
     static dspm::Mat qProduct(float *q);
+    /**
+     * Make right quaternion-product matrices, without allocation.
+     * @param[in] q: source quaternion
+     * @param[out] result: right quaternion-product matrix 4x4
+     */
+    static void qProduct(const float *q, dspm::MatN<4, 4> &result);
 
 };
 
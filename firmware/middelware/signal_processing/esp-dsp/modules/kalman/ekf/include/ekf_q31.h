@@ -0,0 +1,375 @@
+/**
+ * @file ekf_q31.h
+ * @brief Fixed point build of the EKF for the chips without FPU
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef _ekf_q31_h_
+#define _ekf_q31_h_
+
+#include <string.h>
+#include "ekf.h"
+#include <mat_q31.h>
+
+/**
+ * The ekf_q31 is the fixed point build of the EKF class T, for the chips without FPU.
+ * The covariance matrix is kept as dspm::MatQ31 (Q1.31 with block exponent), and
+ * the covariance prediction and the sequential update, O(NUMX^3) and O(NUMX^2)
+ * operations per step, are done on integers. The state vector, the system model
+ * (StateXdot(), LinearizeFG()) and the measurement models of T stay in float.
+ * The float work of the prediction is one multiplication per nonzero element of
+ * F and G; the nonzero elements are found by integer tests of the float bits.
+ * Q is converted to fixed point only when it was changed.
+ *
+ * Pq is the covariance of the filter. P is not updated by the fixed point
+ * prediction and update: SyncCovariance() copies Pq to P, before P is read.
+ * When P is changed by the application after Init(), LoadCovariance() should
+ * be called. Update() and UpdateRef() are done in float on the synchronized P
+ * and load the result to Pq.
+ *
+ * Example: ekf_q31<ekf_imu13states> ekf13;
+ */
+template <class T>
+class ekf_q31: public T {
+public:
+    /**
+     * Constructor of the fixed point EKF, the arguments are passed to T.
+     */
+    template <typename... Args>
+    ekf_q31(Args... args) : T(args...),
+        Pq(this->NUMX, this->NUMX),
+        Qq(this->NUMW, this->NUMW),
+        fP(this->NUMX, this->NUMX),
+        GQ(this->NUMX, this->NUMW),
+        hp(this->NUMX, 1),
+        K(this->NUMX, 1),
+        sK(this->NUMX, 1)
+    {
+        int n = this->NUMX;
+        int w = this->NUMW;
+        this->f_data = new int32_t[n * n];
+        this->g_data = new int32_t[n * w];
+        this->h_data = new int32_t[n];
+        this->h_values = new float[n];
+        this->h_cols = new uint16_t[n];
+        this->acc = new int64_t[(w > n) ? n * w : n * n];
+        this->q_last = new float[w * w];
+        this->q_loaded = false;
+    }
+
+    virtual ~ekf_q31()
+    {
+        delete[] this->f_data;
+        delete[] this->g_data;
+        delete[] this->h_data;
+        delete[] this->h_values;
+        delete[] this->h_cols;
+        delete[] this->acc;
+        delete[] this->q_last;
+    }
+
+    /**
+     * Initialization of T, then the covariance is loaded to Pq.
+    */
+    virtual void Init()
+    {
+        T::Init();
+        LoadCovariance();
+    }
+
+    /**
+     * Load the float covariance P to Pq.
+    */
+    void LoadCovariance()
+    {
+        this->Pq.fromMat(this->P);
+    }
+
+    /**
+     * Copy Pq to the float covariance P.
+    */
+    void SyncCovariance()
+    {
+        this->Pq.toFloat(this->P.data);
+    }
+
+    /**
+     * Covariance prediction P = f*P*f' + dt^2*G*Q*G', f = I + F*dt, in fixed point.
+     * The same nonzero elements of f and G are used as by ekf::CovariancePrediction.
+     * @param[in] dt: time interval from last update
+     */
+    virtual void CovariancePrediction(float dt)
+    {
+        int n = this->NUMX;
+        int w = this->NUMW;
+        // Nonzero values of f = I + F*dt and G*dt, in the order of f_nonzero and
+        // g_nonzero: the patterns are found on integers, the values only for them
+        dspm::Mat f_values(n, n);
+        dspm::Mat g_values(n, w);
+        int pos = 0;
+        for (int i = 0; i < n; i++) {
+            this->f_nonzero.start[i] = pos;
+            for (int j = 0; j < n; j++) {
+                if ((i == j) || NonZero(this->F(i, j))) {
+                    this->f_nonzero.cols[pos++] = j;
+                }
+            }
+        }
+        this->f_nonzero.start[n] = pos;
+        for (int i = 0; i < n; i++) {
+            for (int k = this->f_nonzero.start[i]; k < this->f_nonzero.start[i + 1]; k++) {
+                int j = this->f_nonzero.cols[k];
+                f_values.data[k] = (i == j) ? this->F(i, j) * dt + 1.0f : this->F(i, j) * dt;
+            }
+        }
+        dspm::MatQ31 f(this->f_data, pos, 1);
+        f.fromFloat(f_values.data);
+        pos = 0;
+        for (int i = 0; i < n; i++) {
+            this->g_nonzero.start[i] = pos;
+            for (int j = 0; j < w; j++) {
+                if (NonZero(this->G(i, j))) {
+                    this->g_nonzero.cols[pos] = j;
+                    g_values.data[pos++] = this->G(i, j) * dt;
+                }
+            }
+        }
+        this->g_nonzero.start[n] = pos;
+        dspm::MatQ31 g(this->g_data, pos, 1);
+        g.fromFloat(g_values.data);
+        LoadNoise();
+
+        // The products are summed with guard bits for up to max(n, w) terms
+        int guard = dspm::MatQ31::bits((w > n) ? w : n);
+
+        // fP = f*P
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                int64_t sum = 0;
+                for (int k = this->f_nonzero.start[i]; k < this->f_nonzero.start[i + 1]; k++) {
+                    sum += ((int64_t)f.data[k] * this->Pq(this->f_nonzero.cols[k], j)) >> guard;
+                }
+                this->acc[i * n + j] = sum;
+            }
+        }
+        this->fP.fromInt64(this->acc, guard + f.exponent + this->Pq.exponent - 62);
+        // GQ = G*dt*Q
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < w; j++) {
+                int64_t sum = 0;
+                for (int k = this->g_nonzero.start[i]; k < this->g_nonzero.start[i + 1]; k++) {
+                    sum += ((int64_t)g.data[k] * this->Qq(this->g_nonzero.cols[k], j)) >> guard;
+                }
+                this->acc[i * w + j] = sum;
+            }
+        }
+        this->GQ.fromInt64(this->acc, guard + g.exponent + this->Qq.exponent - 62);
+
+        // P = fP*f' + GQ*(G*dt)', upper triangle, the sums are aligned with one guard bit
+        int scale_fpf = guard + this->fP.exponent + f.exponent - 62;
+        int scale_gqg = guard + this->GQ.exponent + g.exponent - 62;
+        int scale = ((scale_fpf > scale_gqg) ? scale_fpf : scale_gqg) + 1;
+        for (int i = 0; i < n; i++) {
+            for (int j = i; j < n; j++) {
+                int64_t fpf = 0;
+                for (int k = this->f_nonzero.start[j]; k < this->f_nonzero.start[j + 1]; k++) {
+                    fpf += ((int64_t)this->fP(i, this->f_nonzero.cols[k]) * f.data[k]) >> guard;
+                }
+                int64_t gqg = 0;
+                for (int k = this->g_nonzero.start[j]; k < this->g_nonzero.start[j + 1]; k++) {
+                    gqg += ((int64_t)this->GQ(i, this->g_nonzero.cols[k]) * g.data[k]) >> guard;
+                }
+                this->acc[i * n + j] = this->acc[j * n + i] = dspm::MatQ31::shift(fpf, scale - scale_fpf) +
+                                                              dspm::MatQ31::shift(gqg, scale - scale_gqg);
+            }
+        }
+        this->Pq.fromInt64(this->acc, scale);
+    }
+
+    /**
+     * Sequential update with the Joseph form, as ekf::UpdateSequential(), in fixed point.
+     * Only the innovation variance s, its inverse and the gate are calculated in float,
+     * O(1) operations per measurement.
+     * @param[in] H: derivative matrix
+     * @param[in] measured: array of measured values
+     * @param[in] expected: array of expected values
+     * @param[in] R: measurement noise covariance values
+     * @param[in] gate: innovation gate in standard deviations, 0 - no gate
+     *
+     * @return
+     *      - amount of rejected measurements
+     */
+    virtual int UpdateSequential(dspm::Mat &H, float *measured, float *expected, float *R, float gate = 0)
+    {
+        int n = this->NUMX;
+        int guard = dspm::MatQ31::bits(n);
+        int result = 0;
+        for (int m = 0; m < H.rows; m++) {
+            // Nonzero elements of h
+            int count = 0;
+            for (int k = 0; k < n; k++) {
+                if (H(m, k) != 0) {
+                    this->h_cols[count] = k;
+                    this->h_values[count++] = H(m, k);
+                }
+            }
+            dspm::MatQ31 h(this->h_data, count, 1);
+            h.fromFloat(this->h_values);
+
+            // hp = h*P
+            for (int j = 0; j < n; j++) {
+                int64_t sum = 0;
+                for (int k = 0; k < count; k++) {
+                    sum += ((int64_t)h.data[k] * this->Pq(this->h_cols[k], j)) >> guard;
+                }
+                this->acc[j] = sum;
+            }
+            this->hp.fromInt64(this->acc, guard + h.exponent + this->Pq.exponent - 62);
+
+            // Innovation variance s = h*P*h' + r
+            int64_t hph = 0;
+            for (int k = 0; k < count; k++) {
+                hph += ((int64_t)this->hp.data[this->h_cols[k]] * h.data[k]) >> guard;
+            }
+            float s = R[m] + ldexpf((float)hph, guard + this->hp.exponent + h.exponent - 62);
+            float error = measured[m] - expected[m];
+            if ((gate > 0) && (error * error > gate * gate * s)) {
+                result++;
+                continue;
+            }
+
+            // K = hp'/s, sK = s*K
+            int exp_inv;
+            int exp_s;
+            int32_t inv_s = dspm::MatQ31::saturate(llrintf(ldexpf(frexpf(1.0f / s, &exp_inv), 31)));
+            int32_t s_q = dspm::MatQ31::saturate(llrintf(ldexpf(frexpf(s, &exp_s), 31)));
+            for (int i = 0; i < n; i++) {
+                this->K.data[i] = (int32_t)(((int64_t)this->hp.data[i] * inv_s) >> 31);
+            }
+            this->K.exponent = this->hp.exponent + exp_inv;
+            this->K.normalize();
+            for (int i = 0; i < n; i++) {
+                this->sK.data[i] = (int32_t)(((int64_t)this->K.data[i] * s_q) >> 31);
+            }
+            this->sK.exponent = this->K.exponent + exp_s;
+
+            // Joseph form for a scalar measurement:
+            // (I - K*h)*P*(I - K*h)' + K*r*K' = P - K*hp - hp'*K' + s*K*K'
+            int scale_p = this->Pq.exponent - 62;
+            int scale_kh = this->K.exponent + this->hp.exponent - 62;
+            int scale_kk = this->sK.exponent + this->K.exponent - 62;
+            int scale = scale_p;
+            scale = (scale_kh > scale) ? scale_kh : scale;
+            scale = (scale_kk > scale) ? scale_kk : scale;
+            scale += 2;
+            // Right shifts of the terms to the scale of the sum, at least 2 guard bits
+            int shift_p = (scale - scale_p > 63) ? 63 : scale - scale_p;
+            int shift_kh = (scale - scale_kh > 63) ? 63 : scale - scale_kh;
+            int shift_kk = (scale - scale_kk > 63) ? 63 : scale - scale_kk;
+            for (int i = 0; i < n; i++) {
+                int64_t k_i = this->K.data[i];
+                int64_t hp_i = this->hp.data[i];
+                int64_t sk_i = this->sK.data[i];
+                for (int j = i; j < n; j++) {
+                    int64_t p = ((int64_t)this->Pq(i, j) * ((int64_t)1 << 31)) >> shift_p;
+                    int64_t kh = ((k_i * this->hp.data[j]) >> shift_kh) + ((hp_i * this->K.data[j]) >> shift_kh);
+                    int64_t kk = (sk_i * this->K.data[j]) >> shift_kk;
+                    this->acc[i * n + j] = this->acc[j * n + i] = p - kh + kk;
+                }
+            }
+            this->Pq.fromInt64(this->acc, scale);
+
+            for (int i = 0; i < n; i++) {
+                this->Km[i] = this->K.get(i, 0);
+                this->X(i, 0) += this->Km[i] * error;
+            }
+        }
+        this->rejected += result;
+        return result;
+    }
+
+    /**
+     * Update by T, in float on P copied from Pq, then the covariance is loaded to Pq.
+     * @param[in] H: derivative matrix
+     * @param[in] measured: array of measured values
+     * @param[in] expected: array of expected values
+     * @param[in] R: measurement noise covariance values
+     */
+    virtual void Update(dspm::Mat &H, float *measured, float *expected, float *R)
+    {
+        SyncCovariance();
+        T::Update(H, measured, expected, R);
+        LoadCovariance();
+    }
+    /**
+     * Reference update by T, in float on P copied from Pq, then the covariance is loaded to Pq.
+     * @param[in] H: derivative matrix
+     * @param[in] measured: array of measured values
+     * @param[in] expected: array of expected values
+     * @param[in] R: measurement noise covariance values
+     */
+    virtual void UpdateRef(dspm::Mat &H, float *measured, float *expected, float *R)
+    {
+        SyncCovariance();
+        T::UpdateRef(H, measured, expected, R);
+        LoadCovariance();
+    }
+
+    /**
+     * Covariance matrix in fixed point, copied to P by SyncCovariance()
+    */
+    dspm::MatQ31 Pq;
+
+protected:
+    /**
+     * Integer test of a float value, without a soft-float comparison
+     */
+    static inline bool NonZero(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return (bits & 0x7FFFFFFF) != 0;
+    }
+
+    /**
+     * Convert Q to Qq when Q was changed since the last conversion.
+     * The test is an integer comparison of the float bits.
+     */
+    void LoadNoise()
+    {
+        int w = this->NUMW;
+        bool changed = !this->q_loaded;
+        for (int row = 0; (row < w) && !changed; row++) {
+            changed = (memcmp(&this->q_last[row * w], &this->Q.data[row * this->Q.stride], w * sizeof(float)) != 0);
+        }
+        if (!changed) {
+            return;
+        }
+        for (int row = 0; row < w; row++) {
+            memcpy(&this->q_last[row * w], &this->Q.data[row * this->Q.stride], w * sizeof(float));
+        }
+        this->Qq.fromFloat(this->q_last);
+        this->q_loaded = true;
+    }
+
+    dspm::MatQ31 Qq;        /*!< Q in fixed point*/
+    dspm::MatQ31 fP;        /*!< f*P*/
+    dspm::MatQ31 GQ;        /*!< G*dt*Q*/
+    dspm::MatQ31 hp;        /*!< h*P of one measurement*/
+    dspm::MatQ31 K;         /*!< Kalman gain of one measurement*/
+    dspm::MatQ31 sK;        /*!< s*K*/
+    int32_t *f_data;        /*!< Nonzero elements of f, in the order of f_nonzero*/
+    int32_t *g_data;        /*!< Nonzero elements of G*dt, in the order of g_nonzero*/
+    int32_t *h_data;        /*!< Nonzero elements of h*/
+    float *h_values;        /*!< Nonzero elements of h in float*/
+    uint16_t *h_cols;       /*!< Columns of the nonzero elements of h*/
+    int64_t *acc;           /*!< Sums before the conversion to a MatQ31*/
+    float *q_last;          /*!< Q at the last conversion to Qq*/
+    bool q_loaded;          /*!< Qq was converted from q_last*/
+};
+
+#endif // _ekf_q31_h_
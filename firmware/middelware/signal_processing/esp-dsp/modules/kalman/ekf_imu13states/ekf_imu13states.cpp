@@ -12,17 +12,27 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <string.h>
 #include "ekf_imu13states.h"
 
-ekf_imu13states::ekf_imu13states() : ekf(13, 18),
+ekf_imu13states::ekf_imu13states(int history) : ekf(13, 18),
     mag0(3, 1),
     accel0(3, 1)
 {
     this->NUMU = 3;
+    this->timestamp = 0;
+    this->late = 0;
+    this->history_size = history > 0 ? history : 1;
+    this->history_count = 0;
+    this->history_pos = 0;
+    this->history_x = new float[this->history_size * this->NUMX];
+    this->history_time = new int64_t[this->history_size];
 }
 
 ekf_imu13states::~ekf_imu13states()
 {
+    delete[] this->history_x;
+    delete[] this->history_time;
 }
 
 void ekf_imu13states::Init()
@@ -57,14 +67,15 @@ dspm::Mat ekf_imu13states::StateXdot(dspm::Mat &x, float *u)
     float wz = u[2] - x(6, 0);
 
     float w[] = {wx, wy, wz};
-    dspm::Mat q = dspm::Mat(x.data, 4, 1);
+    dspm::MatN<4, 1> q(x.data);
 
     // qdot = Q * w
-    dspm::Mat Omega = 0.5 * SkewSym4x4(w);
-    dspm::Mat qdot = Omega * q;
+    dspm::MatN<4, 4> Omega;
+    SkewSym4x4(w, Omega);
+    Omega *= 0.5;
+    dspm::MatN<4, 1> qdot = Omega * q;
     dspm::Mat Xdot(this->NUMX, 1);
-    Xdot *= 0;
-    Xdot.Copy(qdot, 0, 0);
+    qdot.copyTo(Xdot, 0, 0);
     // dwbias = 0
     // dMang_Ampl = 0
     // dMang_offset = 0
@@ -80,24 +91,31 @@ void ekf_imu13states::LinearizeFG(dspm::Mat &x, float *u)
     this->G *= 0;
 
     // dqdot / dq - skey matrix
-    F.Copy(0.5 * ekf::SkewSym4x4(w), 0, 0);
+    dspm::MatN<4, 4> Omega;
+    ekf::SkewSym4x4(w, Omega);
+    (0.5 * Omega).copyTo(F, 0, 0);
 
     // dqdot/dvector
-    dspm::Mat dq = -0.5 * qProduct(x.data);
-    dspm::Mat dq_q = dq.Get(0, 4, 1, 3);
+    dspm::MatN<4, 4> dq;
+    qProduct(x.data, dq);
+    dq *= -0.5;
+    dspm::MatN<4, 3> dq_q = dq.block<4, 3>(0, 1);
 
     // dqdot / dnw
-    G.Copy(dq_q, 0, 0);
+    dq_q.copyTo(G, 0, 0);
     // dqdot / dwbias
-    F.Copy(dq_q, 0, 4);
-
-    dspm::Mat rotm = -1 * this->quat2rotm(x.data); // Convert quat to rotation matrix
-
-    G.Copy(rotm, 7, 6);
-    G.Copy(dspm::Mat::eye(3), 4, 3);   // random noise wbias
-    G.Copy(dspm::Mat::eye(3), 7, 12);  // random noise magnetometer amplitude
-    G.Copy(dspm::Mat::eye(3), 10, 9);  // magnetometer offset constant
-    G.Copy(dspm::Mat::eye(3), 10, 15); // random noise offset constant
+    dq_q.copyTo(F, 0, 4);
+
+    dspm::MatN<3, 3> rotm;
+    this->quat2rotm(x.data, rotm); // Convert quat to rotation matrix
+    rotm *= -1;
+
+    dspm::MatN<3, 3> eye = dspm::MatN<3, 3>::eye();
+    rotm.copyTo(G, 7, 6);
+    eye.copyTo(G, 4, 3);   // random noise wbias
+    eye.copyTo(G, 7, 12);  // random noise magnetometer amplitude
+    eye.copyTo(G, 10, 9);  // magnetometer offset constant
+    eye.copyTo(G, 10, 15); // random noise offset constant
 }
 
 void ekf_imu13states::Test()
@@ -186,58 +204,86 @@ void ekf_imu13states::TestFull(bool enable_att)
 
 void ekf_imu13states::UpdateRefMeasurement(float *accel_data, float *magn_data, float R[6])
 {
+    dspm::MatArena::Scope scope(this->scratch);
     dspm::Mat quat(this->X.data, 4, 1);
     dspm::Mat H = 0 * dspm::Mat(6, this->NUMX);
-    dspm::Mat Re = this->quat2rotm(quat.data).t();
-
-    // dAccel/dq
-    dspm::Mat dAccel_dq = ekf::dFdq_inv(this->accel0, quat);
-    H.Copy(dAccel_dq, 3, 0);
-
-    // dMagn/dq
-    dspm::Mat magn(&this->X.data[7], 3, 1);
-    dspm::Mat magn_offset(&this->X.data[10], 3, 1);
-    dspm::Mat dMagn_dq = ekf::dFdq_inv(magn, quat);
-    H.Copy(dMagn_dq, 0, 0);
-
-    dspm::Mat expected_magn = Re * magn + magn_offset;
-    dspm::Mat expected_accel = Re * this->accel0;
 
     float measured_data[6];
     float expected_data[6];
+    this->MagnMeasurement(this->X.data, H, 0, expected_data);
+    this->AccelMeasurement(this->X.data, H, 3, &expected_data[3]);
     for (size_t i = 0; i < 3; i++) {
         measured_data[i] = magn_data[i];
-        expected_data[i] = expected_magn.data[i];
         measured_data[i + 3] = accel_data[i];
-        expected_data[i + 3] = expected_accel.data[i];
     }
 
-    this->Update(H, measured_data, expected_data, R);
+    this->UpdateSequential(H, measured_data, expected_data, R, this->innovation_gate);
     quat /= quat.norm();
 }
 
+void ekf_imu13states::AccelMeasurement(const float *x, dspm::Mat &H, int row, float *expected)
+{
+    dspm::MatN<3, 3> Rm;
+    this->quat2rotm(x, Rm);
+    dspm::MatNT<3, 3> Re = Rm.t();
+
+    // dAccel/dq
+    dspm::MatN<3, 4> dAccel_dq;
+    ekf::dFdq_inv(this->accel0.data, x, dAccel_dq);
+    dAccel_dq.copyTo(H, row, 0);
+
+    dspm::MatN<3, 1> expected_accel = Re * dspm::MatN<3, 1>(this->accel0.data);
+    for (size_t i = 0; i < 3; i++) {
+        expected[i] = expected_accel.data[i];
+    }
+}
+
+void ekf_imu13states::MagnMeasurement(const float *x, dspm::Mat &H, int row, float *expected)
+{
+    dspm::MatN<3, 3> Rm;
+    this->quat2rotm(x, Rm);
+    dspm::MatNT<3, 3> Re = Rm.t();
+
+    // dMagn/dq
+    dspm::MatN<3, 1> magn(&x[7]);
+    dspm::MatN<3, 1> magn_offset(&x[10]);
+    dspm::MatN<3, 4> dMagn_dq;
+    ekf::dFdq_inv(magn.data, x, dMagn_dq);
+    dMagn_dq.copyTo(H, row, 0);
+
+    dspm::MatN<3, 1> expected_magn = Re * magn + magn_offset;
+    for (size_t i = 0; i < 3; i++) {
+        expected[i] = expected_magn.data[i];
+    }
+}
+
 void ekf_imu13states::UpdateRefMeasurementMagn(float *accel_data, float *magn_data, float R[6])
 {
+    dspm::MatArena::Scope scope(this->scratch);
     dspm::Mat quat(this->X.data, 4, 1);
     dspm::Mat H = 0 * dspm::Mat(6, this->NUMX);
-    dspm::Mat Re = this->quat2rotm(quat.data).t();
+    dspm::MatN<3, 3> Rm;
+    this->quat2rotm(quat.data, Rm);
+    dspm::MatNT<3, 3> Re = Rm.t();
 
     // We include these two line to update magnetometer initial state
-    H.Copy(Re, 0, 7);
-    H.Copy(dspm::Mat::eye(3), 0, 10);
+    Re.eval().copyTo(H, 0, 7);
+    dspm::MatN<3, 3>::eye().copyTo(H, 0, 10);
 
     // dAccel/dq
-    dspm::Mat dAccel_dq = ekf::dFdq_inv(this->accel0, quat);
-    H.Copy(dAccel_dq, 3, 0);
+    dspm::MatN<3, 4> dAccel_dq;
+    ekf::dFdq_inv(this->accel0.data, quat.data, dAccel_dq);
+    dAccel_dq.copyTo(H, 3, 0);
 
     // dMagn/dq
-    dspm::Mat magn(&this->X.data[7], 3, 1);
-    dspm::Mat magn_offset(&this->X.data[10], 3, 1);
-    dspm::Mat dMagn_dq = ekf::dFdq_inv(magn, quat);
-    H.Copy(dMagn_dq, 0, 0);
+    dspm::MatN<3, 1> magn(&this->X.data[7]);
+    dspm::MatN<3, 1> magn_offset(&this->X.data[10]);
+    dspm::MatN<3, 4> dMagn_dq;
+    ekf::dFdq_inv(magn.data, quat.data, dMagn_dq);
+    dMagn_dq.copyTo(H, 0, 0);
 
-    dspm::Mat expected_magn = Re * magn + magn_offset;
-    dspm::Mat expected_accel = Re * this->accel0;
+    dspm::MatN<3, 1> expected_magn = Re * magn + magn_offset;
+    dspm::MatN<3, 1> expected_accel = Re * dspm::MatN<3, 1>(this->accel0.data);
 
     float measured_data[6];
     float expected_data[6];
@@ -248,32 +294,37 @@ void ekf_imu13states::UpdateRefMeasurementMagn(float *accel_data, float *magn_da
         expected_data[i + 3] = expected_accel.data[i];
     }
 
-    this->Update(H, measured_data, expected_data, R);
+    this->UpdateSequential(H, measured_data, expected_data, R, this->innovation_gate);
     quat /= quat.norm();
 }
 
 void ekf_imu13states::UpdateRefMeasurement(float *accel_data, float *magn_data, float *attitude, float R[10])
 {
+    dspm::MatArena::Scope scope(this->scratch);
     dspm::Mat quat(this->X.data, 4, 1);
     dspm::Mat H = 0 * dspm::Mat(10, this->NUMX);
-    dspm::Mat Re = this->quat2rotm(quat.data).t();
+    dspm::MatN<3, 3> Rm;
+    this->quat2rotm(quat.data, Rm);
+    dspm::MatNT<3, 3> Re = Rm.t();
 
-    H.Copy(Re, 0, 7);
-    H.Copy(dspm::Mat::eye(3), 0, 10);
+    Re.eval().copyTo(H, 0, 7);
+    dspm::MatN<3, 3>::eye().copyTo(H, 0, 10);
     // dAccel/dq
-    dspm::Mat dAccel_dq = ekf::dFdq_inv(this->accel0, quat);
-    H.Copy(dAccel_dq, 3, 0);
+    dspm::MatN<3, 4> dAccel_dq;
+    ekf::dFdq_inv(this->accel0.data, quat.data, dAccel_dq);
+    dAccel_dq.copyTo(H, 3, 0);
     // dMagn/dq
-    dspm::Mat magn(&this->X.data[7], 3, 1);
-    dspm::Mat magn_offset(&this->X.data[10], 3, 1);
-    dspm::Mat dMagn_dq = ekf::dFdq_inv(magn, quat);
-    H.Copy(dMagn_dq, 0, 0);
+    dspm::MatN<3, 1> magn(&this->X.data[7]);
+    dspm::MatN<3, 1> magn_offset(&this->X.data[10]);
+    dspm::MatN<3, 4> dMagn_dq;
+    ekf::dFdq_inv(magn.data, quat.data, dMagn_dq);
+    dMagn_dq.copyTo(H, 0, 0);
 
     // dq/dq
-    H.Copy(dspm::Mat::eye(4), 6, 1);
+    dspm::MatN<4, 4>::eye().copyTo(H, 6, 1);
 
-    dspm::Mat expected_magn = Re * magn + magn_offset;
-    dspm::Mat expected_accel = Re * this->accel0;
+    dspm::MatN<3, 1> expected_magn = Re * magn + magn_offset;
+    dspm::MatN<3, 1> expected_accel = Re * dspm::MatN<3, 1>(this->accel0.data);
 
     float measured_data[10];
     float expected_data[10];
@@ -288,6 +339,104 @@ void ekf_imu13states::UpdateRefMeasurement(float *accel_data, float *magn_data,
         expected_data[i + 6] = this->X.data[i];
     }
 
-    this->Update(H, measured_data, expected_data, R);
+    this->UpdateSequential(H, measured_data, expected_data, R, this->innovation_gate);
+    quat /= quat.norm();
+}
+
+void ekf_imu13states::ProcessGyro(float *gyro_data, int64_t timestamp)
+{
+    bool first = (this->history_count == 0);
+    float dt = (timestamp - this->timestamp) * 1e-6f;
+    if (!first && (dt <= 0)) {
+        return; // sample from the past
+    }
+    this->timestamp = timestamp;
+    if (!first) {
+        this->Process(gyro_data, dt);
+        dspm::Mat quat(this->X.data, 4, 1);
+        quat /= quat.norm();
+    }
+
+    this->history_pos = (this->history_pos + 1) % this->history_size;
+    if (this->history_count < this->history_size) {
+        this->history_count++;
+    }
+    memcpy(&this->history_x[this->history_pos * this->NUMX], this->X.data, this->NUMX * sizeof(float));
+    this->history_time[this->history_pos] = timestamp;
+}
+
+const float *ekf_imu13states::StateAt(int64_t time)
+{
+    if ((this->history_count == 0) || (time >= this->timestamp)) {
+        return this->X.data;
+    }
+    // From the newest state to the oldest one
+    int pos = this->history_pos;
+    for (int i = 0; i < this->history_count; i++) {
+        if (this->history_time[pos] <= time) {
+            // The nearest of the two states around the time
+            int next = (pos + 1) % this->history_size;
+            if ((i > 0) && (this->history_time[next] - time < time - this->history_time[pos])) {
+                pos = next;
+            }
+            return &this->history_x[pos * this->NUMX];
+        }
+        pos = (pos + this->history_size - 1) % this->history_size;
+    }
+    return NULL;
+}
+
+void ekf_imu13states::CorrectHistory(const float *x_before, int64_t time)
+{
+    // The stored states at and after the time of the measurement get the same
+    // correction as the current state, so the next delayed measurement does
+    // not find the error that was already corrected
+    int pos = this->history_pos;
+    for (int i = 0; (i < this->history_count) && (this->history_time[pos] >= time); i++) {
+        float *x = &this->history_x[pos * this->NUMX];
+        for (int j = 0; j < this->NUMX; j++) {
+            x[j] += this->X.data[j] - x_before[j];
+        }
+        pos = (pos + this->history_size - 1) % this->history_size;
+    }
+}
+
+bool ekf_imu13states::UpdateAccel(float *accel_data, int64_t timestamp, float R[3])
+{
+    const float *x = this->StateAt(timestamp);
+    if (x == NULL) {
+        this->late++;
+        return false;
+    }
+    dspm::MatArena::Scope scope(this->scratch);
+    dspm::Mat quat(this->X.data, 4, 1);
+    dspm::Mat H = 0 * dspm::Mat(3, this->NUMX);
+    float expected_data[3];
+    this->AccelMeasurement(x, H, 0, expected_data);
+    dspm::Mat x_before = this->X;
+
+    this->UpdateSequential(H, accel_data, expected_data, R, this->innovation_gate);
+    quat /= quat.norm();
+    this->CorrectHistory(x_before.data, timestamp);
+    return true;
+}
+
+bool ekf_imu13states::UpdateMagn(float *magn_data, int64_t timestamp, float R[3])
+{
+    const float *x = this->StateAt(timestamp);
+    if (x == NULL) {
+        this->late++;
+        return false;
+    }
+    dspm::MatArena::Scope scope(this->scratch);
+    dspm::Mat quat(this->X.data, 4, 1);
+    dspm::Mat H = 0 * dspm::Mat(3, this->NUMX);
+    float expected_data[3];
+    this->MagnMeasurement(x, H, 0, expected_data);
+    dspm::Mat x_before = this->X;
+
+    this->UpdateSequential(H, magn_data, expected_data, R, this->innovation_gate);
     quat /= quat.norm();
+    this->CorrectHistory(x_before.data, timestamp);
+    return true;
 }
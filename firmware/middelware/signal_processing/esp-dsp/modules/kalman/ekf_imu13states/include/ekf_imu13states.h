@@ -30,7 +30,12 @@
 */
 class ekf_imu13states: public ekf {
 public:
-    ekf_imu13states();
+    /**
+     * Constructor of the filter
+     * @param[in] history: amount of states in the history of ProcessGyro(),
+     *                     the limit of delayed measurements in gyroscope samples
+     */
+    ekf_imu13states(int history = 16);
     virtual ~ekf_imu13states();
     virtual void Init();
 
@@ -68,6 +73,8 @@ public:
      * Update part of system state by reference measurements accelerometer and magnetometer.
      * Only attitude and gyro bias will be updated.
      * This method should be used as main method after calibration.
+     * The measurements are applied one by one by UpdateSequential(), and the
+     * measurements outside of innovation_gate are rejected.
      *
      * @param[in] accel_data: accelerometer measurement vector XYZ in g, where 1 g ~ 9.81 m/s^2
      * @param[in] magn_data: magnetometer measurement vector XYZ
@@ -93,6 +100,96 @@ public:
      */
     void UpdateRefMeasurement(float *accel_data, float *magn_data, float *attitude, float R[10]);
 
+    // Multi-rate processing: every sensor is processed when it has a sample
+
+    /**
+     * Prediction by gyroscope sample with time stamp.
+     * The time interval is found from the previous sample, the first sample
+     * only starts the time. The state is stored in the history for the
+     * delayed measurements.
+     * Q is the noise of one gyroscope sample, P grows by dt^2*G*Q*G' per sample,
+     * so at N times higher gyroscope rate Q has to be N times higher for the same
+     * noise per second.
+     * @param[in] gyro_data: gyroscope measurement vector XYZ in rad/sec
+     * @param[in] timestamp: time of the sample in microseconds, for example esp_timer_get_time()
+     */
+    void ProcessGyro(float *gyro_data, int64_t timestamp);
+    /**
+     * Update of attitude and gyro bias by accelerometer sample with time stamp.
+     * The expected value is found from the state at the time of the sample,
+     * the correction is applied to the current state and to the stored states
+     * since the time of the sample.
+     * @param[in] accel_data: accelerometer measurement vector XYZ in g, where 1 g ~ 9.81 m/s^2
+     * @param[in] timestamp: time of the sample in microseconds
+     * @param[in] R: measurement noise covariance values for diagonal covariance matrix
+     *
+     * @return
+     *      - false if the sample is older than the history and was not used
+     */
+    bool UpdateAccel(float *accel_data, int64_t timestamp, float R[3]);
+    /**
+     * Update of attitude and gyro bias by magnetometer sample with time stamp.
+     * The expected value is found from the state at the time of the sample,
+     * the correction is applied to the current state and to the stored states
+     * since the time of the sample.
+     * @param[in] magn_data: magnetometer measurement vector XYZ
+     * @param[in] timestamp: time of the sample in microseconds
+     * @param[in] R: measurement noise covariance values for diagonal covariance matrix
+     *
+     * @return
+     *      - false if the sample is older than the history and was not used
+     */
+    bool UpdateMagn(float *magn_data, int64_t timestamp, float R[3]);
+
+    /**
+     * Time of the last gyroscope sample in microseconds
+     */
+    int64_t timestamp;
+    /**
+     * Amount of measurements older than the history, not used
+     */
+    int late;
+
+protected:
+    /**
+     * Derivative and expected value of accelerometer for state x.
+     * @param[in] x: state vector
+     * @param[out] H: derivative matrix, rows [row..row + 2] are filled
+     * @param[in] row: first row of H
+     * @param[out] expected: 3 expected values
+     */
+    void AccelMeasurement(const float *x, dspm::Mat &H, int row, float *expected);
+    /**
+     * Derivative and expected value of magnetometer for state x.
+     * @param[in] x: state vector
+     * @param[out] H: derivative matrix, rows [row..row + 2] are filled
+     * @param[in] row: first row of H
+     * @param[out] expected: 3 expected values
+     */
+    void MagnMeasurement(const float *x, dspm::Mat &H, int row, float *expected);
+    /**
+     * State at the time of the measurement.
+     * @param[in] time: time of the measurement in microseconds
+     *
+     * @return
+     *      - current state if the measurement is newer than the last gyroscope sample
+     *      - the nearest state in the history
+     *      - NULL if the measurement is older than the history
+     */
+    const float *StateAt(int64_t time);
+    /**
+     * Add the last correction of the state to the stored states since the time of the measurement.
+     * @param[in] x_before: state before the correction
+     * @param[in] time: time of the measurement in microseconds
+     */
+    void CorrectHistory(const float *x_before, int64_t time);
+
+    int history_size;       /*!< Amount of states in the history*/
+    int history_count;      /*!< Amount of stored states*/
+    int history_pos;        /*!< Position of the last stored state*/
+    float *history_x;       /*!< States, [history_size*NUMX]*/
+    int64_t *history_time;  /*!< Time stamps of the states, [history_size]*/
+
 };
 
 #endif // _ekf_imu13states_H_
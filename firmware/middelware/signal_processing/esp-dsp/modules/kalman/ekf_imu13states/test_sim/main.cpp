@@ -0,0 +1,30 @@
+#include <stdio.h>
+
+int test_ekf_alloc();
+int test_mat_n();
+int test_mat_expr();
+int test_mat_solve();
+int test_ekf_sparse();
+int test_ekf_sequential();
+int test_ekf_multirate();
+int test_ahrs();
+int test_lkf();
+int test_ekf_q31();
+
+int main(void)
+{
+    printf("main starts!\n");
+    int ret = test_ekf_alloc();
+    ret += test_mat_n();
+    ret += test_mat_expr();
+    ret += test_mat_solve();
+    ret += test_ekf_sparse();
+    ret += test_ekf_sequential();
+    ret += test_ekf_multirate();
+    ret += test_ahrs();
+    ret += test_lkf();
+    ret += test_ekf_q31();
+
+    printf("Test done\n");
+    return ret;
+}
@@ -0,0 +1,235 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "test_imu_trace.h"
+#include "dsps_ahrs.h"
+
+#define AHRS_DT         0.002f  // 500 Hz MPU6050 loop
+#define ACCEL_LSB       16384   // +-2 g range
+#define GYRO_LSB        131     // +-250 deg/sec range
+#define N_ROUNDS        10
+#define N_ROUNDS_EKF    3
+
+static volatile float bench_sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint64_t now_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Output of MPU6050_getMotion6() for the trace: {ax, ay, az, gx, gy, gz}
+static int16_t motion[N_TRACE][6];
+static float gyro_scale;
+
+static int16_t Quantize(float value)
+{
+    float r = roundf(value);
+    return (int16_t)fmaxf(-32768, fminf(32767, r));
+}
+
+// The gyroscope offset is found at rest and removed, as by the offset registers of MPU6050
+static void RecordMotion(void)
+{
+    gyro_scale = (float)(M_PI / 180) / GYRO_LSB;
+    RecordImuTrace(AHRS_DT);
+    float offset[3] = {0, 0, 0};
+    for (int n = 0; n < N_CALIB; n++) {
+        for (int i = 0; i < 3; i++) {
+            offset[i] += imu_trace[n].gyro[i] / N_CALIB;
+        }
+    }
+    for (int n = 0; n < N_TRACE; n++) {
+        for (int i = 0; i < 3; i++) {
+            motion[n][i] = Quantize(imu_trace[n].accel[i] * ACCEL_LSB);
+            motion[n][i + 3] = Quantize((imu_trace[n].gyro[i] - offset[i]) / gyro_scale);
+        }
+    }
+}
+
+// Angle between the estimated and the true gravity direction in the sensor frame
+static float TiltError(const float *q, int n)
+{
+    const float *t = imu_trace[n].attitude;
+    float v[3] = {2 * (q[1] * q[3] - q[0] * q[2]), 2 * (q[0] * q[1] + q[2] * q[3]), q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3]};
+    float u[3] = {2 * (t[1] * t[3] - t[0] * t[2]), 2 * (t[0] * t[1] + t[2] * t[3]), t[0] * t[0] - t[1] * t[1] - t[2] * t[2] + t[3] * t[3]};
+    float dot = v[0] * u[0] + v[1] * u[1] + v[2] * u[2];
+    float norm = sqrtf((v[0] * v[0] + v[1] * v[1] + v[2] * v[2]) * (u[0] * u[0] + u[1] * u[1] + u[2] * u[2]));
+    return acosf(fminf(dot / norm, 1));
+}
+
+typedef struct {
+    const char *name;
+    float rms;
+    float max;
+    double ns;
+    double cycles;
+    float q[N_TRACE][4];
+} ahrs_result_t;
+
+static ahrs_result_t results[5] = {{"EKF 13 states"}, {"Madgwick f32"}, {"Madgwick s32"}, {"Mahony f32"}, {"Mahony s32"}};
+
+enum {
+    EKF,
+    MADGWICK_F32,
+    MADGWICK_S32,
+    MAHONY_F32,
+    MAHONY_S32,
+};
+
+static void RunEkf(ahrs_result_t *result)
+{
+    float R[10];
+    for (int i = 0; i < 10; i++) {
+        R[i] = 0.01;
+    }
+    for (int r = 0; r < N_ROUNDS_EKF; r++) {
+        ekf_imu13states *ekf13 = new ekf_imu13states();
+        ekf13->Init();
+        double start = now_ns();
+        uint64_t start_cycles = now_cycles();
+        for (int n = 0; n < N_TRACE; n++) {
+            float gyro[3], accel[3];
+            for (int i = 0; i < 3; i++) {
+                accel[i] = (float)motion[n][i] / ACCEL_LSB;
+                gyro[i] = motion[n][i + 3] * gyro_scale;
+            }
+            ekf13->Process(gyro, AHRS_DT);
+            if (n < N_CALIB / 2) {
+                ekf13->UpdateRefMeasurement(accel, imu_trace[n].magn, imu_trace[n].attitude, R);
+            } else if (n < N_CALIB) {
+                ekf13->UpdateRefMeasurementMagn(accel, imu_trace[n].magn, R);
+            } else {
+                ekf13->UpdateRefMeasurement(accel, imu_trace[n].magn, R);
+            }
+            memcpy(result->q[n], ekf13->X.data, 4 * sizeof(float));
+        }
+        double ns = (now_ns() - start) / N_TRACE;
+        double cycles = (double)(now_cycles() - start_cycles) / N_TRACE;
+        if ((r == 0) || (ns < result->ns)) {
+            result->ns = ns;
+            result->cycles = cycles;
+        }
+        delete ekf13;
+    }
+}
+
+static void RunAhrs(int mode, ahrs_result_t *result)
+{
+    for (int r = 0; r < N_ROUNDS; r++) {
+        ahrs_madgwick_f32_t madgwick_f32;
+        ahrs_madgwick_s32_t madgwick_s32;
+        ahrs_mahony_f32_t mahony_f32;
+        ahrs_mahony_s32_t mahony_s32;
+        dsps_madgwick_init_f32(&madgwick_f32, 0.1, gyro_scale, AHRS_DT);
+        dsps_madgwick_init_s32(&madgwick_s32, 0.1, gyro_scale, AHRS_DT);
+        dsps_mahony_init_f32(&mahony_f32, 1, 0.05, gyro_scale, AHRS_DT);
+        dsps_mahony_init_s32(&mahony_s32, 1, 0.05, gyro_scale, AHRS_DT);
+
+        double start = now_ns();
+        uint64_t start_cycles = now_cycles();
+        switch (mode) {
+        case MADGWICK_F32:
+            for (int n = 0; n < N_TRACE; n++) {
+                dsps_madgwick_f32(&madgwick_f32, motion[n]);
+                memcpy(result->q[n], madgwick_f32.q, sizeof(madgwick_f32.q));
+            }
+            break;
+        case MADGWICK_S32:
+            for (int n = 0; n < N_TRACE; n++) {
+                dsps_madgwick_s32(&madgwick_s32, motion[n]);
+                for (int i = 0; i < 4; i++) {
+                    result->q[n][i] = madgwick_s32.q[i] / (float)(1 << 30);
+                }
+            }
+            break;
+        case MAHONY_F32:
+            for (int n = 0; n < N_TRACE; n++) {
+                dsps_mahony_f32(&mahony_f32, motion[n]);
+                memcpy(result->q[n], mahony_f32.q, sizeof(mahony_f32.q));
+            }
+            break;
+        default:
+            for (int n = 0; n < N_TRACE; n++) {
+                dsps_mahony_s32(&mahony_s32, motion[n]);
+                for (int i = 0; i < 4; i++) {
+                    result->q[n][i] = mahony_s32.q[i] / (float)(1 << 30);
+                }
+            }
+            break;
+        }
+        double ns = (now_ns() - start) / N_TRACE;
+        double cycles = (double)(now_cycles() - start_cycles) / N_TRACE;
+        if ((r == 0) || (ns < result->ns)) {
+            result->ns = ns;
+            result->cycles = cycles;
+        }
+    }
+    bench_sink = result->q[N_TRACE - 1][0];
+}
+
+static float MaxQuatDiff(ahrs_result_t *a, ahrs_result_t *b)
+{
+    float diff = 0;
+    for (int n = 0; n < N_TRACE; n++) {
+        for (int i = 0; i < 4; i++) {
+            diff = fmaxf(diff, fabsf(a->q[n][i] - b->q[n][i]));
+        }
+    }
+    return diff;
+}
+
+int test_ahrs()
+{
+    int ret = 0;
+    RecordMotion();
+    for (int mode = 0; mode < 5; mode++) {
+        if (mode == EKF) {
+            RunEkf(&results[mode]);
+        } else {
+            RunAhrs(mode, &results[mode]);
+        }
+        double error2 = 0;
+        results[mode].max = 0;
+        for (int n = N_CALIB; n < N_TRACE; n++) {
+            float error = TiltError(results[mode].q[n], n);
+            error2 += error * error;
+            results[mode].max = fmaxf(results[mode].max, error);
+        }
+        results[mode].rms = sqrtf(error2 / (N_TRACE - N_CALIB));
+        printf("%-14s: tilt error rms %.4f max %.4f rad, %8.1f ns %8.0f TSC cycles per step (x%.0f)\n",
+               results[mode].name, results[mode].rms, results[mode].max, results[mode].ns, results[mode].cycles,
+               results[EKF].ns / results[mode].ns);
+    }
+    float diff_madgwick = MaxQuatDiff(&results[MADGWICK_F32], &results[MADGWICK_S32]);
+    float diff_mahony = MaxQuatDiff(&results[MAHONY_F32], &results[MAHONY_S32]);
+    printf("s32 against f32: max quaternion difference Madgwick %g, Mahony %g\n", diff_madgwick, diff_mahony);
+    for (int mode = MADGWICK_F32; mode <= MAHONY_S32; mode++) {
+        if (results[mode].rms > 0.02) {
+            printf("Error - %s tilt error\n", results[mode].name);
+            ret++;
+        }
+    }
+    if ((diff_madgwick > 1e-3) || (diff_mahony > 1e-3)) {
+        printf("Error - s32 filters differ from f32\n");
+        ret++;
+    }
+    printf("AHRS: %i error(s)\n", ret);
+    return ret;
+}
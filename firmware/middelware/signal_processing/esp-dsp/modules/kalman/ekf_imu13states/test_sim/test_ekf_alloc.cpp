@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <new>
+
+#include "ekf_imu13states.h"
+
+// Count every heap allocation of the program
+static int alloc_count = 0;
+
+void *operator new(size_t size)
+{
+    alloc_count++;
+    void *ptr = malloc(size);
+    if (ptr == NULL) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t size) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr, size_t size) noexcept
+{
+    free(ptr);
+}
+
+#define N_STEPS 20000
+
+typedef struct {
+    float allocs_per_step;
+    float ns_per_step;
+    float X[13];
+} ekf_bench_t;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Static sensor with constant gyroscope bias: the filter has to find the bias
+static void run_ekf(ekf_imu13states *ekf13, ekf_bench_t *result)
+{
+    float gyro[3] = {0.1, 0.2, 0.3};
+    float accel[3] = {0, 0, 1};
+    float magn[3] = {1, 0, 0};
+    float R[6] = {0.01, 0.01, 0.01, 0.01, 0.01, 0.01};
+    float dt = 0.01;
+
+    // The first step is not counted: it is the place for lazy initialization
+    ekf13->Process(gyro, dt);
+    ekf13->UpdateRefMeasurement(accel, magn, R);
+
+    int allocs_start = alloc_count;
+    double start = now_ns();
+    for (int n = 1; n < N_STEPS; n++) {
+        ekf13->Process(gyro, dt);
+        ekf13->UpdateRefMeasurement(accel, magn, R);
+    }
+    double end = now_ns();
+
+    result->allocs_per_step = (float)(alloc_count - allocs_start) / (N_STEPS - 1);
+    result->ns_per_step = (end - start) / (N_STEPS - 1);
+    memcpy(result->X, ekf13->X.data, sizeof(result->X));
+}
+
+int test_ekf_alloc()
+{
+    int ret = 0;
+    ekf_bench_t heap;
+    ekf_bench_t arena;
+
+    ekf_imu13states *ekf_heap = new ekf_imu13states();
+    ekf_heap->Init();
+    ekf_heap->scratch.resize(0); // every temporary matrix goes to the heap
+    run_ekf(ekf_heap, &heap);
+
+    ekf_imu13states *ekf_arena = new ekf_imu13states();
+    ekf_arena->Init();
+    run_ekf(ekf_arena, &arena);
+
+    printf("heap : %6.1f allocations/step, %8.0f ns/step\n", heap.allocs_per_step, heap.ns_per_step);
+    printf("arena: %6.1f allocations/step, %8.0f ns/step, scratch %i of %i floats, %i overflows\n",
+           arena.allocs_per_step, arena.ns_per_step,
+           ekf_arena->scratch.high_water, ekf_arena->scratch.length, ekf_arena->scratch.overflows);
+    printf("gyro bias: %f %f %f\n", arena.X[4], arena.X[5], arena.X[6]);
+
+    if (arena.allocs_per_step != 0) {
+        printf("Error - steady state step allocates from the heap\n");
+        ret = 1;
+    }
+    if (ekf_arena->scratch.overflows != 0) {
+        printf("Error - default scratch size is too small\n");
+        ret = 1;
+    }
+    if (memcmp(heap.X, arena.X, sizeof(heap.X)) != 0) {
+        printf("Error - arena and heap results are different\n");
+        ret = 1;
+    }
+    if ((fabsf(arena.X[4] - 0.1) > 0.01) || (fabsf(arena.X[5] - 0.2) > 0.01) || (fabsf(arena.X[6] - 0.3) > 0.01)) {
+        printf("Error - gyro bias was not estimated\n");
+        ret = 1;
+    }
+
+    delete ekf_heap;
+    delete ekf_arena;
+    return ret;
+}
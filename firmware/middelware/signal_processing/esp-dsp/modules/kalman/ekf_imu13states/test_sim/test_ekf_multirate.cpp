@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "test_imu_trace.h"
+
+#define GYRO_PERIOD_US  1000    // 1 kHz gyroscope
+#define SLOW_DIV        10      // 100 Hz accelerometer and magnetometer
+#define MAGN_DELAY      50      // magnetometer samples come 50 ms late
+#define HISTORY         (MAGN_DELAY + SLOW_DIV)
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Angle between the estimated and the true attitude, in radians
+static float AttitudeError(ekf_imu13states *ekf13, int n)
+{
+    float dot = 0;
+    for (int i = 0; i < 4; i++) {
+        dot += ekf13->X(i, 0) * imu_trace[n].attitude[i];
+    }
+    dot = fminf(fabsf(dot) / ekf13->X.Get(0, 4, 0, 1).norm(), 1);
+    return 2 * std::acos(dot);
+}
+
+typedef struct {
+    const char *name;
+    float rms_error;
+    float max_error;
+    double us_per_second;
+    int updates;
+} multirate_result_t;
+
+enum {
+    LOCKSTEP_FAST,  // all sensors at the gyroscope rate, the slow samples repeated
+    LOCKSTEP_SLOW,  // all sensors at the slowest rate
+    MULTIRATE,      // every sensor at its own rate, delayed magnetometer by history
+    MULTIRATE_NOW,  // every sensor at its own rate, delay is not known
+};
+
+static void Run(int mode, multirate_result_t *result)
+{
+    ekf_imu13states *ekf13 = new ekf_imu13states(HISTORY);
+    ekf13->Init();
+    // Q is the noise of one gyroscope sample, P grows by dt^2*G*Q*G' per
+    // sample: the same noise per second at SLOW_DIV times higher rate
+    if (mode != LOCKSTEP_SLOW) {
+        ekf13->Q *= SLOW_DIV;
+    }
+    float R[10] = {0.01, 0.01, 0.01, 0.01, 0.01, 0.01, 0.01, 0.01, 0.01, 0.01};
+    float dt = GYRO_PERIOD_US * 1e-6f;
+    int slow = 0;   // last sample of the slow sensors
+    int magn = 0;   // last magnetometer sample that has come
+    double error2 = 0;
+    int count = 0;
+    result->max_error = 0;
+    result->updates = 0;
+
+    double start = now_ns();
+    for (int n = 0; n < N_TRACE; n++) {
+        int64_t time = (int64_t)n * GYRO_PERIOD_US;
+        if ((n % SLOW_DIV) == 0) {
+            slow = n;
+        }
+        if ((n >= MAGN_DELAY) && (((n - MAGN_DELAY) % SLOW_DIV) == 0)) {
+            magn = n - MAGN_DELAY;
+        }
+        if (n < N_CALIB) {
+            // The same calibration at rest for all modes
+            if (mode >= MULTIRATE) {
+                ekf13->ProcessGyro(imu_trace[n].gyro, time);
+            } else {
+                ekf13->Process(imu_trace[n].gyro, dt);
+            }
+            if (n < N_CALIB / 2) {
+                ekf13->UpdateRefMeasurement(imu_trace[n].accel, imu_trace[n].magn, imu_trace[n].attitude, R);
+            } else {
+                ekf13->UpdateRefMeasurementMagn(imu_trace[n].accel, imu_trace[n].magn, R);
+            }
+            continue;
+        }
+        switch (mode) {
+        case LOCKSTEP_FAST:
+            ekf13->Process(imu_trace[n].gyro, dt);
+            ekf13->UpdateRefMeasurement(imu_trace[slow].accel, imu_trace[magn].magn, R);
+            result->updates += 2;
+            break;
+        case LOCKSTEP_SLOW:
+            if (n == slow) {
+                ekf13->Process(imu_trace[n].gyro, dt * SLOW_DIV);
+                ekf13->UpdateRefMeasurement(imu_trace[slow].accel, imu_trace[magn].magn, R);
+                result->updates += 2;
+            }
+            break;
+        default:
+            ekf13->ProcessGyro(imu_trace[n].gyro, time);
+            if (n == slow) {
+                ekf13->UpdateAccel(imu_trace[n].accel, time, R);
+                result->updates++;
+            }
+            if ((n >= MAGN_DELAY) && (magn == n - MAGN_DELAY)) {
+                int64_t magn_time = (mode == MULTIRATE) ? (int64_t)magn * GYRO_PERIOD_US : time;
+                ekf13->UpdateMagn(imu_trace[magn].magn, magn_time, R);
+                result->updates++;
+            }
+            break;
+        }
+        {
+            float error = AttitudeError(ekf13, n);
+            error2 += error * error;
+            count++;
+            result->max_error = fmaxf(result->max_error, error);
+        }
+    }
+    result->us_per_second = (now_ns() - start) * 1e-3 / (N_TRACE * dt);
+    result->rms_error = sqrtf(error2 / count);
+    delete ekf13;
+}
+
+// Sample older than the history is not used
+static int CheckLate(void)
+{
+    ekf_imu13states *ekf13 = new ekf_imu13states(4);
+    ekf13->Init();
+    float R[3] = {0.01, 0.01, 0.01};
+    for (int n = 0; n < 10; n++) {
+        ekf13->ProcessGyro(imu_trace[n].gyro, (int64_t)n * GYRO_PERIOD_US);
+    }
+    dspm::Mat X = ekf13->X;
+    bool used_old = ekf13->UpdateMagn(imu_trace[2].magn, 2 * GYRO_PERIOD_US, R);
+    bool late_same = (memcmp(X.data, ekf13->X.data, X.length * sizeof(float)) == 0);
+    bool used_new = ekf13->UpdateMagn(imu_trace[7].magn, 7 * GYRO_PERIOD_US, R);
+    bool used_future = ekf13->UpdateAccel(imu_trace[9].accel, 20 * GYRO_PERIOD_US, R);
+    int late = ekf13->late;
+    delete ekf13;
+    if (used_old || !late_same || !used_new || !used_future || (late != 1)) {
+        printf("Error - late measurements\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Delayed sample equal to the expected value at its time does not change the state
+static int CheckDelayed(void)
+{
+    ekf_imu13states *ekf13 = new ekf_imu13states(HISTORY);
+    ekf13->Init();
+    float R[3] = {0.01, 0.01, 0.01};
+    int delayed = N_CALIB + 100;
+    float magn[3];
+    for (int n = 0; n <= delayed + MAGN_DELAY; n++) {
+        ekf13->ProcessGyro(imu_trace[n].gyro, (int64_t)n * GYRO_PERIOD_US);
+        if (n == delayed) {
+            dspm::Mat Re = ekf::quat2rotm(ekf13->X.data).t();
+            dspm::Mat expected = Re * ekf13->X.Get(7, 3, 0, 1) + ekf13->X.Get(10, 3, 0, 1);
+            memcpy(magn, expected.data, sizeof(magn));
+        }
+    }
+    dspm::Mat X = ekf13->X;
+    dspm::Mat P = ekf13->P;
+    ekf13->UpdateMagn(magn, (int64_t)delayed * GYRO_PERIOD_US, R);
+    float diff_delayed = 0;
+    for (int i = 0; i < X.length; i++) {
+        diff_delayed = fmaxf(diff_delayed, fabsf(X.data[i] - ekf13->X.data[i]));
+    }
+    ekf13->X = X;
+    ekf13->P = P;
+    ekf13->UpdateMagn(magn, (int64_t)(delayed + MAGN_DELAY) * GYRO_PERIOD_US, R);
+    float diff_now = 0;
+    for (int i = 0; i < X.length; i++) {
+        diff_now = fmaxf(diff_now, fabsf(X.data[i] - ekf13->X.data[i]));
+    }
+    delete ekf13;
+    printf("Magnetometer sample %i ms late: state change %g at its time, %g as a new sample\n", MAGN_DELAY, diff_delayed, diff_now);
+    if ((diff_delayed > 1e-6) || (diff_now < 1e-5)) {
+        printf("Error - delayed measurement\n");
+        return 1;
+    }
+    return 0;
+}
+
+int test_ekf_multirate()
+{
+    int ret = 0;
+    RecordImuTrace(GYRO_PERIOD_US * 1e-6f);
+
+    multirate_result_t results[4] = {
+        {"lockstep 1 kHz"}, {"lockstep 100 Hz"}, {"multi-rate"}, {"multi-rate, no delay"}
+    };
+    for (int mode = 0; mode < 4; mode++) {
+        Run(mode, &results[mode]);
+        printf("%-22s: attitude error rms %.4f max %.4f rad, %6i updates, %8.0f us per second of data\n",
+               results[mode].name, results[mode].rms_error, results[mode].max_error,
+               results[mode].updates, results[mode].us_per_second);
+    }
+    if ((results[MULTIRATE].rms_error > results[LOCKSTEP_SLOW].rms_error) ||
+            (results[MULTIRATE].rms_error > 0.9f * results[MULTIRATE_NOW].rms_error) ||
+            (results[MULTIRATE].updates != results[LOCKSTEP_SLOW].updates)) {
+        printf("Error - multi-rate processing\n");
+        ret++;
+    }
+    ret += CheckDelayed();
+    ret += CheckLate();
+    printf("Multi-rate EKF: %i error(s)\n", ret);
+    return ret;
+}
@@ -0,0 +1,251 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "test_imu_trace.h"
+#include "ekf_q31.h"
+
+#define N_BENCH     20000
+#define N_ROUNDS    10
+
+typedef ekf_q31<ekf_imu13states> ekf_imu13states_q31;
+
+static volatile float bench_sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void Fill(dspm::Mat &m, float ampl)
+{
+    for (int row = 0; row < m.rows; row++) {
+        for (int col = 0; col < m.cols; col++) {
+            m(row, col) = ampl * (rand() % 2001 - 1000) / 1000.0f;
+        }
+    }
+}
+
+static float MaxDiff(const dspm::Mat &A, const dspm::Mat &B)
+{
+    float diff = 0;
+    for (int row = 0; row < A.rows; row++) {
+        for (int col = 0; col < A.cols; col++) {
+            diff = fmaxf(diff, fabsf(A(row, col) - B(row, col)));
+        }
+    }
+    return diff;
+}
+
+static float MaxAbs(const dspm::Mat &A)
+{
+    float result = 0;
+    for (int i = 0; i < A.length; i++) {
+        result = fmaxf(result, fabsf(A.data[i]));
+    }
+    return result;
+}
+
+// Angle between the estimated and the true attitude, in radians
+static float AttitudeError(ekf_imu13states *ekf13, int n)
+{
+    float dot = 0;
+    for (int i = 0; i < 4; i++) {
+        dot += ekf13->X(i, 0) * imu_trace[n].attitude[i];
+    }
+    dot = fminf(fabsf(dot) / ekf13->X.Get(0, 4, 0, 1).norm(), 1);
+    return 2 * std::acos(dot);
+}
+
+static int CheckMatQ31(void)
+{
+    int ret = 0;
+
+    // Conversion: the values have 31 bits relative to the largest one
+    dspm::Mat A(7, 5);
+    Fill(A, 1e-3);
+    dspm::MatQ31 Aq(7, 5);
+    Aq.fromMat(A);
+    if ((MaxDiff(Aq.toMat(), A) > ldexpf(MaxAbs(A), -24)) || (Aq.headroom() != 0)) {
+        printf("Error - MatQ31 fromMat/toMat\n");
+        ret++;
+    }
+
+    // Product and sum of matrices of different scales
+    dspm::Mat B(5, 6);
+    Fill(B, 200);
+    dspm::MatQ31 Bq(5, 6);
+    Bq.fromMat(B);
+    dspm::MatQ31 Cq(7, 6);
+    dspm::MatQ31::mult(Aq, Bq, Cq);
+    dspm::Mat C = A * B;
+    float diff_mult = MaxDiff(Cq.toMat(), C) / MaxAbs(C);
+    dspm::Mat D(7, 6);
+    Fill(D, 1e-4);
+    dspm::MatQ31 Dq(7, 6);
+    Dq.fromMat(D);
+    dspm::MatQ31 Sq(7, 6);
+    dspm::MatQ31::add(Cq, Dq, Sq);
+    dspm::Mat S = C + D;
+    float diff_add = MaxDiff(Sq.toMat(), S) / MaxAbs(S);
+    dspm::MatQ31::sub(Sq, Dq, Sq);
+    float diff_sub = MaxDiff(Sq.toMat(), C) / MaxAbs(C);
+    printf("MatQ31 against float: product %g, sum %g, difference %g (relative)\n", diff_mult, diff_add, diff_sub);
+    if ((diff_mult > 1e-6) || (diff_add > 1e-6) || (diff_sub > 1e-6)) {
+        printf("Error - MatQ31 arithmetic\n");
+        ret++;
+    }
+
+    // A zero matrix does not change the precision of the sum
+    dspm::MatQ31 Zq(7, 6);
+    dspm::MatQ31::add(Zq, Dq, Sq);
+    if ((Sq.exponent != Dq.exponent) || memcmp(Sq.data, Dq.data, Dq.length * sizeof(int32_t))) {
+        printf("Error - MatQ31 sum with zero matrix\n");
+        ret++;
+    }
+
+    // Transpose
+    dspm::MatQ31 Tq = Aq.t();
+    if (MaxDiff(Tq.toMat(), A.t()) > ldexpf(MaxAbs(A), -24)) {
+        printf("Error - MatQ31 transpose\n");
+        ret++;
+    }
+
+    // Saturation of dspm_mult_s32
+    int32_t full[2] = {INT32_MAX, INT32_MAX};
+    int32_t negative[2] = {INT32_MIN, INT32_MIN};
+    int32_t result[2];
+    dspm_mult_s32_ansi(full, full, &result[0], 1, 2, 1, 0);
+    dspm_mult_s32_ansi(full, negative, &result[1], 1, 2, 1, 0);
+    if ((result[0] != INT32_MAX) || (result[1] != INT32_MIN)) {
+        printf("Error - dspm_mult_s32_ansi saturation: %i %i\n", (int)result[0], (int)result[1]);
+        ret++;
+    }
+    dspm_mult_s32_ansi(full, full, &result[0], 1, 2, 1, -1);
+    if (result[0] != INT32_MAX - 1) {
+        printf("Error - dspm_mult_s32_ansi shift: %i\n", (int)result[0]);
+        ret++;
+    }
+    return ret;
+}
+
+// Float and fixed point filters over the recorded IMU trace
+static int CheckSameEstimates(float dt)
+{
+    int ret = 0;
+    ekf_imu13states *ekf_f32 = new ekf_imu13states();
+    ekf_imu13states_q31 *ekf_q31 = new ekf_imu13states_q31();
+    ekf_f32->Init();
+    ekf_q31->Init();
+
+    float max_q = 0;
+    float max_p = 0;
+    float max_angle[2] = {0, 0};
+    bool symmetric = true;
+    for (int n = 0; n < N_TRACE; n++) {
+        ReplayImuStep(ekf_f32, n, dt);
+        ReplayImuStep(ekf_q31, n, dt);
+        max_q = fmaxf(max_q, MaxDiff(ekf_f32->X.Get(0, 4, 0, 1), ekf_q31->X.Get(0, 4, 0, 1)));
+        ekf_q31->SyncCovariance();
+        max_p = fmaxf(max_p, MaxDiff(ekf_f32->P, ekf_q31->P) / MaxAbs(ekf_f32->P));
+        if (n >= N_CALIB) {
+            max_angle[0] = fmaxf(max_angle[0], AttitudeError(ekf_f32, n));
+            max_angle[1] = fmaxf(max_angle[1], AttitudeError(ekf_q31, n));
+        }
+        for (int i = 0; i < ekf_q31->NUMX; i++) {
+            for (int j = 0; j < i; j++) {
+                symmetric = symmetric && (ekf_q31->Pq(i, j) == ekf_q31->Pq(j, i));
+            }
+        }
+    }
+    printf("Q31 EKF against float over %i samples: max difference quaternion %g, P %g (relative)\n", N_TRACE, max_q, max_p);
+    printf("Max attitude error after calibration: float %g rad, Q31 %g rad\n", max_angle[0], max_angle[1]);
+    printf("Final gyro bias: float %f %f %f, Q31 %f %f %f\n",
+           ekf_f32->X(4, 0), ekf_f32->X(5, 0), ekf_f32->X(6, 0), ekf_q31->X(4, 0), ekf_q31->X(5, 0), ekf_q31->X(6, 0));
+    if ((max_q > 1e-3) || (max_p > 1e-3) || (max_angle[1] > 1.1f * max_angle[0] + 1e-3f)) {
+        printf("Error - Q31 EKF differs from the float one\n");
+        ret++;
+    }
+    if (!symmetric) {
+        printf("Error - Pq is not symmetric\n");
+        ret++;
+    }
+    delete ekf_f32;
+    delete ekf_q31;
+    return ret;
+}
+
+static void BenchStep(float dt)
+{
+    ekf_imu13states *ekf_f32 = new ekf_imu13states();
+    ekf_imu13states_q31 *ekf_q31 = new ekf_imu13states_q31();
+    ekf_imu13states *filters[2] = {ekf_f32, ekf_q31};
+    ekf_f32->Init();
+    ekf_q31->Init();
+    for (int n = 0; n < N_CALIB + 100; n++) {
+        ReplayImuStep(ekf_f32, n, dt);
+        ReplayImuStep(ekf_q31, n, dt);
+    }
+    ekf_f32->LinearizeFG(ekf_f32->X, imu_trace[N_CALIB].gyro);
+    ekf_q31->LinearizeFG(ekf_q31->X, imu_trace[N_CALIB].gyro);
+
+    // Covariance prediction alone
+    dspm::Mat P = ekf_f32->P;
+    dspm::MatQ31 Pq = ekf_q31->Pq;
+    double prediction[2] = {0, 0};
+    for (int f = 0; f < 2; f++) {
+        for (int r = 0; r < N_ROUNDS; r++) {
+            double start = now_ns();
+            for (int n = 0; n < N_BENCH / N_ROUNDS; n++) {
+                dspm::MatArena::Scope scope(filters[f]->scratch);
+                if (f == 0) {
+                    ekf_f32->P = P;
+                } else {
+                    ekf_q31->Pq = Pq;
+                }
+                filters[f]->CovariancePrediction(dt);
+            }
+            double ns = (now_ns() - start) / (N_BENCH / N_ROUNDS);
+            prediction[f] = ((r == 0) || (ns < prediction[f])) ? ns : prediction[f];
+        }
+        bench_sink = filters[f]->P(0, 0);
+    }
+
+    // Filter step: prediction and update of 6 measurements
+    float R[6] = {0.01, 0.01, 0.01, 0.01, 0.01, 0.01};
+    double step[2] = {0, 0};
+    int len = (N_TRACE - N_CALIB) / N_ROUNDS;
+    for (int f = 0; f < 2; f++) {
+        for (int r = 0; r < N_ROUNDS; r++) {
+            double start = now_ns();
+            for (int n = N_CALIB + r * len; n < N_CALIB + (r + 1) * len; n++) {
+                filters[f]->Process(imu_trace[n].gyro, dt);
+                filters[f]->UpdateRefMeasurement(imu_trace[n].accel, imu_trace[n].magn, R);
+            }
+            double ns = (now_ns() - start) / len;
+            step[f] = ((r == 0) || (ns < step[f])) ? ns : step[f];
+        }
+        bench_sink = filters[f]->P(0, 0);
+    }
+    printf("Covariance prediction 13x13: float %7.1f ns, Q31 %7.1f ns (x%.2f)\n",
+           prediction[0], prediction[1], prediction[0] / prediction[1]);
+    printf("Filter step with 6 measurements: float %7.1f ns, Q31 %7.1f ns (x%.2f), host with FPU\n",
+           step[0], step[1], step[0] / step[1]);
+    delete ekf_f32;
+    delete ekf_q31;
+}
+
+int test_ekf_q31()
+{
+    float dt = 0.01;
+    RecordImuTrace(dt);
+    int ret = CheckMatQ31();
+    ret += CheckSameEstimates(dt);
+    BenchStep(dt);
+    printf("Q31 EKF: %i error(s)\n", ret);
+    return ret;
+}
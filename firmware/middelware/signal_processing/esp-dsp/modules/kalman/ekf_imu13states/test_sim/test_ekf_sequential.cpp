@@ -0,0 +1,223 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "test_imu_trace.h"
+
+#define N_BENCH         20000
+#define N_ROUNDS        10
+#define OUTLIER_PERIOD  97
+
+static volatile float bench_sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Previous measurement update: ekf::Update with P = P - K*h*P
+class ekf_imu13states_simple: public ekf_imu13states {
+public:
+    virtual int UpdateSequential(dspm::Mat &H, float *measured, float *expected, float *R, float gate)
+    {
+        this->Update(H, measured, expected, R);
+        return 0;
+    }
+};
+
+// All measurements at once: Cholesky solve of the innovation covariance
+class ekf_imu13states_batch: public ekf_imu13states {
+public:
+    virtual int UpdateSequential(dspm::Mat &H, float *measured, float *expected, float *R, float gate)
+    {
+        this->UpdateRef(H, measured, expected, R);
+        return 0;
+    }
+};
+
+static float MaxDiff(const dspm::Mat &A, const dspm::Mat &B)
+{
+    float diff = 0;
+    for (int i = 0; i < A.length; i++) {
+        diff = fmaxf(diff, fabsf(A.data[i] - B.data[i]));
+    }
+    return diff;
+}
+
+static float MaxAbs(const dspm::Mat &A)
+{
+    float result = 0;
+    for (int i = 0; i < A.length; i++) {
+        result = fmaxf(result, fabsf(A.data[i]));
+    }
+    return result;
+}
+
+// Angle between the estimated and the true attitude, in radians
+static float AttitudeError(ekf_imu13states *ekf13, int n)
+{
+    float dot = 0;
+    for (int i = 0; i < 4; i++) {
+        dot += ekf13->X(i, 0) * imu_trace[n].attitude[i];
+    }
+    dot = fminf(fabsf(dot) / ekf13->X.Get(0, 4, 0, 1).norm(), 1);
+    return 2 * std::acos(dot);
+}
+
+static int CheckSameEstimates(float dt)
+{
+    int ret = 0;
+    ekf_imu13states *joseph = new ekf_imu13states();
+    ekf_imu13states_simple *simple = new ekf_imu13states_simple();
+    ekf_imu13states_batch *batch = new ekf_imu13states_batch();
+    joseph->Init();
+    simple->Init();
+    batch->Init();
+
+    float max_x[2] = {0, 0};
+    float max_p[2] = {0, 0};
+    float max_angle = 0;
+    bool symmetric = true;
+    for (int n = 0; n < N_TRACE; n++) {
+        ReplayImuStep(joseph, n, dt);
+        ReplayImuStep(simple, n, dt);
+        ReplayImuStep(batch, n, dt);
+        max_x[0] = fmaxf(max_x[0], MaxDiff(joseph->X, simple->X));
+        max_p[0] = fmaxf(max_p[0], MaxDiff(joseph->P, simple->P) / MaxAbs(simple->P));
+        max_x[1] = fmaxf(max_x[1], MaxDiff(joseph->X, batch->X));
+        max_p[1] = fmaxf(max_p[1], MaxDiff(joseph->P, batch->P) / MaxAbs(batch->P));
+        if (n >= N_CALIB) {
+            max_angle = fmaxf(max_angle, AttitudeError(joseph, n));
+        }
+        for (int i = 0; i < joseph->NUMX; i++) {
+            for (int j = 0; j < i; j++) {
+                symmetric = symmetric && (joseph->P(i, j) == joseph->P(j, i));
+            }
+        }
+    }
+    printf("Joseph form against P - K*h*P over %i samples: max difference X %g, P %g (relative)\n", N_TRACE, max_x[0], max_p[0]);
+    printf("Joseph form against batch Cholesky update:   max difference X %g, P %g (relative)\n", max_x[1], max_p[1]);
+    printf("Max attitude error after calibration %g rad, final gyro bias %f %f %f\n",
+           max_angle, joseph->X(4, 0), joseph->X(5, 0), joseph->X(6, 0));
+    if ((max_x[0] > 1e-3) || (max_p[0] > 1e-3) || (max_x[1] > 1e-3) || (max_p[1] > 1e-3)) {
+        printf("Error - sequential update differs from the previous ones\n");
+        ret++;
+    }
+    if (!symmetric) {
+        printf("Error - P is not symmetric\n");
+        ret++;
+    }
+    if (joseph->rejected != 0) {
+        printf("Error - measurements rejected without gate\n");
+        ret++;
+    }
+    delete joseph;
+    delete simple;
+    delete batch;
+    return ret;
+}
+
+// Magnetometer and accelerometer spikes: the gate rejects them
+static int CheckInnovationGate(float dt)
+{
+    int ret = 0;
+    int outliers = 0;
+    for (int n = N_CALIB + OUTLIER_PERIOD; n < N_TRACE; n += OUTLIER_PERIOD) {
+        imu_trace[n].magn[n % 3] += 2;
+        imu_trace[n].accel[(n + 1) % 3] -= 1;
+        outliers += 2;
+    }
+
+    ekf_imu13states *gated = new ekf_imu13states();
+    ekf_imu13states *open = new ekf_imu13states();
+    gated->Init();
+    open->Init();
+    gated->innovation_gate = 4;
+    float max_angle[2] = {0, 0};
+    for (int n = 0; n < N_TRACE; n++) {
+        ReplayImuStep(gated, n, dt);
+        ReplayImuStep(open, n, dt);
+        if (n >= N_CALIB) {
+            max_angle[0] = fmaxf(max_angle[0], AttitudeError(gated, n));
+            max_angle[1] = fmaxf(max_angle[1], AttitudeError(open, n));
+        }
+    }
+    printf("Innovation gate: %i outliers, %i measurements rejected, max attitude error %g rad, without gate %g rad\n",
+           outliers, gated->rejected, max_angle[0], max_angle[1]);
+    if ((gated->rejected < outliers) || (gated->rejected > outliers + outliers / 10) || (max_angle[0] >= max_angle[1])) {
+        printf("Error - innovation gate\n");
+        ret++;
+    }
+    delete gated;
+    delete open;
+
+    // Restore the trace for the next tests
+    for (int n = N_CALIB + OUTLIER_PERIOD; n < N_TRACE; n += OUTLIER_PERIOD) {
+        imu_trace[n].magn[n % 3] -= 2;
+        imu_trace[n].accel[(n + 1) % 3] += 1;
+    }
+    return ret;
+}
+
+// Update of 6 measurements with the H matrix of ekf_imu13states::UpdateRefMeasurement
+static void BenchUpdate(float dt)
+{
+    ekf_imu13states *ekf13 = new ekf_imu13states();
+    ekf13->Init();
+    for (int n = 0; n < N_CALIB + 100; n++) {
+        ReplayImuStep(ekf13, n, dt);
+    }
+    dspm::Mat H(6, ekf13->NUMX);
+    H.Copy(dspm::Mat::eye(3), 0, 10);
+    float q[4];
+    memcpy(q, ekf13->X.data, sizeof(q));
+    dspm::MatN<3, 4> dFdq;
+    ekf::dFdq_inv(ekf13->accel0.data, q, dFdq);
+    dFdq.copyTo(H, 3, 0);
+    ekf::dFdq_inv(&ekf13->X.data[7], q, dFdq);
+    dFdq.copyTo(H, 0, 0);
+    float R[6] = {0.01, 0.01, 0.01, 0.01, 0.01, 0.01};
+    float measured[6] = {0, 0, 0, 0, 0, 0};
+    float expected[6] = {0, 0, 0, 0, 0, 0};
+
+    dspm::Mat P = ekf13->P;
+    dspm::Mat X = ekf13->X;
+    double best[3] = {0, 0, 0};
+    for (int f = 0; f < 3; f++) {
+        for (int r = 0; r < N_ROUNDS; r++) {
+            double start = now_ns();
+            for (int n = 0; n < N_BENCH / N_ROUNDS; n++) {
+                ekf13->P = P;
+                ekf13->X = X;
+                if (f == 0) {
+                    ekf13->Update(H, measured, expected, R);
+                } else if (f == 1) {
+                    ekf13->UpdateSequential(H, measured, expected, R);
+                } else {
+                    ekf13->UpdateRef(H, measured, expected, R);
+                }
+            }
+            double ns = (now_ns() - start) / (N_BENCH / N_ROUNDS);
+            best[f] = ((r == 0) || (ns < best[f])) ? ns : best[f];
+        }
+        bench_sink = ekf13->P(0, 0);
+    }
+    printf("Update 6x13: P - K*h*P %7.1f ns, Joseph form %7.1f ns, batch Cholesky %7.1f ns (ns include P and X copy)\n",
+           best[0], best[1], best[2]);
+    delete ekf13;
+}
+
+int test_ekf_sequential()
+{
+    float dt = 0.01;
+    RecordImuTrace(dt);
+    int ret = CheckSameEstimates(dt);
+    ret += CheckInnovationGate(dt);
+    BenchUpdate(dt);
+    printf("Sequential EKF update: %i error(s)\n", ret);
+    return ret;
+}
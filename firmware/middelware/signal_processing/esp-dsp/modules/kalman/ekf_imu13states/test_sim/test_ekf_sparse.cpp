@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "test_imu_trace.h"
+
+#define N_BENCH     20000
+#define N_ROUNDS    10
+
+static volatile float bench_sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Previous ekf::CovariancePrediction with dense products
+class ekf_imu13states_dense: public ekf_imu13states {
+public:
+    virtual void CovariancePrediction(float dt)
+    {
+        dspm::Mat f = this->F * dt;
+        f = f + dspm::Mat::eye(this->NUMX);
+        dspm::Mat f_t = f.t();
+        this->P = ((f * this->P) * f_t) + (dt * dt) * ((G * Q) * G.t());
+    }
+};
+
+static float MaxDiff(const dspm::Mat &A, const dspm::Mat &B)
+{
+    float diff = 0;
+    for (int i = 0; i < A.length; i++) {
+        diff = fmaxf(diff, fabsf(A.data[i] - B.data[i]));
+    }
+    return diff;
+}
+
+static float MaxAbs(const dspm::Mat &A)
+{
+    float result = 0;
+    for (int i = 0; i < A.length; i++) {
+        result = fmaxf(result, fabsf(A.data[i]));
+    }
+    return result;
+}
+
+// One prediction from the same state: the upper triangle has the same bits
+static int CheckOneStep(ekf_imu13states *sparse, ekf_imu13states_dense *dense, float dt)
+{
+    dense->X = sparse->X;
+    dense->P = sparse->P;
+    dense->LinearizeFG(dense->X, imu_trace[N_TRACE - 1].gyro);
+    sparse->LinearizeFG(sparse->X, imu_trace[N_TRACE - 1].gyro);
+    {
+        dspm::MatArena::Scope scope(dense->scratch);
+        dense->CovariancePrediction(dt);
+    }
+    {
+        dspm::MatArena::Scope scope(sparse->scratch);
+        sparse->CovariancePrediction(dt);
+    }
+    for (int i = 0; i < sparse->NUMX; i++) {
+        for (int j = i; j < sparse->NUMX; j++) {
+            if (sparse->P(i, j) != dense->P(i, j)) {
+                printf("Error - sparse covariance prediction P(%i, %i) = %g, dense %g\n", i, j, sparse->P(i, j), dense->P(i, j));
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void BenchPrediction(ekf_imu13states *sparse, ekf_imu13states_dense *dense, float dt)
+{
+    ekf *filters[2] = {dense, sparse};
+    double best[2] = {0, 0};
+    dspm::Mat P = sparse->P;
+    for (int f = 0; f < 2; f++) {
+        for (int r = 0; r < N_ROUNDS; r++) {
+            double start = now_ns();
+            for (int n = 0; n < N_BENCH / N_ROUNDS; n++) {
+                dspm::MatArena::Scope scope(filters[f]->scratch);
+                filters[f]->P = P;
+                filters[f]->CovariancePrediction(dt);
+            }
+            double ns = (now_ns() - start) / (N_BENCH / N_ROUNDS);
+            best[f] = ((r == 0) || (ns < best[f])) ? ns : best[f];
+        }
+        bench_sink = filters[f]->P(0, 0);
+    }
+
+    // Multiply-accumulate operations of the products
+    int n = sparse->NUMX;
+    int w = sparse->NUMW;
+    int dense_macs = 2 * n * n * n + n * w * w + n * w * n;
+    int nnz_f = sparse->f_nonzero.start[n];
+    int nnz_g = sparse->g_nonzero.start[n];
+    int sparse_macs = nnz_f * n + nnz_g * w;
+    for (int j = 0; j < n; j++) {
+        int row = (sparse->f_nonzero.start[j + 1] - sparse->f_nonzero.start[j]) +
+                  (sparse->g_nonzero.start[j + 1] - sparse->g_nonzero.start[j]);
+        sparse_macs += (j + 1) * row;
+    }
+    printf("Covariance prediction: nonzero f %i of %i, G %i of %i\n", nnz_f, n * n, nnz_g, n * w);
+    printf("Covariance prediction: dense %5i MACs %7.1f ns, sparse %5i MACs %7.1f ns (x%.1f)\n",
+           dense_macs, best[0], sparse_macs, best[1], best[0] / best[1]);
+    printf("Scratch high water: dense %i floats, sparse %i floats\n",
+           dense->scratch.high_water, sparse->scratch.high_water);
+}
+
+int test_ekf_sparse()
+{
+    int ret = 0;
+    float dt = 0.01;
+    RecordImuTrace(dt);
+
+    ekf_imu13states *sparse = new ekf_imu13states();
+    ekf_imu13states_dense *dense = new ekf_imu13states_dense();
+    sparse->Init();
+    dense->Init();
+
+    float max_x = 0;
+    float max_p = 0;
+    for (int n = 0; n < N_TRACE; n++) {
+        ReplayImuStep(sparse, n, dt);
+        ReplayImuStep(dense, n, dt);
+        max_x = fmaxf(max_x, MaxDiff(sparse->X, dense->X));
+        max_p = fmaxf(max_p, MaxDiff(sparse->P, dense->P) / MaxAbs(dense->P));
+    }
+    printf("Sparse EKF against dense over %i samples: max difference X %g, P %g (relative)\n", N_TRACE, max_x, max_p);
+    printf("Final gyro bias: sparse %f %f %f, dense %f %f %f\n",
+           sparse->X(4, 0), sparse->X(5, 0), sparse->X(6, 0), dense->X(4, 0), dense->X(5, 0), dense->X(6, 0));
+    if ((max_x > 1e-3) || (max_p > 1e-3)) {
+        printf("Error - sparse EKF differs from the dense one\n");
+        ret++;
+    }
+    for (int i = 0; i < sparse->NUMX; i++) {
+        for (int j = 0; j < i; j++) {
+            if (sparse->P(i, j) != sparse->P(j, i)) {
+                printf("Error - P is not symmetric\n");
+                ret++;
+                i = sparse->NUMX;
+                break;
+            }
+        }
+    }
+    ret += CheckOneStep(sparse, dense, dt);
+    BenchPrediction(sparse, dense, dt);
+
+    delete sparse;
+    delete dense;
+    printf("Sparse EKF: %i error(s)\n", ret);
+    return ret;
+}
@@ -0,0 +1,61 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "test_imu_trace.h"
+
+imu_sample_t imu_trace[N_TRACE];
+
+static float Noise(float ampl)
+{
+    return ampl * (rand() % 2001 - 1000) / 1000.0f;
+}
+
+void RecordImuTrace(float dt)
+{
+    float pi = std::atan(1) * 4;
+    float bias[3] = {0.1, -0.05, 0.02};
+    float accel0_data[] = {0, 0, 1};
+    float magn0_data[] = {1, 0, 0};
+    dspm::Mat accel0(accel0_data, 3, 1);
+    dspm::Mat magn0(magn0_data, 3, 1);
+    dspm::Mat Rm = dspm::Mat::eye(3);
+
+    for (int n = 0; n < N_TRACE; n++) {
+        float rate[3] = {0, 0, 0};
+        if (n >= N_CALIB) {
+            float phase = 2 * pi * n * dt;
+            rate[0] = 0.5f * std::sin(phase * 0.3f);
+            rate[1] = 0.3f * std::cos(phase * 0.7f);
+            rate[2] = 0.8f * std::sin(phase * 0.1f);
+        }
+        float angle[3] = {rate[0] * dt, rate[1] * dt, rate[2] * dt};
+        dspm::Mat Re = ekf::eul2rotm(angle);
+        Rm = Rm * Re;
+        dspm::Mat attitude = ekf::rotm2quat(Rm);
+        dspm::Mat accel = Rm.t() * accel0;
+        dspm::Mat magn = Rm.t() * magn0;
+        for (int i = 0; i < 3; i++) {
+            imu_trace[n].gyro[i] = rate[i] + bias[i] + Noise(0.01);
+            imu_trace[n].accel[i] = accel(i, 0) + Noise(0.02);
+            imu_trace[n].magn[i] = magn(i, 0) + Noise(0.02);
+        }
+        memcpy(imu_trace[n].attitude, attitude.data, sizeof(imu_trace[n].attitude));
+    }
+}
+
+void ReplayImuStep(ekf_imu13states *ekf13, int n, float dt)
+{
+    float R[10];
+    for (int i = 0; i < 10; i++) {
+        R[i] = 0.01;
+    }
+    ekf13->Process(imu_trace[n].gyro, dt);
+    if (n < N_CALIB / 2) {
+        ekf13->UpdateRefMeasurement(imu_trace[n].accel, imu_trace[n].magn, imu_trace[n].attitude, R);
+    } else if (n < N_CALIB) {
+        ekf13->UpdateRefMeasurementMagn(imu_trace[n].accel, imu_trace[n].magn, R);
+    } else {
+        ekf13->UpdateRefMeasurement(imu_trace[n].accel, imu_trace[n].magn, R);
+    }
+}
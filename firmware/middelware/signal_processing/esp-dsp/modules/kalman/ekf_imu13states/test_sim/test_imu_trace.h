@@ -0,0 +1,26 @@
+#ifndef _test_imu_trace_H_
+#define _test_imu_trace_H_
+
+#include "ekf_imu13states.h"
+
+#define N_TRACE     6000
+#define N_CALIB     1000
+
+// IMU samples of a rotating body: gyroscope with bias and noise,
+// accelerometer and magnetometer in the body frame
+typedef struct {
+    float gyro[3];
+    float accel[3];
+    float magn[3];
+    float attitude[4];
+} imu_sample_t;
+
+extern imu_sample_t imu_trace[N_TRACE];
+
+// Fill imu_trace, the body rests for the first N_CALIB samples
+void RecordImuTrace(float dt);
+
+// Calibration with all the states, then attitude and gyro bias only
+void ReplayImuStep(ekf_imu13states *ekf13, int n, float dt);
+
+#endif // _test_imu_trace_H_
@@ -0,0 +1,249 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "dsps_lkf.h"
+
+#define N_DISTANCE  2000
+#define N_WEIGHT    2000
+#define N_AVERAGE   8
+#define N_BENCH     1000000
+
+// Constant acceleration, N = 3
+DSPS_LKF_DEFINE(ca, 3)
+
+static volatile float bench_sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static float Noise(float ampl)
+{
+    return ampl * (rand() % 2001 - 1000) / 1000.0f;
+}
+
+typedef struct {
+    float rms;          // error over all samples
+    float noise;        // error at constant value
+    int settle;         // samples to settle after the step
+} lkf_result_t;
+
+// First sample after the step, when all the next samples are within the band
+static int Settle(const float *estimate, const float *truth, int step, int len, float band)
+{
+    int last = step;
+    for (int n = step; n < len; n++) {
+        if (fabsf(estimate[n] - truth[n]) > band) {
+            last = n + 1;
+        }
+    }
+    return last - step;
+}
+
+static lkf_result_t Evaluate(const float *estimate, const float *truth, int len, int quiet_end, int step, float band)
+{
+    lkf_result_t result;
+    double error2 = 0;
+    double noise2 = 0;
+    for (int n = 0; n < len; n++) {
+        float e = estimate[n] - truth[n];
+        error2 += e * e;
+        if ((n >= 100) && (n < quiet_end)) {
+            noise2 += e * e;
+        }
+    }
+    result.rms = sqrtf(error2 / len);
+    result.noise = sqrtf(noise2 / (quiet_end - 100));
+    result.settle = Settle(estimate, truth, step, len, band);
+    return result;
+}
+
+// HC-SR04 reads in cm: rest, ramp at 0.2 cm/read to 50 cm, rest, step to 120 cm.
+// 1% of the reads have no echo and return 0, 1% time out and return 300
+static int CheckDistance(void)
+{
+    static float truth[N_DISTANCE], average[N_DISTANCE], fixed[N_DISTANCE], adaptive[N_DISTANCE];
+    float window[N_AVERAGE];
+    int count = 0;
+    lkf_cv_f32_t lkf_fixed, lkf_adaptive;
+    dsps_lkf_cv_init_f32(&lkf_fixed, 0.01, 4);
+    dsps_lkf_cv_init_f32(&lkf_adaptive, 0.01, 4);
+    dsps_lkf_cv_adaptive_f32(&lkf_adaptive, 0.1, 100);
+
+    for (int n = 0; n < N_DISTANCE; n++) {
+        float d = 150;
+        if (n >= 500) {
+            d = 150 - 0.2f * fminf(n - 500, 500);
+        }
+        if (n >= 1500) {
+            d = 120;
+        }
+        truth[n] = d;
+        int read = (int)lroundf(d + Noise(3));
+        int dropout = rand() % 100;
+        if (dropout == 0) {
+            read = 0;
+        } else if (dropout == 1) {
+            read = 300;
+        }
+        if ((read != 0) && (read < 300)) {
+            window[count++ % N_AVERAGE] = read;
+            fixed[n] = dsps_lkf_cv_f32(&lkf_fixed, read, 1);
+            adaptive[n] = dsps_lkf_cv_f32(&lkf_adaptive, read, 1);
+        } else {
+            dsps_lkf_cv_predict_f32(&lkf_fixed, 1);
+            dsps_lkf_cv_predict_f32(&lkf_adaptive, 1);
+            fixed[n] = lkf_fixed.x[0];
+            adaptive[n] = lkf_adaptive.x[0];
+        }
+        int len = count < N_AVERAGE ? count : N_AVERAGE;
+        float sum = 0;
+        for (int i = 0; i < len; i++) {
+            sum += window[i];
+        }
+        average[n] = sum / len;
+    }
+
+    lkf_result_t r_average = Evaluate(average, truth, N_DISTANCE, 500, 1500, 3);
+    lkf_result_t r_fixed = Evaluate(fixed, truth, N_DISTANCE, 500, 1500, 3);
+    lkf_result_t r_adaptive = Evaluate(adaptive, truth, N_DISTANCE, 500, 1500, 3);
+    // Mean error at the ramp, the average lags by half of the window
+    float ramp[3] = {0, 0, 0};
+    for (int n = 800; n < 1000; n++) {
+        ramp[0] += (average[n] - truth[n]) / 200;
+        ramp[1] += (fixed[n] - truth[n]) / 200;
+        ramp[2] += (adaptive[n] - truth[n]) / 200;
+    }
+    printf("HC-SR04 average of %i : rms %.2f cm, at rest %.2f cm, ramp mean error %5.2f cm, settle %3i reads\n",
+           N_AVERAGE, r_average.rms, r_average.noise, ramp[0], r_average.settle);
+    printf("HC-SR04 Kalman CV     : rms %.2f cm, at rest %.2f cm, ramp mean error %5.2f cm, settle %3i reads\n",
+           r_fixed.rms, r_fixed.noise, ramp[1], r_fixed.settle);
+    printf("HC-SR04 Kalman CV adpt: rms %.2f cm, at rest %.2f cm, ramp mean error %5.2f cm, settle %3i reads\n",
+           r_adaptive.rms, r_adaptive.noise, ramp[2], r_adaptive.settle);
+    if ((r_adaptive.rms >= r_average.rms) || (r_adaptive.settle > r_average.settle) ||
+            (r_adaptive.settle >= r_fixed.settle)) {
+        printf("Error - HC-SR04 filter\n");
+        return 1;
+    }
+    return 0;
+}
+
+// HX711 raw counts: constant weight, then a step. The noise is 20 counts rms,
+// 50 nV at gain 128 and 10 SPS. HX711_readAverage(10) gives one value per
+// 10 reads, so its output is held for 10 reads
+static int CheckWeight(void)
+{
+    static float truth[N_WEIGHT], average[N_WEIGHT], fixed[N_WEIGHT], adaptive[N_WEIGHT];
+    lkf_const_f32_t lkf_fixed, lkf_adaptive;
+    dsps_lkf_const_init_f32(&lkf_fixed, 1, 400);
+    dsps_lkf_const_init_f32(&lkf_adaptive, 1, 400);
+    dsps_lkf_const_adaptive_f32(&lkf_adaptive, 0.1, 10000);
+    float sum = 0;
+    float held = 0;
+    for (int n = 0; n < N_WEIGHT; n++) {
+        truth[n] = (n < 1000) ? 8000 : 9000;
+        float read = roundf(truth[n] + Noise(20 * sqrtf(3)));
+        sum += read;
+        if ((n % 10) == 9) {
+            held = sum / 10;
+            sum = 0;
+        }
+        average[n] = (n < 9) ? read : held;
+        fixed[n] = dsps_lkf_const_f32(&lkf_fixed, read, 1);
+        adaptive[n] = dsps_lkf_const_f32(&lkf_adaptive, read, 1);
+    }
+    // Settled within 2.5 times the noise of a read
+    lkf_result_t r_average = Evaluate(average, truth, N_WEIGHT, 1000, 1000, 50);
+    lkf_result_t r_fixed = Evaluate(fixed, truth, N_WEIGHT, 1000, 1000, 50);
+    lkf_result_t r_adaptive = Evaluate(adaptive, truth, N_WEIGHT, 1000, 1000, 50);
+    printf("HX711 average of 10   : rms %6.2f, constant weight %.2f counts, settle %3i reads\n",
+           r_average.rms, r_average.noise, r_average.settle);
+    printf("HX711 Kalman const    : rms %6.2f, constant weight %.2f counts, settle %3i reads\n",
+           r_fixed.rms, r_fixed.noise, r_fixed.settle);
+    printf("HX711 Kalman const adp: rms %6.2f, constant weight %.2f counts, settle %3i reads\n",
+           r_adaptive.rms, r_adaptive.noise, r_adaptive.settle);
+    if ((r_adaptive.noise >= r_average.noise) || (r_adaptive.settle > r_average.settle) ||
+            (r_adaptive.settle >= r_fixed.settle)) {
+        printf("Error - HX711 filter\n");
+        return 1;
+    }
+    return 0;
+}
+
+static int CheckModel(void)
+{
+    int ret = 0;
+    // Constant value: steady-state gain K = P/(P + r), predicted P = (q + sqrt(q^2 + 4*q*r))/2
+    float q = 0.01;
+    float r = 4;
+    lkf_const_f32_t lkf_const;
+    dsps_lkf_const_init_f32(&lkf_const, q, r);
+    for (int n = 0; n < 2000; n++) {
+        dsps_lkf_const_f32(&lkf_const, 1, 1);
+    }
+    float p_pred = (q + sqrtf(q * q + 4 * q * r)) / 2;
+    float p_ref = p_pred * r / (p_pred + r);
+    if (fabsf(lkf_const.P[0] - p_ref) > 1e-4f * p_ref) {
+        printf("Error - constant value covariance %g, expected %g\n", lkf_const.P[0], p_ref);
+        ret++;
+    }
+
+    // Constant velocity follows the ramp without lag, constant acceleration the parabola
+    lkf_cv_f32_t lkf_cv;
+    lkf_ca_f32_t lkf_ca;
+    dsps_lkf_cv_init_f32(&lkf_cv, 0.01, 1);
+    dsps_lkf_ca_init_f32(&lkf_ca, 0.01, 1);
+    float dt = 0.1;
+    float cv = 0;
+    float ca = 0;
+    for (int n = 0; n < 500; n++) {
+        float t = n * dt;
+        cv = dsps_lkf_cv_f32(&lkf_cv, 3 + 2 * t, dt) - (3 + 2 * t);
+        ca = dsps_lkf_ca_f32(&lkf_ca, 1 + t * t, dt) - (1 + t * t);
+    }
+    if ((fabsf(cv) > 1e-3f) || (fabsf(lkf_cv.x[1] - 2) > 1e-3f) || (fabsf(ca) > 1e-2f) || (fabsf(lkf_ca.x[2] - 2) > 1e-2f)) {
+        printf("Error - model: constant velocity error %g, velocity %g, constant acceleration error %g, acceleration %g\n",
+               cv, lkf_cv.x[1], ca, lkf_ca.x[2]);
+        ret++;
+    }
+    return ret;
+}
+
+static void BenchUpdate(void)
+{
+    lkf_const_f32_t lkf_const;
+    lkf_cv_f32_t lkf_cv;
+    dsps_lkf_const_init_f32(&lkf_const, 0.01, 4);
+    dsps_lkf_cv_init_f32(&lkf_cv, 0.5, 4);
+    dsps_lkf_const_adaptive_f32(&lkf_const, 0.1, 10000);
+    dsps_lkf_cv_adaptive_f32(&lkf_cv, 0.1, 100);
+    float sum = 0;
+    double start = now_ns();
+    for (int n = 0; n < N_BENCH; n++) {
+        sum += dsps_lkf_const_f32(&lkf_const, (float)(n & 7), 1);
+    }
+    double ns_const = (now_ns() - start) / N_BENCH;
+    start = now_ns();
+    for (int n = 0; n < N_BENCH; n++) {
+        sum += dsps_lkf_cv_f32(&lkf_cv, (float)(n & 7), 1);
+    }
+    double ns_cv = (now_ns() - start) / N_BENCH;
+    bench_sink = sum;
+    printf("Linear Kalman update: constant value %.1f ns, constant velocity %.1f ns\n", ns_const, ns_cv);
+}
+
+int test_lkf()
+{
+    int ret = CheckModel();
+    ret += CheckDistance();
+    ret += CheckWeight();
+    BenchUpdate();
+    printf("Linear Kalman: %i error(s)\n", ret);
+    return ret;
+}
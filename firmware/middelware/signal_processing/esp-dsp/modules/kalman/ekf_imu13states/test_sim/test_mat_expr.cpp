@@ -0,0 +1,253 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <type_traits>
+#include <utility>
+
+#include "mat.h"
+#include "dspm_mult.h"
+
+#define NUMX    13
+#define NUMW    18
+#define N_BENCH 20000
+#define N_ROUNDS 10
+
+static volatile float bench_sink;
+
+// The expressions keep references to the operands: they can not be copied,
+// and a stored expression can not be evaluated
+typedef decltype(std::declval<dspm::Mat &>() * std::declval<dspm::Mat &>()) product_expr_t;
+static_assert(!std::is_copy_constructible<product_expr_t>::value, "Matrix expression could be copied");
+static_assert(!std::is_constructible<dspm::Mat, product_expr_t &>::value, "Stored matrix expression could be evaluated");
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void Fill(dspm::Mat &m)
+{
+    for (int row = 0; row < m.rows; row++) {
+        for (int col = 0; col < m.cols; col++) {
+            m(row, col) = (rand() % 2001 - 1000) / 1000.0f;
+        }
+    }
+}
+
+static bool Same(const dspm::Mat &A, const dspm::Mat &B)
+{
+    if ((A.rows != B.rows) || (A.cols != B.cols)) {
+        return false;
+    }
+    for (int row = 0; row < A.rows; row++) {
+        if (memcmp(&A.data[row * A.stride], &B.data[row * B.stride], A.cols * sizeof(float)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Previous operators: every operation returns a new matrix
+static dspm::Mat EagerMul(const dspm::Mat &A, const dspm::Mat &B)
+{
+    dspm::Mat result(A.rows, B.cols);
+    dspm_mult_f32_ansi(A.data, B.data, result.data, A.rows, A.cols, B.cols);
+    return result;
+}
+
+static dspm::Mat EagerAdd(const dspm::Mat &A, const dspm::Mat &B)
+{
+    dspm::Mat result(A);
+    result += B;
+    return result;
+}
+
+static dspm::Mat EagerScale(const dspm::Mat &A, float C)
+{
+    dspm::Mat result(A);
+    result *= C;
+    return result;
+}
+
+// ekf::CovariancePrediction with the previous operators
+static void CovarianceEager(dspm::Mat &P, dspm::Mat &F, dspm::Mat &G, dspm::Mat &Q, float dt)
+{
+    dspm::Mat f = EagerScale(F, dt);
+    f = EagerAdd(f, dspm::Mat::eye(NUMX));
+    dspm::Mat f_t = f.t();
+    dspm::Mat G_t = G.t();
+    P = EagerAdd(EagerMul(EagerMul(f, P), f_t), EagerScale(EagerMul(EagerMul(G, Q), G_t), dt * dt));
+}
+
+// ekf::CovariancePrediction
+static void CovarianceExpr(dspm::Mat &P, dspm::Mat &F, dspm::Mat &G, dspm::Mat &Q, float dt)
+{
+    dspm::Mat f = F * dt;
+    f = f + dspm::Mat::eye(NUMX);
+    dspm::Mat f_t = f.t();
+    P = ((f * P) * f_t) + (dt * dt) * ((G * Q) * G.t());
+}
+
+static int CheckExpressions(void)
+{
+    int ret = 0;
+    dspm::Mat A(5, 4), B(4, 6), C(5, 6), D(6, 6), x(5, 4), y(5, 4);
+    Fill(A);
+    Fill(B);
+    Fill(C);
+    Fill(D);
+    Fill(x);
+    Fill(y);
+
+    // Element-wise chain in one pass
+    dspm::Mat chain = (x + 2.0f * y - A) * 0.5f + 1.0f;
+    dspm::Mat chain_ref = EagerAdd(EagerScale(EagerAdd(EagerAdd(x, EagerScale(y, 2.0f)), EagerScale(A, -1.0f)), 0.5f), dspm::Mat::ones(5, 4));
+    dspm::Mat sub_ref(x);
+    sub_ref -= A;
+    if (!Same(x - A, sub_ref) || !Same(chain, chain_ref) || !Same(A / 4.0f, EagerScale(A, 0.25f))) {
+        printf("Error - element-wise expression\n");
+        ret++;
+    }
+
+    // Product with accumulation, on both sides of +
+    dspm::Mat AB = EagerMul(A, B);
+    if (!Same(A * B + C, EagerAdd(AB, C)) || !Same(C + A * B, EagerAdd(C, AB)) ||
+            !Same(A * B + C * D, EagerAdd(AB, EagerMul(C, D))) ||
+            !Same((A * B) * D, EagerMul(AB, D))) {
+        printf("Error - product expression\n");
+        ret++;
+    }
+
+    // Operands that are also the destination
+    dspm::Mat P(6, 6), F(6, 6), Q(6, 6);
+    Fill(P);
+    Fill(F);
+    Fill(Q);
+    dspm::Mat P_ref = EagerAdd(EagerMul(EagerMul(F, P), F.t()), Q);
+    P = F * P * F.t() + Q;
+    bool same = Same(P, P_ref);
+    P_ref = EagerMul(P, P);
+    P = P * P;
+    dspm::Mat x_ref = EagerAdd(x, EagerScale(y, 2.0f));
+    x = x + y * 2.0f;
+    if (!same || !Same(P, P_ref) || !Same(x, x_ref)) {
+        printf("Error - aliased expression\n");
+        ret++;
+    }
+
+    // Sub-matrix operands and destination
+    dspm::Mat big(10, 10);
+    Fill(big);
+    dspm::Mat roi = big.getROI(2, 3, 4, 6);
+    dspm::Mat roi_copy = big.Get(2, 4, 3, 6);
+    dspm::Mat prod_ref = EagerMul(A, roi_copy);
+    dspm::Mat sum_ref = EagerAdd(EagerMul(A.Get(0, 4, 0, 4), B), C.Get(0, 4, 0, 6));
+    if (!Same(A * roi, prod_ref)) {
+        printf("Error - sub-matrix operand\n");
+        ret++;
+    }
+    roi = A.getROI(0, 0, 4, 4) * B + C.getROI(0, 0, 4, 6);
+    if (!Same(roi, sum_ref) || (roi.data != &big.data[2 * 10 + 3])) {
+        printf("Error - sub-matrix destination\n");
+        ret++;
+    }
+
+    // Dimension errors give 1x1 matrix, as before
+    dspm::Mat err_sum = A + B;
+    dspm::Mat err_prod = A * C;
+    if ((err_sum.rows != 1) || (err_sum.cols != 1) || (err_prod.rows != 1) || (err_prod.cols != 1)) {
+        printf("Error - dimension check\n");
+        ret++;
+    }
+
+    // Move takes the buffer of a heap matrix
+    dspm::Mat src(3, 3);
+    float *src_data = src.data;
+    dspm::Mat moved(std::move(src));
+    dspm::Mat dst(2, 2);
+    dspm::Mat other(3, 3);
+    float *other_data = other.data;
+    dst = std::move(other);
+    if ((moved.data != src_data) || (dst.data != other_data) || (dst.rows != 3)) {
+        printf("Error - move\n");
+        ret++;
+    }
+
+    // The arena buffer is kept out of the matrices created before the scope
+    dspm::MatArena arena(1024);
+    dspm::Mat outer(5, 6);
+    {
+        dspm::MatArena::Scope scope(arena);
+        outer = A * B + C;
+    }
+    if (!Same(outer, EagerAdd(AB, C)) || outer.ext_buff) {
+        printf("Error - arena\n");
+        ret++;
+    }
+    return ret;
+}
+
+typedef void (*covariance_fn_t)(dspm::Mat &P, dspm::Mat &F, dspm::Mat &G, dspm::Mat &Q, float dt);
+
+// Best time of N_ROUNDS rounds, in ns per call
+static double BenchRounds(covariance_fn_t fn, dspm::Mat &P, dspm::Mat &F, dspm::Mat &G, dspm::Mat &Q, dspm::MatArena *arena)
+{
+    double best = 0;
+    for (int r = 0; r < N_ROUNDS; r++) {
+        double start = now_ns();
+        for (int n = 0; n < N_BENCH / N_ROUNDS; n++) {
+            if (arena) {
+                dspm::MatArena::Scope scope(*arena);
+                fn(P, F, G, Q, 0.001f);
+            } else {
+                fn(P, F, G, Q, 0.001f);
+            }
+        }
+        double ns = (now_ns() - start) / (N_BENCH / N_ROUNDS);
+        best = ((r == 0) || (ns < best)) ? ns : best;
+    }
+    return best;
+}
+
+static int BenchCovariance(void)
+{
+    dspm::Mat F(NUMX, NUMX), G(NUMX, NUMW), Q(NUMW, NUMW);
+    Fill(F);
+    Fill(G);
+    Fill(Q);
+    F *= 0.01f;
+    dspm::Mat P_eager = dspm::Mat::eye(NUMX);
+    dspm::Mat P_expr = dspm::Mat::eye(NUMX);
+    dspm::MatArena arena(4096);
+
+    double heap_eager = BenchRounds(CovarianceEager, P_eager, F, G, Q, NULL);
+    double heap_expr = BenchRounds(CovarianceExpr, P_expr, F, G, Q, NULL);
+    double arena_eager = BenchRounds(CovarianceEager, P_eager, F, G, Q, &arena);
+    int scratch_eager = arena.high_water;
+    arena.high_water = 0;
+    double arena_expr = BenchRounds(CovarianceExpr, P_expr, F, G, Q, &arena);
+    int scratch_expr = arena.high_water;
+    bench_sink = P_eager(0, 0) + P_expr(0, 0);
+    printf("P = F*P*F' + dt^2*G*Q*G': heap  previous %7.1f ns, expressions %7.1f ns (x%.2f)\n",
+           heap_eager, heap_expr, heap_eager / heap_expr);
+    printf("                          arena previous %7.1f ns, expressions %7.1f ns (x%.2f)\n",
+           arena_eager, arena_expr, arena_eager / arena_expr);
+    printf("                          scratch previous %i floats, expressions %i floats\n",
+           scratch_eager, scratch_expr);
+    if (!Same(P_eager, P_expr)) {
+        printf("Error - covariance expression differs from the previous operators\n");
+        return 1;
+    }
+    return 0;
+}
+
+int test_mat_expr()
+{
+    int ret = CheckExpressions();
+    ret += BenchCovariance();
+    printf("Mat expressions: %i error(s)\n", ret);
+    return ret;
+}
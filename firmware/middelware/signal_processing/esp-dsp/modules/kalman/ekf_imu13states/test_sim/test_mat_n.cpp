@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ekf.h"
+#include "mat_n.h"
+
+#define N_BENCH 200000
+
+static volatile float bench_sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+template <int R, int C>
+static void Fill(dspm::MatN<R, C> &m)
+{
+    for (int i = 0; i < R * C; i++) {
+        m.data[i] = (rand() % 2001 - 1000) / 1000.0f;
+    }
+}
+
+// Product of MatN against dspm_mult_f32_ansi on the same data: same bits
+template <int R, int K, int C>
+static int CheckProduct(void)
+{
+    dspm::MatN<R, K> A;
+    dspm::MatN<K, C> B;
+    Fill(A);
+    Fill(B);
+    dspm::MatN<R, C> result = A * B;
+    float reference[R * C];
+    dspm_mult_f32_ansi(A.data, B.data, reference, R, K, C);
+    if (memcmp(result.data, reference, sizeof(reference)) != 0) {
+        printf("Error - MatN %ix%i * %ix%i differs from dspm_mult_f32_ansi\n", R, K, K, C);
+        return 1;
+    }
+
+    // Transpose views against the transposed copies of Mat
+    dspm::MatN<K, R> At = A.t().eval();
+    dspm::MatN<C, K> Bt = B.t().eval();
+    dspm::Mat At_mat = At.toMat();
+    dspm::Mat Bt_mat = Bt.toMat();
+    dspm::Mat reference_t = At_mat.t() * Bt_mat.t();
+    dspm::MatN<R, C> result_t = At.t() * Bt.t();
+    dspm::MatN<R, C> result_at = At.t() * B;
+    dspm::MatN<R, C> result_bt = A * Bt.t();
+    if ((memcmp(result_t.data, reference_t.data, sizeof(reference)) != 0) ||
+            (memcmp(result_at.data, reference, sizeof(reference)) != 0) ||
+            (memcmp(result_bt.data, reference, sizeof(reference)) != 0)) {
+        printf("Error - MatN %ix%i * %ix%i with transpose views differs from Mat\n", R, K, K, C);
+        return 1;
+    }
+    return 0;
+}
+
+static int CheckInterop(void)
+{
+    int ret = 0;
+    dspm::Mat big(6, 7);
+    for (int i = 0; i < big.length; i++) {
+        big.data[i] = i;
+    }
+
+    // From a sub-matrix (stride 7) and back to another block
+    dspm::MatN<3, 4> block(big.getROI(2, 1, 3, 4));
+    if (block(0, 0) != big(2, 1) || block(2, 3) != big(4, 4)) {
+        printf("Error - MatN from a sub-matrix\n");
+        ret++;
+    }
+    dspm::Mat dst(6, 7);
+    block.copyTo(dst, 3, 3);
+    if (dst(3, 3) != big(2, 1) || dst(5, 6) != big(4, 4) || dst(2, 3) != 0) {
+        printf("Error - MatN copyTo\n");
+        ret++;
+    }
+    if (!(block.toMat() == big.Get(2, 3, 1, 4))) {
+        printf("Error - MatN toMat\n");
+        ret++;
+    }
+    // The view shares the data
+    dspm::Mat view = block.view();
+    view(1, 2) = -1;
+    if (block(1, 2) != -1) {
+        printf("Error - MatN view\n");
+        ret++;
+    }
+    dspm::MatN<2, 3> sub = block.block<2, 3>(1, 1);
+    if (sub(0, 1) != -1 || sub(1, 2) != block(2, 3)) {
+        printf("Error - MatN block\n");
+        ret++;
+    }
+
+    // Helpers of the ekf: the MatN versions give the same matrices
+    float q[4] = {0.9f, 0.1f, -0.3f, 0.2f};
+    float v[3] = {0.3f, -0.5f, 0.8f};
+    dspm::Mat q_mat(q, 4, 1);
+    dspm::Mat v_mat(v, 3, 1);
+    dspm::MatN<3, 3> rotm;
+    dspm::MatN<4, 4> m44;
+    dspm::MatN<3, 4> m34;
+    ekf::quat2rotm(q, rotm);
+    ret += !(rotm.toMat() == ekf::quat2rotm(q));
+    ekf::SkewSym4x4(v, m44);
+    ret += !(m44.toMat() == ekf::SkewSym4x4(v));
+    ekf::qProduct(q, m44);
+    ret += !(m44.toMat() == ekf::qProduct(q));
+    ekf::dFdq(v, q, m34);
+    ret += !(m34.toMat() == ekf::dFdq(v_mat, q_mat));
+    ekf::dFdq_inv(v, q, m34);
+    ret += !(m34.toMat() == ekf::dFdq_inv(v_mat, q_mat));
+    if (ret != 0) {
+        printf("Error - MatN interop\n");
+    }
+    return ret;
+}
+
+template <int R, int K, int C>
+static void BenchProduct(void)
+{
+    dspm::MatN<R, K> A;
+    dspm::MatN<K, C> B;
+    Fill(A);
+    Fill(B);
+    dspm::Mat A_mat = A.toMat();
+    dspm::Mat B_mat = B.toMat();
+    float sum = 0; // all the results are used, so no product is optimized out
+
+    double start = now_ns();
+    for (int n = 0; n < N_BENCH; n++) {
+        A_mat.data[0] = n * 1e-6f;
+        dspm::Mat result = A_mat * B_mat;
+        for (int i = 0; i < R * C; i++) {
+            sum += result.data[i];
+        }
+    }
+    double mat_ns = (now_ns() - start) / N_BENCH;
+
+    start = now_ns();
+    for (int n = 0; n < N_BENCH; n++) {
+        A.data[0] = n * 1e-6f;
+        dspm::MatN<R, C> result = A * B;
+        for (int i = 0; i < R * C; i++) {
+            sum += result.data[i];
+        }
+    }
+    double matn_ns = (now_ns() - start) / N_BENCH;
+    bench_sink = sum;
+    printf("%2ix%-2i * %2ix%-2i: Mat %7.1f ns, MatN %7.1f ns (x%.1f)\n",
+           R, K, K, C, mat_ns, matn_ns, mat_ns / matn_ns);
+}
+
+int test_mat_n()
+{
+    int ret = 0;
+    ret += CheckProduct<3, 3, 3>();
+    ret += CheckProduct<3, 3, 1>();
+    ret += CheckProduct<4, 4, 4>();
+    ret += CheckProduct<4, 4, 1>();
+    ret += CheckProduct<3, 4, 4>();
+    ret += CheckProduct<3, 4, 1>();
+    ret += CheckProduct<2, 5, 3>();
+    ret += CheckProduct<13, 13, 13>();
+    ret += CheckProduct<6, 13, 1>();
+    ret += CheckInterop();
+
+    BenchProduct<3, 3, 3>();
+    BenchProduct<3, 3, 1>();
+    BenchProduct<4, 4, 4>();
+    BenchProduct<4, 4, 1>();
+    BenchProduct<3, 4, 4>();
+    BenchProduct<13, 13, 13>();
+
+    printf("MatN: %i error(s)\n", ret);
+    return ret;
+}
@@ -0,0 +1,265 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "ekf_imu13states.h"
+
+#define N_BENCH 2000
+
+static volatile float bench_sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void Fill(dspm::Mat &m)
+{
+    for (int row = 0; row < m.rows; row++) {
+        for (int col = 0; col < m.cols; col++) {
+            m(row, col) = (rand() % 2001 - 1000) / 1000.0f;
+        }
+    }
+}
+
+// Symmetric positive-definite matrix M*M' + I
+static dspm::Mat RandomSpd(int n)
+{
+    dspm::Mat M(n, n);
+    Fill(M);
+    dspm::Mat A = M * M.t() + dspm::Mat::eye(n);
+    return A;
+}
+
+static float MaxDiff(const dspm::Mat &A, const dspm::Mat &B)
+{
+    float diff = 0;
+    for (int row = 0; row < A.rows; row++) {
+        for (int col = 0; col < A.cols; col++) {
+            diff = fmaxf(diff, fabsf(A(row, col) - B(row, col)));
+        }
+    }
+    return diff;
+}
+
+// Previous Mat::det: recursive cofactor expansion over the first row, n <= 9
+static float DetCofactor(const float *a, int n)
+{
+    if (n == 1) {
+        return a[0];
+    }
+    float minor[8 * 8];
+    float D = 0;
+    int sign = 1;
+    for (int f = 0; f < n; f++) {
+        int pos = 0;
+        for (int r = 1; r < n; r++) {
+            for (int c = 0; c < n; c++) {
+                if (c != f) {
+                    minor[pos++] = a[r * n + c];
+                }
+            }
+        }
+        D += a[f] * DetCofactor(minor, n - 1) * sign;
+        sign = -sign;
+    }
+    return D;
+}
+
+// Previous Mat::pinv: Gauss-Jordan elimination of [A | I]
+static dspm::Mat InverseGaussJordan(dspm::Mat &A)
+{
+    dspm::Mat AI = dspm::Mat::augment(A, dspm::Mat::eye(A.rows));
+    dspm::Mat IA = AI.gaussianEliminate().rowReduceFromGaussian();
+    return IA.Get(0, A.rows, A.cols, A.cols);
+}
+
+static int CheckSolve(void)
+{
+    int ret = 0;
+
+    // LU with pivoting: A*X = B, zero on the diagonal needs a row swap
+    dspm::Mat A(7, 7), B(7, 3);
+    Fill(A);
+    Fill(B);
+    A(0, 0) = 0;
+    dspm::Mat LU = A;
+    dspm::Mat X = B;
+    int pivots[7];
+    if (!LU.luDecompose(pivots) || !LU.solveInPlace(pivots, X) || (MaxDiff(A * X, B) > 1e-4)) {
+        printf("Error - luDecompose/solveInPlace\n");
+        ret++;
+    }
+
+    // Sub-matrix operands
+    dspm::Mat big(10, 10);
+    Fill(big);
+    dspm::Mat A_sub = big.getROI(1, 2, 5, 5);
+    dspm::Mat A_copy = big.Get(1, 5, 2, 5);
+    dspm::Mat B_big(8, 8);
+    Fill(B_big);
+    dspm::Mat B_sub = B_big.getROI(2, 1, 5, 2);
+    dspm::Mat B_copy = B_big.Get(2, 5, 1, 2);
+    if (!A_sub.luDecompose(pivots) || !A_sub.solveInPlace(pivots, B_sub) || (MaxDiff(A_copy * B_sub, B_copy) > 1e-4)) {
+        printf("Error - luDecompose/solveInPlace of sub-matrices\n");
+        ret++;
+    }
+
+    // Cholesky LDL'
+    dspm::Mat S = RandomSpd(6);
+    dspm::Mat LDL = S;
+    dspm::Mat Y(6, 4);
+    Fill(Y);
+    dspm::Mat Z = Y;
+    if (!LDL.choleskyDecompose() || !LDL.choleskySolve(Z) || (MaxDiff(S * Z, Y) > 1e-4)) {
+        printf("Error - choleskyDecompose/choleskySolve\n");
+        ret++;
+    }
+    dspm::Mat not_pd = dspm::Mat::eye(3);
+    not_pd(1, 1) = -1;
+    if (not_pd.choleskyDecompose()) {
+        printf("Error - choleskyDecompose of not positive-definite matrix\n");
+        ret++;
+    }
+
+    // Singular matrix
+    dspm::Mat singular(4, 4);
+    Fill(singular);
+    for (int col = 0; col < 4; col++) {
+        singular(3, col) = 2 * singular(1, col);
+    }
+    dspm::Mat singular_lu = singular;
+    if (singular_lu.luDecompose(pivots) || (singular.det(4) != 0)) {
+        printf("Error - singular matrix\n");
+        ret++;
+    }
+
+    // Determinant against the cofactor expansion
+    float m_data[] = {2, 5, 7, 6, 3, 4, 5, -2, -3};
+    dspm::Mat M(m_data, 3, 3);
+    dspm::Mat D(6, 6);
+    Fill(D);
+    float det_ref = DetCofactor(D.data, 6);
+    if ((fabsf(M.det(3) + 1) > 1e-4) || (fabsf(D.det(6) - det_ref) > 1e-5 * fabsf(det_ref)) || (fabsf(D.det(3) - DetCofactor(D.Get(0, 3, 0, 3).data, 3)) > 1e-5)) {
+        printf("Error - det\n");
+        ret++;
+    }
+
+    // Inverse
+    float m_result[] = {1, -1, 1, -38, 41, -34, 27, -29, 24};
+    dspm::Mat M_inv = M.inverse();
+    dspm::Mat M_pinv = M.pinv();
+    if ((MaxDiff(M_inv, dspm::Mat(m_result, 3, 3)) > 1e-3) || (MaxDiff(M_pinv, M_inv) != 0) ||
+            (MaxDiff(D * D.inverse(), dspm::Mat::eye(6)) > 1e-4)) {
+        printf("Error - inverse\n");
+        ret++;
+    }
+    dspm::Mat singular_inv = singular.inverse();
+    if (MaxDiff(singular_inv, dspm::Mat(4, 4)) != 0) {
+        printf("Error - inverse of singular matrix\n");
+        ret++;
+    }
+    return ret;
+}
+
+// ekf::UpdateRef against the previous calculation by Gauss-Jordan inverse
+static int CheckUpdateRef(void)
+{
+    ekf_imu13states *ekf13 = new ekf_imu13states();
+    ekf13->Init();
+    float gyro[3] = {0.1, 0.2, 0.3};
+    float accel[3] = {0, 0, 1};
+    float magn[3] = {1, 0, 0};
+    float R[6] = {0.01, 0.01, 0.01, 0.01, 0.01, 0.01};
+    for (int n = 0; n < 100; n++) {
+        ekf13->Process(gyro, 0.01);
+        ekf13->UpdateRefMeasurement(accel, magn, R);
+    }
+
+    dspm::Mat H(6, 13);
+    Fill(H);
+    float measured[6] = {1, 0, 0, 0, 0, 1};
+    float expected[6] = {0.9, 0.1, 0, 0, 0.1, 0.9};
+    dspm::Mat P = ekf13->P;
+    dspm::Mat X = ekf13->X;
+
+    dspm::Mat h_t = H.t();
+    dspm::Mat S = H * P * h_t;
+    for (int i = 0; i < 6; i++) {
+        S(i, i) += R[i];
+    }
+    dspm::Mat K = (P * h_t) * InverseGaussJordan(S);
+    P = (dspm::Mat::eye(13) - K * H) * P;
+    X += K * (dspm::Mat(measured, 6, 1) - dspm::Mat(expected, 6, 1));
+
+    ekf13->UpdateRef(H, measured, expected, R);
+    float diff_p = MaxDiff(P, ekf13->P);
+    float diff_x = MaxDiff(X, ekf13->X);
+    printf("UpdateRef: Cholesky against Gauss-Jordan: max difference P %g, X %g\n", diff_p, diff_x);
+    delete ekf13;
+    if ((diff_p > 1e-5) || (diff_x > 1e-5)) {
+        printf("Error - UpdateRef\n");
+        return 1;
+    }
+    return 0;
+}
+
+static void BenchSolve(void)
+{
+    float sum = 0;
+    dspm::Mat D(8, 8);
+    Fill(D);
+    double start = now_ns();
+    for (int n = 0; n < N_BENCH / 100; n++) {
+        D(0, 0) = n * 1e-6f;
+        sum += DetCofactor(D.data, 8);
+    }
+    double det_old = (now_ns() - start) / (N_BENCH / 100);
+    start = now_ns();
+    for (int n = 0; n < N_BENCH; n++) {
+        D(0, 0) = n * 1e-6f;
+        sum += D.det(8);
+    }
+    double det_new = (now_ns() - start) / N_BENCH;
+
+    // Kalman gain of 6 measurements and 13 states
+    dspm::Mat S = RandomSpd(6);
+    dspm::Mat P = RandomSpd(13);
+    dspm::Mat H(6, 13);
+    Fill(H);
+    start = now_ns();
+    for (int n = 0; n < N_BENCH; n++) {
+        S(0, 0) += 1e-6f;
+        dspm::Mat K = (P * H.t()) * InverseGaussJordan(S);
+        sum += K(0, 0);
+    }
+    double gain_old = (now_ns() - start) / N_BENCH;
+    start = now_ns();
+    for (int n = 0; n < N_BENCH; n++) {
+        S(0, 0) += 1e-6f;
+        dspm::Mat K_t = H * P;
+        dspm::Mat LDL = S;
+        LDL.choleskyDecompose();
+        LDL.choleskySolve(K_t);
+        dspm::Mat K = K_t.t();
+        sum += K(0, 0);
+    }
+    double gain_new = (now_ns() - start) / N_BENCH;
+    bench_sink = sum;
+    printf("det 8x8: cofactor %9.1f ns, LU %7.1f ns (x%.0f)\n", det_old, det_new, det_old / det_new);
+    printf("Kalman gain 13x6: Gauss-Jordan inverse %7.1f ns, Cholesky %7.1f ns (x%.2f)\n",
+           gain_old, gain_new, gain_old / gain_new);
+}
+
+int test_mat_solve()
+{
+    int ret = CheckSolve();
+    ret += CheckUpdateRef();
+    BenchSolve();
+    printf("Mat solve: %i error(s)\n", ret);
+    return ret;
+}
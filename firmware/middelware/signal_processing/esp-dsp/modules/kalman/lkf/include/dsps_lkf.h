@@ -0,0 +1,246 @@
+/*
+ * SPDX-FileCopyrightText: 2018-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _dsps_lkf_H_
+#define _dsps_lkf_H_
+
+#include <stdbool.h>
+#include <math.h>
+
+/**
+ * @brief Linear Kalman filter for one measured value
+ *
+ * The state is the measured value and its derivatives: x[0] - value, x[1] - velocity,
+ * x[2] - acceleration... The highest derivative is driven by white noise with
+ * density q, the measurement of x[0] has noise variance r.
+ * The state size is a compile-time constant, the filters are made by
+ * DSPS_LKF_DEFINE(name, N), for example:
+ *      - lkf_const_f32_t, N = 1: constant value, for a weight
+ *      - lkf_cv_f32_t, N = 2: constant velocity, for a distance
+ * Every sample takes O(N^2) operations with fixed N, without allocation and
+ * matrix inversion: the measurement is a scalar.
+ *
+ * The process noise could follow the signal: the average of the normalized
+ * innovation squared y^2/S is kept, and q is scaled by it up to q_max times.
+ * The filter is smooth while the signal follows the model and reacts fast
+ * to a step of the value.
+ *
+ * The filters are header-only, so C drivers could use them without linking the DSP library.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define DSPS_LKF_MAX_N 4 /*!< Max state size*/
+
+/**
+ * @brief Parameters of the linear Kalman filter, common for any state size
+ */
+typedef struct lkf_f32_param_s {
+    float q;            /*!< Process noise density of the highest derivative.*/
+    float r;            /*!< Measurement noise variance.*/
+    float alpha;        /*!< Averaging factor of the normalized innovation squared, 0 - process noise is not adapted.*/
+    float q_max;        /*!< Max scale of the process noise.*/
+    float q_scale;      /*!< Current scale of the process noise.*/
+    float nis;          /*!< Average normalized innovation squared.*/
+    bool initialized;   /*!< The first sample was set to the state.*/
+} lkf_f32_param_t;
+
+/**
+ * @brief Initialization of the filter, the state is set by the first sample
+ *
+ * @param p: filter parameters
+ * @param x: state vector [n]
+ * @param P: state covariance [n*n]
+ * @param n: state size
+ * @param q: process noise density of the highest derivative
+ * @param r: measurement noise variance
+ */
+static inline void dsps_lkf_init_f32(lkf_f32_param_t *p, float *x, float *P, int n, float q, float r)
+{
+    p->q = q;
+    p->r = r;
+    p->alpha = 0;
+    p->q_max = 1;
+    p->q_scale = 1;
+    p->nis = 1;
+    p->initialized = false;
+    for (int i = 0; i < n; i++) {
+        x[i] = 0;
+        for (int j = 0; j < n; j++) {
+            P[i * n + j] = 0;
+        }
+    }
+}
+
+/**
+ * @brief Adaptation of the process noise by the innovation
+ *
+ * @param p: filter parameters
+ * @param alpha: averaging factor of the normalized innovation squared, 0.05..0.2 is a typical value, 0 - no adaptation
+ * @param q_max: max scale of the process noise
+ */
+static inline void dsps_lkf_adaptive_f32(lkf_f32_param_t *p, float alpha, float q_max)
+{
+    p->alpha = alpha;
+    p->q_max = q_max > 1 ? q_max : 1;
+}
+
+/**
+ * @brief Prediction of the state by dt, the sample is missed
+ *
+ * x = F*x, P = F*P*F' + Q, where F is Taylor series of the derivatives,
+ * Q is process noise of white noise on the highest derivative.
+ *
+ * @param p: filter parameters
+ * @param x: state vector [n]
+ * @param P: state covariance [n*n]
+ * @param n: state size
+ * @param dt: time from the previous sample, in any units of q
+ */
+static inline void dsps_lkf_predict_f32(lkf_f32_param_t *p, float *x, float *P, int n, float dt)
+{
+    // F(i, j) = dt^(j - i) / (j - i)!
+    float taylor[DSPS_LKF_MAX_N];
+    taylor[0] = 1;
+    for (int k = 1; k < n; k++) {
+        taylor[k] = taylor[k - 1] * dt / k;
+    }
+    for (int i = 0; i < n; i++) {
+        float sum = 0;
+        for (int j = i; j < n; j++) {
+            sum += taylor[j - i] * x[j];
+        }
+        x[i] = sum;
+    }
+
+    // FP = F*P, P = FP*F'
+    float FP[DSPS_LKF_MAX_N * DSPS_LKF_MAX_N];
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            float sum = 0;
+            for (int k = i; k < n; k++) {
+                sum += taylor[k - i] * P[k * n + j];
+            }
+            FP[i * n + j] = sum;
+        }
+    }
+    // Q(i, j) = q * dt^(2n - 1 - i - j) / ((2n - 1 - i - j) * (n - 1 - i)! * (n - 1 - j)!)
+    float q = p->q * p->q_scale;
+    for (int i = 0; i < n; i++) {
+        for (int j = i; j < n; j++) {
+            float sum = 0;
+            for (int k = j; k < n; k++) {
+                sum += FP[i * n + k] * taylor[k - j];
+            }
+            int a = n - 1 - i;
+            int b = n - 1 - j;
+            sum += q * taylor[a] * taylor[b] * dt / (a + b + 1);
+            P[i * n + j] = sum;
+            P[j * n + i] = sum;
+        }
+    }
+}
+
+/**
+ * @brief Prediction by dt and update by the sample
+ *
+ * @param p: filter parameters
+ * @param x: state vector [n]
+ * @param P: state covariance [n*n]
+ * @param n: state size
+ * @param z: measured value
+ * @param dt: time from the previous sample, in any units of q
+ *
+ * @return
+ *      - filtered value x[0]
+ */
+static inline float dsps_lkf_update_f32(lkf_f32_param_t *p, float *x, float *P, int n, float z, float dt)
+{
+    if (!p->initialized) {
+        // The value is the sample, the derivatives are unknown
+        x[0] = z;
+        P[0] = p->r;
+        for (int i = 1; i < n; i++) {
+            P[i * n + i] = 1e6f * p->r;
+        }
+        p->initialized = true;
+        return x[0];
+    }
+    dsps_lkf_predict_f32(p, x, P, n, dt);
+
+    // Scalar measurement of x[0]: S = P(0, 0) + r, K = P(:, 0) / S
+    float y = z - x[0];
+    float S = P[0] + p->r;
+    float inv_S = 1.0f / S;
+    float P0[DSPS_LKF_MAX_N];
+    for (int i = 0; i < n; i++) {
+        P0[i] = P[i];
+    }
+    for (int i = 0; i < n; i++) {
+        float K = P0[i] * inv_S;
+        x[i] += K * y;
+        for (int j = i; j < n; j++) {
+            P[i * n + j] -= K * P0[j];
+            P[j * n + i] = P[i * n + j];
+        }
+    }
+
+    if (p->alpha > 0) {
+        p->nis += p->alpha * (y * y * inv_S - p->nis);
+        p->q_scale = fminf(fmaxf(p->nis, 1), p->q_max);
+    }
+    return x[0];
+}
+
+/**
+ * @brief Definition of the filter with state size N
+ *
+ * Defines the type lkf_<name>_f32_t and the functions:
+ *      - dsps_lkf_<name>_init_f32(lkf, q, r)
+ *      - dsps_lkf_<name>_adaptive_f32(lkf, alpha, q_max)
+ *      - dsps_lkf_<name>_f32(lkf, z, dt), returns the filtered value
+ *      - dsps_lkf_<name>_predict_f32(lkf, dt), for a missed sample
+ *
+ * N must be 1 to DSPS_LKF_MAX_N: the update works on stack arrays of that
+ * size, a larger N fails to compile.
+ */
+#define DSPS_LKF_DEFINE(name, N) \
+    typedef char lkf_##name##_n_out_of_range[((N) >= 1 && (N) <= DSPS_LKF_MAX_N) ? 1 : -1]; \
+    typedef struct lkf_##name##_f32_s { \
+        lkf_f32_param_t param; \
+        float x[N]; \
+        float P[(N) * (N)]; \
+    } lkf_##name##_f32_t; \
+    static inline void dsps_lkf_##name##_init_f32(lkf_##name##_f32_t *lkf, float q, float r) \
+    { \
+        dsps_lkf_init_f32(&lkf->param, lkf->x, lkf->P, N, q, r); \
+    } \
+    static inline void dsps_lkf_##name##_adaptive_f32(lkf_##name##_f32_t *lkf, float alpha, float q_max) \
+    { \
+        dsps_lkf_adaptive_f32(&lkf->param, alpha, q_max); \
+    } \
+    static inline float dsps_lkf_##name##_f32(lkf_##name##_f32_t *lkf, float z, float dt) \
+    { \
+        return dsps_lkf_update_f32(&lkf->param, lkf->x, lkf->P, N, z, dt); \
+    } \
+    static inline void dsps_lkf_##name##_predict_f32(lkf_##name##_f32_t *lkf, float dt) \
+    { \
+        if (lkf->param.initialized) { \
+            dsps_lkf_predict_f32(&lkf->param, lkf->x, lkf->P, N, dt); \
+        } \
+    }
+
+DSPS_LKF_DEFINE(const, 1)
+DSPS_LKF_DEFINE(cv, 2)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _dsps_lkf_H_
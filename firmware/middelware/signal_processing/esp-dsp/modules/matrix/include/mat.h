@@ -22,10 +22,103 @@
  * DSP library matrix namespace.
  */
 namespace dspm {
+/**
+ * @brief   Scratch memory for matrices
+ *
+ * The MatArena is a stack allocator for the data of temporary matrices.
+ * While a MatArena::Scope is alive, every matrix that allocates its own buffer
+ * takes the memory from the arena instead of the heap, and all of it is returned
+ * at once when the scope is closed. A processing step enclosed in a scope does
+ * no heap allocations as long as the arena is large enough; when the arena is
+ * exhausted, the matrices fall back to the heap and the overflow is counted.
+ *
+ * Matrices created inside a scope must not outlive it, and a matrix created
+ * outside must not be resized (assigned from a matrix of other dimensions) inside it.
+ */
+class MatArena {
+public:
+    float *buffer;          /*!< Arena memory*/
+    int length;             /*!< Size of the arena in floats*/
+    int used;               /*!< Amount of floats in use*/
+    int high_water;         /*!< Max amount of floats that were in use at the same time*/
+    int overflows;          /*!< Amount of allocations that did not fit and went to the heap*/
+    bool ext_buff;          /*!< Flag indicates that arena use external buffer*/
+
+    /**
+     * Constructor allocate arena memory.
+     * @param[in] length: size of the arena in floats
+     */
+    MatArena(int length);
+    /**
+     * Constructor use external buffer.
+     * @param[in] buffer: external buffer, should be aligned to 16 bytes
+     * @param[in] length: size of the buffer in floats
+     */
+    MatArena(float *buffer, int length);
+    virtual ~MatArena();
+
+    /**
+     * Take memory from the arena.
+     * The size is rounded up to 4 floats to keep 16 bytes alignment.
+     * @param[in] length: amount of floats
+     *
+     * @return
+     *      - pointer to the memory
+     *      - NULL if the arena is exhausted
+     */
+    float *alloc(int length);
+
+    /**
+     * Release all the memory of the arena.
+     */
+    void reset(void);
+
+    /**
+     * Change size of the arena.
+     * Releases all the memory; only for arenas with internal buffer.
+     * @param[in] length: new size of the arena in floats, 0 disables the arena
+     */
+    void resize(int length);
+
+    /**
+     * @brief   Arena scope
+     *
+     * Makes the arena the source of matrix memory for the current task until
+     * the scope is destroyed, then returns the memory taken inside the scope.
+     * Scopes could be nested.
+     */
+    class Scope {
+    public:
+        /**
+         * Open the scope.
+         * @param[in] arena: arena to take the memory from
+         */
+        Scope(MatArena &arena);
+        ~Scope();
+    private:
+        MatArena *arena;
+        MatArena *prev;
+        int mark;
+    };
+
+    /**
+     * Arena of the innermost open scope of the current task, NULL if none
+     */
+    static thread_local MatArena *current;
+};
+
+template <class E> class MatExpr;
+
 /**
  * @brief   Matrix
  *
  * The Mat class provides basic matrix operations on single-precision floating point values.
+ *
+ * The arithmetic operators (+, -, * and / by a constant) do not calculate the
+ * result at once: they build an expression (see mat_expr.h) that is evaluated
+ * when it is assigned to a matrix. The element-wise operations of an expression
+ * are done in one pass without temporary matrices, and A*B + C is done by one
+ * multiplication with accumulation.
  */
 class Mat {
 public:
@@ -79,6 +172,7 @@ public:
 
     /**
      * Constructor allocate internal buffer.
+     * Inside a MatArena::Scope the buffer is taken from the arena.
      * @param[in] rows: amount of matrix rows
      * @param[in] cols: amount of matrix columns
      */
@@ -116,6 +210,25 @@ public:
      */
     Mat(const Mat &src);
 
+    /**
+     * @brief Move matrix.
+     *
+     * The buffer of src is taken when it is on the heap or in the arena of the
+     * current scope, src is left empty. Sub-matrices and external buffers are
+     * handled as by the copy constructor.
+     *
+     * @param[in] src: source matrix
+     */
+    Mat(Mat &&src);
+
+    /**
+     * @brief Evaluate matrix expression to a new matrix.
+     *
+     * @param[in] expr: temporary expression made by the matrix operators
+     */
+    template <class E>
+    Mat(MatExpr<E> &&expr);
+
     /**
      * @brief Create a subset of matrix as ROI (Region of Interest)
      *
@@ -207,6 +320,32 @@ public:
      */
     Mat &operator=(const Mat &src);
 
+    /**
+     * Move operator
+     * The buffer of src is taken when this matrix owns its buffer and src is on the
+     * heap (or both are in the arena and src was allocated first); otherwise the
+     * data is copied as by the copy operator.
+     *
+     * @param[in] src: source matrix
+     *
+     * @return
+     *      - result matrix
+     */
+    Mat &operator=(Mat &&src);
+
+    /**
+     * Evaluate matrix expression to this matrix.
+     * The result is written directly to the matrix data, unless the matrix
+     * is an operand of a multiplication in the expression.
+     *
+     * @param[in] expr: temporary expression made by the matrix operators
+     *
+     * @return
+     *      - result matrix
+     */
+    template <class E>
+    Mat &operator=(MatExpr<E> &&expr);
+
     /**
      * Access to the matrix elements.
      * @param[in] row: row position
@@ -506,17 +645,71 @@ public:
     Mat pinv();
 
     /**
-     * Find determinant
-     * @param[in] n: element number in first row
+     * @brief   LU decomposition
+     *
+     * In place LU decomposition with partial pivoting, P*A = L*U.
+     * The matrix is replaced by U (upper triangle with diagonal) and
+     * L (below the diagonal, unit diagonal is not stored).
+     *
+     * @param[out] pivots: array of [N] row indexes, row i was swapped with row pivots[i]
+     *
+     * @return
+     *      - true on success
+     *      - false if the matrix is not square or singular
+     */
+    bool luDecompose(int *pivots);
+
+    /**
+     * @brief   Solve the matrix by LU decomposition
+     *
+     * Find X for A*X = B, where this matrix holds the result of luDecompose() of A.
+     *
+     * @param[in] pivots: row indexes from luDecompose()
+     * @param[in,out] B: matrix [N]x[K] with result values, replaced by the roots X
      *
      * @return
-     *      - determinant value
+     *      - true on success
+     *      - false if the dimensions do not match
+     */
+    bool solveInPlace(const int *pivots, Mat &B) const;
+
+    /**
+     * @brief   Cholesky decomposition
+     *
+     * In place LDL' decomposition of symmetric positive-definite matrix, A = L*D*L'.
+     * Only the lower triangle of the matrix is used. It is replaced by
+     * L (below the diagonal, unit diagonal is not stored) and D (on the diagonal).
+     * No square roots are calculated.
+     *
+     * @return
+     *      - true on success
+     *      - false if the matrix is not square or not positive-definite
+     */
+    bool choleskyDecompose();
+
+    /**
+     * @brief   Solve the matrix by Cholesky decomposition
+     *
+     * Find X for A*X = B, where this matrix holds the result of choleskyDecompose() of A.
+     *
+     * @param[in,out] B: matrix [N]x[K] with result values, replaced by the roots X
+     *
+     * @return
+     *      - true on success
+     *      - false if the dimensions do not match
+     */
+    bool choleskySolve(Mat &B) const;
+
+    /**
+     * Find determinant of the matrix [n]x[n] in the top left corner
+     * The determinant is calculated by LU decomposition.
+     * @param[in] n: size of the matrix
+     *
+     * @return
+     *      - determinant value, 0 for singular matrix
      */
     float det(int n);
 private:
-    Mat cofactor(int row, int col, int n);
-    Mat adjoint();
-
     void allocate(); // Allocate buffer
     Mat expHelper(const Mat &m, int num);
 };
@@ -550,100 +743,6 @@ std::ostream &operator<<(std::ostream &os, const Mat::Rect &rect);
  */
 std::istream &operator>>(std::istream &is, Mat &m);
 
-/**
- * + operator, sum of two matrices
- * The operator use DSP optimized implementation of multiplication.
- *
- * @param[in] A: Input matrix A
- * @param[in] B: Input matrix B
- *
- * @return
- *     - result matrix A+B
-*/
-Mat operator+(const Mat &A, const Mat &B);
-/**
- * + operator, sum of matrix with constant
- * The operator use DSP optimized implementation of multiplication.
- *
- * @param[in] A: Input matrix A
- * @param[in] C: Input constant
- *
- * @return
- *     - result matrix A+C
-*/
-Mat operator+(const Mat &A, float C);
-
-/**
- * - operator, subtraction of two matrices
- * The operator use DSP optimized implementation of multiplication.
- *
- * @param[in] A: Input matrix A
- * @param[in] B: Input matrix B
- *
- * @return
- *     - result matrix A-B
-*/
-Mat operator-(const Mat &A, const Mat &B);
-/**
- * - operator, sum of matrix with constant
- * The operator use DSP optimized implementation of multiplication.
- *
- * @param[in] A: Input matrix A
- * @param[in] C: Input constant
- *
- * @return
- *     - result matrix A+C
-*/
-Mat operator-(const Mat &A, float C);
-
-/**
- * * operator, multiplication of two matrices.
- * The operator use DSP optimized implementation of multiplication.
- *
- * @param[in] A: Input matrix A
- * @param[in] B: Input matrix B
- *
- * @return
- *     - result matrix A*B
-*/
-Mat operator*(const Mat &A, const Mat &B);
-
-/**
- * * operator, multiplication of matrix with constant
- * The operator use DSP optimized implementation of multiplication.
- *
- * @param[in] A: Input matrix A
- * @param[in] C: floating point value
- *
- * @return
- *     - result matrix A*B
-*/
-Mat operator*(const Mat &A, float C);
-
-/**
- * * operator, multiplication of matrix with constant
- * The operator use DSP optimized implementation of multiplication.
- *
- * @param[in] C: floating point value
- * @param[in] A: Input matrix A
- *
- * @return
- *     - result matrix A*B
-*/
-Mat operator*(float C, const Mat &A);
-
-/**
- * / operator, divide of matrix by constant
- * The operator use DSP optimized implementation of multiplication.
- *
- * @param[in] A: Input matrix A
- * @param[in] C: floating point value
- *
- * @return
- *     - result matrix A*B
-*/
-Mat operator/(const Mat &A, float C);
-
 /**
  * / operator, divide matrix A by matrix B
  *
@@ -668,4 +767,5 @@ Mat operator/(const Mat &A, const Mat &B);
 bool operator==(const Mat &A, const Mat &B);
 
 }
+#include "mat_expr.h"
 #endif //_dspm_mat_h_
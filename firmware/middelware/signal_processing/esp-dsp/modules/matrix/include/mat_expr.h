@@ -0,0 +1,730 @@
+// Copyright 2018-2023 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _dspm_mat_expr_h_
+#define _dspm_mat_expr_h_
+#include <type_traits>
+#include <utility>
+#include "mat.h"
+#include "esp_log.h"
+
+/**
+ * @file mat_expr.h
+ *
+ * Expressions of the Mat operators.
+ *
+ * A + B, A - B, A + C, A - C, A * C, C * A and A / C (C is a constant) make
+ * element-wise expressions. A chain of them is evaluated element by element in
+ * one pass, directly to the destination matrix.
+ *
+ * A * B makes a product expression. Its operands are evaluated first (to
+ * temporary matrices when they are expressions), and then multiplied by
+ * dspm_mult_f32 into the destination. A * B + C and C + A * B evaluate C to the
+ * destination and add the product with dspm_mult_acc_f32, without a temporary
+ * matrix for the product. A product inside an element-wise expression is
+ * evaluated to a temporary matrix.
+ *
+ * The expressions keep references to the Mat operands, so they must be
+ * evaluated (assigned to a Mat) in the same statement. They can not be copied,
+ * and only temporary expressions are operands or evaluated, so an expression
+ * stored with auto does not compile where it is used. Every operation sums in
+ * the same order as the Mat operators did before, so the results are the same.
+ */
+
+namespace dspm {
+
+// Evaluation helpers of the expressions, defined in mat.cpp
+
+/**
+ * C = A*B, C has the dimensions of the product and no common memory with A and B.
+ */
+void MatMultTo(const Mat &A, const Mat &B, Mat &C);
+/**
+ * C += A*B, C has the dimensions of the product and no common memory with A and B.
+ */
+void MatMultAddTo(const Mat &A, const Mat &B, Mat &C);
+/**
+ * dst = src, matrices of the same dimensions.
+ */
+void MatCopyTo(const Mat &src, Mat &dst);
+/**
+ * Check if the data of m and dst overlap.
+ * With same_element_ok, a matrix with exactly the data of dst is not counted:
+ * an element-wise expression reads every element before it writes it.
+ */
+bool MatOverlap(const Mat &m, const Mat &dst, bool same_element_ok);
+
+/**
+ * Kinds of the matrix expression operands
+ */
+enum mat_expr_kind_t {
+    MAT_EXPR_MAT = 0,       /*!< Mat*/
+    MAT_EXPR_ELEMENT,       /*!< Element-wise expression*/
+    MAT_EXPR_PRODUCT,       /*!< A*B*/
+    MAT_EXPR_PRODUCT_ADD,   /*!< A*B + C*/
+};
+
+/**
+ * Base of all the matrix expressions, used to select the operators.
+ */
+class MatExprBase {
+};
+
+/**
+ * @brief   Matrix expression
+ *
+ * Base class of the expression E. The expression is evaluated by the
+ * Mat constructor and the Mat operator =.
+ */
+template <class E>
+class MatExpr : public MatExprBase {
+public:
+    /**
+     * Expression itself.
+     */
+    inline const E &self() const
+    {
+        return *static_cast<const E *>(this);
+    }
+
+    /**
+     * Evaluate the expression to a new matrix.
+     *
+     * @return
+     *      - result matrix
+     */
+    Mat eval() &&
+    {
+        return Mat(std::move(*this));
+    }
+
+    /**
+     * Transposed result of the expression.
+     *
+     * @return
+     *      - transposed matrix
+     */
+    Mat t() &&
+    {
+        return std::move(*this).eval().t();
+    }
+};
+
+/**
+ * Operand of an expression: matrix by reference.
+ */
+class MatRef {
+public:
+    explicit MatRef(const Mat &m) : m(m) {}
+    MatRef(const MatRef &) = delete;
+    MatRef(MatRef &&) = default;
+    inline int rows() const
+    {
+        return m.rows;
+    }
+    inline int cols() const
+    {
+        return m.cols;
+    }
+    inline bool valid() const
+    {
+        return true;
+    }
+    inline float operator()(int row, int col) const
+    {
+        return m.data[row * m.stride + col];
+    }
+    inline const Mat &mat() const
+    {
+        return m;
+    }
+    inline bool aliases(const Mat &dst, bool same_element_ok) const
+    {
+        return MatOverlap(m, dst, same_element_ok);
+    }
+    inline void evalTo(Mat &dst) const
+    {
+        MatCopyTo(m, dst);
+    }
+private:
+    const Mat &m;
+};
+
+/**
+ * Operand of an expression: sub-expression evaluated to a temporary matrix.
+ */
+class MatTemp {
+public:
+    template <class E>
+    explicit MatTemp(MatExpr<E> &&expr) : m(std::move(expr)) {}
+    MatTemp(const MatTemp &) = delete;
+    MatTemp(MatTemp &&) = default;
+    inline int rows() const
+    {
+        return m.rows;
+    }
+    inline int cols() const
+    {
+        return m.cols;
+    }
+    inline bool valid() const
+    {
+        return true;
+    }
+    inline float operator()(int row, int col) const
+    {
+        return m.data[row * m.stride + col];
+    }
+    inline const Mat &mat() const
+    {
+        return m;
+    }
+    inline bool aliases(const Mat &, bool) const
+    {
+        return false;
+    }
+    inline void evalTo(Mat &dst) const
+    {
+        MatCopyTo(m, dst);
+    }
+private:
+    Mat m;
+};
+
+struct MatAddOp {
+    static inline float apply(float a, float b)
+    {
+        return a + b;
+    }
+};
+
+struct MatSubOp {
+    static inline float apply(float a, float b)
+    {
+        return a - b;
+    }
+};
+
+struct MatMulOp {
+    static inline float apply(float a, float b)
+    {
+        return a * b;
+    }
+};
+
+/**
+ * Element-wise operation of two operands of the same dimensions.
+ */
+template <class Op, class L, class R>
+class MatElementExpr : public MatExpr<MatElementExpr<Op, L, R> > {
+public:
+    static const int kind = MAT_EXPR_ELEMENT;
+
+    MatElementExpr(const MatElementExpr &) = delete;
+    MatElementExpr(MatElementExpr &&) = default;
+    MatElementExpr(L &&l, R &&r, const char *name) : l(std::move(l)), r(std::move(r))
+    {
+        ok = this->l.valid() && this->r.valid();
+        if (ok && ((this->l.rows() != this->r.rows()) || (this->l.cols() != this->r.cols()))) {
+            ESP_LOGW("Mat", "operator %s Error: matrices do not have equal dimensions", name);
+            ok = false;
+        }
+    }
+    inline int rows() const
+    {
+        return l.rows();
+    }
+    inline int cols() const
+    {
+        return l.cols();
+    }
+    inline bool valid() const
+    {
+        return ok;
+    }
+    inline float operator()(int row, int col) const
+    {
+        return Op::apply(l(row, col), r(row, col));
+    }
+    inline bool aliases(const Mat &dst, bool same_element_ok) const
+    {
+        return l.aliases(dst, same_element_ok) || r.aliases(dst, same_element_ok);
+    }
+    void evalTo(Mat &dst) const
+    {
+        for (int row = 0; row < dst.rows; row++) {
+            float *out = &dst.data[row * dst.stride];
+            for (int col = 0; col < dst.cols; col++) {
+                out[col] = (*this)(row, col);
+            }
+        }
+    }
+private:
+    L l;
+    R r;
+    bool ok;
+};
+
+/**
+ * Element-wise operation of an operand and a constant.
+ */
+template <class Op, class L>
+class MatScalarExpr : public MatExpr<MatScalarExpr<Op, L> > {
+public:
+    static const int kind = MAT_EXPR_ELEMENT;
+
+    MatScalarExpr(const MatScalarExpr &) = delete;
+    MatScalarExpr(MatScalarExpr &&) = default;
+    MatScalarExpr(L &&l, float value) : l(std::move(l)), value(value) {}
+    inline int rows() const
+    {
+        return l.rows();
+    }
+    inline int cols() const
+    {
+        return l.cols();
+    }
+    inline bool valid() const
+    {
+        return l.valid();
+    }
+    inline float operator()(int row, int col) const
+    {
+        return Op::apply(l(row, col), value);
+    }
+    inline bool aliases(const Mat &dst, bool same_element_ok) const
+    {
+        return l.aliases(dst, same_element_ok);
+    }
+    void evalTo(Mat &dst) const
+    {
+        for (int row = 0; row < dst.rows; row++) {
+            float *out = &dst.data[row * dst.stride];
+            for (int col = 0; col < dst.cols; col++) {
+                out[col] = (*this)(row, col);
+            }
+        }
+    }
+private:
+    L l;
+    float value;
+};
+
+/**
+ * Product of two matrices (MatRef or MatTemp operands).
+ */
+template <class L, class R>
+class MatProductExpr : public MatExpr<MatProductExpr<L, R> > {
+public:
+    static const int kind = MAT_EXPR_PRODUCT;
+
+    MatProductExpr(const MatProductExpr &) = delete;
+    MatProductExpr(MatProductExpr &&) = default;
+    MatProductExpr(L &&a, R &&b) : a(std::move(a)), b(std::move(b))
+    {
+        ok = this->a.valid() && this->b.valid();
+        if (ok && (this->a.cols() != this->b.rows())) {
+            ESP_LOGW("Mat", "operator * Error: matrices do not have correct dimensions");
+            ok = false;
+        }
+    }
+    inline int rows() const
+    {
+        return a.rows();
+    }
+    inline int cols() const
+    {
+        return b.cols();
+    }
+    inline bool valid() const
+    {
+        return ok;
+    }
+    inline bool aliases(const Mat &dst, bool) const
+    {
+        return a.aliases(dst, false) || b.aliases(dst, false);
+    }
+    inline void evalTo(Mat &dst) const
+    {
+        MatMultTo(a.mat(), b.mat(), dst);
+    }
+    inline void addTo(Mat &dst) const
+    {
+        MatMultAddTo(a.mat(), b.mat(), dst);
+    }
+private:
+    L a;
+    R b;
+    bool ok;
+};
+
+/**
+ * A*B + C: C is evaluated to the destination, then the product is added.
+ */
+template <class P, class C>
+class MatProductAddExpr : public MatExpr<MatProductAddExpr<P, C> > {
+public:
+    static const int kind = MAT_EXPR_PRODUCT_ADD;
+
+    MatProductAddExpr(const MatProductAddExpr &) = delete;
+    MatProductAddExpr(MatProductAddExpr &&) = default;
+    MatProductAddExpr(P &&p, C &&c) : p(std::move(p)), c(std::move(c))
+    {
+        ok = this->p.valid() && this->c.valid();
+        if (ok && ((this->p.rows() != this->c.rows()) || (this->p.cols() != this->c.cols()))) {
+            ESP_LOGW("Mat", "operator + Error: matrices do not have equal dimensions");
+            ok = false;
+        }
+    }
+    inline int rows() const
+    {
+        return p.rows();
+    }
+    inline int cols() const
+    {
+        return p.cols();
+    }
+    inline bool valid() const
+    {
+        return ok;
+    }
+    inline bool aliases(const Mat &dst, bool same_element_ok) const
+    {
+        return p.aliases(dst, false) || c.aliases(dst, same_element_ok);
+    }
+    inline void evalTo(Mat &dst) const
+    {
+        c.evalTo(dst);
+        p.addTo(dst);
+    }
+private:
+    P p;
+    C c;
+    bool ok;
+};
+
+/**
+ * Kind of the operand type T
+ */
+template <class T, bool is_expr = std::is_base_of<MatExprBase, T>::value>
+struct MatKind {
+    static const int value = MAT_EXPR_MAT;
+};
+
+template <class T>
+struct MatKind<T, true> {
+    static const int value = T::kind;
+};
+
+/**
+ * Operand types that make matrix expressions: matrices and temporary expressions
+ */
+template <class T>
+struct MatIsOperand {
+    typedef typename std::decay<T>::type type;
+    static const bool value = std::is_base_of<Mat, type>::value ||
+                              (std::is_base_of<MatExprBase, type>::value && !std::is_lvalue_reference<T>::value);
+};
+
+/**
+ * Operand of an element-wise expression: Mat by reference, element-wise
+ * expressions as they are, the others evaluated to a temporary matrix.
+ */
+template <class T, int kind = MatKind<T>::value>
+struct MatTerm {
+    typedef MatTemp type;
+    static MatTemp make(T &&expr)
+    {
+        return MatTemp(std::move(expr));
+    }
+};
+
+template <class T>
+struct MatTerm<T, MAT_EXPR_MAT> {
+    typedef MatRef type;
+    static MatRef make(const Mat &m)
+    {
+        return MatRef(m);
+    }
+};
+
+template <class T>
+struct MatTerm<T, MAT_EXPR_ELEMENT> {
+    typedef T type;
+    static T make(T &&expr)
+    {
+        return std::move(expr);
+    }
+};
+
+/**
+ * Operand of a product: Mat by reference, expressions evaluated to a temporary matrix.
+ */
+template <class T, int kind = MatKind<T>::value>
+struct MatFactor {
+    typedef MatTemp type;
+    static MatTemp make(T &&expr)
+    {
+        return MatTemp(std::move(expr));
+    }
+};
+
+template <class T>
+struct MatFactor<T, MAT_EXPR_MAT> {
+    typedef MatRef type;
+    static MatRef make(const Mat &m)
+    {
+        return MatRef(m);
+    }
+};
+
+/**
+ * Sum of A and B: element-wise, or A*B + C when one of them is a product.
+ */
+template <class A, class B, int kind_a = MatKind<A>::value, int kind_b = MatKind<B>::value>
+struct MatSum {
+    typedef MatElementExpr<MatAddOp, typename MatTerm<A>::type, typename MatTerm<B>::type> type;
+    template <class TA, class TB>
+    static type make(TA &&a, TB &&b)
+    {
+        return type(MatTerm<A>::make(std::forward<TA>(a)), MatTerm<B>::make(std::forward<TB>(b)), "+");
+    }
+};
+
+template <class A, class B, int kind_b>
+struct MatSum<A, B, MAT_EXPR_PRODUCT, kind_b> {
+    typedef MatProductAddExpr<A, typename MatTerm<B>::type> type;
+    template <class TA, class TB>
+    static type make(TA &&a, TB &&b)
+    {
+        return type(A(std::forward<TA>(a)), MatTerm<B>::make(std::forward<TB>(b)));
+    }
+};
+
+template <class A, class B, int kind_a>
+struct MatSum<A, B, kind_a, MAT_EXPR_PRODUCT> {
+    typedef MatProductAddExpr<B, typename MatTerm<A>::type> type;
+    template <class TA, class TB>
+    static type make(TA &&a, TB &&b)
+    {
+        return type(B(std::forward<TB>(b)), MatTerm<A>::make(std::forward<TA>(a)));
+    }
+};
+
+template <class A, class B>
+struct MatSum<A, B, MAT_EXPR_PRODUCT, MAT_EXPR_PRODUCT> {
+    typedef MatProductAddExpr<A, typename MatTerm<B>::type> type;
+    template <class TA, class TB>
+    static type make(TA &&a, TB &&b)
+    {
+        return type(A(std::forward<TA>(a)), MatTerm<B>::make(std::forward<TB>(b)));
+    }
+};
+
+/**
+ * Expressions of two operands A and B, defined only for matrices and expressions
+ */
+template <class A, class B, bool is_operand = MatIsOperand<A>::value &&MatIsOperand<B>::value>
+struct MatBinary {
+};
+
+template <class A, class B>
+struct MatBinary<A, B, true> {
+    typedef typename MatIsOperand<A>::type TA;
+    typedef typename MatIsOperand<B>::type TB;
+    typedef MatSum<TA, TB> sum;
+    typedef typename sum::type sum_type;
+    typedef MatElementExpr<MatSubOp, typename MatTerm<TA>::type, typename MatTerm<TB>::type> sub_type;
+    typedef MatProductExpr<typename MatFactor<TA>::type, typename MatFactor<TB>::type> product_type;
+};
+
+/**
+ * Expressions of an operand A and a constant, defined only for matrices and expressions
+ */
+template <class A, bool is_operand = MatIsOperand<A>::value>
+struct MatScalar {
+};
+
+template <class A>
+struct MatScalar<A, true> {
+    typedef typename MatIsOperand<A>::type T;
+    typedef MatScalarExpr<MatAddOp, typename MatTerm<T>::type> add_type;
+    typedef MatScalarExpr<MatMulOp, typename MatTerm<T>::type> mul_type;
+};
+
+/**
+ * + operator, sum of two matrices or expressions
+ *
+ * @param[in] A: Input matrix A
+ * @param[in] B: Input matrix B
+ *
+ * @return
+ *     - expression A+B
+ */
+template <class A, class B>
+inline typename MatBinary<A, B>::sum_type operator+(A &&a, B &&b)
+{
+    return MatBinary<A, B>::sum::make(std::forward<A>(a), std::forward<B>(b));
+}
+
+/**
+ * - operator, subtraction of two matrices or expressions
+ *
+ * @param[in] A: Input matrix A
+ * @param[in] B: Input matrix B
+ *
+ * @return
+ *     - expression A-B
+ */
+template <class A, class B>
+inline typename MatBinary<A, B>::sub_type operator-(A &&a, B &&b)
+{
+    typedef typename MatBinary<A, B>::TA TA;
+    typedef typename MatBinary<A, B>::TB TB;
+    return typename MatBinary<A, B>::sub_type(MatTerm<TA>::make(std::forward<A>(a)), MatTerm<TB>::make(std::forward<B>(b)), "-");
+}
+
+/**
+ * * operator, multiplication of two matrices or expressions
+ *
+ * @param[in] A: Input matrix A
+ * @param[in] B: Input matrix B
+ *
+ * @return
+ *     - expression A*B
+ */
+template <class A, class B>
+inline typename MatBinary<A, B>::product_type operator*(A &&a, B &&b)
+{
+    typedef typename MatBinary<A, B>::TA TA;
+    typedef typename MatBinary<A, B>::TB TB;
+    return typename MatBinary<A, B>::product_type(MatFactor<TA>::make(std::forward<A>(a)), MatFactor<TB>::make(std::forward<B>(b)));
+}
+
+/**
+ * + operator, sum of matrix with constant
+ *
+ * @param[in] A: Input matrix A
+ * @param[in] C: Input constant
+ *
+ * @return
+ *     - expression A+C
+ */
+template <class A>
+inline typename MatScalar<A>::add_type operator+(A &&a, float C)
+{
+    typedef typename MatScalar<A>::T T;
+    return typename MatScalar<A>::add_type(MatTerm<T>::make(std::forward<A>(a)), C);
+}
+
+/**
+ * - operator, subtraction of constant from matrix
+ *
+ * @param[in] A: Input matrix A
+ * @param[in] C: Input constant
+ *
+ * @return
+ *     - expression A+(-C)
+ */
+template <class A>
+inline typename MatScalar<A>::add_type operator-(A &&a, float C)
+{
+    typedef typename MatScalar<A>::T T;
+    return typename MatScalar<A>::add_type(MatTerm<T>::make(std::forward<A>(a)), -C);
+}
+
+/**
+ * * operator, multiplication of matrix with constant
+ *
+ * @param[in] A: Input matrix A
+ * @param[in] C: floating point value
+ *
+ * @return
+ *     - expression A*C
+ */
+template <class A>
+inline typename MatScalar<A>::mul_type operator*(A &&a, float C)
+{
+    typedef typename MatScalar<A>::T T;
+    return typename MatScalar<A>::mul_type(MatTerm<T>::make(std::forward<A>(a)), C);
+}
+
+/**
+ * * operator, multiplication of matrix with constant
+ *
+ * @param[in] C: floating point value
+ * @param[in] A: Input matrix A
+ *
+ * @return
+ *     - expression A*C
+ */
+template <class A>
+inline typename MatScalar<A>::mul_type operator*(float C, A &&a)
+{
+    typedef typename MatScalar<A>::T T;
+    return typename MatScalar<A>::mul_type(MatTerm<T>::make(std::forward<A>(a)), C);
+}
+
+/**
+ * / operator, divide of matrix by constant
+ *
+ * @param[in] A: Input matrix A
+ * @param[in] C: floating point value
+ *
+ * @return
+ *     - expression A*(1/C)
+ */
+template <class A>
+inline typename MatScalar<A>::mul_type operator/(A &&a, float C)
+{
+    typedef typename MatScalar<A>::T T;
+    return typename MatScalar<A>::mul_type(MatTerm<T>::make(std::forward<A>(a)), 1 / C);
+}
+
+template <class E>
+Mat::Mat(MatExpr<E> &&expr)
+{
+    const E &e = expr.self();
+    bool valid = e.valid();
+    this->rows = valid ? e.rows() : 1;
+    this->cols = valid ? e.cols() : 1;
+    this->sub_matrix = false;
+    this->stride = this->cols;
+    this->padding = 0;
+    allocate();
+    if (valid) {
+        e.evalTo(*this);
+    } else {
+        this->data[0] = 0;
+    }
+}
+
+template <class E>
+Mat &Mat::operator=(MatExpr<E> &&expr)
+{
+    const E &e = expr.self();
+    if (!e.valid()) {
+        Mat err_ret;
+        return (*this = err_ret);
+    }
+    if ((this->rows != e.rows()) || (this->cols != e.cols()) || e.aliases(*this, true)) {
+        Mat temp(std::move(expr));
+        return (*this = std::move(temp));
+    }
+    e.evalTo(*this);
+    return *this;
+}
+
+}
+#endif //_dspm_mat_expr_h_
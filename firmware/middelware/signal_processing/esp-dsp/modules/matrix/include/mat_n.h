@@ -0,0 +1,568 @@
+// Copyright 2018-2023 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _dspm_mat_n_h_
+#define _dspm_mat_n_h_
+#include <string.h>
+#include "mat.h"
+#include "dspm_matrix.h"
+#include "esp_log.h"
+
+namespace dspm {
+
+template <int R, int C> class MatNT;
+
+/**
+ * @brief   Matrix with dimensions known at compile time
+ *
+ * The MatN keeps the data inside the object (no heap or arena memory) and its
+ * dimensions are constants, so the compiler checks the dimensions of every
+ * operation and inlines the small kernels. The products 3x3*3x3, 3x3*3x1,
+ * 4x4*4x4, 4x4*4x1, 3x4*4x4 and 3x4*4x1 are fully unrolled; larger products
+ * go to dspm_mult_f32. All the products sum in the same order as
+ * dspm_mult_f32_ansi, so the results are the same as with Mat.
+ *
+ * The data is row-major without padding, as in Mat, and view() gives a Mat
+ * over it for the operations that exist only for Mat.
+ */
+template <int R, int C>
+class MatN {
+public:
+    static const int rows = R;          /*!< Amount of rows*/
+    static const int cols = C;          /*!< Amount of columns*/
+    static const int length = R * C;    /*!< Total amount of data in data array*/
+    float data[R * C];                  /*!< Buffer with matrix data*/
+
+    /**
+     * Constructor, the data is not initialized.
+     */
+    MatN() {}
+
+    /**
+     * Constructor, copy the data.
+     * @param[in] src: array of rows*cols values, row by row
+     */
+    explicit MatN(const float *src)
+    {
+        memcpy(this->data, src, sizeof(this->data));
+    }
+
+    /**
+     * Constructor, copy the data of a Mat (or a sub-matrix of it).
+     * The matrix is cleared if the dimensions of src are not R x C.
+     * @param[in] src: source matrix
+     */
+    explicit MatN(const Mat &src)
+    {
+        if ((src.rows != R) || (src.cols != C)) {
+            ESP_LOGE("Mat", "MatN Error: source matrix is %dx%d instead of %dx%d", src.rows, src.cols, R, C);
+            clear();
+            return;
+        }
+        for (int r = 0; r < R; r++) {
+            memcpy(&this->data[r * C], &src.data[r * src.stride], C * sizeof(float));
+        }
+    }
+
+    /**
+     * Access to the matrix elements.
+     * @param[in] row: row position
+     * @param[in] col: column position
+     *
+     * @return
+     *      - element of matrix M[row][col]
+     */
+    inline float &operator()(int row, int col)
+    {
+        return data[row * C + col];
+    }
+    /**
+     * Access to the matrix elements.
+     * @param[in] row: row position
+     * @param[in] col: column position
+     *
+     * @return
+     *      - element of matrix M[row][col]
+     */
+    inline const float &operator()(int row, int col) const
+    {
+        return data[row * C + col];
+    }
+
+    /**
+     * Transpose of the matrix as a view, without copy.
+     * The view is valid while the matrix exists.
+     *
+     * @return
+     *      - transposed matrix C x R
+     */
+    inline MatNT<C, R> t() const
+    {
+        return MatNT<C, R>(*this);
+    }
+
+    /**
+     * Mat over the data of the matrix, without copy.
+     * The Mat is valid while the matrix exists.
+     *
+     * @return
+     *      - Mat R x C with external buffer
+     */
+    inline Mat view()
+    {
+        return Mat(this->data, R, C, C);
+    }
+
+    /**
+     * Copy of the matrix to a new Mat.
+     *
+     * @return
+     *      - Mat R x C
+     */
+    Mat toMat() const
+    {
+        Mat result(R, C);
+        memcpy(result.data, this->data, sizeof(this->data));
+        return result;
+    }
+
+    /**
+     * Copy the matrix to a block of a Mat.
+     * @param[in] dst: destination matrix
+     * @param[in] row_pos: start row position of the block in dst
+     * @param[in] col_pos: start column position of the block in dst
+     */
+    void copyTo(Mat &dst, int row_pos, int col_pos) const
+    {
+        if (((row_pos + R) > dst.rows) || ((col_pos + C) > dst.cols)) {
+            ESP_LOGE("Mat", "copyTo Error: %dx%d block at %d,%d is outside of %dx%d matrix", R, C, row_pos, col_pos, dst.rows, dst.cols);
+            return;
+        }
+        for (int r = 0; r < R; r++) {
+            memcpy(&dst.data[(r + row_pos) * dst.stride + col_pos], &this->data[r * C], C * sizeof(float));
+        }
+    }
+
+    /**
+     * Copy of a block of the matrix.
+     * @param[in] startRow: start row position
+     * @param[in] startCol: start column position
+     *
+     * @return
+     *      - matrix BR x BC
+     */
+    template <int BR, int BC>
+    MatN<BR, BC> block(int startRow, int startCol) const
+    {
+        MatN<BR, BC> result;
+        for (int r = 0; r < BR; r++) {
+            memcpy(&result.data[r * BC], &this->data[(r + startRow) * C + startCol], BC * sizeof(float));
+        }
+        return result;
+    }
+
+    /**
+     * Set all the elements to zero.
+     */
+    void clear()
+    {
+        memset(this->data, 0, sizeof(this->data));
+    }
+
+    /**
+     * Make identity matrix.
+     *
+     * @return
+     *      - identity matrix R x R
+     */
+    static MatN eye()
+    {
+        MatN result;
+        result.clear();
+        for (int i = 0; i < R && i < C; i++) {
+            result.data[i * C + i] = 1;
+        }
+        return result;
+    }
+
+    /**
+     * Make matrix with zero values.
+     *
+     * @return
+     *      - matrix R x C of zeros
+     */
+    static MatN zeros()
+    {
+        MatN result;
+        result.clear();
+        return result;
+    }
+
+    /**
+     * += operator
+     * @param[in] A: source matrix
+     *
+     * @return
+     *      - result matrix: result += A
+     */
+    MatN &operator+=(const MatN &A)
+    {
+        for (int i = 0; i < R * C; i++) {
+            this->data[i] += A.data[i];
+        }
+        return *this;
+    }
+
+    /**
+     * -= operator
+     * @param[in] A: source matrix
+     *
+     * @return
+     *      - result matrix: result -= A
+     */
+    MatN &operator-=(const MatN &A)
+    {
+        for (int i = 0; i < R * C; i++) {
+            this->data[i] -= A.data[i];
+        }
+        return *this;
+    }
+
+    /**
+     * *= with constant operator
+     * @param[in] value: constant value
+     *
+     * @return
+     *      - result matrix: result *= value
+     */
+    MatN &operator*=(float value)
+    {
+        for (int i = 0; i < R * C; i++) {
+            this->data[i] *= value;
+        }
+        return *this;
+    }
+};
+
+/**
+ * @brief   Transpose view of a MatN
+ *
+ * Made by MatN::t(). Keeps a pointer to the data of the source matrix, and the
+ * products with it read the source by columns instead of making a copy.
+ */
+template <int R, int C>
+class MatNT {
+public:
+    static const int rows = R;          /*!< Amount of rows*/
+    static const int cols = C;          /*!< Amount of columns*/
+    const float *data;                  /*!< Data of the source matrix C x R*/
+
+    /**
+     * Constructor of the view.
+     * @param[in] src: source matrix
+     */
+    explicit MatNT(const MatN<C, R> &src) : data(src.data) {}
+
+    /**
+     * Access to the matrix elements.
+     * @param[in] row: row position
+     * @param[in] col: column position
+     *
+     * @return
+     *      - element of matrix M[row][col]
+     */
+    inline const float &operator()(int row, int col) const
+    {
+        return data[col * R + row];
+    }
+
+    /**
+     * Transpose of the view.
+     *
+     * @return
+     *      - source matrix
+     */
+    inline MatN<C, R> t() const
+    {
+        return MatN<C, R>(this->data);
+    }
+
+    /**
+     * Copy of the view to a MatN.
+     *
+     * @return
+     *      - matrix R x C
+     */
+    inline MatN<R, C> eval() const
+    {
+        MatN<R, C> result;
+        for (int r = 0; r < R; r++) {
+            for (int c = 0; c < C; c++) {
+                result.data[r * C + c] = (*this)(r, c);
+            }
+        }
+        return result;
+    }
+};
+
+/**
+ * Generic product of two matrices or views, inline for small sizes
+ * and dspm_mult_f32 for MatN * MatN above 64 multiplications.
+ */
+template <int R, int K, int C, class TA, class TB>
+inline MatN<R, C> MultN(const TA &A, const TB &B)
+{
+    MatN<R, C> result;
+    for (int i = 0; i < R; i++) {
+        for (int j = 0; j < C; j++) {
+            float acc = A(i, 0) * B(0, j);
+            for (int s = 1; s < K; s++) {
+                acc += A(i, s) * B(s, j);
+            }
+            result.data[i * C + j] = acc;
+        }
+    }
+    return result;
+}
+
+/**
+ * * operator, multiplication of two matrices.
+ * @param[in] A: input matrix A R x K
+ * @param[in] B: input matrix B K x C
+ *
+ * @return
+ *     - result matrix A*B
+ */
+template <int R, int K, int C>
+inline MatN<R, C> operator*(const MatN<R, K> &A, const MatN<K, C> &B)
+{
+    if (R * K * C > 64) {
+        MatN<R, C> result;
+        dspm_mult_f32(A.data, B.data, result.data, R, K, C);
+        return result;
+    }
+    return MultN<R, K, C>(A, B);
+}
+
+/**
+ * * operator, multiplication of a matrix and a transpose view.
+ */
+template <int R, int K, int C>
+inline MatN<R, C> operator*(const MatN<R, K> &A, const MatNT<K, C> &B)
+{
+    return MultN<R, K, C>(A, B);
+}
+
+/**
+ * * operator, multiplication of a transpose view and a matrix.
+ */
+template <int R, int K, int C>
+inline MatN<R, C> operator*(const MatNT<R, K> &A, const MatN<K, C> &B)
+{
+    return MultN<R, K, C>(A, B);
+}
+
+/**
+ * * operator, multiplication of two transpose views.
+ */
+template <int R, int K, int C>
+inline MatN<R, C> operator*(const MatNT<R, K> &A, const MatNT<K, C> &B)
+{
+    return MultN<R, K, C>(A, B);
+}
+
+// Fully unrolled products, same order of the sums as dspm_mult_f32_ansi
+inline float DotN3(const float *a, const float *b, int b_stride)
+{
+    return a[0] * b[0] + a[1] * b[b_stride] + a[2] * b[2 * b_stride];
+}
+
+inline float DotN4(const float *a, const float *b, int b_stride)
+{
+    return a[0] * b[0] + a[1] * b[b_stride] + a[2] * b[2 * b_stride] + a[3] * b[3 * b_stride];
+}
+
+/**
+ * * operator, 3x3 * 3x3, unrolled.
+ */
+inline MatN<3, 3> operator*(const MatN<3, 3> &A, const MatN<3, 3> &B)
+{
+    MatN<3, 3> result;
+    const float *a = A.data;
+    const float *b = B.data;
+    result.data[0] = DotN3(&a[0], &b[0], 3);
+    result.data[1] = DotN3(&a[0], &b[1], 3);
+    result.data[2] = DotN3(&a[0], &b[2], 3);
+    result.data[3] = DotN3(&a[3], &b[0], 3);
+    result.data[4] = DotN3(&a[3], &b[1], 3);
+    result.data[5] = DotN3(&a[3], &b[2], 3);
+    result.data[6] = DotN3(&a[6], &b[0], 3);
+    result.data[7] = DotN3(&a[6], &b[1], 3);
+    result.data[8] = DotN3(&a[6], &b[2], 3);
+    return result;
+}
+
+/**
+ * * operator, 3x3 * 3x1, unrolled.
+ */
+inline MatN<3, 1> operator*(const MatN<3, 3> &A, const MatN<3, 1> &B)
+{
+    MatN<3, 1> result;
+    result.data[0] = DotN3(&A.data[0], B.data, 1);
+    result.data[1] = DotN3(&A.data[3], B.data, 1);
+    result.data[2] = DotN3(&A.data[6], B.data, 1);
+    return result;
+}
+
+/**
+ * * operator, 4x4 * 4x4, unrolled.
+ */
+inline MatN<4, 4> operator*(const MatN<4, 4> &A, const MatN<4, 4> &B)
+{
+    MatN<4, 4> result;
+    const float *a = A.data;
+    const float *b = B.data;
+    result.data[0] = DotN4(&a[0], &b[0], 4);
+    result.data[1] = DotN4(&a[0], &b[1], 4);
+    result.data[2] = DotN4(&a[0], &b[2], 4);
+    result.data[3] = DotN4(&a[0], &b[3], 4);
+    result.data[4] = DotN4(&a[4], &b[0], 4);
+    result.data[5] = DotN4(&a[4], &b[1], 4);
+    result.data[6] = DotN4(&a[4], &b[2], 4);
+    result.data[7] = DotN4(&a[4], &b[3], 4);
+    result.data[8] = DotN4(&a[8], &b[0], 4);
+    result.data[9] = DotN4(&a[8], &b[1], 4);
+    result.data[10] = DotN4(&a[8], &b[2], 4);
+    result.data[11] = DotN4(&a[8], &b[3], 4);
+    result.data[12] = DotN4(&a[12], &b[0], 4);
+    result.data[13] = DotN4(&a[12], &b[1], 4);
+    result.data[14] = DotN4(&a[12], &b[2], 4);
+    result.data[15] = DotN4(&a[12], &b[3], 4);
+    return result;
+}
+
+/**
+ * * operator, 4x4 * 4x1, unrolled.
+ */
+inline MatN<4, 1> operator*(const MatN<4, 4> &A, const MatN<4, 1> &B)
+{
+    MatN<4, 1> result;
+    result.data[0] = DotN4(&A.data[0], B.data, 1);
+    result.data[1] = DotN4(&A.data[4], B.data, 1);
+    result.data[2] = DotN4(&A.data[8], B.data, 1);
+    result.data[3] = DotN4(&A.data[12], B.data, 1);
+    return result;
+}
+
+/**
+ * * operator, 3x4 * 4x4, unrolled.
+ */
+inline MatN<3, 4> operator*(const MatN<3, 4> &A, const MatN<4, 4> &B)
+{
+    MatN<3, 4> result;
+    const float *a = A.data;
+    const float *b = B.data;
+    result.data[0] = DotN4(&a[0], &b[0], 4);
+    result.data[1] = DotN4(&a[0], &b[1], 4);
+    result.data[2] = DotN4(&a[0], &b[2], 4);
+    result.data[3] = DotN4(&a[0], &b[3], 4);
+    result.data[4] = DotN4(&a[4], &b[0], 4);
+    result.data[5] = DotN4(&a[4], &b[1], 4);
+    result.data[6] = DotN4(&a[4], &b[2], 4);
+    result.data[7] = DotN4(&a[4], &b[3], 4);
+    result.data[8] = DotN4(&a[8], &b[0], 4);
+    result.data[9] = DotN4(&a[8], &b[1], 4);
+    result.data[10] = DotN4(&a[8], &b[2], 4);
+    result.data[11] = DotN4(&a[8], &b[3], 4);
+    return result;
+}
+
+/**
+ * * operator, 3x4 * 4x1, unrolled.
+ */
+inline MatN<3, 1> operator*(const MatN<3, 4> &A, const MatN<4, 1> &B)
+{
+    MatN<3, 1> result;
+    result.data[0] = DotN4(&A.data[0], B.data, 1);
+    result.data[1] = DotN4(&A.data[4], B.data, 1);
+    result.data[2] = DotN4(&A.data[8], B.data, 1);
+    return result;
+}
+
+/**
+ * + operator, sum of two matrices
+ * @param[in] A: Input matrix A
+ * @param[in] B: Input matrix B
+ *
+ * @return
+ *     - result matrix A+B
+ */
+template <int R, int C>
+inline MatN<R, C> operator+(const MatN<R, C> &A, const MatN<R, C> &B)
+{
+    MatN<R, C> result = A;
+    result += B;
+    return result;
+}
+
+/**
+ * - operator, subtraction of two matrices
+ * @param[in] A: Input matrix A
+ * @param[in] B: Input matrix B
+ *
+ * @return
+ *     - result matrix A-B
+ */
+template <int R, int C>
+inline MatN<R, C> operator-(const MatN<R, C> &A, const MatN<R, C> &B)
+{
+    MatN<R, C> result = A;
+    result -= B;
+    return result;
+}
+
+/**
+ * * operator, multiplication of matrix with constant
+ * @param[in] A: Input matrix A
+ * @param[in] value: floating point value
+ *
+ * @return
+ *     - result matrix A*value
+ */
+template <int R, int C>
+inline MatN<R, C> operator*(const MatN<R, C> &A, float value)
+{
+    MatN<R, C> result = A;
+    result *= value;
+    return result;
+}
+
+/**
+ * * operator, multiplication of matrix with constant
+ * @param[in] value: floating point value
+ * @param[in] A: Input matrix A
+ *
+ * @return
+ *     - result matrix value*A
+ */
+template <int R, int C>
+inline MatN<R, C> operator*(float value, const MatN<R, C> &A)
+{
+    MatN<R, C> result = A;
+    result *= value;
+    return result;
+}
+
+} // namespace dspm
+#endif //_dspm_mat_n_h_
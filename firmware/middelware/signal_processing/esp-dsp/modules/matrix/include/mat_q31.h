@@ -0,0 +1,246 @@
+/**
+ * @file mat_q31.h
+ * @brief Fixed point matrix with block floating point scaling
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef _dspm_mat_q31_h_
+#define _dspm_mat_q31_h_
+#include <stdint.h>
+#include "mat.h"
+
+namespace dspm {
+
+/**
+ * @brief   Fixed point matrix with block floating point scaling
+ *
+ * The MatQ31 keeps the elements as Q1.31 fractions with one exponent for the
+ * whole matrix: element = data * 2^(exponent - 31). The arithmetic is done on
+ * integers with 64 bit accumulators and saturation, so on the chips without
+ * FPU the operations do not call the soft-float library. After every operation
+ * the result is normalized: the exponent is chosen so that the largest element
+ * uses all 31 bits.
+ *
+ * One exponent for all the elements keeps 31 bits for the largest element and
+ * less for the smaller ones: an element 2^k times smaller than the largest has
+ * 31 - k significant bits. It fits the matrices with elements of the same
+ * order, such as a covariance matrix.
+ *
+ * A zero matrix has the exponent zero_exponent, lower than of any other
+ * matrix, so it does not limit the precision of the other operand of a sum.
+ *
+ * The data is row-major without padding.
+ */
+class MatQ31 {
+public:
+    int rows;               /*!< Amount of rows*/
+    int cols;               /*!< Amount of columns*/
+    int length;             /*!< Total amount of data in data array*/
+    int32_t *data;          /*!< Buffer with matrix data, Q1.31 fractions*/
+    int exponent;           /*!< Block exponent: element = data * 2^(exponent - 31)*/
+    bool ext_buff;          /*!< Flag indicates that matrix use external buffer*/
+    static const int zero_exponent = INT16_MIN; /*!< Exponent of a zero matrix*/
+
+    /**
+     * Constructor allocate internal buffer, the matrix is cleared.
+     * @param[in] rows: amount of matrix rows
+     * @param[in] cols: amount of matrix columns
+     */
+    MatQ31(int rows, int cols);
+    /**
+     * Constructor use external buffer, the data is not changed.
+     * @param[in] data: external buffer with row-major data
+     * @param[in] rows: amount of matrix rows
+     * @param[in] cols: amount of matrix columns
+     * @param[in] exponent: block exponent of the data
+     */
+    MatQ31(int32_t *data, int rows, int cols, int exponent = 0);
+    /**
+     * Allocate matrix with undefined size.
+     */
+    MatQ31();
+    /**
+     * Make copy of matrix.
+     * @param[in] src: source matrix
+     */
+    MatQ31(const MatQ31 &src);
+    virtual ~MatQ31();
+
+    /**
+     * Copy operator
+     * The buffer is reallocated if the dimensions are different.
+     *
+     * @param[in] src: source matrix
+     *
+     * @return
+     *      - matrix copy
+     */
+    MatQ31 &operator=(const MatQ31 &src);
+
+    /**
+     * Access to the matrix elements.
+     * @param[in] row: row position
+     * @param[in] col: column position
+     *
+     * @return
+     *      - Q1.31 fraction of element M[row][col]
+     */
+    inline int32_t &operator()(int row, int col)
+    {
+        return data[row * this->cols + col];
+    }
+    /**
+     * Access to the matrix elements.
+     * @param[in] row: row position
+     * @param[in] col: column position
+     *
+     * @return
+     *      - Q1.31 fraction of element M[row][col]
+     */
+    inline const int32_t &operator()(int row, int col) const
+    {
+        return data[row * this->cols + col];
+    }
+
+    /**
+     * Value of the matrix element.
+     * @param[in] row: row position
+     * @param[in] col: column position
+     *
+     * @return
+     *      - element M[row][col] as float
+     */
+    float get(int row, int col) const;
+
+    /**
+     * Set the matrix from floating point values, the exponent is chosen by the largest value.
+     * @param[in] src: array of rows*cols values, row by row
+     */
+    void fromFloat(const float *src);
+    /**
+     * Set the matrix from a floating point matrix of the same dimensions.
+     * @param[in] src: source matrix, could be a sub-matrix
+     */
+    void fromMat(const Mat &src);
+    /**
+     * Set the matrix from 64 bit values with rounding, the exponent is chosen by the largest value.
+     * @param[in] src: array of rows*cols values, row by row
+     * @param[in] scale: exponent of the values: element = src * 2^scale
+     */
+    void fromInt64(const int64_t *src, int scale);
+    /**
+     * Convert the matrix to floating point values.
+     * @param[out] dst: array of rows*cols values, row by row
+     */
+    void toFloat(float *dst) const;
+    /**
+     * Convert the matrix to floating point matrix.
+     *
+     * @return
+     *      - float matrix with the same dimensions
+     */
+    Mat toMat() const;
+
+    /**
+     * Amount of the redundant sign bits of the largest element.
+     *
+     * @return
+     *      - 0 for a normalized matrix, 31 for a zero matrix
+     */
+    int headroom() const;
+    /**
+     * Shift the data left by the headroom and decrease the exponent, the values are not changed.
+     */
+    void normalize();
+
+    /**
+     * Transpose of the matrix.
+     *
+     * @return
+     *      - transposed matrix
+     */
+    MatQ31 t() const;
+
+    /**
+     * Sum of two matrices, C = A + B.
+     * The operands are aligned to the larger exponent with one guard bit, so
+     * the sum does not overflow. C could be the same as A or B.
+     * @param[in] A: input matrix
+     * @param[in] B: input matrix with the same dimensions
+     * @param[out] C: result matrix with the same dimensions
+     */
+    static void add(const MatQ31 &A, const MatQ31 &B, MatQ31 &C);
+    /**
+     * Difference of two matrices, C = A - B.
+     * C could be the same as A or B.
+     * @param[in] A: input matrix
+     * @param[in] B: input matrix with the same dimensions
+     * @param[out] C: result matrix with the same dimensions
+     */
+    static void sub(const MatQ31 &A, const MatQ31 &B, MatQ31 &C);
+    /**
+     * Product of two matrices, C = A * B, by dspm_mult_s32.
+     * The shift of the result is found from the headroom of the operands and
+     * the length of the sums, so the product does not saturate.
+     * C should be a different matrix than A and B.
+     * @param[in] A: input matrix [m x n]
+     * @param[in] B: input matrix [n x k]
+     * @param[out] C: result matrix [m x k]
+     */
+    static void mult(const MatQ31 &A, const MatQ31 &B, MatQ31 &C);
+
+    /**
+     * Saturation of a 64 bit value to 32 bits.
+     * @param[in] x: input value
+     *
+     * @return
+     *      - x limited to INT32_MIN..INT32_MAX
+     */
+    static inline int32_t saturate(int64_t x)
+    {
+        if (x > INT32_MAX) {
+            return INT32_MAX;
+        }
+        if (x < INT32_MIN) {
+            return INT32_MIN;
+        }
+        return (int32_t)x;
+    }
+    /**
+     * Amount of significant bits of a 64 bit value, without the sign bit.
+     * @param[in] x: input value
+     *
+     * @return
+     *      - 0..63
+     */
+    static inline int bits(int64_t x)
+    {
+        return 63 - __builtin_clrsbll(x);
+    }
+    /**
+     * Arithmetic shift of a 64 bit value.
+     * The left shift is a multiplication, x * 2^(-right) has to fit 64 bits.
+     * @param[in] x: input value
+     * @param[in] right: right shift, negative for left shift
+     *
+     * @return
+     *      - x * 2^(-right), the right shift is limited to 63
+     */
+    static inline int64_t shift(int64_t x, int right)
+    {
+        if (right >= 0) {
+            return x >> ((right > 63) ? 63 : right);
+        }
+        return x * ((int64_t)1 << -right);
+    }
+
+private:
+    void allocate();
+};
+
+}
+#endif //_dspm_mat_q31_h_
@@ -33,6 +33,85 @@ namespace dspm {
 
 float Mat::abs_tol = 1e-10;
 
+thread_local MatArena *MatArena::current = NULL;
+
+MatArena::MatArena(int length)
+{
+    this->buffer = NULL;
+    this->length = 0;
+    this->ext_buff = false;
+    resize(length);
+}
+
+MatArena::MatArena(float *buffer, int length)
+{
+    this->buffer = buffer;
+    this->length = length;
+    this->ext_buff = true;
+    this->high_water = 0;
+    this->overflows = 0;
+    reset();
+}
+
+MatArena::~MatArena()
+{
+    if (false == this->ext_buff) {
+        delete[] this->buffer;
+    }
+}
+
+float *MatArena::alloc(int length)
+{
+    // Keep every block aligned to 16 bytes for the optimized matrix functions
+    int size = (length + 3) & ~3;
+    if (size > (this->length - this->used)) {
+        this->overflows++;
+        return NULL;
+    }
+    float *result = this->buffer + this->used;
+    this->used += size;
+    if (this->used > this->high_water) {
+        this->high_water = this->used;
+    }
+    return result;
+}
+
+void MatArena::reset(void)
+{
+    this->used = 0;
+}
+
+void MatArena::resize(int length)
+{
+    if (this->ext_buff) {
+        ESP_LOGE("Mat", "MatArena resize Error: arena use external buffer");
+        return;
+    }
+    delete[] this->buffer;
+    this->buffer = NULL;
+    if (length > 0) {
+        this->buffer = new float[length];
+    }
+    this->length = length;
+    this->high_water = 0;
+    this->overflows = 0;
+    reset();
+}
+
+MatArena::Scope::Scope(MatArena &arena)
+{
+    this->arena = &arena;
+    this->prev = MatArena::current;
+    this->mark = arena.used;
+    MatArena::current = &arena;
+}
+
+MatArena::Scope::~Scope()
+{
+    this->arena->used = this->mark;
+    MatArena::current = this->prev;
+}
+
 Mat::Rect::Rect(int x, int y, int width, int height)
 {
     this->x = x;
@@ -133,6 +212,41 @@ Mat::Mat(const Mat &m)
     }
 }
 
+// Matrix data is in the arena of the current scope
+static bool InArena(const Mat &m)
+{
+    MatArena *arena = MatArena::current;
+    if ((arena == NULL) || !m.ext_buff || m.sub_matrix) {
+        return false;
+    }
+    return (m.data >= arena->buffer) && (m.data < (arena->buffer + arena->length));
+}
+
+Mat::Mat(Mat &&src)
+{
+    this->rows = src.rows;
+    this->cols = src.cols;
+    this->padding = src.padding;
+    this->stride = src.stride;
+    this->sub_matrix = src.sub_matrix;
+    this->length = src.length;
+
+    if (src.sub_matrix) {
+        this->data = src.data;
+        this->ext_buff = true;
+    } else if (src.ext_buff && !InArena(src)) {
+        // external buffer of the user stays with the source
+        allocate();
+        memcpy(this->data, src.data, this->length * sizeof(float));
+    } else {
+        this->data = src.data;
+        this->ext_buff = src.ext_buff;
+        src.data = NULL;
+        src.ext_buff = true;
+        src.length = 0;
+    }
+}
+
 Mat Mat::getROI(int startRow, int startCol, int roiRows, int roiCols, int stride)
 {
     Mat result(this->data, roiRows, roiCols, 0);
@@ -257,6 +371,28 @@ Mat &Mat::operator=(const Mat &m)
     return *this;
 }
 
+Mat &Mat::operator=(Mat &&m)
+{
+    if (this == &m) {
+        return *this;
+    }
+    // Take the buffer only if it lives at least as long as this matrix:
+    // arena memory taken earlier (at lower address) is released later
+    bool own = !this->sub_matrix && (!this->ext_buff || InArena(*this));
+    bool steal = own && !m.sub_matrix && (!m.ext_buff || (InArena(*this) && InArena(m) && (m.data < this->data)));
+    if (!steal) {
+        return (*this = static_cast<const Mat &>(m));
+    }
+    std::swap(this->rows, m.rows);
+    std::swap(this->cols, m.cols);
+    std::swap(this->stride, m.stride);
+    std::swap(this->padding, m.padding);
+    std::swap(this->data, m.data);
+    std::swap(this->length, m.length);
+    std::swap(this->ext_buff, m.ext_buff);
+    return *this;
+}
+
 Mat &Mat::operator+=(const Mat &m)
 {
     if ((this->rows != m.rows) || (this->cols != m.cols)) {
@@ -702,126 +838,224 @@ Mat Mat::rowReduceFromGaussian()
     return R;
 }
 
-Mat Mat::pinv()
+// LU decomposition of the square matrix A with partial pivoting.
+// The rows of B (if any) are swapped together with the rows of A.
+static bool LuFactor(Mat &A, int *pivots, Mat *B, int *swaps)
 {
-    Mat I = Mat::eye(this->rows);
-    Mat AI = Mat::augment(*this, I);
-    Mat U = AI.gaussianEliminate();
-    Mat IAInverse = U.rowReduceFromGaussian();
-    Mat AInverse(this->rows, this->cols);
-    for (int i = 0; i < this->rows; ++i) {
-        for (int j = 0; j < this->cols; ++j) {
-            AInverse(i, j) = IAInverse(i, j + this->cols);
+    int n = A.rows;
+    for (int k = 0; k < n; k++) {
+        int pivot = k;
+        float max_val = fabsf(A(k, k));
+        for (int i = k + 1; i < n; i++) {
+            if (fabsf(A(i, k)) > max_val) {
+                max_val = fabsf(A(i, k));
+                pivot = i;
+            }
+        }
+        if (pivots) {
+            pivots[k] = pivot;
+        }
+        if (max_val <= Mat::abs_tol) {
+            return false;
+        }
+        if (pivot != k) {
+            A.swapRows(pivot, k);
+            if (B) {
+                B->swapRows(pivot, k);
+            }
+            if (swaps) {
+                (*swaps)++;
+            }
+        }
+        const float *row_k = &A.data[k * A.stride];
+        float a_kk = 1 / row_k[k];
+        for (int i = k + 1; i < n; i++) {
+            float *row_i = &A.data[i * A.stride];
+            float l_ik = row_i[k] * a_kk;
+            row_i[k] = l_ik;
+            for (int j = k + 1; j < n; j++) {
+                row_i[j] -= l_ik * row_k[j];
+            }
         }
     }
-    return AInverse;
+    return true;
 }
 
-Mat Mat::cofactor(int row, int col, int n)
+// Forward and back substitution of L*U*X = B, rows of B are already swapped
+static void LuSubstitute(const Mat &LU, Mat &B)
 {
-    int i = 0, j = 0;
-    Mat result(n, n);
-    // Looping for each element of the matrix
-    for (int r = 0; r < n; r++) {
-        for (int c = 0; c < n; c++) {
-            //  Copying into temporary matrix only those element
-            //  which are not in given row and column
-            if (r != row && c != col) {
-                result(i, j++) = (*this)(r, c);
-
-                // Row is filled, so increase row index and
-                // reset col index
-                if (j == this->rows - 1) {
-                    j = 0;
-                    i++;
-                }
+    int n = LU.rows;
+    for (int col = 0; col < B.cols; col++) {
+        for (int i = 1; i < n; i++) {
+            float sum = B(i, col);
+            for (int j = 0; j < i; j++) {
+                sum -= LU(i, j) * B(j, col);
             }
+            B(i, col) = sum;
+        }
+        for (int i = n - 1; i >= 0; i--) {
+            float sum = B(i, col);
+            for (int j = i + 1; j < n; j++) {
+                sum -= LU(i, j) * B(j, col);
+            }
+            B(i, col) = sum / LU(i, i);
         }
     }
-    return result;
 }
 
-float Mat::det(int n)
+bool Mat::luDecompose(int *pivots)
 {
-    float D = 0; // Initialize result
-
-    //  Base case : if matrix contains single element
-    if (n == 1) {
-        return (*this)(0, 0);
+    if (this->rows != this->cols) {
+        ESP_LOGW("Mat", "luDecompose Error: matrix %dx%d is not square", this->rows, this->cols);
+        return false;
     }
+    return LuFactor(*this, pivots, NULL, NULL);
+}
 
-    Mat temp(this->rows, this->rows); // To store cofactors
-
-    int sign = 1;  // To store sign multiplier
-
-    // Iterate for each element of first row
-    for (int f = 0; f < n; f++) {
-        // Getting Cofactor of A[0][f]
-        Mat temp = this->cofactor(0, f, n);
-        D += (*this)(0, f) * temp.det(n - 1) * sign;
-
-        // terms are to be added with alternate sign
-        sign = -sign;
+bool Mat::solveInPlace(const int *pivots, Mat &B) const
+{
+    if ((this->rows != this->cols) || (B.rows != this->rows)) {
+        ESP_LOGW("Mat", "solveInPlace Error: matrices do not have correct dimensions");
+        return false;
     }
-
-    return D;
+    for (int k = 0; k < this->rows; k++) {
+        if (pivots[k] != k) {
+            B.swapRows(pivots[k], k);
+        }
+    }
+    LuSubstitute(*this, B);
+    return true;
 }
 
-Mat Mat::adjoint()
+bool Mat::choleskyDecompose()
 {
-    Mat adj(this->rows, this->cols);
-    if (this->rows == 1) {
-        adj(0, 0) = 1;
-        return adj;
+    if (this->rows != this->cols) {
+        ESP_LOGW("Mat", "choleskyDecompose Error: matrix %dx%d is not square", this->rows, this->cols);
+        return false;
     }
+    Mat &A = *this;
+    for (int j = 0; j < this->rows; j++) {
+        float d = A(j, j);
+        for (int k = 0; k < j; k++) {
+            d -= A(j, k) * A(j, k) * A(k, k);
+        }
+        if (d <= abs_tol) {
+            return false;
+        }
+        A(j, j) = d;
+        float inv_d = 1 / d;
+        for (int i = j + 1; i < this->rows; i++) {
+            float sum = A(i, j);
+            for (int k = 0; k < j; k++) {
+                sum -= A(i, k) * A(j, k) * A(k, k);
+            }
+            A(i, j) = sum * inv_d;
+        }
+    }
+    return true;
+}
 
-    // temp is used to store cofactors of A(,)
-    int sign = 1;
-    Mat temp(this->rows, this->cols);
-
-    for (int i = 0; i < this->rows; i++) {
-        for (int j = 0; j < this->cols; j++) {
-            // Get cofactor of A(i,j)
-            temp = this->cofactor( i, j, this->rows);
-
-            // sign of adj(j,i) positive if sum of row
-            // and column indexes is even.
-            sign = ((i + j) % 2 == 0) ? 1 : -1;
+bool Mat::choleskySolve(Mat &B) const
+{
+    if ((this->rows != this->cols) || (B.rows != this->rows)) {
+        ESP_LOGW("Mat", "choleskySolve Error: matrices do not have correct dimensions");
+        return false;
+    }
+    const Mat &A = *this;
+    int n = this->rows;
+    for (int col = 0; col < B.cols; col++) {
+        // L*z = b
+        for (int i = 1; i < n; i++) {
+            float sum = B(i, col);
+            for (int j = 0; j < i; j++) {
+                sum -= A(i, j) * B(j, col);
+            }
+            B(i, col) = sum;
+        }
+        // D*y = z
+        for (int i = 0; i < n; i++) {
+            B(i, col) /= A(i, i);
+        }
+        // L'*x = y
+        for (int i = n - 2; i >= 0; i--) {
+            float sum = B(i, col);
+            for (int j = i + 1; j < n; j++) {
+                sum -= A(j, i) * B(j, col);
+            }
+            B(i, col) = sum;
+        }
+    }
+    return true;
+}
 
-            // Interchanging rows and columns to get the
-            // transpose of the cofactor matrix
-            adj(j, i) = (sign) * (temp.det(this->rows - 1));
+Mat Mat::pinv()
+{
+    // Non singular matrix is inverted by LU decomposition
+    if (this->rows == this->cols) {
+        Mat LU = this->Get(0, this->rows, 0, this->cols);
+        Mat AInverse = Mat::eye(this->rows);
+        if (LuFactor(LU, NULL, &AInverse, NULL)) {
+            LuSubstitute(LU, AInverse);
+            return AInverse;
+        }
+    }
+    Mat I = Mat::eye(this->rows);
+    Mat AI = Mat::augment(*this, I);
+    Mat U = AI.gaussianEliminate();
+    Mat IAInverse = U.rowReduceFromGaussian();
+    Mat AInverse(this->rows, this->cols);
+    for (int i = 0; i < this->rows; ++i) {
+        for (int j = 0; j < this->cols; ++j) {
+            AInverse(i, j) = IAInverse(i, j + this->cols);
         }
     }
-    return adj;
+    return AInverse;
+}
+
+float Mat::det(int n)
+{
+    Mat LU = this->Get(0, n, 0, n);
+    int swaps = 0;
+    if (!LuFactor(LU, NULL, NULL, &swaps)) {
+        return 0;
+    }
+    float D = (swaps % 2) ? -1 : 1;
+    for (int i = 0; i < n; i++) {
+        D *= LU(i, i);
+    }
+    return D;
 }
 
 Mat Mat::inverse()
 {
     Mat result(this->rows, this->cols);
-    // Find determinant of matrix
-    float det = this->det(this->rows);
-    if (det == 0) {
-        //std::cout << "Singular matrix, can't find its inverse";
+    if (this->rows != this->cols) {
+        ESP_LOGW("Mat", "inverse Error: matrix %dx%d is not square", this->rows, this->cols);
         return result;
     }
-
-    // Find adjoint
-    Mat adj = this->adjoint();
-
-    // Find Inverse using formula "inverse(A) = adj(A)/det(A)"
-    for (int i = 0; i < this->rows; i++)
-        for (int j = 0; j < this->cols; j++) {
-            result(i, j) = adj(i, j) / float(det);
-        }
-
+    Mat LU = this->Get(0, this->rows, 0, this->cols);
+    result = Mat::eye(this->rows);
+    if (!LuFactor(LU, NULL, &result, NULL)) {
+        // singular matrix, can't find its inverse
+        result.clear();
+        return result;
+    }
+    LuSubstitute(LU, result);
     return result;
 }
 
 void Mat::allocate()
 {
-    this->ext_buff = false;
     this->length = this->rows * this->cols;
+    if (MatArena::current != NULL) {
+        data = MatArena::current->alloc(this->length);
+        if (data != NULL) {
+            // Arena memory is released by the scope, not by the matrix
+            this->ext_buff = true;
+            return;
+        }
+    }
+    this->ext_buff = false;
     data = new float[this->length];
     ESP_LOGD("Mat", "allocate(%i) = %p", this->length, this->data);
 }
@@ -839,36 +1073,46 @@ Mat Mat::expHelper(const Mat &m, int num)
     }
 }
 
-Mat operator+(const Mat &m1, const Mat &m2)
+void MatMultTo(const Mat &A, const Mat &B, Mat &C)
 {
-    if ((m1.rows != m2.rows) || (m1.cols != m2.cols)) {
-        ESP_LOGW("Mat", "operator + Error: matrices do not have equal dimensions");
-        Mat err_ret;
-        return err_ret;
+    if (A.padding || B.padding || C.padding) {
+        dspm_mult_ex_f32(A.data, B.data, C.data, A.rows, A.cols, B.cols, A.padding, B.padding, C.padding);
+    } else {
+        dspm_mult_f32(A.data, B.data, C.data, A.rows, A.cols, B.cols);
     }
+}
 
-    if (m1.sub_matrix || m2.sub_matrix) {
-        Mat temp(m1.rows, m2.cols);
-        dspm_add_f32(m1.data, m2.data, temp.data, m1.rows, m1.cols, m1.padding, m2.padding, temp.padding, 1, 1, 1);
-        return temp;
+void MatMultAddTo(const Mat &A, const Mat &B, Mat &C)
+{
+    if (A.padding || B.padding || C.padding) {
+        Mat temp(A.rows, B.cols);
+        MatMultTo(A, B, temp);
+        C += temp;
     } else {
-        Mat temp(m1);
-        return (temp += m2);
+        dspm_mult_acc_f32(A.data, B.data, C.data, A.rows, A.cols, B.cols);
     }
 }
 
-Mat operator+(const Mat &m, float C)
+void MatCopyTo(const Mat &src, Mat &dst)
 {
-    if (m.sub_matrix) {
-        Mat temp(m.rows, m.cols);
-        dspm_addc_f32(m.data, temp.data, C, m.rows, m.cols, m.padding, temp.padding, 1, 1);
-        return temp;
-    } else {
-        Mat temp(m);
-        return (temp += C);
+    if ((src.data == dst.data) && (src.stride == dst.stride)) {
+        return;
+    }
+    for (int row = 0; row < dst.rows; row++) {
+        memcpy(dst.data + (row * dst.stride), src.data + (row * src.stride), dst.cols * sizeof(float));
     }
 }
 
+bool MatOverlap(const Mat &m, const Mat &dst, bool same_element_ok)
+{
+    if (same_element_ok && (m.data == dst.data) && (m.stride == dst.stride)) {
+        return false;
+    }
+    const float *m_end = m.data + (m.rows - 1) * m.stride + m.cols;
+    const float *dst_end = dst.data + (dst.rows - 1) * dst.stride + dst.cols;
+    return (m.data < dst_end) && (dst.data < m_end);
+}
+
 bool operator==(const Mat &m1, const Mat &m2)
 {
     if ((m1.cols != m2.cols) || (m1.rows != m2.rows)) {
@@ -887,84 +1131,6 @@ bool operator==(const Mat &m1, const Mat &m2)
     return true;
 }
 
-Mat operator-(const Mat &m1, const Mat &m2)
-{
-    if ((m1.rows != m2.rows) || (m1.cols != m2.cols)) {
-        ESP_LOGW("Mat", "operator - Error: matrices do not have equal dimensions");
-        Mat err_ret;
-        return err_ret;
-    }
-
-    if (m1.sub_matrix || m2.sub_matrix) {
-        Mat temp(m1.rows, m1.cols);
-        dspm_sub_f32(m1.data, m2.data, temp.data, m1.rows, m1.cols, m1.padding, m2.padding, temp.padding, 1, 1, 1);
-        return temp;
-    } else {
-        Mat temp(m1);
-        return (temp -= m2);
-    }
-}
-
-Mat operator-(const Mat &m, float C)
-{
-    if (m.sub_matrix) {
-        Mat temp(m.rows, m.cols);
-        dspm_addc_f32(m.data, temp.data, -C, m.rows, m.cols, m.padding, temp.padding, 1, 1);
-        return temp;
-    } else {
-        Mat temp(m);
-        return (temp -= C);
-    }
-}
-
-Mat operator*(const Mat &m1, const Mat &m2)
-{
-    if (m1.cols != m2.rows) {
-        ESP_LOGW("Mat", "operator * Error: matrices do not have correct dimensions");
-        Mat err_ret;
-        return err_ret;
-    }
-    Mat temp(m1.rows, m2.cols);
-
-    if (m1.sub_matrix || m2.sub_matrix) {
-        dspm_mult_ex_f32(m1.data, m2.data, temp.data, m1.rows, m1.cols, m2.cols, m1.padding, m2.padding, temp.padding);
-    } else {
-        dspm_mult_f32(m1.data, m2.data, temp.data, m1.rows, m1.cols, m2.cols);
-    }
-
-    return temp;
-
-}
-
-Mat operator*(const Mat &m, float num)
-{
-    if (m.sub_matrix) {
-        Mat temp(m.rows, m.cols);
-        dspm_mulc_f32(m.data, temp.data, num, m.rows, m.cols, m.padding, temp.padding, 1, 1);
-        return temp;
-    } else {
-        Mat temp(m);
-        return (temp *= num);
-    }
-}
-
-Mat operator*(float num, const Mat &m)
-{
-    return (m * num);
-}
-
-Mat operator/(const Mat &m, float num)
-{
-    if (m.sub_matrix) {
-        Mat temp(m.rows, m.cols);
-        dspm_mulc_f32(m.data, temp.data, 1 / num, m.rows, m.cols, m.padding, temp.padding, 1, 1);
-        return temp;
-    } else {
-        Mat temp(m);
-        return (temp /= num);
-    }
-}
-
 Mat operator/(const Mat &A, const Mat &B)
 {
     if ((A.rows != B.rows) || (A.cols != B.cols)) {
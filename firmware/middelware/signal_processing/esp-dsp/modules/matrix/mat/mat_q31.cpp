@@ -0,0 +1,265 @@
+/**
+ * @file mat_q31.cpp
+ * @brief Fixed point matrix with block floating point scaling
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <string.h>
+#include <math.h>
+#include "mat_q31.h"
+#include "esp_log.h"
+#include "dspm_matrix.h"
+
+namespace dspm {
+
+MatQ31::MatQ31(int rows, int cols)
+{
+    this->rows = rows;
+    this->cols = cols;
+    this->exponent = zero_exponent;
+    allocate();
+    memset(this->data, 0, this->length * sizeof(int32_t));
+}
+
+MatQ31::MatQ31(int32_t *data, int rows, int cols, int exponent)
+{
+    this->rows = rows;
+    this->cols = cols;
+    this->length = rows * cols;
+    this->data = data;
+    this->exponent = exponent;
+    this->ext_buff = true;
+}
+
+MatQ31::MatQ31()
+{
+    this->rows = 1;
+    this->cols = 1;
+    this->exponent = zero_exponent;
+    allocate();
+    this->data[0] = 0;
+}
+
+MatQ31::MatQ31(const MatQ31 &src)
+{
+    this->rows = src.rows;
+    this->cols = src.cols;
+    this->exponent = src.exponent;
+    allocate();
+    memcpy(this->data, src.data, this->length * sizeof(int32_t));
+}
+
+MatQ31::~MatQ31()
+{
+    if (false == this->ext_buff) {
+        delete[] this->data;
+    }
+}
+
+MatQ31 &MatQ31::operator=(const MatQ31 &src)
+{
+    if (this == &src) {
+        return *this;
+    }
+    if ((this->rows != src.rows) || (this->cols != src.cols)) {
+        if (false == this->ext_buff) {
+            delete[] this->data;
+        }
+        this->rows = src.rows;
+        this->cols = src.cols;
+        allocate();
+    }
+    this->exponent = src.exponent;
+    memcpy(this->data, src.data, this->length * sizeof(int32_t));
+    return *this;
+}
+
+void MatQ31::allocate()
+{
+    this->length = this->rows * this->cols;
+    if (MatArena::current != NULL) {
+        // int32_t has the size of float
+        this->data = (int32_t *)MatArena::current->alloc(this->length);
+        if (this->data != NULL) {
+            this->ext_buff = true;
+            return;
+        }
+    }
+    this->ext_buff = false;
+    this->data = new int32_t[this->length];
+}
+
+float MatQ31::get(int row, int col) const
+{
+    return ldexpf((float)(*this)(row, col), this->exponent - 31);
+}
+
+void MatQ31::fromFloat(const float *src)
+{
+    float max_abs = 0;
+    for (int i = 0; i < this->length; i++) {
+        max_abs = fmaxf(max_abs, fabsf(src[i]));
+    }
+    if (max_abs == 0) {
+        memset(this->data, 0, this->length * sizeof(int32_t));
+        this->exponent = zero_exponent;
+        return;
+    }
+    // max_abs = m*2^exponent, 0.5 <= m < 1
+    frexpf(max_abs, &this->exponent);
+    float scale = ldexpf(1.0f, 31 - this->exponent);
+    for (int i = 0; i < this->length; i++) {
+        float value = src[i] * scale;
+        this->data[i] = saturate((int64_t)(value + ((value < 0) ? -0.5f : 0.5f)));
+    }
+}
+
+void MatQ31::fromMat(const Mat &src)
+{
+    if ((src.rows != this->rows) || (src.cols != this->cols)) {
+        ESP_LOGE("Mat", "MatQ31 fromMat Error: source matrix is %dx%d instead of %dx%d", src.rows, src.cols, this->rows, this->cols);
+        return;
+    }
+    if (src.stride == src.cols) {
+        fromFloat(src.data);
+        return;
+    }
+    Mat copy(src.rows, src.cols);
+    for (int row = 0; row < src.rows; row++) {
+        memcpy(&copy.data[row * src.cols], &src.data[row * src.stride], src.cols * sizeof(float));
+    }
+    fromFloat(copy.data);
+}
+
+void MatQ31::fromInt64(const int64_t *src, int scale)
+{
+    int64_t any_bits = 0;
+    for (int i = 0; i < this->length; i++) {
+        any_bits |= src[i] ^ (src[i] >> 63);
+    }
+    // Right shift to fit the largest value into 31 bits
+    int shift = bits(any_bits) - 31;
+    if (shift > 0) {
+        int64_t round = 1LL << (shift - 1);
+        for (int i = 0; i < this->length; i++) {
+            this->data[i] = saturate((src[i] + round) >> shift);
+        }
+    } else {
+        // Left shift as a multiplication, the values fit 31 bits
+        int64_t scale_up = (int64_t)1 << -shift;
+        for (int i = 0; i < this->length; i++) {
+            this->data[i] = (int32_t)(src[i] * scale_up);
+        }
+    }
+    this->exponent = (any_bits == 0) ? zero_exponent : scale + shift + 31;
+}
+
+void MatQ31::toFloat(float *dst) const
+{
+    float scale = ldexpf(1.0f, this->exponent - 31);
+    for (int i = 0; i < this->length; i++) {
+        dst[i] = this->data[i] * scale;
+    }
+}
+
+Mat MatQ31::toMat() const
+{
+    Mat result(this->rows, this->cols);
+    toFloat(result.data);
+    return result;
+}
+
+int MatQ31::headroom() const
+{
+    int32_t any_bits = 0;
+    for (int i = 0; i < this->length; i++) {
+        any_bits |= this->data[i] ^ (this->data[i] >> 31);
+    }
+    return (any_bits == 0) ? 31 : __builtin_clz(any_bits) - 1;
+}
+
+void MatQ31::normalize()
+{
+    int shift = headroom();
+    if (shift == 31) {
+        this->exponent = zero_exponent;
+        return;
+    }
+    // Left shift as a multiplication, the headroom keeps the values in 32 bits
+    int32_t scale_up = (int32_t)1 << shift;
+    for (int i = 0; i < this->length; i++) {
+        this->data[i] *= scale_up;
+    }
+    this->exponent -= shift;
+}
+
+MatQ31 MatQ31::t() const
+{
+    MatQ31 result(this->cols, this->rows);
+    for (int row = 0; row < this->rows; row++) {
+        for (int col = 0; col < this->cols; col++) {
+            result(col, row) = (*this)(row, col);
+        }
+    }
+    result.exponent = this->exponent;
+    return result;
+}
+
+// Exponent of the largest element
+static int ExponentOfMax(const MatQ31 &M)
+{
+    return M.exponent - M.headroom();
+}
+
+// C = A + sign*B, aligned to the larger exponent with one guard bit
+static void AddSigned(const MatQ31 &A, const MatQ31 &B, MatQ31 &C, int sign)
+{
+    if ((A.rows != B.rows) || (A.cols != B.cols) || (A.rows != C.rows) || (A.cols != C.cols)) {
+        ESP_LOGE("Mat", "MatQ31 add Error: %dx%d, %dx%d, %dx%d", A.rows, A.cols, B.rows, B.cols, C.rows, C.cols);
+        return;
+    }
+    int exp_a = ExponentOfMax(A);
+    int exp_b = ExponentOfMax(B);
+    int exponent = ((exp_a > exp_b) ? exp_a : exp_b) + 1;
+    // Right shift of the operands, negative for the operands with headroom
+    int shift_a = exponent - A.exponent;
+    int shift_b = exponent - B.exponent;
+    for (int i = 0; i < A.length; i++) {
+        int64_t a = MatQ31::shift(A.data[i], shift_a);
+        int64_t b = MatQ31::shift(B.data[i], shift_b);
+        C.data[i] = MatQ31::saturate(a + sign * b);
+    }
+    C.exponent = exponent;
+    C.normalize();
+}
+
+void MatQ31::add(const MatQ31 &A, const MatQ31 &B, MatQ31 &C)
+{
+    AddSigned(A, B, C, 1);
+}
+
+void MatQ31::sub(const MatQ31 &A, const MatQ31 &B, MatQ31 &C)
+{
+    AddSigned(A, B, C, -1);
+}
+
+void MatQ31::mult(const MatQ31 &A, const MatQ31 &B, MatQ31 &C)
+{
+    if ((A.cols != B.rows) || (C.rows != A.rows) || (C.cols != B.cols)) {
+        ESP_LOGE("Mat", "MatQ31 mult Error: %dx%d * %dx%d to %dx%d", A.rows, A.cols, B.rows, B.cols, C.rows, C.cols);
+        return;
+    }
+    // |sum| < n * 2^(62 - headroom(A) - headroom(B)), shifted to 31 bits
+    int guard = bits(A.cols - 1);
+    int shift = A.headroom() + B.headroom() - guard;
+    shift = (shift > 23) ? 23 : shift;
+    dspm_mult_s32(A.data, B.data, C.data, A.rows, A.cols, B.cols, shift);
+    C.exponent = A.exponent + B.exponent - shift;
+    C.normalize();
+}
+
+}
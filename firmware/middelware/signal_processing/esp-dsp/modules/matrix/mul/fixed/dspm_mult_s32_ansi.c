@@ -0,0 +1,40 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdint.h>
+#include "dspm_mult.h"
+
+// Matrinx A(m,n), m - amount or rows, n - amount of columns
+// C(m,k) = A(m,n)*B(n,k)
+// c(i,j) = sum(a(i,s)*b(s,j)) , s=1..n
+esp_err_t dspm_mult_s32_ansi(const int32_t *A, const int32_t *B, int32_t *C, int m, int n, int k, int shift)
+{
+    // The products are summed with 8 guard bits, the rest of the shift is done at the end
+    int final_shift = 23 - shift;
+    long long round = (final_shift > 0) ? (1LL << (final_shift - 1)) : 0;
+    for (int i = 0 ; i < m ; i++) {
+        for (int j = 0 ; j < k ; j++) {
+            long long acc = round;
+            for (int s = 0; s < n ; s++) {
+                acc += ((long long)A[i * n + s] * (long long)B[s * k + j]) >> 8;
+            }
+            if (final_shift > 0) {
+                acc >>= final_shift;
+            } else {
+                // Left shift as a multiplication of a value limited to 32 bits
+                acc = (acc > INT32_MAX) ? INT32_MAX : ((acc < INT32_MIN) ? INT32_MIN : acc);
+                acc *= 1LL << -final_shift;
+            }
+            if (acc > INT32_MAX) {
+                acc = INT32_MAX;
+            } else if (acc < INT32_MIN) {
+                acc = INT32_MIN;
+            }
+            C[i * k + j] = (int32_t)acc;
+        }
+    }
+    return ESP_OK;
+}
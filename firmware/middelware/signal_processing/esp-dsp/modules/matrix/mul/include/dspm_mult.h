@@ -46,6 +46,27 @@ esp_err_t dspm_mult_f32_ae32(const float *A, const float *B, float *C, int m, in
 esp_err_t dspm_mult_f32_aes3(const float *A, const float *B, float *C, int m, int n, int k);
 /**@}*/
 
+/**
+ * @brief   Matrix multiplication with accumulation
+ *
+ * Adds the product of two floating point matrices to a matrix: C[m][k] += A[m][n] * B[n][k]
+ * Each element of the product is summed before it is added to C, so the
+ * result is the same as dspm_mult_f32_ansi followed by dsps_add_f32_ansi,
+ * without the temporary matrix and the second pass.
+ * The extension (_ansi) use ANSI C and could be compiled and run on any platform.
+ *
+ * @param[in] A  input matrix A[m][n]
+ * @param[in] B  input matrix B[n][k]
+ * @param C  input and result matrix C[m][k]
+ * @param[in] m  matrix dimension
+ * @param[in] n  matrix dimension
+ * @param[in] k  matrix dimension
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dspm_mult_acc_f32_ansi(const float *A, const float *B, float *C, int m, int n, int k);
+
 
 /**
  * @brief   Matrix multiplication A[3x3]xB[3x1]
@@ -132,6 +153,28 @@ esp_err_t dspm_mult_s16_ae32(const int16_t *A, const int16_t *B, int16_t *C, int
 esp_err_t dspm_mult_s16_aes3(const int16_t *A, const int16_t *B, int16_t *C, int m, int n, int k, int shift);
 /**@}*/
 
+/**
+ * @brief   Matrix multiplication 32 bit signed int
+ *
+ * Matrix multiplication for two signed 32 bit fixed point matrices: C[m][k] = (A[m][n] * B[n][k]) >> (31 - shift)
+ * The result is rounded and saturated to 32 bits. The products are summed in 64 bits
+ * with 8 guard bits, so n up to 256 full scale products do not overflow;
+ * the shift should be less than 24.
+ * The extension (_ansi) use ANSI C and could be compiled and run on any platform.
+ *
+ * @param[in] A  input matrix A[m][n]
+ * @param[in] B  input matrix B[n][k]
+ * @param C  result matrix C[m][k]
+ * @param[in] m  matrix dimension
+ * @param[in] n  matrix dimension
+ * @param[in] k  matrix dimension
+ * @param[in] shift every result will be shifted and stored as 32 bit signed value, could be negative.
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dspm_mult_s32_ansi(const int32_t *A, const int32_t *B, int32_t *C, int m, int n, int k, int shift);
+
 /**@{*/
 /**
  * @brief   Matrix subset multiplication
@@ -172,6 +215,7 @@ esp_err_t dspm_mult_ex_f32_aes3(const float *A, const float *B, float *C, int m,
 #else
 #define dspm_mult_s16 dspm_mult_s16_ansi
 #endif
+#define dspm_mult_s32 dspm_mult_s32_ansi
 
 #if (dspm_mult_f32_aes3_enabled == 1)
 #define dspm_mult_f32 dspm_mult_f32_aes3
@@ -183,6 +227,7 @@ esp_err_t dspm_mult_ex_f32_aes3(const float *A, const float *B, float *C, int m,
 #define dspm_mult_f32 dspm_mult_f32_ansi
 #define dspm_mult_ex_f32 dspm_mult_ex_f32_ansi
 #endif
+#define dspm_mult_acc_f32 dspm_mult_acc_f32_ansi
 
 #if (dspm_mult_3x3x1_f32_ae32_enabled == 1)
 #define dspm_mult_3x3x1_f32 dspm_mult_3x3x1_f32_ae32
@@ -210,12 +255,14 @@ esp_err_t dspm_mult_ex_f32_aes3(const float *A, const float *B, float *C, int m,
 
 #else
 #define dspm_mult_s16 dspm_mult_s16_ansi
+#define dspm_mult_s32 dspm_mult_s32_ansi
 #define dspm_mult_f32 dspm_mult_f32_ansi
 #define dspm_mult_3x3x1_f32(A,B,C) dspm_mult_f32_ansi(A,B,C, 3, 3, 1)
 #define dsps_sub_f32 dsps_sub_f32_ansi
 #define dsps_add_f32 dsps_add_f32_ansi
 #define dspm_mult_4x4x4_f32(A,B,C) dspm_mult_f32_ansi(A,B,C, 4, 4, 4)
 #define dspm_mult_ex_f32 dspm_mult_ex_f32_ansi
+#define dspm_mult_acc_f32 dspm_mult_acc_f32_ansi
 #endif // CONFIG_DSP_OPTIMIZED
 
 
@@ -235,10 +235,11 @@ TEST_CASE("Mat class operators", "[dspm]")
                        };
     result = dspm::Mat(m_data, 3, 3);
     result = result.inverse();
+    // LU decomposition in single precision, the matrix is ill-conditioned
     std::cout << "inverse: " << std::endl;
     std::cout << result << std::endl;
     for (int i = 0 ; i < 3 * 3 ; i++) {
-        if (std::abs(result.data[i] - m_result[i]) > 1e-8) {
+        if (std::abs(result.data[i] - m_result[i]) > 1e-3) {
             printf("Error at[%i] = %f, expected= %f, calculated = %f \n", i, std::abs(result.data[i] - m_result[i]), m_result[i], result.data[i]);
             TEST_ASSERT_MESSAGE (false, "Error in inverse() operation!\n");
         }
@@ -818,10 +818,11 @@ static void test_mat_subset_inverse(void)
     result = result_sub.inverse();
     test_assert_check_area_mat_mat(result_origin_area_check, result_sub, 1, 1, "area check inverse");
 
+    // LU decomposition in single precision, the matrix is ill-conditioned
     std::cout << "inverse: " << std::endl;
     std::cout << result << std::endl;
     for (int i = 0; i < 3 * 3; i++) {
-        if (std::abs(result.data[i] - m_result[i]) > 1e-8) {
+        if (std::abs(result.data[i] - m_result[i]) > 1e-3) {
             printf("Error at[%i] = %f, expected= %f, calculated = %f \n", i, std::abs(result.data[i] - m_result[i]), m_result[i], result.data[i]);
             TEST_ASSERT_MESSAGE (false, "Error in inverse() operation!\n");
         }
@@ -16,6 +16,10 @@
  * |   Date	    | Description                                    						|
  * |:----------:|:----------------------------------------------------------------------|
  * | 15/03/2024 | Document creation		                         						|
+ * | 16/10/2026 | Fixed point (Q15) FFT magnitude for raw ADC samples					|
+ * | 16/10/2026 | FFTMagnitude computed as a N/2 points complex FFT (real FFT)			|
+ * | 16/10/2026 | Reentrant FFT contexts with cached window								|
+ * | 16/10/2026 | Selectable spectrum output: power, fast magnitude and dB				|
  * 
  **/
 
@@ -24,7 +28,44 @@
 #include <stdbool.h>
 /*==================[macros]=================================================*/
 #define MAX_SIGNAL_LENGHT   2048
+#define FFT_DB_FLOOR        -200.0f     /*!< dB value of empty bins */
 /*==================[typedef]================================================*/
+/**
+ * @brief Window applied to the signal before the FFT
+ */
+typedef enum fft_window {
+    FFT_WINDOW_HANN,                /*!< Hann: general purpose */
+    FFT_WINDOW_BLACKMAN_HARRIS,     /*!< Blackman-Harris: low leakage, wide main lobe */
+    FFT_WINDOW_FLAT_TOP             /*!< Flat top: accurate amplitude of tones between bins */
+} fft_window_t;
+
+/**
+ * @brief Spectrum output of FFTSpectrumCtx
+ * 
+ * Error bounds are relative to FFT_OUTPUT_MAGNITUDE (float rounding aside).
+ */
+typedef enum fft_output {
+    FFT_OUTPUT_MAGNITUDE,           /*!< |X| with sqrtf (reference) */
+    FFT_OUTPUT_MAGNITUDE_FAST,      /*!< |X| with dsps_sqrt_f32 bit approximation, error within +/-3.6% */
+    FFT_OUTPUT_MAGNITUDE_AMBM,      /*!< |X| alpha max plus beta min in integers (no square root), error within +/-2.3% */
+    FFT_OUTPUT_POWER,               /*!< |X|^2 (no square root), exact */
+    FFT_OUTPUT_DB                   /*!< 20 log10(|X|) with table log2, error within 0.001 dB, FFT_DB_FLOOR for empty bins */
+} fft_output_t;
+
+/**
+ * @brief FFT context
+ * 
+ * Owns the buffers of one FFT size and the precomputed window, so several 
+ * analyzers (of different sizes) can run concurrently from different tasks.
+ * Create it with FFTCreate and release it with FFTDelete.
+ */
+typedef struct fft_ctx {
+    uint16_t signal_lenght;         /*!< Lenght of the signal (power of two) */
+    fft_window_t window_type;       /*!< Window applied to the signal */
+    float scale;                    /*!< Amplitude normalization of the window */
+    float * wind;                   /*!< Window coefficients (signal_lenght) */
+    float * buffer;                 /*!< Real FFT work buffer (signal_lenght) */
+} fft_ctx_t;
 
 /*==================[external data declaration]==============================*/
 
@@ -32,6 +73,10 @@
 /**
  * @brief Initialize the FFT calculation module
  * 
+ * Computes the tables shared by all the FFT functions and contexts. Call it 
+ * once at startup, before starting the tasks that use them; later calls 
+ * return without touching the tables.
+ * 
  * @return true     FFT initialized
  * @return false    Not possible to initialize FFT
  */
@@ -40,6 +85,10 @@ bool FFTInit(void);
 /**
  * @brief Calculates the Fast Fourier Transform of a given signal
  * 
+ * Real input FFT: the N samples are packed as a N/2 points complex signal, 
+ * transformed with the radix-4 FFT (radix-2 when N/2 is not a power of four) 
+ * and split into the N/2 bins of the real spectrum.
+ * 
  * @note  Lenght of signal array must be a power of two (with maximun value = MAX_SIGNAL_LENGHT)
  * 
  * @param signal            Array with signal values (of lenght = signal_lenght)
@@ -48,6 +97,82 @@ bool FFTInit(void);
  */
 void FFTMagnitude(float * signal, float * fft, uint16_t signal_lenght);
 
+/**
+ * @brief Calculates the Fast Fourier Transform of raw ADC samples in fixed point (Q15)
+ * 
+ * Integer only version of FFTMagnitude for targets without FPU. Samples are 
+ * shifted so the largest one fills 15 bits (block floating point), windowed 
+ * with a Q15 Hann table and transformed with the 16 bits FFT. Magnitudes are 
+ * returned in the same units as the input samples, matching FFTMagnitude 
+ * within 0.1% of full scale.
+ * 
+ * @note  Lenght of signal array must be a power of two (with maximun value = MAX_SIGNAL_LENGHT)
+ * 
+ * @param signal            Array with ADC samples (of lenght = signal_lenght)
+ * @param fft               Array to store FFT magnitude values (of lenght = signal_lenght / 2)
+ * @param signal_lenght     Lenght of signal arrays
+ */
+void FFTMagnitudeQ15(const uint16_t * signal, uint16_t * fft, uint16_t signal_lenght);
+
+/**
+ * @brief Create a FFT context for signals of a given lenght
+ * 
+ * Allocates the context with right-sized buffers and computes the window 
+ * once.
+ * 
+ * @note  FFTInit must have been called, the FFT tables are shared by all 
+ *        the contexts.
+ * 
+ * @param signal_lenght     Lenght of the signal (power of two, up to MAX_SIGNAL_LENGHT)
+ * @param window_type       Window applied to the signal
+ * @return fft_ctx_t*       FFT context (NULL if the lenght is invalid, FFTInit was not called or out of memory)
+ */
+fft_ctx_t * FFTCreate(uint16_t signal_lenght, fft_window_t window_type);
+
+/**
+ * @brief Release a FFT context created with FFTCreate
+ * 
+ * @param ctx               FFT context (can be NULL)
+ */
+void FFTDelete(fft_ctx_t * ctx);
+
+/**
+ * @brief Calculates the FFT spectrum of a signal with a FFT context
+ * 
+ * Same units as FFTMagnitude, normalized by the gain of the context window.
+ * The output mode trades accuracy for speed on targets without FPU, where 
+ * the square root of each bin costs as much as a large part of the FFT.
+ * 
+ * @param ctx               FFT context
+ * @param signal            Array with signal values (of lenght = ctx->signal_lenght)
+ * @param fft               Array to store spectrum values (of lenght = ctx->signal_lenght / 2)
+ * @param output            Spectrum output (see fft_output_t for the error bounds)
+ */
+void FFTSpectrumCtx(fft_ctx_t * ctx, const float * signal, float * fft, fft_output_t output);
+
+/**
+ * @brief Calculates the FFT magnitude of a signal with a FFT context
+ * 
+ * Same as FFTSpectrumCtx with FFT_OUTPUT_MAGNITUDE.
+ * 
+ * @param ctx               FFT context
+ * @param signal            Array with signal values (of lenght = ctx->signal_lenght)
+ * @param fft               Array to store FFT magnitude values (of lenght = ctx->signal_lenght / 2)
+ */
+void FFTMagnitudeCtx(fft_ctx_t * ctx, const float * signal, float * fft);
+
+/**
+ * @brief Calculates the FFT power (squared magnitude) of a signal with a FFT context
+ * 
+ * Same as FFTSpectrumCtx with FFT_OUTPUT_POWER: square of FFTMagnitudeCtx 
+ * values, without the square roots.
+ * 
+ * @param ctx               FFT context
+ * @param signal            Array with signal values (of lenght = ctx->signal_lenght)
+ * @param fft               Array to store FFT power values (of lenght = ctx->signal_lenght / 2)
+ */
+void FFTPowerCtx(fft_ctx_t * ctx, const float * signal, float * fft);
+
 /**
  * @brief Return the FFT frequency axis vector
  * 
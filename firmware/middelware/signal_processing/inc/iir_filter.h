@@ -16,13 +16,82 @@
  * |   Date	    | Description                                    						|
  * |:----------:|:----------------------------------------------------------------------|
  * | 15/03/2024 | Document creation		                         						|
+ * | 16/10/2026 | Filter handles: any order, band-pass and notch	 					|
+ * | 16/10/2026 | Fixed point (Q14/Q30) filter kernels									|
+ * 
+ * @section handles Filter handles
+ * 
+ * Each filter keeps its coefficients and delay line in storage owned by the 
+ * caller, declared with IIR_FILTER_DEFINE(), so any number of channels can be 
+ * filtered concurrently:
+ * 
+ * @code
+ * IIR_FILTER_DEFINE(ecg_filter, 4);
+ * IIR_FILTER_DEFINE(mains_filter, 2);
+ * 
+ * IirInit(&ecg_filter, IIR_BAND_PASS, 4, 250, 0.5, 40);
+ * IirInit(&mains_filter, IIR_NOTCH, 2, 250, 50, 2);
+ * IirFilter(&ecg_filter, ecg, ecg, ECG_LENGHT);
+ * IirFilter(&mains_filter, ecg, ecg, ECG_LENGHT);
+ * @endcode
+ * 
+ * On targets without FPU a filter can run in fixed point instead. The kernel 
+ * is chosen when the filter is declared, and IirInit() quantizes the 
+ * coefficients for it:
+ * 
+ * @code
+ * IIR_FILTER_DEFINE_KERNEL(accel_filter, 2, IIR_S16);
+ * 
+ * IirInit(&accel_filter, IIR_LOW_PASS, 2, 100, 5, 0);
+ * IirFilterS16(&accel_filter, accel_raw, accel_raw, ACCEL_LENGHT);
+ * @endcode
+ * 
+ * IIR_S16 (Q14 coefficients) suits cut-off frequencies down to ~0.5% of the 
+ * sample frequency: IirInit() rejects the designs whose poles Q14 can't place 
+ * accurately (see DSPS_BIQUAD_MAX_POLE_ERROR). IIR_S32 (Q30 coefficients) keeps 
+ * lower cut-off frequencies accurate.
+ * 
+ * LowPassInit/HiPassInit and LowPassFilter/HiPassFilter use one internal 
+ * filter each and are kept for existing projects.
  * 
  **/
 
 /*==================[inclusions]=============================================*/
 #include <stdint.h>
+#include <stdbool.h>
 /*==================[macros]=================================================*/
+#define IIR_SOS_SIZE        5   /*!< Coefficients per second order section (b0, b1, b2, a1, a2) */
+#define IIR_DELAY_SIZE      2   /*!< Delay line values per second order section */
+
+#define IIR_FX_DELAY_SIZE   5   /*!< Delay line values per fixed point section (x1, x2, y1, y2, error) */
+
+/** @brief Second order sections needed by a filter of the given order (any type) */
+#define IIR_SECTIONS(order)     ((order) / 2 + 1)
+
+/** @brief 32 bits words needed by one second order section of the given kernel */
+#define IIR_SECTION_WORDS(kernel)                                                               \
+    ((kernel) == IIR_S32 ? IIR_SOS_SIZE + IIR_FX_DELAY_SIZE :                                   \
+     (kernel) == IIR_S16 ? (IIR_SOS_SIZE + 1) / 2 + IIR_FX_DELAY_SIZE :                         \
+                           IIR_SOS_SIZE + IIR_DELAY_SIZE)
+
+/**
+ * @brief Declares a floating point filter handle together with its storage
+ * 
+ * @param name      Name of the iir_filter_t variable
+ * @param order     Maximum order the filter will be initialized with
+ */
+#define IIR_FILTER_DEFINE(name, order)  IIR_FILTER_DEFINE_KERNEL(name, order, IIR_F32)
 
+/**
+ * @brief Declares a filter handle running the given kernel, together with its storage
+ * 
+ * @param name      Name of the iir_filter_t variable
+ * @param order     Maximum order the filter will be initialized with
+ * @param kernel    IIR_F32, IIR_S16 or IIR_S32
+ */
+#define IIR_FILTER_DEFINE_KERNEL(name, order, kernel)                                           \
+    static int32_t name##_storage[IIR_SECTIONS(order) * IIR_SECTION_WORDS(kernel)];             \
+    static iir_filter_t name = {kernel, IIR_SECTIONS(order) * IIR_SECTION_WORDS(kernel), 0, name##_storage}
 /*==================[typedef]================================================*/
 typedef enum filter_order {
     ORDER_2 = 2,        /*!< 2nd order filter */
@@ -30,9 +99,95 @@ typedef enum filter_order {
     ORDER_6 = 6,        /*!< 6th order filter */
     ORDER_8 = 8         /*!< 8th order filter */
 } filter_order_t;
+
+typedef enum filter_type {
+    IIR_LOW_PASS,       /*!< Butterworth low pass filter */
+    IIR_HIGH_PASS,      /*!< Butterworth high pass filter */
+    IIR_BAND_PASS,      /*!< Butterworth high pass + low pass cascade */
+    IIR_NOTCH           /*!< Notch (band stop) filter, e.g. 50/60 Hz mains */
+} filter_type_t;
+
+typedef enum iir_kernel {
+    IIR_F32,            /*!< Floating point samples and coefficients */
+    IIR_S16,            /*!< int16_t samples, Q14 coefficients, 64 bits accumulator */
+    IIR_S32             /*!< int32_t samples, Q30 coefficients, 64 bits accumulator */
+} iir_kernel_t;
+
+/**
+ * @brief Filter handle. Declare it with IIR_FILTER_DEFINE() or IIR_FILTER_DEFINE_KERNEL()
+ */
+typedef struct iir_filter {
+    iir_kernel_t kernel;    /*!< Kernel the filter runs */
+    uint16_t storage_size;  /*!< Size of the storage in 32 bits words */
+    uint8_t n_sections;     /*!< Number of sections in use */
+    int32_t * storage;      /*!< Coefficients of all sections followed by their delay lines */
+} iir_filter_t;
 /*==================[external data declaration]==============================*/
 
 /*==================[external functions declaration]=========================*/
+/**
+ * @brief Initialize a filter
+ * 
+ * Low and high pass filters accept any order. Band pass filters cascade a 
+ * high pass (cut_frec) and a low pass (cut_frec2) of half the order each. 
+ * Notch filters cascade order / 2 identical notch sections. Band pass and 
+ * notch orders must be even.
+ * 
+ * @param filter        Filter handle
+ * @param type          Filter type
+ * @param order         Filter's order
+ * @param sample_frec   Signal's sample frequency
+ * @param cut_frec      Cut-off frequency (low cut-off for band pass, center for notch)
+ * @param cut_frec2     High cut-off frequency for band pass, -3 dB width of each notch section (ignored otherwise)
+ * @return true         Filter initialized
+ * @return false        Order does not fit the filter storage, invalid frequencies or 
+ *                      coefficients out of the fixed point range or precision
+ */
+bool IirInit(iir_filter_t * filter, filter_type_t type, uint8_t order, float sample_frec, float cut_frec, float cut_frec2);
+
+/**
+ * @brief Clear the delay lines of a filter
+ * 
+ * @param filter        Filter handle
+ */
+void IirReset(iir_filter_t * filter);
+
+/**
+ * @brief Apply a filter to a signal array
+ * 
+ * @note  Only for IIR_F32 filters, other filters leave the output untouched
+ * 
+ * @param filter            Filter handle
+ * @param input_signal      Input signal array
+ * @param output_signal     Filtered signal array (may be the same as input_signal)
+ * @param signal_lenght     Number of samples of both signals
+ */
+void IirFilter(iir_filter_t * filter, float * input_signal, float * output_signal, int16_t signal_lenght);
+
+/**
+ * @brief Apply a fixed point filter to a 16 bits signal array
+ * 
+ * @note  Only for IIR_S16 filters, other filters leave the output untouched
+ * 
+ * @param filter            Filter handle
+ * @param input_signal      Input signal array
+ * @param output_signal     Filtered signal array (may be the same as input_signal)
+ * @param signal_lenght     Number of samples of both signals
+ */
+void IirFilterS16(iir_filter_t * filter, const int16_t * input_signal, int16_t * output_signal, int16_t signal_lenght);
+
+/**
+ * @brief Apply a fixed point filter to a 32 bits signal array
+ * 
+ * @note  Only for IIR_S32 filters, other filters leave the output untouched
+ * 
+ * @param filter            Filter handle
+ * @param input_signal      Input signal array
+ * @param output_signal     Filtered signal array (may be the same as input_signal)
+ * @param signal_lenght     Number of samples of both signals
+ */
+void IirFilterS32(iir_filter_t * filter, const int32_t * input_signal, int32_t * output_signal, int16_t signal_lenght);
+
 /**
  * @brief Initialize a 2nd order Butterwotrh Low Pass Filter
  * 
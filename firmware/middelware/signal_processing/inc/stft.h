@@ -0,0 +1,151 @@
+#ifndef STFT_H_
+#define STFT_H_
+/** \addtogroup Drivers_Programable Drivers Programable
+ ** @{ */
+/** \addtogroup Middelware Middelware
+ ** @{ */
+/** \addtogroup STFT Streaming spectral analysis
+ */
+
+/** \brief Short time Fourier transform of a continuous sample stream
+ *
+ * Samples are pushed in chunks of any lenght. Every `hop` samples a frame of
+ * the last `frame_lenght` samples is windowed and transformed (overlap =
+ * frame_lenght - hop), so no data is lost between frames. Each frame power
+ * spectrum is averaged (exponential or Welch) and optionally stored in a
+ * spectrogram ring with the last frames.
+ *
+ * @section changelog
+ *
+ * |   Date	    | Description                                    						|
+ * |:----------:|:----------------------------------------------------------------------|
+ * | 16/10/2026 | Document creation		                         						|
+ *
+ * @section stft_usage Usage
+ *
+ * @code
+ * stft_config_t config = {
+ *     .frame_lenght = 256,
+ *     .hop = 128,                      // 50% overlap
+ *     .window_type = FFT_WINDOW_HANN,
+ *     .average = STFT_AVERAGE_WELCH,
+ *     .spectrogram_frames = 16,
+ * };
+ * FFTInit();                          // once at startup
+ * stft_t * stft = StftCreate(&config);
+ * ...
+ * if (StftPush(stft, samples, n) > 0){
+ *     float * last = StftSpectrogram(stft, 0);
+ *     float * psd = StftAverage(stft);
+ * }
+ * @endcode
+ *
+ * All the memory is allocated by StftCreate, pushing samples does not
+ * allocate and costs a constant time per sample.
+ **/
+
+/*==================[inclusions]=============================================*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "fft.h"
+/*==================[macros]=================================================*/
+
+/*==================[typedef]================================================*/
+typedef enum stft_average {
+    STFT_AVERAGE_NONE,              /*!< No averaging */
+    STFT_AVERAGE_EXPONENTIAL,       /*!< avg += alpha * (frame - avg) */
+    STFT_AVERAGE_WELCH              /*!< Mean of the frames since the last StftReset */
+} stft_average_t;
+
+/**
+ * @brief STFT configuration
+ */
+typedef struct stft_config {
+    uint16_t frame_lenght;          /*!< Samples per frame (power of two, up to MAX_SIGNAL_LENGHT) */
+    uint16_t hop;                   /*!< Samples between frames (1 to frame_lenght) */
+    fft_window_t window_type;       /*!< Window applied to each frame */
+    stft_average_t average;         /*!< Averaging of the frame spectra */
+    float alpha;                    /*!< Exponential averaging factor (0 to 1) */
+    uint16_t spectrogram_frames;    /*!< Frames kept in the spectrogram ring (0: none) */
+} stft_config_t;
+
+/**
+ * @brief STFT context. Create it with StftCreate and release it with StftDelete.
+ */
+typedef struct stft {
+    stft_config_t config;           /*!< Configuration */
+    fft_ctx_t * fft;                /*!< FFT context of the frames */
+    uint16_t fill;                  /*!< Samples in the frame buffer */
+    uint16_t head;                  /*!< Spectrogram ring row of the last frame */
+    uint32_t frames;                /*!< Frames since the last StftReset */
+    float * frame;                  /*!< Frame buffer (frame_lenght) */
+    float * power;                  /*!< Power spectrum of the last frame (frame_lenght / 2) */
+    float * average;                /*!< Averaged power spectrum (frame_lenght / 2) */
+    float * spectrogram;            /*!< Spectrogram ring (spectrogram_frames * frame_lenght / 2) */
+} stft_t;
+
+/*==================[external data declaration]==============================*/
+
+/*==================[external functions declaration]=========================*/
+/**
+ * @brief Create a STFT context
+ *
+ * @note  FFTInit must have been called, the frames use a FFT context.
+ *
+ * @param config            STFT configuration
+ * @return stft_t*          STFT context (NULL if the configuration is invalid or out of memory)
+ */
+stft_t * StftCreate(const stft_config_t * config);
+
+/**
+ * @brief Release a STFT context created with StftCreate
+ *
+ * @param stft              STFT context (can be NULL)
+ */
+void StftDelete(stft_t * stft);
+
+/**
+ * @brief Discard the buffered samples, the averages and the spectrogram
+ *
+ * @param stft              STFT context
+ */
+void StftReset(stft_t * stft);
+
+/**
+ * @brief Push samples to the STFT
+ *
+ * Computes a frame each time `hop` new samples complete it.
+ *
+ * @param stft              STFT context
+ * @param samples           Array with the new samples
+ * @param lenght            Number of samples (any lenght)
+ * @return uint16_t         Number of frames computed
+ */
+uint16_t StftPush(stft_t * stft, const float * samples, uint16_t lenght);
+
+/**
+ * @brief Averaged power spectrum
+ *
+ * Power in the units of FFTPowerCtx, averaged as configured (the last frame
+ * power with STFT_AVERAGE_NONE).
+ *
+ * @param stft              STFT context
+ * @return float*           Averaged power spectrum (frame_lenght / 2 bins), NULL before the first frame
+ */
+float * StftAverage(stft_t * stft);
+
+/**
+ * @brief Power spectrum of a frame of the spectrogram ring
+ *
+ * @param stft              STFT context
+ * @param age               0 for the last frame, 1 for the previous one, ...
+ * @return float*           Power spectrum (frame_lenght / 2 bins), NULL if the frame is not available
+ */
+float * StftSpectrogram(stft_t * stft, uint16_t age);
+
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+#endif /* STFT_H_ */
+
+/*==================[end of file]============================================*/
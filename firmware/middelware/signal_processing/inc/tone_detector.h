@@ -0,0 +1,201 @@
+#ifndef TONE_DETECTOR_H_
+#define TONE_DETECTOR_H_
+/** \addtogroup Drivers_Programable Drivers Programable
+ ** @{ */
+/** \addtogroup Middelware Middelware
+ ** @{ */
+/** \addtogroup Tone_Detector Tone detector
+ */
+
+/** \brief Bank of single frequency detectors (Goertzel / sliding DFT)
+ *
+ * Measures the amplitude of a few known frequencies (mains 50 Hz, a buzzer
+ * tone, a stimulus frequency) without a full FFT. Each bin costs O(1) per
+ * sample and the bank keeps no sample buffer in Goertzel mode.
+ *
+ * - TONE_GOERTZEL: amplitude updated every window_lenght samples, any frequency.
+ * - TONE_SLIDING: sliding DFT, amplitude of the last window_lenght samples
+ *   updated on every sample (one sample latency). Frequencies are rounded to
+ *   the nearest multiple of sample_freq / window_lenght.
+ *
+ * Levels are tone amplitudes in the units of the samples (a tone a*sin(wt)
+ * on a bin gives a). Each bin has on/off thresholds with hysteresis, and the
+ * callback is called when a bin turns on or off.
+ *
+ * @section changelog
+ *
+ * |   Date	    | Description                                    						|
+ * |:----------:|:----------------------------------------------------------------------|
+ * | 16/10/2026 | Document creation		                         						|
+ *
+ * @section tone_usage Usage
+ *
+ * @code
+ * void MainsAlarm(uint8_t bin, bool detected, float level, void * param){
+ *     ...
+ * }
+ * tone_bin_config_t bins[] = {
+ *     {.frequency = 50, .threshold_on = 100, .threshold_off = 80},
+ * };
+ * tone_detector_config_t config = {
+ *     .sample_freq = 1000,
+ *     .window_lenght = 200,
+ *     .mode = TONE_SLIDING,
+ *     .kernel = TONE_Q15,
+ *     .n_bins = 1,
+ *     .bins = bins,
+ *     .func_p = MainsAlarm,
+ * };
+ * tone_detector_t * mains = ToneDetectorCreate(&config);
+ * ...
+ * ToneDetectorPushQ15(mains, adc_samples, n);
+ * @endcode
+ **/
+
+/*==================[inclusions]=============================================*/
+#include <stdint.h>
+#include <stdbool.h>
+/*==================[macros]=================================================*/
+#define TONE_SDFT_DAMPING   0.99999f    /*!< Sliding DFT pole radius (keeps rounding errors bounded) */
+/*==================[typedef]================================================*/
+typedef enum tone_mode {
+    TONE_GOERTZEL,                  /*!< Goertzel, level every window_lenght samples */
+    TONE_SLIDING                    /*!< Sliding DFT, level every sample */
+} tone_mode_t;
+
+typedef enum tone_kernel {
+    TONE_F32,                       /*!< Float samples (ToneDetectorPush) */
+    TONE_Q15                        /*!< int16_t samples, integer states (ToneDetectorPushQ15) */
+} tone_kernel_t;
+
+/**
+ * @brief Callback called when a bin turns on or off
+ *
+ * @param bin       Index of the bin in the configuration
+ * @param detected  true when the level rose above threshold_on, false when it fell below threshold_off
+ * @param level     Tone amplitude
+ * @param param     Callback parameter (param_p)
+ */
+typedef void (*tone_func)(uint8_t bin, bool detected, float level, void * param);
+
+/**
+ * @brief Bin configuration
+ */
+typedef struct tone_bin_config {
+    float frequency;                /*!< Tone frequency (Hz) */
+    float threshold_on;             /*!< Amplitude to detect the tone */
+    float threshold_off;            /*!< Amplitude to release the tone (<= threshold_on) */
+} tone_bin_config_t;
+
+/**
+ * @brief Detector bank configuration
+ */
+typedef struct tone_detector_config {
+    float sample_freq;              /*!< Sample frequency (Hz) */
+    uint16_t window_lenght;         /*!< Samples per level (resolution sample_freq / window_lenght) */
+    tone_mode_t mode;               /*!< Goertzel or sliding DFT */
+    tone_kernel_t kernel;           /*!< Float or Q15 samples */
+    uint8_t n_bins;                 /*!< Number of bins */
+    const tone_bin_config_t * bins; /*!< Bins configuration (copied by ToneDetectorCreate) */
+    tone_func func_p;               /*!< Callback on detection changes (NULL if not requiered) */
+    void * param_p;                 /*!< Callback parameter */
+} tone_detector_config_t;
+
+/**
+ * @brief Bin state
+ */
+typedef struct tone_bin {
+    tone_bin_config_t config;       /*!< Bin configuration */
+    float coef[2];                  /*!< Goertzel 2 cos(w) / sliding DFT r e^jw */
+    float state[2];                 /*!< Filter state (TONE_F32) */
+    float power;                    /*!< Last filter power (except TONE_Q15 sliding DFT) */
+    float threshold[2];             /*!< On/off thresholds as filter power */
+    int32_t coef_q[2];              /*!< coef in Q29 (Goertzel) / Q30 (sliding DFT) */
+    int32_t state_q[2];             /*!< Filter state (TONE_Q15) */
+    int64_t power_q;                /*!< Last filter power (TONE_Q15 sliding DFT) */
+    int64_t threshold_q[2];         /*!< On/off thresholds as filter power (TONE_Q15 sliding DFT) */
+    bool detected;                  /*!< Detection state */
+} tone_bin_t;
+
+/**
+ * @brief Detector bank. Create it with ToneDetectorCreate and release it with ToneDetectorDelete.
+ */
+typedef struct tone_detector {
+    tone_detector_config_t config;  /*!< Configuration */
+    tone_bin_t * bins;              /*!< Bins (n_bins) */
+    uint16_t index;                 /*!< Samples in the Goertzel block / sliding DFT delay line position */
+    float norm;                     /*!< Squared amplitude per unit of filter power */
+    float damping_n;                /*!< Sliding DFT r^N */
+    int32_t damping_n_q;            /*!< Sliding DFT r^N in Q30 */
+    float * delay;                  /*!< Sliding DFT delay line (TONE_F32) */
+    int16_t * delay_q15;            /*!< Sliding DFT delay line (TONE_Q15) */
+} tone_detector_t;
+
+/*==================[external data declaration]==============================*/
+
+/*==================[external functions declaration]=========================*/
+/**
+ * @brief Create a detector bank
+ *
+ * @param config            Detector bank configuration
+ * @return tone_detector_t* Detector bank (NULL if the configuration is invalid or out of memory)
+ */
+tone_detector_t * ToneDetectorCreate(const tone_detector_config_t * config);
+
+/**
+ * @brief Release a detector bank created with ToneDetectorCreate
+ *
+ * @param detector          Detector bank (can be NULL)
+ */
+void ToneDetectorDelete(tone_detector_t * detector);
+
+/**
+ * @brief Clear the filter states, levels and detections
+ *
+ * @param detector          Detector bank
+ */
+void ToneDetectorReset(tone_detector_t * detector);
+
+/**
+ * @brief Push float samples to a TONE_F32 detector bank
+ *
+ * @param detector          Detector bank
+ * @param samples           Array with the new samples
+ * @param lenght            Number of samples
+ */
+void ToneDetectorPush(tone_detector_t * detector, const float * samples, uint16_t lenght);
+
+/**
+ * @brief Push int16_t samples to a TONE_Q15 detector bank
+ *
+ * @param detector          Detector bank
+ * @param samples           Array with the new samples
+ * @param lenght            Number of samples
+ */
+void ToneDetectorPushQ15(tone_detector_t * detector, const int16_t * samples, uint16_t lenght);
+
+/**
+ * @brief Last amplitude measured on a bin
+ *
+ * @param detector          Detector bank
+ * @param bin               Bin index
+ * @return float            Tone amplitude
+ */
+float ToneDetectorLevel(tone_detector_t * detector, uint8_t bin);
+
+/**
+ * @brief Detection state of a bin
+ *
+ * @param detector          Detector bank
+ * @param bin               Bin index
+ * @return true             Tone detected
+ * @return false            Tone not detected
+ */
+bool ToneDetectorState(tone_detector_t * detector, uint8_t bin);
+
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+#endif /* TONE_DETECTOR_H_ */
+
+/*==================[end of file]============================================*/
@@ -10,53 +10,388 @@
  */
 
 /*==================[inclusions]=============================================*/
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <float.h>
 #include "fft.h"
 #include "esp_dsp.h"
 #include "esp_log.h"
 /*==================[macros and definitions]=================================*/
 #define TAG "FFT Module"
+#define Q15_MAX             32767
+#define Q15_ROUND           (1 << 14)
+#define MAG_MAX             0xFFFF
+#define AMBM_ALPHA          0.898f
+#define AMBM_BETA           0.485f
+#define AMBM_Q              14              /* Fractional bits of the scaled AMBM constants */
+#define AMBM_MANT_BITS      16              /* Mantissa bits kept by the integer AMBM */
+#define LOG2_TABLE_BITS     5
+#define LOG2_TABLE_SIZE     (1 << LOG2_TABLE_BITS)
+#define DB_PER_OCTAVE       3.01029996f     /* 10 * log10(2) */
+/*==================[typedef]================================================*/
+/**
+ * @brief Constants of the integer alpha max plus beta min, scale included
+ * 
+ * one, alpha and beta are scale_mantissa, AMBM_ALPHA * scale_mantissa and 
+ * AMBM_BETA * scale_mantissa in Q14 (below 2^15), exponent is the one of scale.
+ */
+typedef struct {
+    uint32_t one;
+    uint32_t alpha;
+    uint32_t beta;
+    int32_t exponent;
+} ambm_scale_t;
 /*==================[internal data declaration]==============================*/
-static float fft_complex[2 * MAX_SIGNAL_LENGHT];
-static float wind[MAX_SIGNAL_LENGHT];
+static fft_ctx_t * legacy_ctx = NULL;
+static int16_t fft_complex_q15[2 * MAX_SIGNAL_LENGHT];
+static int16_t wind_q15[MAX_SIGNAL_LENGHT];
+static uint16_t wind_q15_lenght = 0;
+static float log2_table[LOG2_TABLE_SIZE + 1];
+static bool fft_tables_ready = false;
 /*==================[internal functions declaration]=========================*/
+static uint32_t MagnitudeQ15(int32_t re, int32_t im);
+static void FFTRealCtx(fft_ctx_t * ctx, const float * signal);
+static void AMBMScale(float scale, ambm_scale_t * s);
+static float MagnitudeAMBM(float re, float im, const ambm_scale_t * s);
+static float Log2Table(float x);
+static float PowerToDB(float power, float offset);
 
 /*==================[internal data definition]===============================*/
 
 /*==================[external data definition]===============================*/
 
 /*==================[internal functions definition]==========================*/
+/**
+ * @brief Integer magnitude of a complex number
+ * 
+ * Alpha max plus beta min estimate (max(hi, 7/8 hi + 1/2 lo), within 4%),
+ * refined with one Newton step on re² + im² (error below 0.1%).
+ */
+static uint32_t MagnitudeQ15(int32_t re, int32_t im){
+    uint32_t hi = (re < 0) ? -re : re;
+    uint32_t lo = (im < 0) ? -im : im;
+    if (lo > hi){
+        uint32_t tmp = hi;
+        hi = lo;
+        lo = tmp;
+    }
+    if (hi == 0){
+        return 0;
+    }
+    uint32_t mag = hi - (hi >> 3) + (lo >> 1);
+    if (mag < hi){
+        mag = hi;
+    }
+    return (mag + (hi * hi + lo * lo) / mag + 1) >> 1;
+}
+
+/**
+ * @brief Windowed real FFT of a signal into the context buffer
+ * 
+ * The N samples are packed as a N/2 points complex signal (even samples as 
+ * real part, odd samples as imaginary part), transformed and split into the 
+ * N/2 bins of the real signal. Bin N/2 is left in the imaginary part of bin 0.
+ */
+static void FFTRealCtx(fft_ctx_t * ctx, const float * signal){
+    uint16_t half = ctx->signal_lenght / 2;
+    // Multiply input array with window
+    dsps_mul_f32(signal, ctx->wind, ctx->buffer, ctx->signal_lenght, 1, 1, 1);
+    // Calculate N/2 points FFT (radix-4 when N/2 is a power of four)
+    if (dsp_power_of_two(half) % 2 == 0){
+        dsps_fft4r_fc32(ctx->buffer, half);
+        dsps_bit_rev4r_fc32(ctx->buffer, half);
+    } else {
+        dsps_fft2r_fc32(ctx->buffer, half);
+        dsps_bit_rev2r_fc32(ctx->buffer, half);
+    }
+    // Split even/odd spectra into the N/2 bins of the real signal
+    dsps_cplx2real_fc32(ctx->buffer, half);
+}
+
+/**
+ * @brief Scale of the magnitude folded into the integer AMBM constants
+ */
+static void AMBMScale(float scale, ambm_scale_t * s){
+    int exponent;
+    // scale = m 2^exponent, 0.5 <= m < 1, so every constant is below 2^15
+    float m = frexpf(scale, &exponent);
+    s->one = (uint32_t)lrintf(m * (1 << (AMBM_Q + 1)));
+    s->alpha = (uint32_t)lrintf(AMBM_ALPHA * m * (1 << (AMBM_Q + 1)));
+    s->beta = (uint32_t)lrintf(AMBM_BETA * m * (1 << (AMBM_Q + 1)));
+    s->exponent = exponent - 1;
+}
+
+/**
+ * @brief Alpha max plus beta min magnitude estimate, times scale
+ * 
+ * max(hi, 0.898 hi + 0.485 lo) * scale, error within +/-2.3%. Done in integers
+ * on the float bits: the 16 bits mantissas of hi and lo (lo aligned to the 
+ * exponent of hi) are weighted by the constants of AMBMScale(), and the sum is
+ * packed back as a float. No float operation is left for targets without FPU.
+ */
+static float MagnitudeAMBM(float re, float im, const ambm_scale_t * s){
+    union {
+        float f;
+        uint32_t i;
+    } hi = {re}, lo = {im}, mag;
+    hi.i &= 0x7FFFFFFF;
+    lo.i &= 0x7FFFFFFF;
+    if (lo.i > hi.i){
+        uint32_t tmp = hi.i;
+        hi.i = lo.i;
+        lo.i = tmp;
+    }
+    int32_t hi_exp = hi.i >> 23;
+    int32_t lo_exp = lo.i >> 23;
+    // Zero and denormals give 0
+    if (hi_exp == 0){
+        return 0;
+    }
+    uint32_t hi_m = ((hi.i & 0x7FFFFF) | 0x800000) >> (24 - AMBM_MANT_BITS);
+    uint32_t lo_m = 0;
+    if (lo_exp > 0 && hi_exp - lo_exp < AMBM_MANT_BITS){
+        lo_m = (((lo.i & 0x7FFFFF) | 0x800000) >> (24 - AMBM_MANT_BITS)) >> (hi_exp - lo_exp);
+    }
+    // Both terms are below 2^31, the sum fits 32 bits unsigned
+    uint32_t sum = s->alpha * hi_m + s->beta * lo_m;
+    uint32_t max = s->one * hi_m;
+    if (sum < max){
+        sum = max;
+    }
+    // sum = 1.f 2^top, value = sum 2^(hi_exp - 127 - 15 - AMBM_Q + exponent)
+    int32_t top = 31 - __builtin_clz(sum);
+    int32_t exp = hi_exp + top - (AMBM_MANT_BITS - 1) - AMBM_Q + s->exponent;
+    if (exp <= 0){
+        return 0;
+    }
+    mag.i = (top > 23) ? (sum >> (top - 23)) : (sum << (23 - top));
+    mag.i = (mag.i & 0x7FFFFF) | ((uint32_t)exp << 23);
+    return mag.f;
+}
+
+/**
+ * @brief Base 2 logarithm of a positive normal float
+ * 
+ * Exponent from the float bits plus log2 of the mantissa, interpolated in a 
+ * 33 entries table (error below 2e-4, 6e-4 dB).
+ */
+static float Log2Table(float x){
+    union {
+        float f;
+        uint32_t i;
+    } bits = {x};
+    int32_t exponent = (int32_t)(bits.i >> 23) - 127;
+    uint32_t mantissa = bits.i & 0x7FFFFF;
+    uint32_t index = mantissa >> (23 - LOG2_TABLE_BITS);
+    float frac = (mantissa & ((1 << (23 - LOG2_TABLE_BITS)) - 1)) * (1.0f / (1 << (23 - LOG2_TABLE_BITS)));
+    return exponent + log2_table[index] + frac * (log2_table[index + 1] - log2_table[index]);
+}
+
+/**
+ * @brief Power in dB (10 log10(power) + offset), FFT_DB_FLOOR for empty bins
+ */
+static float PowerToDB(float power, float offset){
+    if (power < FLT_MIN){
+        return FFT_DB_FLOOR;
+    }
+    float db = DB_PER_OCTAVE * Log2Table(power) + offset;
+    return (db < FFT_DB_FLOOR) ? FFT_DB_FLOOR : db;
+}
 
 /*==================[external functions definition]==========================*/
 bool FFTInit(void){
+    // Contexts may already be reading the tables
+    if (fft_tables_ready){
+        return true;
+    }
+    for (int i = 0; i <= LOG2_TABLE_SIZE; i++){
+        log2_table[i] = log2f(1.0f + (float)i / LOG2_TABLE_SIZE);
+    }
     esp_err_t ret = dsps_fft2r_init_fc32(NULL, CONFIG_DSP_MAX_FFT_SIZE);
     if (ret != ESP_OK){
         return false;
     }
+    // Real FFT of N samples runs as a N/2 points complex FFT
+    ret = dsps_fft4r_init_fc32(NULL, MAX_SIGNAL_LENGHT / 2);
+    if (ret != ESP_OK){
+        return false;
+    }
+    ret = dsps_fft2r_init_sc16(NULL, CONFIG_DSP_MAX_FFT_SIZE);
+    if (ret != ESP_OK){
+        return false;
+    }
+    fft_tables_ready = true;
     return true;
 }
 
 void FFTMagnitude(float * signal, float * fft, uint16_t signal_lenght){
-    // Generate Hann window
-    dsps_wind_hann_f32(wind, signal_lenght);
-    // Clear fft array
-    memset(fft_complex, 0, 2 * MAX_SIGNAL_LENGHT * sizeof(float));
+    // Hann window context, kept while the lenght does not change
+    if (legacy_ctx == NULL || legacy_ctx->signal_lenght != signal_lenght){
+        FFTDelete(legacy_ctx);
+        legacy_ctx = FFTCreate(signal_lenght, FFT_WINDOW_HANN);
+        if (legacy_ctx == NULL){
+            ESP_LOGE(TAG, "Not possible to create FFT of %d points", signal_lenght);
+            return;
+        }
+        // Historic normalization by N/2 instead of the window sum ((N-1)/2)
+        legacy_ctx->scale = 2.0f / signal_lenght;
+    }
+    FFTMagnitudeCtx(legacy_ctx, signal, fft);
+}
+
+void FFTMagnitudeQ15(const uint16_t * signal, uint16_t * fft, uint16_t signal_lenght){
+    // Generate Q15 Hann window (only when the lenght changes)
+    if (wind_q15_lenght != signal_lenght){
+        float len_mult = 1 / (float)(signal_lenght - 1);
+        for (int i = 0; i < signal_lenght; i++){
+            float hann = 0.5f * (1 - cosf(i * 2 * M_PI * len_mult));
+            wind_q15[i] = (int16_t)(hann * Q15_MAX + 0.5f);
+        }
+        wind_q15_lenght = signal_lenght;
+    }
+    // Block floating point: shift samples so the largest one fills 15 bits
+    uint16_t max = 0;
+    for (int i = 0; i < signal_lenght; i++){
+        if (signal[i] > max){
+            max = signal[i];
+        }
+    }
+    int shift = 0;
+    while ((max << shift) <= (Q15_MAX >> 1) && shift < 15){
+        shift++;
+    }
+    int down = (max > Q15_MAX) ? 1 : 0;
     // Multiply input array with window and store as real part
-    dsps_mul_f32(signal, wind, fft_complex, signal_lenght, 1, 1, 2);    
-    // Calculate FFT  
-    dsps_fft2r_fc32(fft_complex, signal_lenght);
+    for (int i = 0; i < signal_lenght; i++){
+        int32_t sample = down ? (signal[i] >> 1) : (signal[i] << shift);
+        fft_complex_q15[i * 2 + 0] = (int16_t)((sample * wind_q15[i] + Q15_ROUND) >> 15);
+        fft_complex_q15[i * 2 + 1] = 0;
+    }
+    shift -= down;
+    // Calculate FFT (each stage scales by 1/2, so the result is X / N)
+    dsps_fft2r_sc16(fft_complex_q15, signal_lenght);
     // Bit reverse
-    dsps_bit_rev_fc32(fft_complex, signal_lenght);
+    dsps_bit_rev_sc16(fft_complex_q15, signal_lenght);
     // Convert one complex vector to two complex vectors
-    dsps_cplx2reC_fc32(fft_complex, signal_lenght);
-    // Calculate FFT magnitude 
-    for (int j = 0; j < signal_lenght; j++){
-            fft_complex[j] = 2*(sqrt(fft_complex[j*2+0]*fft_complex[j*2+0] + fft_complex[j*2+1]*fft_complex[j*2+1])) / (signal_lenght/2);
-    }
-    fft_complex[0] = fft_complex[0] / 2;
-    // Copy result in fft array
-    memcpy(fft, fft_complex, (signal_lenght / 2) * sizeof(float));
+    dsps_cplx2reC_sc16(fft_complex_q15, signal_lenght);
+    // Calculate FFT magnitude, undoing the block exponent: 4 * |X| / 2^shift
+    for (int j = 0; j < signal_lenght / 2; j++){
+        uint32_t mag = MagnitudeQ15(fft_complex_q15[j * 2 + 0], fft_complex_q15[j * 2 + 1]) << 2;
+        if (j == 0){
+            mag >>= 1;
+        }
+        if (shift > 0){
+            mag = (mag + (1 << (shift - 1))) >> shift;
+        } else {
+            mag <<= -shift;
+        }
+        fft[j] = (mag > MAG_MAX) ? MAG_MAX : mag;
+    }
+}
+
+fft_ctx_t * FFTCreate(uint16_t signal_lenght, fft_window_t window_type){
+    if (signal_lenght < 4 || signal_lenght > MAX_SIGNAL_LENGHT || !dsp_is_power_of_two(signal_lenght)){
+        ESP_LOGE(TAG, "Invalid FFT lenght %d", signal_lenght);
+        return NULL;
+    }
+    if (!fft_tables_ready){
+        ESP_LOGE(TAG, "FFTInit not called");
+        return NULL;
+    }
+    // Context, window and work buffer in a single allocation
+    fft_ctx_t * ctx = malloc(sizeof(fft_ctx_t) + 2 * signal_lenght * sizeof(float));
+    if (ctx == NULL){
+        return NULL;
+    }
+    ctx->signal_lenght = signal_lenght;
+    ctx->window_type = window_type;
+    ctx->wind = (float *)(ctx + 1);
+    ctx->buffer = ctx->wind + signal_lenght;
+    switch (window_type){
+        case FFT_WINDOW_BLACKMAN_HARRIS:
+            dsps_wind_blackman_harris_f32(ctx->wind, signal_lenght);
+            break;
+        case FFT_WINDOW_FLAT_TOP:
+            dsps_wind_flat_top_f32(ctx->wind, signal_lenght);
+            break;
+        case FFT_WINDOW_HANN:
+        default:
+            ctx->window_type = FFT_WINDOW_HANN;
+            dsps_wind_hann_f32(ctx->wind, signal_lenght);
+            break;
+    }
+    // Normalize by the window sum, so tone amplitudes do not depend on the window
+    float sum = 0;
+    for (int i = 0; i < signal_lenght; i++){
+        sum += ctx->wind[i];
+    }
+    ctx->scale = 1.0f / sum;
+    return ctx;
+}
+
+void FFTDelete(fft_ctx_t * ctx){
+    free(ctx);
+}
+
+void FFTSpectrumCtx(fft_ctx_t * ctx, const float * signal, float * fft, fft_output_t output){
+    float * buffer = ctx->buffer;
+    uint16_t bins = ctx->signal_lenght / 2;
+    FFTRealCtx(ctx, signal);
+    // Bin 0 is real (DC), the others are single sided (x2) in the units of 
+    // FFTMagnitude (x2)
+    float scale_dc = ctx->scale;
+    float scale = 4 * ctx->scale;
+    switch (output){
+        case FFT_OUTPUT_MAGNITUDE_FAST:
+            fft[0] = buffer[0] * buffer[0] * scale_dc * scale_dc;
+            for (int j = 1; j < bins; j++){
+                fft[j] = (buffer[j*2+0]*buffer[j*2+0] + buffer[j*2+1]*buffer[j*2+1]) * scale * scale;
+            }
+            dsps_sqrt_f32(fft, fft, bins);
+            break;
+        case FFT_OUTPUT_MAGNITUDE_AMBM:
+        {
+            ambm_scale_t ambm;
+            AMBMScale(scale, &ambm);
+            fft[0] = fabsf(buffer[0]) * scale_dc;
+            for (int j = 1; j < bins; j++){
+                fft[j] = MagnitudeAMBM(buffer[j*2+0], buffer[j*2+1], &ambm);
+            }
+            break;
+        }
+        case FFT_OUTPUT_POWER:
+            fft[0] = buffer[0] * buffer[0] * scale_dc * scale_dc;
+            for (int j = 1; j < bins; j++){
+                fft[j] = (buffer[j*2+0]*buffer[j*2+0] + buffer[j*2+1]*buffer[j*2+1]) * scale * scale;
+            }
+            break;
+        case FFT_OUTPUT_DB:
+        {
+            // 10 log10(|X|^2 scale^2) = 10 log10(2) log2(|X|^2) + 20 log10(scale)
+            float offset = 20 * log10f(scale);
+            fft[0] = PowerToDB(buffer[0] * buffer[0], 20 * log10f(scale_dc));
+            for (int j = 1; j < bins; j++){
+                fft[j] = PowerToDB(buffer[j*2+0]*buffer[j*2+0] + buffer[j*2+1]*buffer[j*2+1], offset);
+            }
+            break;
+        }
+        case FFT_OUTPUT_MAGNITUDE:
+        default:
+            fft[0] = fabsf(buffer[0]) * scale_dc;
+            for (int j = 1; j < bins; j++){
+                fft[j] = sqrtf(buffer[j*2+0]*buffer[j*2+0] + buffer[j*2+1]*buffer[j*2+1]) * scale;
+            }
+            break;
+    }
+}
+
+void FFTMagnitudeCtx(fft_ctx_t * ctx, const float * signal, float * fft){
+    FFTSpectrumCtx(ctx, signal, fft, FFT_OUTPUT_MAGNITUDE);
+}
+
+void FFTPowerCtx(fft_ctx_t * ctx, const float * signal, float * fft){
+    FFTSpectrumCtx(ctx, signal, fft, FFT_OUTPUT_POWER);
 }
 
 void FFTFrequency(float sample_freq, uint16_t signal_lenght, float * f){
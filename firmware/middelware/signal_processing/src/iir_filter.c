@@ -10,147 +10,202 @@
  */
 
 /*==================[inclusions]=============================================*/
+#include <math.h>
 #include "iir_filter.h"
 #include "esp_dsp.h"
 /*==================[macros and definitions]=================================*/
-#define N_SOS       5
-#define N_DELAY     2
-// 2nd order Butterworth 
-#define ORDER2_Q    (1 / 1.414)
-// 4th order Butterworth 
-#define ORDER4_Q1   (1 / 0.765)
-#define ORDER4_Q2   (1 / 1.848)
-// 6th order Butterworth 
-#define ORDER6_Q1   (1 / 0.518)
-#define ORDER6_Q2   (1 / 1.414)
-#define ORDER6_Q3   (1 / 1.932)
-// 8th order Butterworth 
-#define ORDER8_Q1   (1 / 0.390)
-#define ORDER8_Q2   (1 / 1.111)
-#define ORDER8_Q3   (1 / 1.663)
-#define ORDER8_Q4   (1 / 1.962)
+#define LEGACY_MAX_ORDER    ORDER_8
 /*==================[internal data declaration]==============================*/
-static uint8_t lp_order, hp_order;
-float hp2_delay[N_DELAY] = {0, 0};  // delay
-float hp4_delay[N_DELAY] = {0, 0};  // delay
-float hp6_delay[N_DELAY] = {0, 0};  // delay
-float hp8_delay[N_DELAY] = {0, 0};  // delay
-float lp2_delay[N_DELAY] = {0, 0};  // delay
-float lp4_delay[N_DELAY] = {0, 0};  // delay
-float lp6_delay[N_DELAY] = {0, 0};  // delay
-float lp8_delay[N_DELAY] = {0, 0};  // delay
-float lp2_sos_coeff[N_SOS]; 
-float lp4_sos_coeff[N_SOS]; 
-float lp6_sos_coeff[N_SOS]; 
-float lp8_sos_coeff[N_SOS]; 
-float hp2_sos_coeff[N_SOS]; 
-float hp4_sos_coeff[N_SOS]; 
-float hp6_sos_coeff[N_SOS]; 
-float hp8_sos_coeff[N_SOS]; 
+IIR_FILTER_DEFINE(lp_filter, LEGACY_MAX_ORDER);
+IIR_FILTER_DEFINE(hp_filter, LEGACY_MAX_ORDER);
 /*==================[internal functions declaration]=========================*/
-
+static uint8_t ButterworthInit(float * sos, filter_type_t type, uint8_t order, float f);
+static void NotchInit(float * sos, float f, float bw);
+static uint8_t CoefWords(iir_kernel_t kernel);
+static int32_t * DelayLine(iir_filter_t * filter);
 /*==================[internal data definition]===============================*/
 
 /*==================[external data definition]===============================*/
 
 /*==================[internal functions definition]==========================*/
+/**
+ * @brief Butterworth low/high pass as order / 2 biquads (plus a first order 
+ * section for odd orders). Returns the number of sections written.
+ */
+static uint8_t ButterworthInit(float * sos, filter_type_t type, uint8_t order, float f){
+    uint8_t n = 0;
+    for (uint8_t k = 1; k <= order / 2; k++, n++){
+        // Pole pair k of the analog prototype
+        float q = 1 / (2 * sinf((2 * k - 1) * M_PI / (2 * order)));
+        if (type == IIR_LOW_PASS){
+            dsps_biquad_gen_lpf_f32(&sos[n * IIR_SOS_SIZE], f, q);
+        } else {
+            dsps_biquad_gen_hpf_f32(&sos[n * IIR_SOS_SIZE], f, q);
+        }
+    }
+    if (order % 2){
+        // Real pole, bilinear transform
+        float k = tanf(M_PI * f);
+        float * c = &sos[n * IIR_SOS_SIZE];
+        c[0] = (type == IIR_LOW_PASS) ? k / (k + 1) : 1 / (k + 1);
+        c[1] = (type == IIR_LOW_PASS) ? c[0] : -c[0];
+        c[2] = 0;
+        c[3] = (k - 1) / (k + 1);
+        c[4] = 0;
+        n++;
+    }
+    return n;
+}
 
-/*==================[external functions definition]==========================*/
+/**
+ * @brief Notch biquad with zeros on the unit circle at f and -3 dB width bw
+ */
+static void NotchInit(float * sos, float f, float bw){
+    float w0 = 2 * M_PI * f;
+    float alpha = sinf(w0) * bw / (2 * f);
+    float a0 = 1 + alpha;
+    sos[0] = 1 / a0;
+    sos[1] = -2 * cosf(w0) / a0;
+    sos[2] = 1 / a0;
+    sos[3] = -2 * cosf(w0) / a0;
+    sos[4] = (1 - alpha) / a0;
+}
 
-void LowPassInit(float sample_frec, float cut_frec, filter_order_t order){
+/**
+ * @brief 32 bits words taken by the coefficients of one section
+ */
+static uint8_t CoefWords(iir_kernel_t kernel){
+    return (kernel == IIR_S16) ? (IIR_SOS_SIZE + 1) / 2 : IIR_SOS_SIZE;
+}
+
+/**
+ * @brief Delay lines start right after the coefficients of all sections
+ */
+static int32_t * DelayLine(iir_filter_t * filter){
+    return &filter->storage[filter->n_sections * CoefWords(filter->kernel)];
+}
+
+/*==================[external functions definition]==========================*/
+bool IirInit(iir_filter_t * filter, filter_type_t type, uint8_t order, float sample_frec, float cut_frec, float cut_frec2){
     float f = cut_frec / sample_frec;
-    lp_order = order;
-    switch(lp_order){
-        case ORDER_2:
-            dsps_biquad_gen_lpf_f32(lp2_sos_coeff, f, ORDER2_Q);
-        break;
-        case ORDER_4:
-            dsps_biquad_gen_lpf_f32(lp2_sos_coeff, f, ORDER4_Q1);
-            dsps_biquad_gen_lpf_f32(lp4_sos_coeff, f, ORDER4_Q2);
+    float f2 = cut_frec2 / sample_frec;
+    uint8_t sections;
+    if (order == 0 || f <= 0 || f >= 0.5){
+        return false;
+    }
+    switch (type){
+        case IIR_LOW_PASS:
+        case IIR_HIGH_PASS:
+            sections = (order + 1) / 2;
+        break;
+        case IIR_BAND_PASS:
+            if (order % 2 || f2 <= f || f2 >= 0.5){
+                return false;
+            }
+            sections = 2 * ((order / 2 + 1) / 2);
+        break;
+        case IIR_NOTCH:
+            if (order % 2 || f2 <= 0 || f2 >= 0.5){
+                return false;
+            }
+            sections = order / 2;
+        break;
+        default:
+            return false;
+    }
+    if (sections * IIR_SECTION_WORDS(filter->kernel) > filter->storage_size){
+        return false;
+    }
+    // Fixed point filters are designed in the delay line area, then quantized
+    float * sos = (float *)&filter->storage[sections * CoefWords(filter->kernel)];
+    if (filter->kernel == IIR_F32){
+        sos = (float *)filter->storage;
+    }
+    switch (type){
+        case IIR_LOW_PASS:
+        case IIR_HIGH_PASS:
+            ButterworthInit(sos, type, order, f);
         break;
-        case ORDER_6:
-            dsps_biquad_gen_lpf_f32(lp2_sos_coeff, f, ORDER6_Q1);
-            dsps_biquad_gen_lpf_f32(lp4_sos_coeff, f, ORDER6_Q2);
-            dsps_biquad_gen_lpf_f32(lp6_sos_coeff, f, ORDER6_Q3);
+        case IIR_BAND_PASS:
+            sections = ButterworthInit(sos, IIR_HIGH_PASS, order / 2, f);
+            ButterworthInit(&sos[sections * IIR_SOS_SIZE], IIR_LOW_PASS, order / 2, f2);
+            sections *= 2;
         break;
-        case ORDER_8:
-            dsps_biquad_gen_lpf_f32(lp2_sos_coeff, f, ORDER8_Q1);
-            dsps_biquad_gen_lpf_f32(lp4_sos_coeff, f, ORDER8_Q2);
-            dsps_biquad_gen_lpf_f32(lp6_sos_coeff, f, ORDER8_Q3);
-            dsps_biquad_gen_lpf_f32(lp8_sos_coeff, f, ORDER8_Q4);
+        case IIR_NOTCH:
+            for (uint8_t i = 0; i < sections; i++){
+                NotchInit(&sos[i * IIR_SOS_SIZE], f, f2);
+            }
         break;
     }
+    esp_err_t ret = ESP_OK;
+    if (filter->kernel == IIR_S16){
+        ret = dsps_biquad_coef_s16(sos, (int16_t *)filter->storage, sections);
+    } else if (filter->kernel == IIR_S32){
+        ret = dsps_biquad_coef_s32(sos, filter->storage, sections);
+    }
+    if (ret != ESP_OK){
+        filter->n_sections = 0;
+        return false;
+    }
+    filter->n_sections = sections;
+    IirReset(filter);
+    return true;
 }
 
-void HiPassInit(float sample_frec, float cut_frec, filter_order_t order){
-    float f = cut_frec / sample_frec;
-    hp_order = order;
-    switch(hp_order){
-        case ORDER_2:
-            dsps_biquad_gen_hpf_f32(hp2_sos_coeff, f, ORDER2_Q);
-        break;
-        case ORDER_4:
-            dsps_biquad_gen_hpf_f32(hp2_sos_coeff, f, ORDER4_Q1);
-            dsps_biquad_gen_hpf_f32(hp4_sos_coeff, f, ORDER4_Q2);
-        break;
-        case ORDER_6:
-            dsps_biquad_gen_hpf_f32(hp2_sos_coeff, f, ORDER6_Q1);
-            dsps_biquad_gen_hpf_f32(hp4_sos_coeff, f, ORDER6_Q2);
-            dsps_biquad_gen_hpf_f32(hp6_sos_coeff, f, ORDER6_Q3);
-        break;
-        case ORDER_8:
-            dsps_biquad_gen_hpf_f32(hp2_sos_coeff, f, ORDER8_Q1);
-            dsps_biquad_gen_hpf_f32(hp4_sos_coeff, f, ORDER8_Q2);
-            dsps_biquad_gen_hpf_f32(hp6_sos_coeff, f, ORDER8_Q3);
-            dsps_biquad_gen_hpf_f32(hp8_sos_coeff, f, ORDER8_Q4);
-        break;
+void IirReset(iir_filter_t * filter){
+    int32_t * delay = DelayLine(filter);
+    for (int32_t * end = &filter->storage[filter->storage_size]; delay < end; delay++){
+        *delay = 0;
     }
 }
 
-void LowPassFilter(float * input_signal, float * output_signal, int16_t signal_lenght){
-    switch(lp_order){
-        case ORDER_2:
-            dsps_biquad_f32(input_signal, output_signal, signal_lenght, lp2_sos_coeff, lp2_delay);
-        break;
-        case ORDER_4:
-            dsps_biquad_f32(input_signal, output_signal, signal_lenght, lp2_sos_coeff, lp2_delay);
-            dsps_biquad_f32(output_signal, output_signal, signal_lenght, lp4_sos_coeff, lp4_delay);
-        break;
-        case ORDER_6:
-            dsps_biquad_f32(input_signal, output_signal, signal_lenght, lp2_sos_coeff, lp2_delay);
-            dsps_biquad_f32(output_signal, output_signal, signal_lenght, lp4_sos_coeff, lp4_delay);
-            dsps_biquad_f32(output_signal, output_signal, signal_lenght, lp6_sos_coeff, lp6_delay);
-        break;
-        case ORDER_8:
-            dsps_biquad_f32(input_signal, output_signal, signal_lenght, lp2_sos_coeff, lp2_delay);
-            dsps_biquad_f32(output_signal, output_signal, signal_lenght, lp4_sos_coeff, lp4_delay);
-            dsps_biquad_f32(output_signal, output_signal, signal_lenght, lp6_sos_coeff, lp6_delay);
-            dsps_biquad_f32(output_signal, output_signal, signal_lenght, lp8_sos_coeff, lp8_delay);
-        break;
+void IirFilter(iir_filter_t * filter, float * input_signal, float * output_signal, int16_t signal_lenght){
+    if (filter == NULL || filter->kernel != IIR_F32){
+        return;
     }
+    float * sos = (float *)filter->storage;
+    float * delay = (float *)DelayLine(filter);
+    dsps_biquad_cascade_f32(input_signal, output_signal, signal_lenght, sos, delay, filter->n_sections);
 }
 
-void HiPassFilter(float * input_signal, float * output_signal, int16_t signal_lenght){
-    switch(hp_order){
-        case ORDER_2:
-            dsps_biquad_f32(input_signal, output_signal, signal_lenght, hp2_sos_coeff, hp2_delay);
-        break;
-        case ORDER_4:
-            dsps_biquad_f32(input_signal, output_signal, signal_lenght, hp2_sos_coeff, hp2_delay);
-            dsps_biquad_f32(output_signal, output_signal, signal_lenght, hp4_sos_coeff, hp4_delay);
-        break;
-        case ORDER_6:
-            dsps_biquad_f32(input_signal, output_signal, signal_lenght, hp2_sos_coeff, hp2_delay);
-            dsps_biquad_f32(output_signal, output_signal, signal_lenght, hp4_sos_coeff, hp4_delay);
-            dsps_biquad_f32(output_signal, output_signal, signal_lenght, hp6_sos_coeff, hp6_delay);
-        break;
-        case ORDER_8:
-            dsps_biquad_f32(input_signal, output_signal, signal_lenght, hp2_sos_coeff, hp2_delay);
-            dsps_biquad_f32(output_signal, output_signal, signal_lenght, hp4_sos_coeff, hp4_delay);
-            dsps_biquad_f32(output_signal, output_signal, signal_lenght, hp6_sos_coeff, hp6_delay);
-            dsps_biquad_f32(output_signal, output_signal, signal_lenght, hp8_sos_coeff, hp8_delay);
-        break;
+void IirFilterS16(iir_filter_t * filter, const int16_t * input_signal, int16_t * output_signal, int16_t signal_lenght){
+    if (filter == NULL || filter->kernel != IIR_S16 || filter->n_sections == 0){
+        return;
+    }
+    const int16_t * sos = (const int16_t *)filter->storage;
+    int32_t * delay = DelayLine(filter);
+    dsps_biquad_s16(input_signal, output_signal, signal_lenght, sos, delay);
+    for (uint8_t i = 1; i < filter->n_sections; i++){
+        dsps_biquad_s16(output_signal, output_signal, signal_lenght, &sos[i * IIR_SOS_SIZE], &delay[i * IIR_FX_DELAY_SIZE]);
+    }
+}
+
+void IirFilterS32(iir_filter_t * filter, const int32_t * input_signal, int32_t * output_signal, int16_t signal_lenght){
+    if (filter == NULL || filter->kernel != IIR_S32 || filter->n_sections == 0){
+        return;
     }
+    const int32_t * sos = filter->storage;
+    int32_t * delay = DelayLine(filter);
+    dsps_biquad_s32(input_signal, output_signal, signal_lenght, sos, delay);
+    for (uint8_t i = 1; i < filter->n_sections; i++){
+        dsps_biquad_s32(output_signal, output_signal, signal_lenght, &sos[i * IIR_SOS_SIZE], &delay[i * IIR_FX_DELAY_SIZE]);
+    }
+}
+
+void LowPassInit(float sample_frec, float cut_frec, filter_order_t order){
+    IirInit(&lp_filter, IIR_LOW_PASS, order, sample_frec, cut_frec, 0);
+}
+
+void HiPassInit(float sample_frec, float cut_frec, filter_order_t order){
+    IirInit(&hp_filter, IIR_HIGH_PASS, order, sample_frec, cut_frec, 0);
+}
+
+void LowPassFilter(float * input_signal, float * output_signal, int16_t signal_lenght){
+    IirFilter(&lp_filter, input_signal, output_signal, signal_lenght);
+}
+
+void HiPassFilter(float * input_signal, float * output_signal, int16_t signal_lenght){
+    IirFilter(&hp_filter, input_signal, output_signal, signal_lenght);
 }
 
 /*==================[end of file]============================================*/
\ No newline at end of file
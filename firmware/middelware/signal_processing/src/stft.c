@@ -0,0 +1,156 @@
+/**
+ * @file stft.c
+ * @brief Streaming short time Fourier transform
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdlib.h>
+#include <string.h>
+#include "stft.h"
+#include "esp_log.h"
+/*==================[macros and definitions]=================================*/
+#define TAG "STFT Module"
+/*==================[internal data declaration]==============================*/
+
+/*==================[internal functions declaration]=========================*/
+static void StftFrame(stft_t * stft);
+
+/*==================[internal data definition]===============================*/
+
+/*==================[external data definition]===============================*/
+
+/*==================[internal functions definition]==========================*/
+/**
+ * @brief Transform the frame buffer, update the averages and keep the overlap
+ */
+static void StftFrame(stft_t * stft){
+    uint16_t lenght = stft->config.frame_lenght;
+    uint16_t bins = lenght / 2;
+    // Power spectrum straight into the next spectrogram row
+    if (stft->config.spectrogram_frames > 0){
+        stft->head = (stft->head + 1) % stft->config.spectrogram_frames;
+        stft->power = stft->spectrogram + stft->head * bins;
+    }
+    FFTPowerCtx(stft->fft, stft->frame, stft->power);
+    stft->frames++;
+    // Averages
+    float alpha = 0;
+    switch (stft->config.average){
+        case STFT_AVERAGE_EXPONENTIAL:
+            alpha = (stft->frames == 1) ? 1.0f : stft->config.alpha;
+            break;
+        case STFT_AVERAGE_WELCH:
+            alpha = 1.0f / stft->frames;
+            break;
+        case STFT_AVERAGE_NONE:
+        default:
+            break;
+    }
+    if (alpha > 0){
+        for (int i = 0; i < bins; i++){
+            stft->average[i] += alpha * (stft->power[i] - stft->average[i]);
+        }
+    }
+    // Keep the last frame_lenght - hop samples for the next frame
+    memmove(stft->frame, stft->frame + stft->config.hop, (lenght - stft->config.hop) * sizeof(float));
+    stft->fill = lenght - stft->config.hop;
+}
+
+/*==================[external functions definition]==========================*/
+stft_t * StftCreate(const stft_config_t * config){
+    uint16_t lenght = config->frame_lenght;
+    if (config->hop == 0 || config->hop > lenght){
+        ESP_LOGE(TAG, "Invalid hop %d", config->hop);
+        return NULL;
+    }
+    if (config->average == STFT_AVERAGE_EXPONENTIAL && (config->alpha <= 0 || config->alpha > 1)){
+        ESP_LOGE(TAG, "Invalid averaging factor");
+        return NULL;
+    }
+    fft_ctx_t * fft = FFTCreate(lenght, config->window_type);
+    if (fft == NULL){
+        return NULL;
+    }
+    // Context, frame, average and spectrogram (at least one row for the 
+    // last power) in a single allocation
+    uint16_t bins = lenght / 2;
+    uint16_t rows = (config->spectrogram_frames > 0) ? config->spectrogram_frames : 1;
+    size_t floats = lenght + bins + rows * bins;
+    stft_t * stft = malloc(sizeof(stft_t) + floats * sizeof(float));
+    if (stft == NULL){
+        FFTDelete(fft);
+        return NULL;
+    }
+    stft->config = *config;
+    stft->fft = fft;
+    stft->frame = (float *)(stft + 1);
+    stft->average = stft->frame + lenght;
+    stft->spectrogram = stft->average + bins;
+    StftReset(stft);
+    return stft;
+}
+
+void StftDelete(stft_t * stft){
+    if (stft != NULL){
+        FFTDelete(stft->fft);
+        free(stft);
+    }
+}
+
+void StftReset(stft_t * stft){
+    uint16_t bins = stft->config.frame_lenght / 2;
+    stft->fill = 0;
+    stft->frames = 0;
+    // Without spectrogram the last power is kept in a single row
+    stft->head = 0;
+    stft->power = stft->spectrogram;
+    memset(stft->average, 0, bins * sizeof(float));
+    if (stft->config.spectrogram_frames > 0){
+        stft->head = stft->config.spectrogram_frames - 1;
+        stft->power = stft->spectrogram + stft->head * bins;
+    }
+}
+
+uint16_t StftPush(stft_t * stft, const float * samples, uint16_t lenght){
+    uint16_t frames = 0;
+    while (lenght > 0){
+        // Copy as many samples as the frame takes
+        uint16_t n = stft->config.frame_lenght - stft->fill;
+        if (n > lenght){
+            n = lenght;
+        }
+        memcpy(stft->frame + stft->fill, samples, n * sizeof(float));
+        stft->fill += n;
+        samples += n;
+        lenght -= n;
+        if (stft->fill == stft->config.frame_lenght){
+            StftFrame(stft);
+            frames++;
+        }
+    }
+    return frames;
+}
+
+float * StftAverage(stft_t * stft){
+    if (stft->frames == 0){
+        return NULL;
+    }
+    if (stft->config.average == STFT_AVERAGE_NONE){
+        return stft->power;
+    }
+    return stft->average;
+}
+
+float * StftSpectrogram(stft_t * stft, uint16_t age){
+    uint16_t rows = stft->config.spectrogram_frames;
+    if (age >= rows || age >= stft->frames){
+        return NULL;
+    }
+    uint16_t row = (stft->head + rows - age) % rows;
+    return stft->spectrogram + row * (stft->config.frame_lenght / 2);
+}
+
+/*==================[end of file]============================================*/
@@ -0,0 +1,263 @@
+/**
+ * @file tone_detector.c
+ * @brief Bank of single frequency detectors (Goertzel / sliding DFT)
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "tone_detector.h"
+#include "esp_log.h"
+/*==================[macros and definitions]=================================*/
+#define TAG "Tone Detector"
+#define GOERTZEL_Q          29
+#define SDFT_Q              30
+#define SDFT_GUARD_BITS     4           /* Fractional bits of the Q15 sliding DFT state */
+#define Q31_MAX             2147483647.0
+/*==================[internal data declaration]==============================*/
+
+/*==================[internal functions declaration]=========================*/
+static void Detect(tone_detector_t * detector, uint8_t bin, bool above_on, bool below_off);
+static void GoertzelEnd(tone_detector_t * detector);
+
+/*==================[internal data definition]===============================*/
+
+/*==================[external data definition]===============================*/
+
+/*==================[internal functions definition]==========================*/
+/**
+ * @brief Hysteresis of a bin, calls the callback on changes
+ */
+static void Detect(tone_detector_t * detector, uint8_t bin, bool above_on, bool below_off){
+    tone_bin_t * b = &detector->bins[bin];
+    if ((!b->detected && above_on) || (b->detected && below_off)){
+        b->detected = !b->detected;
+        if (detector->config.func_p != NULL){
+            detector->config.func_p(bin, b->detected, ToneDetectorLevel(detector, bin), detector->config.param_p);
+        }
+    }
+}
+
+/**
+ * @brief End of a Goertzel block: power of each bin, detection and states cleared
+ *
+ * |X|^2 = s1^2 + s2^2 - 2 cos(w) s1 s2
+ */
+static void GoertzelEnd(tone_detector_t * detector){
+    for (uint8_t i = 0; i < detector->config.n_bins; i++){
+        tone_bin_t * b = &detector->bins[i];
+        float s1, s2;
+        if (detector->config.kernel == TONE_Q15){
+            s1 = b->state_q[0];
+            s2 = b->state_q[1];
+            b->state_q[0] = 0;
+            b->state_q[1] = 0;
+        } else {
+            s1 = b->state[0];
+            s2 = b->state[1];
+            b->state[0] = 0;
+            b->state[1] = 0;
+        }
+        b->power = s1 * s1 + s2 * s2 - b->coef[0] * s1 * s2;
+        if (b->power < 0){
+            b->power = 0;
+        }
+        Detect(detector, i, b->power >= b->threshold[0], b->power < b->threshold[1]);
+    }
+    detector->index = 0;
+}
+
+/*==================[external functions definition]==========================*/
+tone_detector_t * ToneDetectorCreate(const tone_detector_config_t * config){
+    uint16_t n = config->window_lenght;
+    if (n < 2 || config->n_bins == 0 || config->sample_freq <= 0){
+        ESP_LOGE(TAG, "Invalid configuration");
+        return NULL;
+    }
+    // Detector, bins and delay line (sliding DFT) in a single allocation
+    size_t size = sizeof(tone_detector_t) + config->n_bins * sizeof(tone_bin_t);
+    if (config->mode == TONE_SLIDING){
+        size += n * ((config->kernel == TONE_Q15) ? sizeof(int16_t) : sizeof(float));
+    }
+    tone_detector_t * detector = malloc(size);
+    if (detector == NULL){
+        return NULL;
+    }
+    detector->config = *config;
+    detector->bins = (tone_bin_t *)(detector + 1);
+    detector->delay = (float *)(detector->bins + config->n_bins);
+    detector->delay_q15 = (int16_t *)detector->delay;
+    // Squared amplitude per unit of filter power: a tone on a bin gives
+    // |X| = a/2 * sum of the window weights (N, or r + r^2 + ... + r^N)
+    double r = TONE_SDFT_DAMPING;
+    double weight = n;
+    if (config->mode == TONE_SLIDING){
+        weight = r * (1 - pow(r, n)) / (1 - r);
+        detector->damping_n = pow(r, n);
+        detector->damping_n_q = (int32_t)(detector->damping_n * (1 << SDFT_Q) + 0.5);
+    }
+    detector->norm = 4 / (weight * weight);
+
+    for (uint8_t i = 0; i < config->n_bins; i++){
+        tone_bin_t * b = &detector->bins[i];
+        b->config = config->bins[i];
+        if (b->config.threshold_off > b->config.threshold_on){
+            ESP_LOGE(TAG, "Bin %d: threshold_off above threshold_on", i);
+            free(detector);
+            return NULL;
+        }
+        double w = 2 * M_PI * b->config.frequency / config->sample_freq;
+        if (config->mode == TONE_SLIDING){
+            // Q15 states grow up to N * 32768 << SDFT_GUARD_BITS
+            if (config->kernel == TONE_Q15 && ((double)n * 32768 * (1 << SDFT_GUARD_BITS)) > Q31_MAX){
+                ESP_LOGE(TAG, "Window too long for Q15 sliding DFT");
+                free(detector);
+                return NULL;
+            }
+            // Bin centered frequency, so the comb cancels the old samples
+            w = 2 * M_PI * round(w * n / (2 * M_PI)) / n;
+            b->coef[0] = r * cos(w);
+            b->coef[1] = r * sin(w);
+            b->coef_q[0] = (int32_t)round(r * cos(w) * (1 << SDFT_Q));
+            b->coef_q[1] = (int32_t)round(r * sin(w) * (1 << SDFT_Q));
+        } else {
+            b->coef[0] = 2 * cos(w);
+            b->coef[1] = 0;
+            b->coef_q[0] = (int32_t)round(2 * cos(w) * (1 << GOERTZEL_Q));
+            b->coef_q[1] = 0;
+            // Goertzel states grow up to N * 32768 / |sin(w)|
+            if (config->kernel == TONE_Q15 && n * 32768.0 / fabs(sin(w)) > Q31_MAX){
+                ESP_LOGE(TAG, "Bin %d: window too long for Q15 at %.1f Hz", i, b->config.frequency);
+                free(detector);
+                return NULL;
+            }
+        }
+        b->threshold[0] = b->config.threshold_on * b->config.threshold_on / detector->norm;
+        b->threshold[1] = b->config.threshold_off * b->config.threshold_off / detector->norm;
+        b->threshold_q[0] = (int64_t)(b->threshold[0] * (1 << (2 * SDFT_GUARD_BITS)));
+        b->threshold_q[1] = (int64_t)(b->threshold[1] * (1 << (2 * SDFT_GUARD_BITS)));
+    }
+    ToneDetectorReset(detector);
+    return detector;
+}
+
+void ToneDetectorDelete(tone_detector_t * detector){
+    free(detector);
+}
+
+void ToneDetectorReset(tone_detector_t * detector){
+    uint16_t n = detector->config.window_lenght;
+    for (uint8_t i = 0; i < detector->config.n_bins; i++){
+        tone_bin_t * b = &detector->bins[i];
+        memset(b->state, 0, sizeof(b->state));
+        memset(b->state_q, 0, sizeof(b->state_q));
+        b->power = 0;
+        b->power_q = 0;
+        b->detected = false;
+    }
+    detector->index = 0;
+    if (detector->config.mode == TONE_SLIDING){
+        if (detector->config.kernel == TONE_Q15){
+            memset(detector->delay_q15, 0, n * sizeof(int16_t));
+        } else {
+            memset(detector->delay, 0, n * sizeof(float));
+        }
+    }
+}
+
+void ToneDetectorPush(tone_detector_t * detector, const float * samples, uint16_t lenght){
+    uint8_t n_bins = detector->config.n_bins;
+    uint16_t n = detector->config.window_lenght;
+    if (detector->config.kernel != TONE_F32){
+        return;
+    }
+    for (uint16_t j = 0; j < lenght; j++){
+        float x = samples[j];
+        if (detector->config.mode == TONE_GOERTZEL){
+            // s[n] = x[n] + 2 cos(w) s[n-1] - s[n-2]
+            for (uint8_t i = 0; i < n_bins; i++){
+                tone_bin_t * b = &detector->bins[i];
+                float s = x + b->coef[0] * b->state[0] - b->state[1];
+                b->state[1] = b->state[0];
+                b->state[0] = s;
+            }
+            if (++detector->index == n){
+                GoertzelEnd(detector);
+            }
+        } else {
+            // S[n] = r e^jw (S[n-1] + x[n] - r^N x[n-N])
+            float delta = x - detector->damping_n * detector->delay[detector->index];
+            detector->delay[detector->index] = x;
+            if (++detector->index == n){
+                detector->index = 0;
+            }
+            for (uint8_t i = 0; i < n_bins; i++){
+                tone_bin_t * b = &detector->bins[i];
+                float re = b->state[0] + delta;
+                float im = b->state[1];
+                b->state[0] = re * b->coef[0] - im * b->coef[1];
+                b->state[1] = re * b->coef[1] + im * b->coef[0];
+                b->power = b->state[0] * b->state[0] + b->state[1] * b->state[1];
+                Detect(detector, i, b->power >= b->threshold[0], b->power < b->threshold[1]);
+            }
+        }
+    }
+}
+
+void ToneDetectorPushQ15(tone_detector_t * detector, const int16_t * samples, uint16_t lenght){
+    uint8_t n_bins = detector->config.n_bins;
+    uint16_t n = detector->config.window_lenght;
+    if (detector->config.kernel != TONE_Q15){
+        return;
+    }
+    for (uint16_t j = 0; j < lenght; j++){
+        int32_t x = samples[j];
+        if (detector->config.mode == TONE_GOERTZEL){
+            for (uint8_t i = 0; i < n_bins; i++){
+                tone_bin_t * b = &detector->bins[i];
+                int64_t acc = (int64_t)b->coef_q[0] * b->state_q[0] + (1 << (GOERTZEL_Q - 1));
+                int32_t s = x + (int32_t)(acc >> GOERTZEL_Q) - b->state_q[1];
+                b->state_q[1] = b->state_q[0];
+                b->state_q[0] = s;
+            }
+            if (++detector->index == n){
+                GoertzelEnd(detector);
+            }
+        } else {
+            int64_t old = (int64_t)detector->damping_n_q * detector->delay_q15[detector->index];
+            int32_t delta = x * (1 << SDFT_GUARD_BITS) - (int32_t)((old + (1 << (SDFT_Q - SDFT_GUARD_BITS - 1))) >> (SDFT_Q - SDFT_GUARD_BITS));
+            detector->delay_q15[detector->index] = x;
+            if (++detector->index == n){
+                detector->index = 0;
+            }
+            for (uint8_t i = 0; i < n_bins; i++){
+                tone_bin_t * b = &detector->bins[i];
+                int64_t re = b->state_q[0] + delta;
+                int64_t im = b->state_q[1];
+                b->state_q[0] = (int32_t)((re * b->coef_q[0] - im * b->coef_q[1] + (1 << (SDFT_Q - 1))) >> SDFT_Q);
+                b->state_q[1] = (int32_t)((re * b->coef_q[1] + im * b->coef_q[0] + (1 << (SDFT_Q - 1))) >> SDFT_Q);
+                b->power_q = (int64_t)b->state_q[0] * b->state_q[0] + (int64_t)b->state_q[1] * b->state_q[1];
+                Detect(detector, i, b->power_q >= b->threshold_q[0], b->power_q < b->threshold_q[1]);
+            }
+        }
+    }
+}
+
+float ToneDetectorLevel(tone_detector_t * detector, uint8_t bin){
+    tone_bin_t * b = &detector->bins[bin];
+    float power = b->power;
+    if (detector->config.kernel == TONE_Q15 && detector->config.mode == TONE_SLIDING){
+        power = (float)b->power_q / (1 << (2 * SDFT_GUARD_BITS));
+    }
+    return sqrtf(power * detector->norm);
+}
+
+bool ToneDetectorState(tone_detector_t * detector, uint8_t bin){
+    return detector->bins[bin].detected;
+}
+
+/*==================[end of file]============================================*/
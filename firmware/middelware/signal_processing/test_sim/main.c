@@ -0,0 +1,36 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+int test_fft_real();
+int test_fft_ctx();
+int test_fft_output();
+int test_stft();
+int test_tone_detector();
+int test_resample();
+int test_fir();
+int test_fft_q15();
+int test_iir_handles();
+int test_iir_cascade();
+int test_iir_fixed();
+int test_conv_fft();
+
+int main(void)
+{
+    int errors = 0;
+    printf("main starts!\n");
+    errors += test_fft_real();
+    errors += test_fft_ctx();
+    errors += test_fft_output();
+    errors += test_stft();
+    errors += test_tone_detector();
+    errors += test_resample();
+    errors += test_fir();
+    errors += test_fft_q15();
+    errors += test_iir_handles();
+    errors += test_iir_cascade();
+    errors += test_iir_fixed();
+    errors += test_conv_fft();
+
+    printf("Test done, %i error(s)\n", errors);
+    return errors != 0;
+}
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "dsps_conv.h"
+#include "dsps_corr.h"
+#include "dsps_fft2r.h"
+#include "dsp_common.h"
+
+#define MAX_LENGHT      8192
+#define BENCH_SIGNAL    2048
+
+static float sig[MAX_LENGHT];
+static float kern[MAX_LENGHT];
+static float out_direct[2 * MAX_LENGHT];
+static float out_fft[2 * MAX_LENGHT];
+
+static void Random(float *x, int len)
+{
+    for (int i = 0; i < len; i++) {
+        x[i] = (rand() % 2001 - 1000) / 1000.0f;
+    }
+}
+
+// Largest difference, relative to the largest direct result
+static float Compare(const float *a, const float *b, int len)
+{
+    float max = 0, err = 0;
+    for (int i = 0; i < len; i++) {
+        max = fmaxf(max, fabsf(a[i]));
+        err = fmaxf(err, fabsf(a[i] - b[i]));
+    }
+    return err / max;
+}
+
+// Time per call (ns) of both methods for one size
+static void Bench(int siglen, int kernlen, int reps, uint32_t *direct, uint32_t *fft)
+{
+    uint32_t start = dsp_get_cpu_cycle_count();
+    for (int r = 0; r < reps; r++) {
+        dsps_conv_f32(sig, siglen, kern, kernlen, out_direct);
+    }
+    *direct = (dsp_get_cpu_cycle_count() - start) / reps;
+    start = dsp_get_cpu_cycle_count();
+    for (int r = 0; r < reps; r++) {
+        dsps_conv_fft_f32(sig, siglen, kern, kernlen, out_fft);
+    }
+    *fft = (dsp_get_cpu_cycle_count() - start) / reps;
+}
+
+int test_conv_fft()
+{
+    int errors = 0;
+    dsps_fft2r_init_fc32(NULL, CONFIG_DSP_MAX_FFT_SIZE);
+    Random(sig, MAX_LENGHT);
+    Random(kern, MAX_LENGHT);
+
+    // Same result as the direct loops, single block and overlap-add
+    const int sizes[][2] = {{100, 7}, {7, 100}, {1000, 64}, {5000, 300}, {8192, 2048}, {2048, 2048}, {300, 1}};
+    for (int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int siglen = sizes[s][0], kernlen = sizes[s][1];
+        dsps_conv_f32_ansi(sig, siglen, kern, kernlen, out_direct);
+        esp_err_t ret = dsps_conv_fft_f32(sig, siglen, kern, kernlen, out_fft);
+        float conv_err = Compare(out_direct, out_fft, siglen + kernlen - 1);
+        float corr_err = 0;
+        if (siglen >= kernlen) {
+            dsps_corr_f32_ansi(sig, siglen, kern, kernlen, out_direct);
+            ret |= dsps_corr_fft_f32(sig, siglen, kern, kernlen, out_fft);
+            corr_err = Compare(out_direct, out_fft, siglen - kernlen + 1);
+        }
+        if (ret != ESP_OK || conv_err > 1e-5f || corr_err > 1e-5f) {
+            printf("FFT conv/corr %i x %i: error %i, relative error %g / %g\n", siglen, kernlen, ret, conv_err, corr_err);
+            errors++;
+        }
+    }
+
+    // Crossover between the direct loop and the FFT
+    printf("Convolution of %i samples, direct vs FFT:\n", BENCH_SIGNAL);
+    int crossover = 0;
+    for (int kernlen = 8; kernlen <= 2048; kernlen *= 2) {
+        uint32_t direct, fft;
+        Bench(BENCH_SIGNAL, kernlen, 20, &direct, &fft);
+        printf("  kernel %4i: direct %8u ns, FFT %7u ns (x%.1f)\n", kernlen, direct, fft, (float)direct / fft);
+        if (!crossover && fft < direct) {
+            crossover = kernlen;
+        }
+    }
+    for (int kernlen = crossover / 2; kernlen <= crossover; kernlen += crossover / 8) {
+        uint32_t direct, fft;
+        Bench(BENCH_SIGNAL, kernlen, 50, &direct, &fft);
+        printf("  kernel %4i: direct %8u ns, FFT %7u ns\n", kernlen, direct, fft);
+    }
+    printf("  DSPS_CONV_FFT_MIN_LEN = %i\n", DSPS_CONV_FFT_MIN_LEN);
+
+    // The dispatcher picks a valid method for short and long kernels
+    for (int kernlen = 4; kernlen <= 1024; kernlen *= 4) {
+        dsps_corr_f32_ansi(sig, 4096, kern, kernlen, out_direct);
+        dsps_corr_auto_f32(sig, 4096, kern, kernlen, out_fft);
+        if (Compare(out_direct, out_fft, 4096 - kernlen + 1) > 1e-5f) {
+            printf("dsps_corr_auto_f32 differs for a %i pattern\n", kernlen);
+            errors++;
+        }
+    }
+
+    printf("FFT convolution: %i error(s)\n", errors);
+    return errors;
+}
@@ -0,0 +1,355 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "fft.h"
+#include "dsp_common.h"
+#include "dsps_fft2r.h"
+#include "dsps_wind_hann.h"
+
+#define CTX_LENGHT      512
+
+#define ADC_FULL_SCALE  4095
+#define N_BENCH         200
+
+static float signal_f[MAX_SIGNAL_LENGHT];
+static uint16_t signal_adc[MAX_SIGNAL_LENGHT];
+static float mag_f[MAX_SIGNAL_LENGHT / 2];
+static uint16_t mag_q15[MAX_SIGNAL_LENGHT / 2];
+static float mag_ref[MAX_SIGNAL_LENGHT / 2];
+static float ref_wind[MAX_SIGNAL_LENGHT];
+static float ref_complex[2 * MAX_SIGNAL_LENGHT];
+static float mag_ctx[MAX_SIGNAL_LENGHT / 2];
+static float pow_ctx[MAX_SIGNAL_LENGHT / 2];
+static float out_ctx[MAX_SIGNAL_LENGHT / 2];
+
+// 12 bits ADC capture: offset + two tones + noise
+static void GenerateSignal(uint16_t n, float offset, float amp1, float bin1, float amp2, float bin2)
+{
+    for (int i = 0; i < n; i++) {
+        float v = offset + amp1 * sinf(2 * M_PI * bin1 * i / n) + amp2 * sinf(2 * M_PI * bin2 * i / n + 1.0f)
+                  + (rand() % 5 - 2);
+        if (v < 0) {
+            v = 0;
+        }
+        if (v > ADC_FULL_SCALE) {
+            v = ADC_FULL_SCALE;
+        }
+        signal_adc[i] = (uint16_t)(v + 0.5f);
+        signal_f[i] = signal_adc[i];
+    }
+}
+
+// Largest error of the Q15 magnitudes against the float path, in ADC counts
+static float CompareMagnitudes(uint16_t n, float *peak_err)
+{
+    float max_err = 0, peak = 0;
+    int peak_bin = 0;
+    FFTMagnitude(signal_f, mag_f, n);
+    FFTMagnitudeQ15(signal_adc, mag_q15, n);
+    for (int i = 0; i < n / 2; i++) {
+        float err = fabsf(mag_f[i] - mag_q15[i]);
+        if (err > max_err) {
+            max_err = err;
+        }
+        if (i > 1 && mag_f[i] > peak) {
+            peak = mag_f[i];
+            peak_bin = i;
+        }
+    }
+    *peak_err = 100 * fabsf(mag_f[peak_bin] - mag_q15[peak_bin]) / mag_f[peak_bin];
+    return max_err;
+}
+
+// Reference magnitude: FFTMagnitude over a N points complex FFT (former implementation)
+static void FFTMagnitudeComplex(float *signal, float *fft, uint16_t n)
+{
+    dsps_wind_hann_f32(ref_wind, n);
+    for (int i = 0; i < n; i++) {
+        ref_complex[i * 2 + 0] = signal[i] * ref_wind[i];
+        ref_complex[i * 2 + 1] = 0;
+    }
+    dsps_fft2r_fc32(ref_complex, n);
+    dsps_bit_rev_fc32(ref_complex, n);
+    dsps_cplx2reC_fc32(ref_complex, n);
+    for (int j = 0; j < n / 2; j++) {
+        fft[j] = 2 * sqrtf(ref_complex[j * 2 + 0] * ref_complex[j * 2 + 0] +
+                           ref_complex[j * 2 + 1] * ref_complex[j * 2 + 1]) / (n / 2);
+    }
+    fft[0] = fft[0] / 2;
+}
+
+int test_fft_real()
+{
+    int errors = 0;
+    if (!FFTInit()) {
+        printf("FFTInit failed\n");
+        return 1;
+    }
+
+    // Radix-4 (N/2 = 4^k) and radix-2 lenghts against the complex FFT
+    const uint16_t lenghts[] = {32, 64, 128, 256, 512, 1024, 2048};
+    for (int l = 0; l < sizeof(lenghts) / sizeof(lenghts[0]); l++) {
+        uint16_t n = lenghts[l];
+        GenerateSignal(n, 2048, 1500, n / 8, 150, n / 8 + n / 16 + 0.5f);
+        FFTMagnitude(signal_f, mag_f, n);
+        FFTMagnitudeComplex(signal_f, mag_ref, n);
+        float max_err = 0;
+        for (int i = 0; i < n / 2; i++) {
+            float err = fabsf(mag_f[i] - mag_ref[i]);
+            if (err > max_err) {
+                max_err = err;
+            }
+        }
+        printf("N = %4i: real FFT max error %.5f counts\n", n, max_err);
+        if (max_err > 0.01f) {
+            printf("FFTMagnitude does not match the complex FFT\n");
+            errors++;
+        }
+    }
+
+    // Speed: real FFT against the complex FFT of the same 2048 samples
+    GenerateSignal(2048, 2048, 1000, 100, 100, 300);
+    uint32_t start = dsp_get_cpu_cycle_count();
+    for (int i = 0; i < N_BENCH; i++) {
+        FFTMagnitudeComplex(signal_f, mag_ref, 2048);
+    }
+    uint32_t complex_time = dsp_get_cpu_cycle_count() - start;
+    start = dsp_get_cpu_cycle_count();
+    for (int i = 0; i < N_BENCH; i++) {
+        FFTMagnitude(signal_f, mag_f, 2048);
+    }
+    uint32_t real_time = dsp_get_cpu_cycle_count() - start;
+    printf("N = 2048: complex %u ns, real %u ns per call (x%.2f)\n",
+           complex_time / N_BENCH, real_time / N_BENCH, (float)complex_time / real_time);
+
+    return errors;
+}
+
+// Tone of amplitude amp (in FFTMagnitude units, 2 * amp at the tone bin) 
+static void GenerateTone(float *signal, uint16_t n, float offset, float amp, float bin)
+{
+    for (int i = 0; i < n; i++) {
+        signal[i] = offset + amp * sinf(2 * M_PI * bin * i / n);
+    }
+}
+
+int test_fft_ctx()
+{
+    int errors = 0;
+    const char *names[] = {"Hann", "Blackman-Harris", "Flat top"};
+
+    // Tables are initialized once, a second call leaves them as they are
+    if (!FFTInit() || !FFTInit()) {
+        printf("FFTInit failed\n");
+        return 1;
+    }
+
+    // Invalid lenghts
+    if (FFTCreate(0, FFT_WINDOW_HANN) != NULL || FFTCreate(100, FFT_WINDOW_HANN) != NULL ||
+            FFTCreate(2 * MAX_SIGNAL_LENGHT, FFT_WINDOW_HANN) != NULL) {
+        printf("FFTCreate accepts an invalid lenght\n");
+        errors++;
+    }
+
+    // Tone amplitude with each window, on a bin and half way between two bins
+    for (fft_window_t w = FFT_WINDOW_HANN; w <= FFT_WINDOW_FLAT_TOP; w++) {
+        fft_ctx_t *ctx = FFTCreate(CTX_LENGHT, w);
+        if (ctx == NULL) {
+            printf("FFTCreate failed\n");
+            return errors + 1;
+        }
+        const float offsets[] = {0, 0.5f};
+        for (int o = 0; o < 2; o++) {
+            GenerateTone(signal_f, CTX_LENGHT, 1000, 500, 40 + offsets[o]);
+            FFTMagnitudeCtx(ctx, signal_f, mag_ctx);
+            FFTPowerCtx(ctx, signal_f, pow_ctx);
+            float peak = 0, pow_err = 0;
+            for (int i = 0; i < CTX_LENGHT / 2; i++) {
+                if (i > 10 && mag_ctx[i] > peak) {
+                    peak = mag_ctx[i];
+                }
+                float err = fabsf(pow_ctx[i] - mag_ctx[i] * mag_ctx[i]) / (mag_ctx[i] * mag_ctx[i] + 1e-3f);
+                if (err > pow_err) {
+                    pow_err = err;
+                }
+            }
+            float dc_err = 100 * fabsf(mag_ctx[0] - 1000) / 1000;
+            float peak_err = 100 * fabsf(peak - 1000) / 1000;
+            printf("%-15s tone at bin %4.1f: DC error %5.2f%%, peak error %5.2f%%, power error %.1e\n",
+                   names[w], 40 + offsets[o], dc_err, peak_err, pow_err);
+            // Scalloping loss: Hann 15%, Blackman-Harris 9%, flat top < 1%
+            float max_peak_err = (offsets[o] == 0 || w == FFT_WINDOW_FLAT_TOP) ? 1.0f : 20.0f;
+            if (dc_err > 1.0f || peak_err > max_peak_err || pow_err > 1e-4f) {
+                printf("FFT context gives wrong amplitudes\n");
+                errors++;
+            }
+        }
+        FFTDelete(ctx);
+    }
+
+    // Two analyzers of different sizes interleaved give the same result as alone
+    fft_ctx_t *ctx_a = FFTCreate(256, FFT_WINDOW_HANN);
+    fft_ctx_t *ctx_b = FFTCreate(1024, FFT_WINDOW_BLACKMAN_HARRIS);
+    GenerateSignal(1024, 2048, 1000, 100, 100, 300);
+    FFTMagnitudeCtx(ctx_a, signal_f, mag_ref);
+    FFTMagnitudeCtx(ctx_b, signal_f, mag_f);
+    FFTMagnitudeCtx(ctx_a, signal_f, mag_ctx);
+    for (int i = 0; i < 128; i++) {
+        if (mag_ctx[i] != mag_ref[i]) {
+            printf("FFT contexts are not independent\n");
+            errors++;
+            break;
+        }
+    }
+
+    // Speed: window computed on every call against the cached window
+    uint32_t start = dsp_get_cpu_cycle_count();
+    for (int i = 0; i < N_BENCH; i++) {
+        dsps_wind_hann_f32(ref_wind, 1024);
+        FFTMagnitudeCtx(ctx_b, signal_f, mag_f);
+    }
+    uint32_t wind_time = dsp_get_cpu_cycle_count() - start;
+    start = dsp_get_cpu_cycle_count();
+    for (int i = 0; i < N_BENCH; i++) {
+        FFTMagnitudeCtx(ctx_b, signal_f, mag_f);
+    }
+    uint32_t ctx_time = dsp_get_cpu_cycle_count() - start;
+    printf("N = 1024: window per call %u ns, cached window %u ns per call (x%.2f)\n",
+           wind_time / N_BENCH, ctx_time / N_BENCH, (float)wind_time / ctx_time);
+    FFTDelete(ctx_a);
+    FFTDelete(ctx_b);
+
+    printf("FFT contexts: %i error(s)\n", errors);
+    return errors;
+}
+
+int test_fft_output()
+{
+    int errors = 0;
+    const char *names[] = {"sqrtf", "dsps_sqrt", "AMBM", "power", "dB"};
+    // Error bounds of fft_output_t (relative, dB for FFT_OUTPUT_DB)
+    const float bounds[] = {1e-5f, 0.036f, 0.023f, 1e-5f, 0.001f};
+    const uint16_t n = 1024;
+    fft_ctx_t *ctx = FFTCreate(n, FFT_WINDOW_BLACKMAN_HARRIS);
+    if (ctx == NULL) {
+        printf("FFTCreate failed\n");
+        return 1;
+    }
+    GenerateSignal(n, 2048, 1000, 100.3f, 100, 300.7f);
+    FFTMagnitudeCtx(ctx, signal_f, mag_ref);
+
+    uint32_t base_time = 0;
+    for (fft_output_t out = FFT_OUTPUT_MAGNITUDE; out <= FFT_OUTPUT_DB; out++) {
+        FFTSpectrumCtx(ctx, signal_f, out_ctx, out);
+        float max_err = 0;
+        for (int i = 0; i < n / 2; i++) {
+            float err;
+            if (mag_ref[i] < 1e-3f) {
+                continue;
+            }
+            if (out == FFT_OUTPUT_POWER) {
+                err = fabsf(out_ctx[i] - mag_ref[i] * mag_ref[i]) / (mag_ref[i] * mag_ref[i]);
+            } else if (out == FFT_OUTPUT_DB) {
+                err = fabsf(out_ctx[i] - 20 * log10(mag_ref[i]));
+            } else {
+                err = fabsf(out_ctx[i] - mag_ref[i]) / mag_ref[i];
+            }
+            if (err > max_err) {
+                max_err = err;
+            }
+        }
+        uint32_t start = dsp_get_cpu_cycle_count();
+        for (int i = 0; i < N_BENCH; i++) {
+            FFTSpectrumCtx(ctx, signal_f, out_ctx, out);
+        }
+        uint32_t time = (dsp_get_cpu_cycle_count() - start) / N_BENCH;
+        if (out == FFT_OUTPUT_POWER) {
+            base_time = time;
+        }
+        printf("Output %-9s: max error %.2e (bound %.1e), %6u ns per call\n", names[out], max_err, bounds[out], time);
+        if (max_err > bounds[out]) {
+            printf("Spectrum output above its error bound\n");
+            errors++;
+        }
+    }
+    // Output stage cost per bin, over the power output
+    for (fft_output_t out = FFT_OUTPUT_MAGNITUDE; out <= FFT_OUTPUT_DB; out++) {
+        uint32_t start = dsp_get_cpu_cycle_count();
+        for (int i = 0; i < N_BENCH; i++) {
+            FFTSpectrumCtx(ctx, signal_f, out_ctx, out);
+        }
+        int32_t time = (dsp_get_cpu_cycle_count() - start) / N_BENCH - base_time;
+        printf("Output %-9s: %+.2f ns per bin over power\n", names[out], (float)time / (n / 2));
+    }
+
+    // Empty spectrum in dB
+    for (int i = 0; i < n; i++) {
+        signal_f[i] = 0;
+    }
+    FFTSpectrumCtx(ctx, signal_f, out_ctx, FFT_OUTPUT_DB);
+    if (out_ctx[0] != FFT_DB_FLOOR || out_ctx[n / 4] != FFT_DB_FLOOR) {
+        printf("Empty bins are not at FFT_DB_FLOOR\n");
+        errors++;
+    }
+    FFTDelete(ctx);
+
+    printf("FFT outputs: %i error(s)\n", errors);
+    return errors;
+}
+
+int test_fft_q15()
+{
+    int errors = 0;
+    if (!FFTInit()) {
+        printf("FFTInit failed\n");
+        return 1;
+    }
+
+    // Accuracy: the error must stay within 0.1% of the ADC full scale
+    const uint16_t lenghts[] = {64, 256, 1024, 2048};
+    const float amplitudes[] = {2000, 500, 50};
+    for (int l = 0; l < sizeof(lenghts) / sizeof(lenghts[0]); l++) {
+        for (int a = 0; a < sizeof(amplitudes) / sizeof(amplitudes[0]); a++) {
+            uint16_t n = lenghts[l];
+            float peak_err;
+            GenerateSignal(n, 2048, amplitudes[a], n / 8, amplitudes[a] / 10, n / 8 + n / 16 + 0.5f);
+            float max_err = CompareMagnitudes(n, &peak_err);
+            printf("N = %4i, A = %4.0f: max error %5.2f counts, peak bin error %5.2f%%\n",
+                   n, amplitudes[a], max_err, peak_err);
+            if (max_err > 0.001f * ADC_FULL_SCALE || peak_err > 2.0f) {
+                printf("FFTMagnitudeQ15 does not match FFTMagnitude\n");
+                errors++;
+            }
+        }
+    }
+
+    // Low level signal without offset: block floating point keeps the resolution
+    {
+        float peak_err;
+        GenerateSignal(256, 100, 60, 20, 0, 0);
+        float max_err = CompareMagnitudes(256, &peak_err);
+        printf("Low level signal: max error %5.2f counts, peak bin error %5.2f%%\n", max_err, peak_err);
+        if (max_err > 2 || peak_err > 2.0f) {
+            printf("FFTMagnitudeQ15 loses resolution on low level signals\n");
+            errors++;
+        }
+    }
+
+    // Speed: both paths on the same 1024 samples
+    GenerateSignal(1024, 2048, 1000, 100, 100, 300);
+    uint32_t start = dsp_get_cpu_cycle_count();
+    for (int i = 0; i < N_BENCH; i++) {
+        FFTMagnitude(signal_f, mag_f, 1024);
+    }
+    uint32_t float_time = dsp_get_cpu_cycle_count() - start;
+    start = dsp_get_cpu_cycle_count();
+    for (int i = 0; i < N_BENCH; i++) {
+        FFTMagnitudeQ15(signal_adc, mag_q15, 1024);
+    }
+    uint32_t q15_time = dsp_get_cpu_cycle_count() - start;
+    printf("N = 1024: float %u ns, Q15 %u ns per call (x%.2f)\n",
+           float_time / N_BENCH, q15_time / N_BENCH, (float)float_time / q15_time);
+
+    return errors;
+}
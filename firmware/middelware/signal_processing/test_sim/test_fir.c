@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "dsps_fir.h"
+#include "dsp_common.h"
+
+#define N_SAMPLES       4096
+#define MAX_TAPS        128
+#define BLOCK           256
+#define N_BENCH         20
+
+static float input[N_SAMPLES];
+static float output[N_SAMPLES];
+static float reference[N_SAMPLES];
+static int16_t input_s16[N_SAMPLES];
+static int16_t output_s16[N_SAMPLES];
+static int16_t reference_s16[N_SAMPLES];
+static float coeffs[MAX_TAPS];
+static int16_t coeffs_s16[MAX_TAPS];
+static float delay[DSPS_FIR_DELAY_LEN(MAX_TAPS)];
+static float delay_ref[DSPS_FIR_DELAY_LEN(MAX_TAPS)];
+static int16_t delay_s16[DSPS_FIR_DELAY_LEN(MAX_TAPS)];
+static int16_t delay_ref_s16[MAX_TAPS];
+
+// Previous dsps_fir_f32_ansi: single delay line split in two loops
+static void FirF32Reference(fir_f32_t *fir, const float *x, float *y, int len)
+{
+    for (int i = 0 ; i < len ; i++) {
+        float acc = 0;
+        int coeff_pos = 0;
+        fir->delay[fir->pos] = x[i];
+        fir->pos++;
+        if (fir->pos >= fir->N) {
+            fir->pos = 0;
+        }
+        for (int n = fir->pos; n < fir->N ; n++) {
+            acc += fir->coeffs[coeff_pos++] * fir->delay[n];
+        }
+        for (int n = 0; n < fir->pos ; n++) {
+            acc += fir->coeffs[coeff_pos++] * fir->delay[n];
+        }
+        y[i] = acc;
+    }
+}
+
+// Previous dsps_fird_s16_ansi
+static int FirdS16Reference(fir_s16_t *fir, const int16_t *x, int16_t *y, int len)
+{
+    int result = 0, input_pos = 0;
+    long long rounding = (long long)(fir->rounding_val) >> fir->shift;
+    for (int i = 0; i < len; i++) {
+        for (int j = 0; j < fir->decim - fir->d_pos; j++) {
+            if (fir->pos >= fir->coeffs_len) {
+                fir->pos = 0;
+            }
+            fir->delay[fir->pos++] = x[input_pos++];
+        }
+        fir->d_pos = 0;
+        long long acc = rounding;
+        int16_t coeff_pos = fir->coeffs_len - 1;
+        for (int n = fir->pos; n < fir->coeffs_len ; n++) {
+            acc += (int32_t)fir->coeffs[coeff_pos--] * (int32_t)fir->delay[n];
+        }
+        for (int n = 0; n < fir->pos ; n++) {
+            acc += (int32_t)fir->coeffs[coeff_pos--] * (int32_t)fir->delay[n];
+        }
+        y[result++] = (int16_t)(acc >> (15 - fir->shift));
+    }
+    return result;
+}
+
+static void ReferenceInitS16(fir_s16_t *fir, int N, int decim, int shift)
+{
+    fir->coeffs = coeffs_s16;
+    fir->delay = delay_ref_s16;
+    fir->coeffs_len = N;
+    fir->pos = 0;
+    fir->decim = decim;
+    fir->d_pos = 0;
+    fir->shift = shift;
+    fir->rounding_val = 0x7fff;
+    for (int i = 0; i < N; i++) {
+        delay_ref_s16[i] = 0;
+    }
+}
+
+// Blocks of random lenght, so both the 4 outputs and the single output loops run
+static void FirBlocks(fir_f32_t *fir, const float *x, float *y, int len)
+{
+    for (int i = 0; i < len;) {
+        int n = 1 + rand() % 37;
+        n = (n > len - i) ? len - i : n;
+        dsps_fir_f32(fir, x + i, y + i, n);
+        i += n;
+    }
+}
+
+static void FirBlocksS16(fir_s16_t *fir, const int16_t *x, int16_t *y, int len)
+{
+    for (int i = 0; i < len;) {
+        int n = 1 + rand() % 37;
+        n = (n > len - i) ? len - i : n;
+        dsps_fir_s16(fir, x + i, y + i, n);
+        i += n;
+    }
+}
+
+int test_fir()
+{
+    int errors = 0;
+    const int taps[] = {1, 2, 5, 16, 33, 64, 128};
+
+    for (int i = 0; i < N_SAMPLES; i++) {
+        input_s16[i] = rand() % 60001 - 30000;
+        input[i] = input_s16[i] / 32768.0f;
+    }
+
+    // Same results as the previous kernels, for any block lenght
+    for (int t = 0; t < sizeof(taps) / sizeof(taps[0]); t++) {
+        int N = taps[t];
+        for (int i = 0; i < N; i++) {
+            coeffs[i] = (rand() % 2001 - 1000) / (1000.0f * N);
+            coeffs_s16[i] = (int16_t)(coeffs[i] * 32767);
+        }
+        fir_f32_t fir, fir_ref;
+        dsps_fir_init_f32(&fir, coeffs, delay, N);
+        dsps_fir_init_f32(&fir_ref, coeffs, delay_ref, N);
+        FirBlocks(&fir, input, output, N_SAMPLES);
+        FirF32Reference(&fir_ref, input, reference, N_SAMPLES);
+        for (int i = 0; i < N_SAMPLES; i++) {
+            if (output[i] != reference[i]) {
+                printf("dsps_fir_f32 N = %i differs from the previous kernel at %i\n", N, i);
+                errors++;
+                break;
+            }
+        }
+
+        fir_s16_t fir_s16, fir_ref_s16;
+        dsps_fir_init_s16(&fir_s16, coeffs_s16, delay_s16, N, 0);
+        ReferenceInitS16(&fir_ref_s16, N, 1, 0);
+        FirBlocksS16(&fir_s16, input_s16, output_s16, N_SAMPLES);
+        FirdS16Reference(&fir_ref_s16, input_s16, reference_s16, N_SAMPLES);
+        for (int i = 0; i < N_SAMPLES; i++) {
+            if (output_s16[i] != reference_s16[i]) {
+                printf("dsps_fir_s16 N = %i differs from dsps_fird_s16 at %i\n", N, i);
+                errors++;
+                break;
+            }
+        }
+
+        for (int decim = 1; decim <= 3; decim++) {
+            dsps_fird_init_s16(&fir_s16, coeffs_s16, delay_s16, N, decim, 0, 0);
+            ReferenceInitS16(&fir_ref_s16, N, decim, 0);
+            int len = dsps_fird_s16_ansi(&fir_s16, input_s16, output_s16, N_SAMPLES / decim);
+            FirdS16Reference(&fir_ref_s16, input_s16, reference_s16, N_SAMPLES / decim);
+            for (int i = 0; i < len; i++) {
+                if (output_s16[i] != reference_s16[i]) {
+                    printf("dsps_fird_s16 N = %i, decimation %i differs from the previous kernel at %i\n", N, decim, i);
+                    errors++;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Speed against the previous kernels, blocks of BLOCK samples
+    for (int N = 16; N <= MAX_TAPS; N *= 2) {
+        fir_f32_t fir, fir_ref;
+        fir_s16_t fir_s16, fir_ref_s16;
+        uint32_t time[4] = {0};
+        dsps_fir_init_f32(&fir, coeffs, delay, N);
+        dsps_fir_init_f32(&fir_ref, coeffs, delay_ref, N);
+        dsps_fir_init_s16(&fir_s16, coeffs_s16, delay_s16, N, 0);
+        ReferenceInitS16(&fir_ref_s16, N, 1, 0);
+        for (int r = 0; r < N_BENCH; r++) {
+            uint32_t start = dsp_get_cpu_cycle_count();
+            for (int i = 0; i < N_SAMPLES; i += BLOCK) {
+                FirF32Reference(&fir_ref, input + i, reference + i, BLOCK);
+            }
+            time[0] += dsp_get_cpu_cycle_count() - start;
+            start = dsp_get_cpu_cycle_count();
+            for (int i = 0; i < N_SAMPLES; i += BLOCK) {
+                dsps_fir_f32(&fir, input + i, output + i, BLOCK);
+            }
+            time[1] += dsp_get_cpu_cycle_count() - start;
+            start = dsp_get_cpu_cycle_count();
+            for (int i = 0; i < N_SAMPLES; i += BLOCK) {
+                FirdS16Reference(&fir_ref_s16, input_s16 + i, reference_s16 + i, BLOCK);
+            }
+            time[2] += dsp_get_cpu_cycle_count() - start;
+            start = dsp_get_cpu_cycle_count();
+            for (int i = 0; i < N_SAMPLES; i += BLOCK) {
+                dsps_fir_s16(&fir_s16, input_s16 + i, output_s16 + i, BLOCK);
+            }
+            time[3] += dsp_get_cpu_cycle_count() - start;
+        }
+        float ns[4];
+        for (int k = 0; k < 4; k++) {
+            ns[k] = (float)time[k] / (N_BENCH * N_SAMPLES);
+        }
+        printf("FIR N = %3i: f32 previous %6.2f ns, mirrored %6.2f ns (x%.2f); "
+               "s16 dsps_fird %6.2f ns, dsps_fir_s16 %6.2f ns (x%.2f) per sample\n",
+               N, ns[0], ns[1], ns[0] / ns[1], ns[2], ns[3], ns[2] / ns[3]);
+    }
+
+    printf("FIR: %i error(s)\n", errors);
+    return errors;
+}
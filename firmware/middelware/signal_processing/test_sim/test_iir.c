@@ -0,0 +1,317 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "iir_filter.h"
+#include "dsps_biquad.h"
+#include "dsps_biquad_gen.h"
+#include "dsp_common.h"
+
+#define TEST_LENGHT     4096
+#define BLOCK_LENGHT    64
+#define BENCH_LENGHT    1024
+#define N_BENCH         2000
+
+static float input[TEST_LENGHT];
+static float output[TEST_LENGHT];
+static float output_ref[TEST_LENGHT];
+
+// Steady state gain of a filter for a sine of frequency freq
+static float Gain(iir_filter_t *filter, float sample_frec, float freq)
+{
+    float in_pow = 0, out_pow = 0;
+    IirReset(filter);
+    for (int i = 0; i < TEST_LENGHT; i++) {
+        input[i] = sinf(2 * M_PI * freq * i / sample_frec);
+    }
+    IirFilter(filter, input, output, TEST_LENGHT);
+    for (int i = TEST_LENGHT / 2; i < TEST_LENGHT; i++) {
+        in_pow += input[i] * input[i];
+        out_pow += output[i] * output[i];
+    }
+    return sqrtf(out_pow / in_pow);
+}
+
+static int CheckGain(const char *name, iir_filter_t *filter, float sample_frec, float freq, float min, float max)
+{
+    float gain = Gain(filter, sample_frec, freq);
+    if (gain < min || gain > max) {
+        printf("%s: gain %.4f at %.1f Hz, expected %.4f..%.4f\n", name, gain, freq, min, max);
+        return 1;
+    }
+    return 0;
+}
+
+int test_iir_handles()
+{
+    int errors = 0;
+    IIR_FILTER_DEFINE(lp, 8);
+    IIR_FILTER_DEFINE(hp, 2);
+    IIR_FILTER_DEFINE(bp, 4);
+    IIR_FILTER_DEFINE(notch, 4);
+
+    // Frequency response of each type
+    IirInit(&lp, IIR_LOW_PASS, 4, 1000, 40, 0);
+    errors += CheckGain("LPF 4", &lp, 1000, 10, 0.99, 1.01);
+    errors += CheckGain("LPF 4", &lp, 1000, 40, 0.69, 0.72);
+    errors += CheckGain("LPF 4", &lp, 1000, 200, 0, 0.003);
+    IirInit(&lp, IIR_LOW_PASS, 3, 1000, 40, 0);
+    errors += CheckGain("LPF 3", &lp, 1000, 40, 0.69, 0.72);
+    errors += CheckGain("LPF 3", &lp, 1000, 200, 0, 0.01);
+    IirInit(&hp, IIR_HIGH_PASS, 2, 250, 5, 0);
+    errors += CheckGain("HPF 2", &hp, 250, 5, 0.69, 0.72);
+    errors += CheckGain("HPF 2", &hp, 250, 50, 0.99, 1.01);
+    IirInit(&bp, IIR_BAND_PASS, 4, 250, 5, 40);
+    errors += CheckGain("BPF 4", &bp, 250, 15, 0.95, 1.01);
+    errors += CheckGain("BPF 4", &bp, 250, 1, 0, 0.05);
+    errors += CheckGain("BPF 4", &bp, 250, 110, 0, 0.05);
+    IirInit(&notch, IIR_NOTCH, 4, 250, 50, 2);
+    errors += CheckGain("Notch 4", &notch, 250, 50, 0, 0.01);
+    errors += CheckGain("Notch 4", &notch, 250, 40, 0.98, 1.01);
+    errors += CheckGain("Notch 4", &notch, 250, 60, 0.98, 1.01);
+
+    // Orders that do not fit the storage are rejected
+    if (IirInit(&hp, IIR_HIGH_PASS, 6, 250, 5, 0) || IirInit(&bp, IIR_BAND_PASS, 3, 250, 5, 40) ||
+            IirInit(&bp, IIR_BAND_PASS, 4, 250, 40, 5)) {
+        printf("IirInit accepted an invalid filter\n");
+        errors++;
+    }
+
+    // Two channels processed block by block don't share state
+    for (int i = 0; i < TEST_LENGHT; i++) {
+        input[i] = sinf(i * 0.05f) + (rand() % 100) / 100.0f;
+    }
+    IirInit(&lp, IIR_LOW_PASS, 6, 1000, 20, 0);
+    IirInit(&bp, IIR_BAND_PASS, 4, 1000, 5, 40);
+    IirFilter(&lp, input, output_ref, TEST_LENGHT);
+    IirReset(&lp);
+    for (int i = 0; i < TEST_LENGHT; i += BLOCK_LENGHT) {
+        float block[BLOCK_LENGHT];
+        IirFilter(&bp, &input[i], block, BLOCK_LENGHT);
+        IirFilter(&lp, &input[i], &output[i], BLOCK_LENGHT);
+    }
+    if (memcmp(output, output_ref, sizeof(output))) {
+        printf("Interleaved channels differ from a single channel\n");
+        errors++;
+    }
+
+    // Legacy API matches the handle API
+    LowPassInit(1000, 20, ORDER_6);
+    LowPassFilter(input, output, TEST_LENGHT);
+    if (memcmp(output, output_ref, sizeof(output))) {
+        printf("LowPassFilter differs from IirFilter\n");
+        errors++;
+    }
+
+    printf("IIR filter handles: %i error(s)\n", errors);
+    return errors;
+}
+
+int test_iir_cascade()
+{
+    int errors = 0;
+    float coef[4 * IIR_SOS_SIZE];
+    int16_t coef_s16[4 * IIR_SOS_SIZE];
+    float delay[4 * IIR_DELAY_SIZE];
+    int32_t delay_s16[4 * IIR_DELAY_SIZE];
+    static int16_t input_s16[BENCH_LENGHT];
+    static int16_t output_s16[BENCH_LENGHT];
+
+    for (int i = 0; i < BENCH_LENGHT; i++) {
+        input[i] = 8000 * sinf(i * 0.05f) + 4000 * sinf(i * 0.7f) + rand() % 2000 - 1000;
+        input_s16[i] = (int16_t)input[i];
+        input[i] = input_s16[i];
+    }
+    for (int order = 2; order <= 8; order += 2) {
+        int n = order / 2;
+        for (int k = 0; k < n; k++) {
+            dsps_biquad_gen_lpf_f32(&coef[k * IIR_SOS_SIZE], 0.05f, 1 / (2 * sinf((2 * k + 1) * M_PI / (2 * order))));
+            for (int j = 0; j < IIR_SOS_SIZE; j++) {
+                coef_s16[k * IIR_SOS_SIZE + j] = (int16_t)lrintf(coef[k * IIR_SOS_SIZE + j] * (1 << DSPS_BIQUAD_S16_Q));
+            }
+        }
+
+        // Multi-pass reference: one dsps_biquad_f32 sweep per section
+        uint32_t start = dsp_get_cpu_cycle_count();
+        for (int r = 0; r < N_BENCH; r++) {
+            memset(delay, 0, sizeof(delay));
+            dsps_biquad_f32(input, output_ref, BENCH_LENGHT, coef, delay);
+            for (int k = 1; k < n; k++) {
+                dsps_biquad_f32(output_ref, output_ref, BENCH_LENGHT, &coef[k * IIR_SOS_SIZE], &delay[k * IIR_DELAY_SIZE]);
+            }
+        }
+        uint32_t multi_time = dsp_get_cpu_cycle_count() - start;
+
+        start = dsp_get_cpu_cycle_count();
+        for (int r = 0; r < N_BENCH; r++) {
+            memset(delay, 0, sizeof(delay));
+            dsps_biquad_cascade_f32(input, output, BENCH_LENGHT, coef, delay, n);
+        }
+        uint32_t cascade_time = dsp_get_cpu_cycle_count() - start;
+
+        start = dsp_get_cpu_cycle_count();
+        for (int r = 0; r < N_BENCH; r++) {
+            memset(delay_s16, 0, sizeof(delay_s16));
+            dsps_biquad_cascade_s16(input_s16, output_s16, BENCH_LENGHT, coef_s16, delay_s16, n);
+        }
+        uint32_t s16_time = dsp_get_cpu_cycle_count() - start;
+
+        float max_err = 0, max_err_s16 = 0;
+        for (int i = 0; i < BENCH_LENGHT; i++) {
+            max_err = fmaxf(max_err, fabsf(output[i] - output_ref[i]));
+            max_err_s16 = fmaxf(max_err_s16, fabsf(output_s16[i] - output_ref[i]));
+        }
+        printf("Order %i: multi-pass %6u ns, cascade f32 %6u ns (x%.2f), cascade s16 %6u ns, error f32 %.4f, s16 %.1f\n",
+               order, multi_time / N_BENCH, cascade_time / N_BENCH, (float)multi_time / cascade_time,
+               s16_time / N_BENCH, max_err, max_err_s16);
+        if (max_err > 0.05f || max_err_s16 > 32) {
+            printf("Cascade output differs from the multi-pass filter\n");
+            errors++;
+        }
+    }
+
+    printf("IIR cascade: %i error(s)\n", errors);
+    return errors;
+}
+
+// Signal to noise ratio (dB) of a fixed point output against the float reference
+static float Snr(const float *ref, const float *out, int len)
+{
+    double sig = 0, noise = 0;
+    for (int i = 0; i < len; i++) {
+        sig += (double)ref[i] * ref[i];
+        noise += (double)(out[i] - ref[i]) * (out[i] - ref[i]);
+    }
+    return 10 * log10(sig / (noise + 1e-30));
+}
+
+// Double precision direct form I reference over the float coefficients of a filter
+static void ReferenceFilter(iir_filter_t *filter, const float *in, float *out, int len)
+{
+    const float *c = (const float *)filter->storage;
+    double w[16][4] = {{0}};
+    for (int i = 0; i < len; i++) {
+        double x = in[i];
+        for (int k = 0; k < filter->n_sections; k++, c += IIR_SOS_SIZE) {
+            double y = c[0] * x + c[1] * w[k][0] + c[2] * w[k][1] - c[3] * w[k][2] - c[4] * w[k][3];
+            w[k][1] = w[k][0];
+            w[k][0] = x;
+            w[k][3] = w[k][2];
+            w[k][2] = y;
+            x = y;
+        }
+        c = (const float *)filter->storage;
+        out[i] = x;
+    }
+}
+
+int test_iir_fixed()
+{
+    int errors = 0;
+    static int16_t x16[TEST_LENGHT], y16[TEST_LENGHT];
+    static int32_t x32[TEST_LENGHT], y32[TEST_LENGHT];
+    IIR_FILTER_DEFINE(ref, 4);
+    IIR_FILTER_DEFINE_KERNEL(f16, 4, IIR_S16);
+    IIR_FILTER_DEFINE_KERNEL(f32, 4, IIR_S32);
+
+    // SNR against the float filter, s16 at a moderate cut-off, s32 at a very low one.
+    // Q14 can't place the poles of the very low cut-offs: IirInit() rejects them.
+    const struct {
+        filter_type_t type;
+        uint8_t order;
+        float fs, fc, fc2;
+        bool s16_fits;
+        float min_snr16, min_snr32;
+    } cases[] = {
+        {IIR_LOW_PASS, 4, 250, 5, 0, true, 55, 130},
+        {IIR_HIGH_PASS, 2, 250, 5, 0, true, 60, 130},
+        {IIR_NOTCH, 2, 250, 50, 2, true, 60, 130},
+        {IIR_LOW_PASS, 2, 250, 1, 0, true, 40, 130},
+        {IIR_BAND_PASS, 4, 250, 0.5, 40, false, 0, 130},
+        {IIR_LOW_PASS, 2, 1000, 0.5, 0, false, 0, 80},
+    };
+    for (int c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        IirInit(&ref, cases[c].type, cases[c].order, cases[c].fs, cases[c].fc, cases[c].fc2);
+        bool fits = IirInit(&f16, cases[c].type, cases[c].order, cases[c].fs, cases[c].fc, cases[c].fc2);
+        IirInit(&f32, cases[c].type, cases[c].order, cases[c].fs, cases[c].fc, cases[c].fc2);
+        if (fits != cases[c].s16_fits) {
+            printf("Fixed point filter %i: IirInit s16 returned %i\n", c, fits);
+            errors++;
+        }
+        for (int i = 0; i < TEST_LENGHT; i++) {
+            x16[i] = 6000 * sinf(i * 0.01f) + 3000 * sinf(i * 1.2566f) + rand() % 2000 - 1000;
+            x32[i] = x16[i] * 65536;
+            input[i] = x16[i];
+        }
+        ReferenceFilter(&ref, input, output_ref, TEST_LENGHT);
+        IirFilterS16(&f16, x16, y16, TEST_LENGHT);
+        IirFilterS32(&f32, x32, y32, TEST_LENGHT);
+        for (int i = 0; i < TEST_LENGHT; i++) {
+            output[i] = y16[i];
+        }
+        float snr16 = Snr(output_ref, output, TEST_LENGHT);
+        for (int i = 0; i < TEST_LENGHT; i++) {
+            output[i] = y32[i] / 65536.0f;
+        }
+        float snr32 = Snr(output_ref, output, TEST_LENGHT);
+        if (!fits) {
+            snr16 = NAN;
+        }
+        printf("Fixed point filter %i: SNR s16 %.1f dB, s32 %.1f dB\n", c, snr16, snr32);
+        if ((fits && snr16 < cases[c].min_snr16) || snr32 < cases[c].min_snr32) {
+            printf("Fixed point filter %i is not accurate enough\n", c);
+            errors++;
+        }
+    }
+
+    // Error feedback: exact DC gain and no limit cycle at a low cut-off
+    IirInit(&f16, IIR_LOW_PASS, 2, 250, 1, 0);
+    for (int i = 0; i < TEST_LENGHT; i++) {
+        x16[i] = (i < TEST_LENGHT / 2) ? 1001 : 0;
+    }
+    IirFilterS16(&f16, x16, y16, TEST_LENGHT);
+    if (y16[TEST_LENGHT / 2 - 1] != 1001 || y16[TEST_LENGHT - 1] != 0) {
+        printf("s16 filter settles at %i and %i, expected 1001 and 0\n", y16[TEST_LENGHT / 2 - 1], y16[TEST_LENGHT - 1]);
+        errors++;
+    }
+
+    // Full scale input: the sums don't fit 32 bits, the output saturates instead of wrapping
+    const int16_t gain6[IIR_SOS_SIZE] = {32000, 32000, 32000, 0, 0};
+    int32_t state[4 * IIR_FX_DELAY_SIZE] = {0};
+    for (int i = 0; i < BLOCK_LENGHT; i++) {
+        x16[i] = (i & 1) ? INT16_MAX : INT16_MIN;
+        x16[BLOCK_LENGHT + i] = INT16_MAX;
+    }
+    dsps_biquad_s16(x16, y16, 2 * BLOCK_LENGHT, gain6, state);
+    memset(state, 0, sizeof(state));
+    dsps_biquad_cascade_s16(x16, &y16[2 * BLOCK_LENGHT], 2 * BLOCK_LENGHT, gain6, state, 1);
+    if (y16[2 * BLOCK_LENGHT - 1] != INT16_MAX || y16[4 * BLOCK_LENGHT - 1] != INT16_MAX) {
+        printf("s16 kernels overflow at full scale: %i %i\n", y16[2 * BLOCK_LENGHT - 1], y16[4 * BLOCK_LENGHT - 1]);
+        errors++;
+    }
+
+    // A filter is only run by the function of its kernel
+    for (int i = 0; i < BLOCK_LENGHT; i++) {
+        input[i] = 1;
+        output[i] = 0;
+    }
+    IirFilter(&f16, input, output, BLOCK_LENGHT);
+    IirFilterS16(&f32, x16, y16, BLOCK_LENGHT);
+    IirFilterS16(NULL, x16, y16, BLOCK_LENGHT);
+    if (output[BLOCK_LENGHT - 1] != 0 || y16[BLOCK_LENGHT - 1] != INT16_MAX) {
+        printf("A filter ran with the kernel of another type\n");
+        errors++;
+    }
+
+    // Coefficients outside the Q14/Q30 range are rejected
+    float big[IIR_SOS_SIZE] = {2.5f, 0, 0, 0, 0};
+    int16_t q16[IIR_SOS_SIZE];
+    if (dsps_biquad_coef_s16(big, q16, 1) == ESP_OK) {
+        printf("dsps_biquad_coef_s16 accepted an out of range coefficient\n");
+        errors++;
+    }
+
+    printf("IIR fixed point: %i error(s)\n", errors);
+    return errors;
+}
@@ -0,0 +1,383 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "dsps_fir.h"
+#include "dsps_fir_gen.h"
+#include "dsp_common.h"
+
+#define N_SAMPLES       8192
+#define MAX_TAPS        160
+#define BLOCK           256
+#define N_BENCH         20
+
+static float input[N_SAMPLES];
+static float output[4 * N_SAMPLES + 1];
+static float reference[4 * N_SAMPLES + 1];
+static int16_t input_s16[N_SAMPLES];
+static int16_t output_s16[4 * N_SAMPLES + 1];
+static int16_t reference_s16[N_SAMPLES];
+static float coeffs[MAX_TAPS];
+static int16_t coeffs_s16[MAX_TAPS];
+static float delay[MAX_TAPS];
+static int16_t delay_s16[MAX_TAPS];
+
+static void Tone(float *x, int len, float amplitude, float f)
+{
+    for (int i = 0; i < len; i++) {
+        x[i] = amplitude * sinf(2 * M_PI * f * i);
+    }
+}
+
+// Amplitude of the tone at normalized frequency f (Hann windowed projection)
+static float ToneAmplitude(const float *y, int len, float f)
+{
+    double re = 0, im = 0, sum = 0;
+    for (int i = 0; i < len; i++) {
+        double w = 0.5 - 0.5 * cos(2 * M_PI * i / len);
+        re += w * y[i] * cos(2 * M_PI * f * i);
+        im += w * y[i] * sin(2 * M_PI * f * i);
+        sum += w;
+    }
+    return 2 * sqrt(re * re + im * im) / sum;
+}
+
+// Zero stuffing, convolution and decimation, one output at a time
+static int ResampleReference(const float *x, int len, const float *h, int N, int interp, int decim, float *y)
+{
+    int result = 0;
+    for (int j = 0; j < len * interp; j += decim) {
+        float acc = 0;
+        for (int i = 0; i < N && i <= j; i++) {
+            if ((j - i) % interp == 0) {
+                acc += h[i] * x[(j - i) / interp];
+            }
+        }
+        y[result++] = acc;
+    }
+    return result;
+}
+
+// Streams blocks of random lenght through a resampler, returns the number of outputs
+static int ResampleBlocks(fir_resample_f32_t *fir, const float *x, int len, float *y)
+{
+    int pushed = 0, result = 0;
+    while (pushed < len) {
+        int n = 1 + rand() % 100;
+        if (n > len - pushed) {
+            n = len - pushed;
+        }
+        result += dsps_resample_f32(fir, x + pushed, y + result, n);
+        pushed += n;
+    }
+    return result;
+}
+
+// Tone amplitudes at the output rate: passband ripple (dB) up to pass and
+// rejection (dB) of the images / aliases of tones above stop
+static void Response(fir_resample_f32_t *fir, float fs_in, float fs_out, float pass, float stop,
+                     float *ripple, float *rejection)
+{
+    *ripple = 0;
+    *rejection = 1000;
+    for (float f = 5; f < fs_in / 2; f += 5) {
+        dsps_resample_init_f32(fir, fir->coeffs, fir->delay, fir->N, fir->interp, fir->decim);
+        Tone(input, N_SAMPLES, 1, f / fs_in);
+        int len = dsps_resample_f32(fir, input, output, N_SAMPLES);
+        // Skip the filter transient
+        const float *y = output + len / 4;
+        len -= len / 4;
+        if (f <= pass) {
+            float db = 20 * log10f(ToneAmplitude(y, len, f / fs_out));
+            *ripple = fmaxf(*ripple, fabsf(db));
+        }
+        if (f >= stop) {
+            // Alias of f at the output rate
+            float alias = fabsf(f - fs_out * roundf(f / fs_out));
+            float db = 20 * log10f(ToneAmplitude(y, len, alias / fs_out) + 1e-9f);
+            *rejection = fminf(*rejection, -db);
+        }
+        if (fs_out > fs_in && f <= pass) {
+            // Image of f above the input Nyquist frequency
+            float db = 20 * log10f(ToneAmplitude(y, len, (fs_in - f) / fs_out) + 1e-9f);
+            *rejection = fminf(*rejection, -db);
+        }
+    }
+}
+
+static int TestResampleStreaming(void)
+{
+    int errors = 0;
+    const int ratios[][2] = {{3, 2}, {4, 1}, {1, 3}, {5, 4}, {2, 5}};
+    for (int r = 0; r < sizeof(ratios) / sizeof(ratios[0]); r++) {
+        int interp = ratios[r][0], decim = ratios[r][1];
+        int N = 12 * (interp > decim ? interp : decim) + 1;
+        dsps_fir_gen_lpf_f32(coeffs, N, 0.4f / (interp > decim ? interp : decim), interp);
+        for (int i = 0; i < 1000; i++) {
+            input[i] = (rand() % 2001 - 1000) / 1000.0f;
+        }
+        fir_resample_f32_t fir;
+        dsps_resample_init_f32(&fir, coeffs, delay, N, interp, decim);
+        int len = ResampleBlocks(&fir, input, 1000, output);
+        int ref_len = ResampleReference(input, 1000, coeffs, N, interp, decim, reference);
+        float err = 0;
+        for (int i = 0; i < ref_len; i++) {
+            err = fmaxf(err, fabsf(output[i] - reference[i]));
+        }
+        if (len != ref_len || err > 1e-5f) {
+            printf("Resample %i/%i: %i outputs instead of %i, error %g\n", interp, decim, len, ref_len, err);
+            errors++;
+        }
+    }
+    fir_resample_f32_t fir;
+    if (dsps_resample_init_f32(&fir, coeffs, delay, 10, 0, 1) == ESP_OK) {
+        printf("dsps_resample_init_f32 accepts interp = 0\n");
+        errors++;
+    }
+    return errors;
+}
+
+static int TestHalfband(void)
+{
+    int errors = 0;
+    const int N = 23;
+    fir_f32_t hb, fird;
+    fir_s16_t hb_s16, fird_s16;
+    int16_t delay2_s16[2 * N];
+    float delay2[N];
+
+    if (dsps_fir_gen_halfband_f32(coeffs, 21) == ESP_OK || dsps_fird_hb_init_f32(&hb, coeffs, delay, 25) == ESP_OK) {
+        printf("Half-band accepts N != 4 * k + 3\n");
+        errors++;
+    }
+    dsps_fir_gen_halfband_f32(coeffs, N);
+    dsps_fir_coef_s16(coeffs, coeffs_s16, N, 0);
+    for (int i = 0; i < N_SAMPLES; i++) {
+        input_s16[i] = rand() % 20001 - 10000;
+        input[i] = input_s16[i];
+    }
+
+    // Same results as dsps_fird with the zero coefficients
+    dsps_fird_hb_init_f32(&hb, coeffs, delay, N);
+    dsps_fird_init_f32(&fird, coeffs, delay2, N, 2);
+    dsps_fird_hb_f32(&hb, input, output, N_SAMPLES / 2);
+    dsps_fird_f32_ansi(&fird, input, reference, N_SAMPLES / 2);
+    float err = 0;
+    for (int i = 0; i < N_SAMPLES / 2; i++) {
+        err = fmaxf(err, fabsf(output[i] - reference[i]));
+    }
+    if (err > 1e-2f) {
+        printf("Half-band f32 differs from dsps_fird_f32 by %g\n", err);
+        errors++;
+    }
+    dsps_fird_hb_init_s16(&hb_s16, coeffs_s16, delay_s16, N, 0);
+    dsps_fird_init_s16(&fird_s16, coeffs_s16, delay2_s16, N, 2, 0, 0);
+    dsps_fird_hb_s16(&hb_s16, input_s16, output_s16, N_SAMPLES / 2);
+    dsps_fird_s16_ansi(&fird_s16, input_s16, reference_s16, N_SAMPLES / 2);
+    for (int i = 0; i < N_SAMPLES / 2; i++) {
+        if (output_s16[i] != reference_s16[i]) {
+            printf("Half-band s16 differs from dsps_fird_s16 at %i\n", i);
+            errors++;
+            break;
+        }
+    }
+
+    uint32_t start = dsp_get_cpu_cycle_count();
+    for (int i = 0; i < N_BENCH; i++) {
+        dsps_fird_f32_ansi(&fird, input, reference, N_SAMPLES / 2);
+    }
+    uint32_t time_fird = dsp_get_cpu_cycle_count() - start;
+    start = dsp_get_cpu_cycle_count();
+    for (int i = 0; i < N_BENCH; i++) {
+        dsps_fird_hb_f32(&hb, input, output, N_SAMPLES / 2);
+    }
+    uint32_t time_hb = dsp_get_cpu_cycle_count() - start;
+    printf("Decimation by 2, N = %i: dsps_fird_f32 %.2f ns, half-band %.2f ns per input sample\n", N,
+           (float)time_fird / (N_BENCH * N_SAMPLES), (float)time_hb / (N_BENCH * N_SAMPLES));
+    return errors;
+}
+
+// ECG table at 250 Hz replayed at 1 kHz
+static int TestInterpolation(void)
+{
+    int errors = 0;
+    const int N = 96;
+    fir_resample_f32_t fir;
+    fir_resample_s16_t fir_s16;
+    float ripple, rejection;
+
+    dsps_fir_gen_lpf_f32(coeffs, N, 0.5f / 4 - 2.75f / N / 2, 4);
+    dsps_resample_init_f32(&fir, coeffs, delay, N, 4, 1);
+    Response(&fir, 250, 1000, 60, 250, &ripple, &rejection);
+    printf("Interpolation 250 -> 1000 Hz, N = %i: ripple %.3f dB up to 60 Hz, images %.1f dB\n", N, ripple, rejection);
+    if (ripple > 0.1f || rejection < 60) {
+        printf("Interpolation response out of limits\n");
+        errors++;
+    }
+
+    // s16 within a few LSB of f32
+    if (dsps_fir_coef_s16(coeffs, coeffs_s16, N, 1) != ESP_OK) {
+        printf("Interpolation coefficients do not fit with shift 1\n");
+        errors++;
+    }
+    for (int i = 0; i < N_SAMPLES; i++) {
+        input_s16[i] = (int16_t)(8000 * sinf(2 * M_PI * i * 7.0f / 250) + rand() % 2001 - 1000);
+        input[i] = input_s16[i];
+    }
+    dsps_resample_init_f32(&fir, coeffs, delay, N, 4, 1);
+    dsps_resample_init_s16(&fir_s16, coeffs_s16, delay_s16, N, 4, 1, 1);
+    int len = dsps_resample_f32(&fir, input, output, N_SAMPLES);
+    int len_s16 = dsps_resample_s16(&fir_s16, input_s16, output_s16, N_SAMPLES);
+    float err = 0;
+    for (int i = 0; i < len; i++) {
+        err = fmaxf(err, fabsf(output[i] - output_s16[i]));
+    }
+    printf("Interpolation s16: largest difference with f32 %.1f LSB\n", err);
+    if (len != 4 * N_SAMPLES || len_s16 != len || err > 4) {
+        printf("Interpolation s16 differs from f32\n");
+        errors++;
+    }
+
+    uint32_t start = dsp_get_cpu_cycle_count();
+    for (int i = 0; i < N_BENCH; i++) {
+        dsps_resample_f32(&fir, input, output, N_SAMPLES);
+    }
+    uint32_t time = dsp_get_cpu_cycle_count() - start;
+    start = dsp_get_cpu_cycle_count();
+    for (int i = 0; i < N_BENCH; i++) {
+        dsps_resample_s16(&fir_s16, input_s16, output_s16, N_SAMPLES);
+    }
+    uint32_t time_s16 = dsp_get_cpu_cycle_count() - start;
+    printf("Interpolation by 4: f32 %.2f ns, s16 %.2f ns per output sample\n",
+           (float)time / (N_BENCH * len), (float)time_s16 / (N_BENCH * len));
+    return errors;
+}
+
+// ADC stream at 2 kHz reduced to 250 Hz telemetry: three half-band stages
+// against a single polyphase stage with the same transition band
+static int TestMultistage(void)
+{
+    int errors = 0;
+    const int hb_len[3] = {15, 19, 35};
+    const int single_len = 128;
+    static float hb_coeffs[3][35], hb_delay[3][35], work[BLOCK / 2];
+    static int16_t hb_coeffs_s16[3][35], hb_delay_s16[3][35], work_s16[BLOCK / 2];
+    fir_f32_t hb[3];
+    fir_s16_t hb_s16[3];
+    fir_src_f32_t src;
+    fir_src_s16_t src_s16;
+    fir_resample_f32_t single;
+
+    for (int s = 0; s < 3; s++) {
+        dsps_fir_gen_halfband_f32(hb_coeffs[s], hb_len[s]);
+        dsps_fir_coef_s16(hb_coeffs[s], hb_coeffs_s16[s], hb_len[s], 0);
+        dsps_fird_hb_init_f32(&hb[s], hb_coeffs[s], hb_delay[s], hb_len[s]);
+        dsps_fird_hb_init_s16(&hb_s16[s], hb_coeffs_s16[s], hb_delay_s16[s], hb_len[s], 0);
+    }
+    if (dsps_src_init_f32(&src, NULL, 0, NULL, NULL, 0) == ESP_OK) {
+        printf("dsps_src_init_f32 accepts a converter without stages\n");
+        errors++;
+    }
+    dsps_src_init_f32(&src, hb, 3, NULL, work, BLOCK / 2);
+    dsps_src_init_s16(&src_s16, hb_s16, 3, NULL, work_s16, BLOCK / 2);
+    if ((dsps_src_f32(&src, input, output, BLOCK - 4) != -ESP_ERR_DSP_INVALID_LENGTH) ||
+        (dsps_src_f32(&src, input, output, 2 * BLOCK) != -ESP_ERR_DSP_INVALID_LENGTH) ||
+        (dsps_src_s16(&src_s16, input_s16, output_s16, BLOCK + 1) != -ESP_ERR_DSP_INVALID_LENGTH)) {
+        printf("dsps_src accepts a block that is not a multiple of 8 or longer than the work buffer\n");
+        errors++;
+    }
+
+    // Passband ripple and alias rejection, tones streamed in blocks
+    float ripple = 0, rejection = 1000;
+    for (float f = 10; f < 1000; f += 10) {
+        for (int s = 0; s < 3; s++) {
+            dsps_fird_hb_init_f32(&hb[s], hb_coeffs[s], hb_delay[s], hb_len[s]);
+        }
+        Tone(input, N_SAMPLES, 1, f / 2000);
+        int len = 0;
+        for (int i = 0; i < N_SAMPLES; i += BLOCK) {
+            len += dsps_src_f32(&src, input + i, output + len, BLOCK);
+        }
+        const float *y = output + len / 4;
+        len -= len / 4;
+        if (f <= 80) {
+            ripple = fmaxf(ripple, fabsf(20 * log10f(ToneAmplitude(y, len, f / 250))));
+        }
+        if (f >= 170) {
+            float alias = fabsf(f - 250 * roundf(f / 250));
+            if (alias <= 80) {
+                float db = -20 * log10f(ToneAmplitude(y, len, alias / 250) + 1e-9f);
+                rejection = fminf(rejection, db);
+            }
+        }
+    }
+    printf("Decimation 2000 -> 250 Hz, half-band N = 15, 19, 35: ripple %.3f dB up to 80 Hz, aliases %.1f dB\n",
+           ripple, rejection);
+    if (ripple > 0.1f || rejection < 60) {
+        printf("Multistage response out of limits\n");
+        errors++;
+    }
+
+    // s16 within a few LSB of f32
+    for (int i = 0; i < N_SAMPLES; i++) {
+        input_s16[i] = (int16_t)(8000 * sinf(2 * M_PI * i * 30.0f / 2000) + rand() % 2001 - 1000);
+        input[i] = input_s16[i];
+    }
+    for (int s = 0; s < 3; s++) {
+        dsps_fird_hb_init_f32(&hb[s], hb_coeffs[s], hb_delay[s], hb_len[s]);
+    }
+    int len = 0, len_s16 = 0;
+    for (int i = 0; i < N_SAMPLES; i += BLOCK) {
+        len += dsps_src_f32(&src, input + i, output + len, BLOCK);
+        len_s16 += dsps_src_s16(&src_s16, input_s16 + i, output_s16 + len_s16, BLOCK);
+    }
+    float err = 0;
+    for (int i = 0; i < len; i++) {
+        err = fmaxf(err, fabsf(output[i] - output_s16[i]));
+    }
+    printf("Multistage s16: largest difference with f32 %.1f LSB\n", err);
+    if (len != N_SAMPLES / 8 || len_s16 != len || err > 4) {
+        printf("Multistage s16 differs from f32\n");
+        errors++;
+    }
+
+    // Speed against a single stage with the same transition band
+    dsps_fir_gen_lpf_f32(coeffs, single_len, 125.0f / 2000, 1);
+    dsps_resample_init_f32(&single, coeffs, delay, single_len, 1, 8);
+    uint32_t start = dsp_get_cpu_cycle_count();
+    for (int r = 0; r < N_BENCH; r++) {
+        for (int i = 0; i < N_SAMPLES; i += BLOCK) {
+            dsps_resample_f32(&single, input + i, output, BLOCK);
+        }
+    }
+    uint32_t time_single = dsp_get_cpu_cycle_count() - start;
+    start = dsp_get_cpu_cycle_count();
+    for (int r = 0; r < N_BENCH; r++) {
+        for (int i = 0; i < N_SAMPLES; i += BLOCK) {
+            dsps_src_f32(&src, input + i, output, BLOCK);
+        }
+    }
+    uint32_t time_src = dsp_get_cpu_cycle_count() - start;
+    start = dsp_get_cpu_cycle_count();
+    for (int r = 0; r < N_BENCH; r++) {
+        for (int i = 0; i < N_SAMPLES; i += BLOCK) {
+            dsps_src_s16(&src_s16, input_s16 + i, output_s16, BLOCK);
+        }
+    }
+    uint32_t time_src_s16 = dsp_get_cpu_cycle_count() - start;
+    printf("Decimation by 8: single stage N = %i %.2f ns, half-band cascade f32 %.2f ns, s16 %.2f ns per input sample\n",
+           single_len, (float)time_single / (N_BENCH * N_SAMPLES), (float)time_src / (N_BENCH * N_SAMPLES),
+           (float)time_src_s16 / (N_BENCH * N_SAMPLES));
+    return errors;
+}
+
+int test_resample()
+{
+    int errors = 0;
+    errors += TestResampleStreaming();
+    errors += TestHalfband();
+    errors += TestInterpolation();
+    errors += TestMultistage();
+    printf("Resample: %i error(s)\n", errors);
+    return errors;
+}
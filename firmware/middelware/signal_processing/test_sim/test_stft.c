@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "stft.h"
+#include "dsp_common.h"
+#include "dsps_tone_gen.h"
+
+#define STFT_LENGHT     256
+#define STFT_SAMPLES    8192
+#define N_FRAMES        16
+
+static float stream[STFT_SAMPLES];
+static float noise[STFT_SAMPLES];
+static float power_ref[STFT_LENGHT / 2];
+
+// Standard deviation over mean of the noise floor (bins away from the tone)
+static float NoiseSpread(const float *power, int tone_bin)
+{
+    float sum = 0, sum2 = 0;
+    int n = 0;
+    for (int i = 4; i < STFT_LENGHT / 2; i++) {
+        if (abs(i - tone_bin) < 4) {
+            continue;
+        }
+        sum += power[i];
+        sum2 += power[i] * power[i];
+        n++;
+    }
+    float mean = sum / n;
+    return sqrtf(sum2 / n - mean * mean) / mean;
+}
+
+int test_stft()
+{
+    int errors = 0;
+
+    // Tone at bin 32 plus white noise
+    dsps_tone_gen_f32(stream, STFT_SAMPLES, 100, 32.0f / STFT_LENGHT, 0);
+    for (int i = 0; i < STFT_SAMPLES; i++) {
+        noise[i] = (rand() / (float)RAND_MAX - 0.5f) * 20;
+        stream[i] += noise[i];
+    }
+
+    // Invalid configurations
+    stft_config_t config = {
+        .frame_lenght = STFT_LENGHT,
+        .hop = 0,
+        .window_type = FFT_WINDOW_HANN,
+        .average = STFT_AVERAGE_WELCH,
+        .spectrogram_frames = N_FRAMES,
+    };
+    if (StftCreate(&config) != NULL) {
+        printf("StftCreate accepts hop = 0\n");
+        errors++;
+    }
+    config.hop = STFT_LENGHT / 2;
+    config.average = STFT_AVERAGE_EXPONENTIAL;
+    config.alpha = 0;
+    if (StftCreate(&config) != NULL) {
+        printf("StftCreate accepts alpha = 0\n");
+        errors++;
+    }
+
+    // Chunks of random lenght: frame count and frame contents as the whole buffer FFT
+    config.average = STFT_AVERAGE_WELCH;
+    stft_t *stft = StftCreate(&config);
+    fft_ctx_t *fft = FFTCreate(STFT_LENGHT, FFT_WINDOW_HANN);
+    if (stft == NULL || fft == NULL) {
+        printf("StftCreate failed\n");
+        return errors + 1;
+    }
+    int frames = 0, pushed = 0;
+    while (pushed < STFT_SAMPLES) {
+        int n = 1 + rand() % 300;
+        if (n > STFT_SAMPLES - pushed) {
+            n = STFT_SAMPLES - pushed;
+        }
+        frames += StftPush(stft, stream + pushed, n);
+        pushed += n;
+    }
+    int expected = (STFT_SAMPLES - STFT_LENGHT) / config.hop + 1;
+    if (frames != expected) {
+        printf("STFT computed %i frames instead of %i\n", frames, expected);
+        errors++;
+    }
+    for (int age = 0; age < N_FRAMES; age++) {
+        int start = (expected - 1 - age) * config.hop;
+        FFTPowerCtx(fft, stream + start, power_ref);
+        float *power = StftSpectrogram(stft, age);
+        for (int i = 0; i < STFT_LENGHT / 2; i++) {
+            if (fabsf(power[i] - power_ref[i]) > 1e-5f * (power_ref[i] + 1)) {
+                printf("Spectrogram frame %i does not match the FFT of its samples\n", age);
+                errors++;
+                break;
+            }
+        }
+    }
+    if (StftSpectrogram(stft, N_FRAMES) != NULL) {
+        printf("Spectrogram returns a frame older than the ring\n");
+        errors++;
+    }
+
+    // Welch average: tone amplitude kept and noise floor smoother than a single frame
+    float *welch = StftAverage(stft);
+    float single_spread = NoiseSpread(StftSpectrogram(stft, 0), 32);
+    float welch_spread = NoiseSpread(welch, 32);
+    printf("STFT %i frames: tone %.1f, noise spread single frame %.2f, Welch %.2f\n",
+           frames, sqrtf(welch[32]), single_spread, welch_spread);
+    if (fabsf(sqrtf(welch[32]) - 200) > 2 || welch_spread > single_spread / 3) {
+        printf("Welch average is wrong\n");
+        errors++;
+    }
+    StftDelete(stft);
+
+    // Exponential average of a stationary tone converges to the tone power
+    config.average = STFT_AVERAGE_EXPONENTIAL;
+    config.alpha = 0.1f;
+    config.spectrogram_frames = 0;
+    stft = StftCreate(&config);
+    if (StftAverage(stft) != NULL || StftSpectrogram(stft, 0) != NULL) {
+        printf("STFT returns spectra before the first frame\n");
+        errors++;
+    }
+    dsps_tone_gen_f32(stream, STFT_SAMPLES, 100, 32.0f / STFT_LENGHT, 0);
+    StftPush(stft, stream, STFT_SAMPLES);
+    float tone = sqrtf(StftAverage(stft)[32]);
+    printf("STFT exponential average: tone %.2f\n", tone);
+    if (fabsf(tone - 200) > 1) {
+        printf("Exponential average is wrong\n");
+        errors++;
+    }
+
+    // Speed: cost per pushed sample for 50% and 75% overlap
+    for (int hop = STFT_LENGHT / 2; hop >= STFT_LENGHT / 4; hop /= 2) {
+        StftDelete(stft);
+        config.hop = hop;
+        stft = StftCreate(&config);
+        uint32_t start = dsp_get_cpu_cycle_count();
+        StftPush(stft, stream, STFT_SAMPLES);
+        uint32_t time = dsp_get_cpu_cycle_count() - start;
+        printf("STFT N = %i, hop %3i: %.1f ns per sample\n", STFT_LENGHT, hop, (float)time / STFT_SAMPLES);
+    }
+    StftDelete(stft);
+    FFTDelete(fft);
+
+    printf("STFT: %i error(s)\n", errors);
+    return errors;
+}
@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "tone_detector.h"
+#include "fft.h"
+#include "dsp_common.h"
+
+#define FS              1000.0f
+#define WINDOW          200
+#define N_SAMPLES       20000
+#define TONE_START      5000
+#define TONE_STOP       15000
+#define N_BENCH         20
+
+static float samples_f[N_SAMPLES];
+static int16_t samples_q15[N_SAMPLES];
+static float fft_out[MAX_SIGNAL_LENGHT / 2];
+
+static int events_on[3], events_off[3];
+static int first_on[3], first_off[3];
+static int sample_now;
+
+static void ToneEvent(uint8_t bin, bool detected, float level, void *param)
+{
+    if (detected) {
+        if (events_on[bin]++ == 0) {
+            first_on[bin] = sample_now;
+        }
+    } else {
+        if (events_off[bin]++ == 0) {
+            first_off[bin] = sample_now;
+        }
+    }
+}
+
+// 50 Hz tone of amplitude 1000 between TONE_START and TONE_STOP, 200 Hz tone always, noise
+static void GenerateStream(void)
+{
+    for (int i = 0; i < N_SAMPLES; i++) {
+        float v = 300 * sinf(2 * M_PI * 200 * i / FS) + (rand() % 101 - 50);
+        if (i >= TONE_START && i < TONE_STOP) {
+            v += 1000 * sinf(2 * M_PI * 50 * i / FS + 0.3f);
+        }
+        samples_f[i] = v;
+        samples_q15[i] = (int16_t)lrintf(v);
+    }
+}
+
+// Push sample by sample (to time the callbacks) and check the levels
+static int RunDetector(tone_mode_t mode, tone_kernel_t kernel)
+{
+    const char *names[2][2] = {{"Goertzel f32", "Goertzel q15"}, {"Sliding f32", "Sliding q15"}};
+    int errors = 0;
+    tone_bin_config_t bins[] = {
+        {.frequency = 50, .threshold_on = 600, .threshold_off = 400},
+        {.frequency = 120, .threshold_on = 600, .threshold_off = 400},
+        {.frequency = 200, .threshold_on = 200, .threshold_off = 100},
+    };
+    tone_detector_config_t config = {
+        .sample_freq = FS,
+        .window_lenght = WINDOW,
+        .mode = mode,
+        .kernel = kernel,
+        .n_bins = 3,
+        .bins = bins,
+        .func_p = ToneEvent,
+    };
+    tone_detector_t *detector = ToneDetectorCreate(&config);
+    if (detector == NULL) {
+        printf("ToneDetectorCreate failed\n");
+        return 1;
+    }
+    for (int b = 0; b < 3; b++) {
+        events_on[b] = events_off[b] = 0;
+        first_on[b] = first_off[b] = -1;
+    }
+    float level_on[3] = {0}, level_off[3] = {0};
+    for (sample_now = 0; sample_now < N_SAMPLES; sample_now++) {
+        if (kernel == TONE_Q15) {
+            ToneDetectorPushQ15(detector, &samples_q15[sample_now], 1);
+        } else {
+            ToneDetectorPush(detector, &samples_f[sample_now], 1);
+        }
+        if (sample_now == TONE_STOP - 1) {
+            for (int b = 0; b < 3; b++) {
+                level_on[b] = ToneDetectorLevel(detector, b);
+            }
+        }
+    }
+    for (int b = 0; b < 3; b++) {
+        level_off[b] = ToneDetectorLevel(detector, b);
+    }
+    printf("%-12s: 50 Hz %6.1f / %5.1f (on after %3i, off after %3i samples, %i/%i events), "
+           "120 Hz %5.1f, 200 Hz %5.1f\n",
+           names[mode][kernel], level_on[0], level_off[0], first_on[0] - TONE_START,
+           first_off[0] - TONE_STOP, events_on[0], events_off[0], level_on[1], level_on[2]);
+    // Levels within 2%, one event per edge (hysteresis), latency within a window
+    if (fabsf(level_on[0] - 1000) > 20 || level_off[0] > 50 || level_on[1] > 50 ||
+            fabsf(level_on[2] - 300) > 5) {
+        printf("Wrong tone levels\n");
+        errors++;
+    }
+    if (events_on[0] != 1 || events_off[0] != 1 || events_on[1] != 0 || events_on[2] != 1 || events_off[2] != 0) {
+        printf("Wrong detection events\n");
+        errors++;
+    }
+    if (first_on[0] < TONE_START || first_on[0] - TONE_START > WINDOW ||
+            first_off[0] < TONE_STOP || first_off[0] - TONE_STOP > WINDOW) {
+        printf("Detection latency above a window\n");
+        errors++;
+    }
+    ToneDetectorDelete(detector);
+    return errors;
+}
+
+int test_tone_detector()
+{
+    int errors = 0;
+    GenerateStream();
+
+    // Invalid configurations
+    tone_bin_config_t bad_bin = {.frequency = 50, .threshold_on = 10, .threshold_off = 20};
+    tone_detector_config_t config = {.sample_freq = FS, .window_lenght = WINDOW, .n_bins = 1, .bins = &bad_bin};
+    if (ToneDetectorCreate(&config) != NULL) {
+        printf("ToneDetectorCreate accepts threshold_off > threshold_on\n");
+        errors++;
+    }
+    tone_bin_config_t slow_bin = {.frequency = 0.01f, .threshold_on = 10, .threshold_off = 5};
+    config.bins = &slow_bin;
+    config.kernel = TONE_Q15;
+    config.window_lenght = 10000;
+    if (ToneDetectorCreate(&config) != NULL) {
+        printf("ToneDetectorCreate accepts a Q15 Goertzel that overflows\n");
+        errors++;
+    }
+
+    for (tone_mode_t mode = TONE_GOERTZEL; mode <= TONE_SLIDING; mode++) {
+        for (tone_kernel_t kernel = TONE_F32; kernel <= TONE_Q15; kernel++) {
+            errors += RunDetector(mode, kernel);
+        }
+    }
+
+    // Speed: 3 bins over the whole stream against FFTMagnitude frames of 2048 samples
+    tone_bin_config_t bins[3] = {
+        {.frequency = 50, .threshold_on = 600, .threshold_off = 400},
+        {.frequency = 120, .threshold_on = 600, .threshold_off = 400},
+        {.frequency = 200, .threshold_on = 200, .threshold_off = 100},
+    };
+    config.window_lenght = WINDOW;
+    config.n_bins = 3;
+    config.bins = bins;
+    for (tone_mode_t mode = TONE_GOERTZEL; mode <= TONE_SLIDING; mode++) {
+        for (tone_kernel_t kernel = TONE_F32; kernel <= TONE_Q15; kernel++) {
+            config.mode = mode;
+            config.kernel = kernel;
+            tone_detector_t *detector = ToneDetectorCreate(&config);
+            uint32_t start = dsp_get_cpu_cycle_count();
+            for (int i = 0; i < N_BENCH; i++) {
+                if (kernel == TONE_Q15) {
+                    ToneDetectorPushQ15(detector, samples_q15, N_SAMPLES);
+                } else {
+                    ToneDetectorPush(detector, samples_f, N_SAMPLES);
+                }
+            }
+            uint32_t time = dsp_get_cpu_cycle_count() - start;
+            printf("%s %s, 3 bins: %.2f ns per sample\n", mode == TONE_GOERTZEL ? "Goertzel" : "Sliding DFT",
+                   kernel == TONE_Q15 ? "q15" : "f32", (float)time / (N_BENCH * N_SAMPLES));
+            // Long run: the sliding DFT rounding errors stay bounded
+            if (fabsf(ToneDetectorLevel(detector, 2) - 300) > 5) {
+                printf("Level drifts after %i samples\n", N_BENCH * N_SAMPLES);
+                errors++;
+            }
+            ToneDetectorDelete(detector);
+        }
+    }
+    uint32_t start = dsp_get_cpu_cycle_count();
+    for (int i = 0; i < N_BENCH; i++) {
+        for (int j = 0; j + MAX_SIGNAL_LENGHT <= N_SAMPLES; j += MAX_SIGNAL_LENGHT) {
+            FFTMagnitude(samples_f + j, fft_out, MAX_SIGNAL_LENGHT);
+        }
+    }
+    uint32_t time = dsp_get_cpu_cycle_count() - start;
+    int frames = N_SAMPLES / MAX_SIGNAL_LENGHT;
+    printf("FFTMagnitude 2048: %.2f ns per sample\n", (float)time / (N_BENCH * frames * MAX_SIGNAL_LENGHT));
+
+    printf("Tone detector: %i error(s)\n", errors);
+    return errors;
+}